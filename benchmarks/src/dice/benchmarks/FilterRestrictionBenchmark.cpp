@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <dice/node-store/PersistentNodeStorageBackend.hpp>
+#include <dice/triple-store/TripleStore.hpp>
+
+/*
+ * Measures FILTER queries with the variables of single-variable conjuncts restricted before the join and with all conjuncts
+ * checked per solution, i.e., with TripleStore::set_filter_scan_limit(0). Both must yield the same number of solutions.
+ */
+
+namespace {
+	namespace fs = std::filesystem;
+	using namespace dice;
+	using metall_manager = rdf_tensor::metall_manager;
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * Writes a dataset of people who know each other, with ages and labels in two languages.
+	 */
+	void write_dataset(fs::path const &path, size_t people) {
+		std::ofstream out{path};
+		for (size_t i = 0; i < people; ++i) {
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/knows> <http://example.com/person/{}> .\n", i, (i * 7 + 1) % people);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/knows> <http://example.com/person/{}> .\n", i, (i * 13 + 5) % people);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/knows> <http://example.com/person/{}> .\n", i, (i * 31 + 11) % people);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/age> \"{}\"^^<http://www.w3.org/2001/XMLSchema#integer> .\n", i, i % 100);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/label> \"Person {}\"@en .\n", i, i);
+			if (i % 10 == 0)
+				out << fmt::format("<http://example.com/person/{}> <http://example.com/label> \"Person {}\"@de .\n", i, i);
+		}
+	}
+
+	std::vector<std::string> const default_queries{
+			"SELECT ?s ?o WHERE { ?s <http://example.com/knows> ?o . ?o <http://example.com/age> ?a FILTER(?a > 97) }",
+			"SELECT ?s ?o2 WHERE { ?s <http://example.com/knows> ?o . ?o <http://example.com/knows> ?o2 . ?o2 <http://example.com/age> ?a FILTER(?a < 2) }",
+			"SELECT ?s ?o ?l WHERE { ?s <http://example.com/knows> ?o . ?o <http://example.com/label> ?l FILTER(lang(?l) = \"de\") }",
+			"SELECT ?s ?o WHERE { ?s <http://example.com/knows> ?o . ?o <http://example.com/age> ?a FILTER(?a >= 10 && ?a < 12) FILTER(isIRI(?s)) }",
+			"SELECT ?s ?o WHERE { ?s <http://example.com/knows> ?o . ?s <http://example.com/age> ?a . ?o <http://example.com/age> ?b FILTER(?a < ?b) } LIMIT 1000",
+	};
+
+	struct Measurement {
+		double median_ms;
+		size_t solutions;
+	};
+
+	Measurement measure(triple_store::TripleStore &triplestore, sparql2tensor::SPARQLQuery const &query, size_t rounds) {
+		std::vector<double> times;
+		size_t solutions = 0;
+		for (size_t round = 0; round < rounds; ++round) {
+			solutions = 0;
+			auto const start = Clock::now();
+			for (auto const &entry : triplestore.eval_select(query))
+				solutions += entry.value();
+			times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+		}
+		std::ranges::nth_element(times, times.begin() + times.size() / 2);
+		return {times[times.size() / 2], solutions};
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("filter_restriction_benchmark",
+							 "Measures FILTER queries with and without restricting filtered variables before the join.");
+	options.add_options()                                                                                                                        //
+			("f,file", "An N-Triples file to query. Without it, a generated dataset is used.", cxxopts::value<std::string>())                    //
+			("people", "Number of people in the generated dataset.", cxxopts::value<size_t>()->default_value("100000"))                         //
+			("q,queries", "A file with one query per line. Without it, a few built-in queries for the generated dataset are used.", cxxopts::value<std::string>())//
+			("n,rounds", "How often each query is evaluated; the median is reported.", cxxopts::value<size_t>()->default_value("5"))              //
+			("h,help", "Print this help page.")                                                                                                  //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	auto const work_dir = fs::temp_directory_path() / fmt::format("tentris_filter_benchmark_{}", ::getpid());
+	fs::remove_all(work_dir);
+	fs::create_directories(work_dir);
+	auto dataset = work_dir / "dataset.nt";
+	if (parsed_args.count("file"))
+		dataset = parsed_args["file"].as<std::string>();
+	else
+		write_dataset(dataset, parsed_args["people"].as<size_t>());
+
+	auto queries = default_queries;
+	if (parsed_args.count("queries")) {
+		queries.clear();
+		std::ifstream file{parsed_args["queries"].as<std::string>()};
+		for (std::string line; std::getline(file, line);) {
+			if (not line.empty())
+				queries.push_back(std::move(line));
+		}
+	}
+	auto const rounds = std::max<size_t>(parsed_args["rounds"].as<size_t>(), 1);
+
+	{
+		using namespace rdf4cpp::rdf::storage::node;
+		metall_manager storage_manager{metall::create_only, (work_dir / "storage").c_str()};
+		auto *nodestore_backend = storage_manager.construct<node_store::PersistentNodeStorageBackendImpl>(metall::anonymous_instance)(storage_manager.get_allocator());
+		NodeStorage::set_default_instance(NodeStorage::new_instance<node_store::PersistentNodeStorageBackend>(nodestore_backend));
+		auto *ht_context = storage_manager.construct<rdf_tensor::HypertrieContext>(metall::anonymous_instance)(storage_manager.get_allocator());
+		auto *rdf_tensor = storage_manager.construct<rdf_tensor::BoolHypertrie>(metall::anonymous_instance)(3, rdf_tensor::HypertrieContext_ptr{ht_context});
+		triple_store::TripleStore triplestore{*rdf_tensor};
+		triplestore.load_ttl(dataset.string());
+
+		std::cout << "query, solutions, per solution ms, restricted ms, speedup" << std::endl;
+		for (size_t i = 0; i < queries.size(); ++i) {
+			try {
+				sparql2tensor::SPARQLQuery const query{queries[i]};
+				triplestore.set_filter_scan_limit(0);
+				auto const per_solution = measure(triplestore, query, rounds);
+				triplestore.set_filter_scan_limit(std::numeric_limits<size_t>::max());
+				auto const restricted = measure(triplestore, query, rounds);
+				if (per_solution.solutions != restricted.solutions)
+					std::cerr << fmt::format("Query {}: {} solutions per solution, but {} restricted", i, per_solution.solutions, restricted.solutions) << std::endl;
+				std::cout << fmt::format("{}, {}, {:.2f}, {:.2f}, {:.1f}", i, restricted.solutions, per_solution.median_ms, restricted.median_ms,
+										 per_solution.median_ms / restricted.median_ms)
+						  << std::endl;
+			} catch (std::exception const &error) {
+				std::cerr << fmt::format("Query {} failed: {}", i, error.what()) << std::endl;
+			}
+		}
+	}
+	fs::remove_all(work_dir);
+}
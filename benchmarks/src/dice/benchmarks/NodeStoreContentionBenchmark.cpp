@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <dice/node-store/PersistentNodeStorageBackend.hpp>
+#include <dice/triple-store/TripleStore.hpp>
+
+/*
+ * Measures how interning in the sharded node storage scales with the number of threads.
+ * Every thread interns its own IRIs and looks up IRIs that all threads share, which is the access pattern of parser threads
+ * that load one file. With --file, loading an N-Triples file is measured for each number of parser threads as well.
+ */
+
+namespace {
+	namespace fs = std::filesystem;
+	using namespace dice;
+	using metall_manager = rdf_tensor::metall_manager;
+	using Clock = std::chrono::steady_clock;
+
+	fs::path fresh_storage_path(size_t run) {
+		auto path = fs::temp_directory_path() / fmt::format("tentris_contention_benchmark_{}_{}", ::getpid(), run);
+		fs::remove_all(path);
+		return path;
+	}
+
+	/**
+	 * @return seconds it took threads threads to intern terms_per_thread IRIs each
+	 */
+	double intern(size_t threads, size_t terms_per_thread, size_t shared_terms, size_t run) {
+		auto const storage_path = fresh_storage_path(run);
+		double seconds;
+		{
+			metall_manager storage_manager{metall::create_only, storage_path.c_str()};
+			auto *node_store = storage_manager.construct<node_store::PersistentNodeStorageBackendImpl>(metall::anonymous_instance)(storage_manager.get_allocator());
+
+			// the terms are rendered beforehand, so only interning is measured
+			std::vector<std::vector<std::string>> terms(threads);
+			for (size_t thread = 0; thread < threads; ++thread) {
+				terms[thread].reserve(terms_per_thread);
+				for (size_t term = 0; term < terms_per_thread; ++term) {
+					// every fourth term is shared by all threads
+					if (term % 4 == 0)
+						terms[thread].push_back(fmt::format("http://example.com/shared/{}", (term / 4) % shared_terms));
+					else
+						terms[thread].push_back(fmt::format("http://example.com/thread/{}/term/{}", thread, term));
+				}
+			}
+
+			auto const start = Clock::now();
+			{
+				std::vector<std::jthread> workers;
+				for (size_t thread = 0; thread < threads; ++thread) {
+					workers.emplace_back([&, thread]() {
+						for (auto const &term : terms[thread])
+							(void) node_store->find_or_make_id(rdf4cpp::rdf::storage::node::view::IRIBackendView{.identifier = term});
+					});
+				}
+			}
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			storage_manager.destroy_ptr(node_store);
+		}
+		fs::remove_all(storage_path);
+		return seconds;
+	}
+
+	/**
+	 * @return seconds it took to load file with parser_threads parser threads
+	 */
+	double load(std::string const &file, size_t parser_threads, size_t run) {
+		using namespace rdf4cpp::rdf::storage::node;
+		auto const storage_path = fresh_storage_path(run);
+		double seconds;
+		{
+			metall_manager storage_manager{metall::create_only, storage_path.c_str()};
+			auto *nodestore_backend = storage_manager.construct<node_store::PersistentNodeStorageBackendImpl>(metall::anonymous_instance)(storage_manager.get_allocator());
+			NodeStorage::set_default_instance(NodeStorage::new_instance<node_store::PersistentNodeStorageBackend>(nodestore_backend));
+			auto *ht_context = storage_manager.construct<rdf_tensor::HypertrieContext>(metall::anonymous_instance)(storage_manager.get_allocator());
+			auto *rdf_tensor = storage_manager.construct<rdf_tensor::BoolHypertrie>(metall::anonymous_instance)(3, rdf_tensor::HypertrieContext_ptr{ht_context});
+			triple_store::TripleStore triplestore{*rdf_tensor};
+
+			auto const start = Clock::now();
+			triplestore.load_ttl(
+					file, 1'000'000, [](size_t, size_t, size_t) {}, [](rdf_tensor::parser::ParsingError const &) {}, parser_threads);
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		}
+		fs::remove_all(storage_path);
+		return seconds;
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("node_store_contention_benchmark",
+							 "Measures concurrent interning in the node storage for an increasing number of threads.");
+	options.add_options()                                                                                                                                               //
+			("t,max-threads", "Largest number of threads; the thread count is doubled from 1.", cxxopts::value<size_t>()->default_value(std::to_string(std::max(1U, std::thread::hardware_concurrency()))))//
+			("n,terms", "Number of IRIs that each thread interns.", cxxopts::value<size_t>()->default_value("1000000"))                                                 //
+			("shared-terms", "Number of distinct IRIs that all threads intern.", cxxopts::value<size_t>()->default_value("10000"))                                      //
+			("f,file", "An N-Triples file (extension .nt) that is loaded for each number of parser threads.", cxxopts::value<std::string>())                         //
+			("h,help", "Print this help page.")                                                                                                                        //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	auto const max_threads = parsed_args["max-threads"].as<size_t>();
+	auto const terms = parsed_args["terms"].as<size_t>();
+	auto const shared_terms = std::max<size_t>(parsed_args["shared-terms"].as<size_t>(), 1);
+
+	size_t run = 0;
+	std::cout << "interning: threads, seconds, million terms/s, speedup" << std::endl;
+	double single_thread_rate = 0;
+	for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+		auto const seconds = intern(threads, terms, shared_terms, run++);
+		auto const rate = double(threads * terms) / seconds;
+		if (threads == 1)
+			single_thread_rate = rate;
+		std::cout << fmt::format("{}, {:.3f}, {:.3f}, {:.2f}", threads, seconds, rate / 1'000'000, rate / single_thread_rate) << std::endl;
+	}
+
+	if (parsed_args.count("file")) {
+		auto const file = parsed_args["file"].as<std::string>();
+		std::cout << "loading: parser threads, seconds, speedup" << std::endl;
+		double single_thread_seconds = 0;
+		for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+			auto const seconds = load(file, threads, run++);
+			if (threads == 1)
+				single_thread_seconds = seconds;
+			std::cout << fmt::format("{}, {:.3f}, {:.2f}", threads, seconds, single_thread_seconds / seconds) << std::endl;
+		}
+	}
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <dice/endpoint/ConcurrentQueryCache.hpp>
+
+/*
+ * Measures the lookup latency of the query cache under a mixed hit/miss load.
+ * Every thread requests hot keys, which are cached after their first request, and with probability --miss-ratio a key that
+ * was never requested before. Building a value stands in for parsing a query: it spins for --build-us microseconds, and one
+ * in --slow-every misses is a large query that spins for --slow-build-us.
+ * The sharded single-flight cache is compared to a cache that builds values while holding its one mutex, so a slow miss
+ * stalls every other lookup there. All threads start on a cold cache, so the hot keys are requested concurrently before they
+ * are cached; with single-flight, each of them is built once.
+ */
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	std::chrono::microseconds build_time{200};
+	std::chrono::microseconds slow_build_time{50'000};
+	std::atomic<size_t> builds{0};
+
+	/**
+	 * A value that takes as long to build as parsing a query. Keys starting with "slow" take slow_build_time.
+	 */
+	struct SimulatedQuery {
+		std::string key;
+
+		explicit SimulatedQuery(std::string const &key) : key(key) {
+			builds.fetch_add(1, std::memory_order_relaxed);
+			auto const duration = key.starts_with("slow") ? slow_build_time : build_time;
+			auto const end = Clock::now() + duration;
+			// spin instead of sleeping, so building occupies a core like parsing does
+			while (Clock::now() < end) {
+			}
+		}
+	};
+
+	using ConcurrentCache = dice::endpoint::ConcurrentQueryCache<std::string, SimulatedQuery>;
+
+	/**
+	 * The cache before values were built outside of the lock: a miss builds its value while holding the one mutex.
+	 */
+	class GlobalLockCache {
+		std::mutex mutex_;
+		std::unordered_map<std::string, std::shared_ptr<SimulatedQuery const>> entries_;
+		size_t max_entries_;
+
+	public:
+		explicit GlobalLockCache(size_t max_entries) : max_entries_(max_entries) {}
+
+		std::shared_ptr<SimulatedQuery const> operator[](std::string const &key) {
+			std::unique_lock lock{mutex_};
+			if (auto iter = entries_.find(key); iter != entries_.end())
+				return iter->second;
+			auto value = std::make_shared<SimulatedQuery const>(key);
+			// the benchmark only cares about hits on hot keys, so misses are not cached once the cache is full
+			if (entries_.size() < max_entries_)
+				entries_.emplace(key, value);
+			return value;
+		}
+	};
+
+	struct Options {
+		size_t threads;
+		size_t requests;
+		size_t hot_keys;
+		double miss_ratio;
+		size_t slow_every;
+	};
+
+	struct Latencies {
+		// lookups of hot keys, which are hits once the key was built
+		std::vector<double> hot;
+		std::vector<double> miss;
+	};
+
+	/**
+	 * Runs the load on cache.
+	 * @return latencies in microseconds of all lookups, and the wall time in seconds
+	 */
+	template<class Cache>
+	std::pair<Latencies, double> run(Cache &cache, Options const &options) {
+		std::vector<Latencies> per_thread(options.threads);
+		std::atomic<size_t> next_miss{0};
+		auto const start = Clock::now();
+		{
+			std::vector<std::jthread> workers;
+			for (size_t thread = 0; thread < options.threads; ++thread) {
+				workers.emplace_back([&, thread]() {
+					auto &latencies = per_thread[thread];
+					latencies.hot.reserve(options.requests);
+					std::mt19937_64 rng{thread};
+					std::uniform_int_distribution<size_t> hot_key{0, options.hot_keys - 1};
+					std::bernoulli_distribution miss{options.miss_ratio};
+					std::string key;
+					for (size_t request = 0; request < options.requests; ++request) {
+						bool const is_miss = miss(rng);
+						if (is_miss) {
+							auto const id = next_miss.fetch_add(1, std::memory_order_relaxed);
+							key = fmt::format("{}/miss/{}", (options.slow_every != 0 and id % options.slow_every == 0) ? "slow" : "fast", id);
+						} else {
+							key = fmt::format("hot/{}", hot_key(rng));
+						}
+						auto const lookup_start = Clock::now();
+						auto value = cache[key];
+						auto const latency = std::chrono::duration<double, std::micro>(Clock::now() - lookup_start).count();
+						(is_miss ? latencies.miss : latencies.hot).push_back(latency);
+					}
+				});
+			}
+		}
+		auto const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		Latencies all;
+		for (auto &latencies : per_thread) {
+			all.hot.insert(all.hot.end(), latencies.hot.begin(), latencies.hot.end());
+			all.miss.insert(all.miss.end(), latencies.miss.begin(), latencies.miss.end());
+		}
+		return {std::move(all), seconds};
+	}
+
+	double percentile(std::vector<double> &values, double p) {
+		if (values.empty())
+			return 0;
+		auto const index = std::min(values.size() - 1, size_t(p * double(values.size())));
+		std::ranges::nth_element(values, values.begin() + index);
+		return values[index];
+	}
+
+	void print(std::string_view cache, std::string_view lookups, std::vector<double> &latencies) {
+		std::cout << fmt::format("{}, {}, {}, {:.1f}, {:.1f}, {:.1f}, {:.1f}", cache, lookups, latencies.size(),
+								 percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999),
+								 latencies.empty() ? 0.0 : *std::ranges::max_element(latencies))
+				  << std::endl;
+	}
+
+	template<class Cache>
+	void measure(std::string_view name, Cache &cache, Options const &options) {
+		builds = 0;
+		auto [latencies, seconds] = run(cache, options);
+		print(name, "hot", latencies.hot);
+		print(name, "miss", latencies.miss);
+		std::cerr << fmt::format("{}: {:.3f} s, {:.0f} lookups/s, {} values built for {} misses and {} hot keys",
+								 name, seconds, double(options.threads * options.requests) / seconds,
+								 builds.load(), latencies.miss.size(), options.hot_keys)
+				  << std::endl;
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("query_cache_contention_benchmark",
+							 "Measures query cache lookup latency under a mixed hit/miss load.");
+	options.add_options()                                                                                                                                                //
+			("t,threads", "Number of threads that look up keys.", cxxopts::value<size_t>()->default_value(std::to_string(std::max(1U, std::thread::hardware_concurrency()))))//
+			("n,requests", "Number of lookups per thread.", cxxopts::value<size_t>()->default_value("100000"))                                                           //
+			("hot-keys", "Number of frequently requested keys.", cxxopts::value<size_t>()->default_value("1000"))                                                        //
+			("miss-ratio", "Fraction of lookups for keys that were never requested before.", cxxopts::value<double>()->default_value("0.01"))                            //
+			("build-us", "Microseconds it takes to build a value.", cxxopts::value<size_t>()->default_value("200"))                                                      //
+			("slow-build-us", "Microseconds it takes to build the value of a large query.", cxxopts::value<size_t>()->default_value("50000"))                           //
+			("slow-every", "Every n-th miss is a large query; 0 for none.", cxxopts::value<size_t>()->default_value("100"))                                             //
+			("h,help", "Print this help page.")                                                                                                                          //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	Options const run_options{
+			.threads = std::max<size_t>(parsed_args["threads"].as<size_t>(), 1),
+			.requests = parsed_args["requests"].as<size_t>(),
+			.hot_keys = std::max<size_t>(parsed_args["hot-keys"].as<size_t>(), 1),
+			.miss_ratio = std::clamp(parsed_args["miss-ratio"].as<double>(), 0.0, 1.0),
+			.slow_every = parsed_args["slow-every"].as<size_t>()};
+	build_time = std::chrono::microseconds{parsed_args["build-us"].as<size_t>()};
+	slow_build_time = std::chrono::microseconds{parsed_args["slow-build-us"].as<size_t>()};
+
+	// room for all hot keys, so hot keys are hits once they were built
+	auto const max_entries = 4 * run_options.hot_keys;
+
+	std::cout << "cache, lookups, count, p50 us, p99 us, p99.9 us, max us" << std::endl;
+	{
+		GlobalLockCache cache{max_entries};
+		measure("global lock", cache, run_options);
+	}
+	{
+		ConcurrentCache cache{max_entries};
+		measure("single-flight", cache, run_options);
+	}
+}
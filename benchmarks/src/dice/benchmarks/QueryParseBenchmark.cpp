@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <dice/sparql2tensor/SPARQLQuery.hpp>
+
+/*
+ * Measures how long parsing a query takes with the hand-written parser for plain basic graph pattern queries and with the ANTLR
+ * parser. The terms of the queries are interned in the default in-memory node storage, so interning is part of the measurement
+ * for both parsers, but after the first round the terms are known.
+ */
+
+namespace {
+	using namespace dice::sparql2tensor;
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<std::string> const default_queries{
+			"SELECT ?s WHERE { ?s ?p ?o }",
+			"PREFIX dbo: <http://dbpedia.org/ontology/> PREFIX rdfs: <http://www.w3.org/2000/01/rdf-schema#> "
+			"SELECT DISTINCT ?city ?label WHERE { ?city a dbo:City ; rdfs:label ?label ; dbo:country ?country . ?country rdfs:label \"Germany\"@en }",
+			"PREFIX ex: <http://example.com/> "
+			"SELECT ?a ?b ?c ?d WHERE { ?a ex:p1 ?b . ?b ex:p2 ?c . ?c ex:p3 ?d . ?d ex:p4 ?a . ?a ex:p5 42 . ?b ex:p6 \"x\"^^ex:t } LIMIT 100",
+			"SELECT (COUNT(DISTINCT ?o) AS ?count) WHERE { ?s <http://example.com/p> ?o }",
+			"ASK { <http://example.com/s> <http://example.com/p> 1.5e3 }",
+	};
+
+	/**
+	 * @return mean microseconds per call of parse over rounds rounds
+	 */
+	template<class Parse>
+	double measure(std::string const &query, size_t rounds, Parse parse) {
+		auto const start = Clock::now();
+		for (size_t round = 0; round < rounds; ++round) {
+			auto parsed = parse(query);
+			// keep the result alive until here, so destroying it is measured as well
+			(void) parsed;
+		}
+		return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / double(rounds);
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("query_parse_benchmark",
+							 "Measures how long parsing queries takes with the hand-written parser and with the ANTLR parser.");
+	options.add_options()                                                                                                          //
+			("f,file", "A file with one query per line. Without it, a few built-in queries are parsed.", cxxopts::value<std::string>())//
+			("n,rounds", "How often each query is parsed.", cxxopts::value<size_t>()->default_value("1000"))                     //
+			("h,help", "Print this help page.")                                                                                    //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	auto queries = default_queries;
+	if (parsed_args.count("file")) {
+		queries.clear();
+		std::ifstream file{parsed_args["file"].as<std::string>()};
+		for (std::string line; std::getline(file, line);) {
+			if (not line.empty())
+				queries.push_back(std::move(line));
+		}
+	}
+	auto const rounds = std::max<size_t>(parsed_args["rounds"].as<size_t>(), 1);
+
+	std::cout << "query, hand-written us, ANTLR us, speedup" << std::endl;
+	double hand_written_total = 0;
+	double grammar_total = 0;
+	size_t plain_bgp_queries = 0;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		auto const &query = queries[i];
+		try {
+			auto const grammar = measure(query, rounds, SPARQLQuery::parse_with_grammar);
+			if (not SPARQLQuery::parse_bgp(query)) {
+				std::cout << fmt::format("{}, -, {:.2f}, -", i, grammar) << std::endl;
+				continue;
+			}
+			auto const hand_written = measure(query, rounds, SPARQLQuery::parse_bgp);
+			std::cout << fmt::format("{}, {:.2f}, {:.2f}, {:.1f}", i, hand_written, grammar, grammar / hand_written) << std::endl;
+			hand_written_total += hand_written;
+			grammar_total += grammar;
+			++plain_bgp_queries;
+		} catch (std::exception const &error) {
+			std::cerr << fmt::format("Query {} could not be parsed: {}", i, error.what()) << std::endl;
+		}
+	}
+	if (plain_bgp_queries != 0)
+		std::cout << fmt::format("plain BGP queries: {} of {}, mean hand-written {:.2f} us, mean ANTLR {:.2f} us, speedup {:.1f}",
+								 plain_bgp_queries, queries.size(), hand_written_total / double(plain_bgp_queries),
+								 grammar_total / double(plain_bgp_queries), grammar_total / hand_written_total)
+				  << std::endl;
+}
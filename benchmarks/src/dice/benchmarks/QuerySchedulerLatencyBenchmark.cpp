@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+#include <dice/endpoint/QueryScheduler.hpp>
+
+/*
+ * Measures the tail latency of cheap queries that arrive together with expensive ones, with and without the query scheduler.
+ * Requests arrive with exponentially distributed gaps and are processed by a fixed number of workers, like the HTTP endpoint
+ * does. Evaluating a query is simulated by spinning; one in --expensive-every queries is expensive and spins for a random
+ * multiple of --expensive-ms, the others spin for --cheap-us. The latency of a request is the time from its arrival to the end
+ * of its evaluation.
+ * Without the scheduler, every worker evaluates its query to the end, so cheap queries wait whenever expensive ones occupy all
+ * workers. With the scheduler, at most --max-running expensive queries are evaluated at a time, in slices of --slice-ms.
+ */
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct Options {
+		size_t workers;
+		size_t requests;
+		std::chrono::microseconds arrival_gap;
+		std::chrono::microseconds cheap_time;
+		std::chrono::microseconds expensive_time;
+		size_t expensive_every;
+		size_t max_running;
+		std::chrono::microseconds time_slice;
+	};
+
+	struct Request {
+		// the arrival relative to the start of a run
+		std::chrono::microseconds offset;
+		Clock::time_point arrival;
+		std::chrono::microseconds work;
+		bool expensive;
+		// in milliseconds
+		double latency = 0;
+	};
+
+	void spin(std::chrono::microseconds duration) {
+		auto const end = Clock::now() + duration;
+		// spin instead of sleeping, so the evaluation occupies a core like a query does
+		while (Clock::now() < end) {
+		}
+	}
+
+	void finish(Request &request) {
+		request.latency = std::chrono::duration<double, std::milli>(Clock::now() - request.arrival).count();
+	}
+
+	/**
+	 * A fixed number of threads that process tasks in arrival order, like the executor of the HTTP endpoint.
+	 */
+	class Workers {
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::deque<std::function<void()>> tasks_;
+		bool closed_ = false;
+		std::vector<std::jthread> threads_;
+
+	public:
+		explicit Workers(size_t threads) {
+			for (size_t thread = 0; thread < threads; ++thread) {
+				threads_.emplace_back([this]() {
+					while (true) {
+						std::function<void()> task;
+						{
+							std::unique_lock lock{mutex_};
+							cv_.wait(lock, [this]() { return closed_ or not tasks_.empty(); });
+							if (tasks_.empty())
+								return;
+							task = std::move(tasks_.front());
+							tasks_.pop_front();
+						}
+						task();
+					}
+				});
+			}
+		}
+
+		void submit(std::function<void()> task) {
+			{
+				std::unique_lock lock{mutex_};
+				tasks_.push_back(std::move(task));
+			}
+			cv_.notify_one();
+		}
+
+		/**
+		 * Waits until all submitted tasks are processed.
+		 */
+		void join() {
+			{
+				std::unique_lock lock{mutex_};
+				closed_ = true;
+			}
+			cv_.notify_all();
+			threads_.clear();
+		}
+	};
+
+	std::vector<Request> make_requests(Options const &options) {
+		std::mt19937_64 rng{42};
+		std::exponential_distribution<double> gap{1.0 / double(options.arrival_gap.count())};
+		std::uniform_real_distribution<double> expensive_factor{0.25, 4.0};
+		std::vector<Request> requests(options.requests);
+		auto offset = std::chrono::microseconds{0};
+		for (size_t i = 0; i < requests.size(); ++i) {
+			offset += std::chrono::microseconds{size_t(gap(rng))};
+			auto &request = requests[i];
+			request.offset = offset;
+			request.expensive = options.expensive_every != 0 and i % options.expensive_every == 0;
+			request.work = request.expensive ? std::chrono::microseconds{size_t(double(options.expensive_time.count()) * expensive_factor(rng))}
+											 : options.cheap_time;
+		}
+		return requests;
+	}
+
+	/**
+	 * Processes requests on the workers, with or without a scheduler, and records their latencies.
+	 * @return the wall time in seconds
+	 */
+	double run(std::vector<Request> &requests, Options const &options, bool scheduled) {
+		// the cost of a query is its estimate; here, the estimate is exact
+		auto const expensive_cost = double(options.cheap_time.count()) + 1;
+		dice::endpoint::QueryScheduler scheduler{options.max_running, expensive_cost, options.time_slice};
+		auto const time_slice = options.time_slice;
+
+		auto const start = Clock::now();
+		{
+			Workers workers{options.workers};
+			for (auto &request : requests) {
+				request.arrival = start + request.offset;
+				std::this_thread::sleep_until(request.arrival);
+				// expensive queries may continue on another worker after the task that started them ended
+				workers.submit([&scheduler, current = &request, scheduled, time_slice]() {
+					auto const cost = double(current->work.count());
+					if (not scheduled or not scheduler.is_expensive(cost)) {
+						spin(current->work);
+						finish(*current);
+						return;
+					}
+					scheduler.schedule(cost, [current, time_slice, remaining = current->work]() mutable {
+						spin(std::min(remaining, time_slice));
+						remaining -= std::min(remaining, time_slice);
+						if (remaining.count() > 0)
+							return false;
+						finish(*current);
+						return true;
+					});
+				});
+			}
+			workers.join();
+		}
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	double percentile(std::vector<double> &values, double p) {
+		if (values.empty())
+			return 0;
+		auto const index = std::min(values.size() - 1, size_t(p * double(values.size())));
+		std::ranges::nth_element(values, values.begin() + index);
+		return values[index];
+	}
+
+	void print(std::string_view mode, std::string_view queries, std::vector<double> &latencies) {
+		std::cout << fmt::format("{}, {}, {}, {:.2f}, {:.2f}, {:.2f}, {:.2f}, {:.2f}", mode, queries, latencies.size(),
+								 percentile(latencies, 0.5), percentile(latencies, 0.95), percentile(latencies, 0.99),
+								 percentile(latencies, 0.999), latencies.empty() ? 0.0 : *std::ranges::max_element(latencies))
+				  << std::endl;
+	}
+
+	void measure(std::string_view mode, Options const &options, bool scheduled) {
+		auto requests = make_requests(options);
+		auto const seconds = run(requests, options, scheduled);
+		std::vector<double> cheap;
+		std::vector<double> expensive;
+		for (auto const &request : requests)
+			(request.expensive ? expensive : cheap).push_back(request.latency);
+		print(mode, "cheap", cheap);
+		print(mode, "expensive", expensive);
+		std::cerr << fmt::format("{}: {:.3f} s for {} requests", mode, seconds, requests.size()) << std::endl;
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("query_scheduler_latency_benchmark",
+							 "Measures the tail latency of cheap queries among expensive ones, with and without the query scheduler.");
+	options.add_options()                                                                                                                                                     //
+			("w,workers", "Number of workers that process requests.", cxxopts::value<size_t>()->default_value(std::to_string(std::max(2U, std::thread::hardware_concurrency()))))//
+			("n,requests", "Number of requests.", cxxopts::value<size_t>()->default_value("20000"))                                                                           //
+			("gap-us", "Mean microseconds between two requests.", cxxopts::value<size_t>()->default_value("500"))                                                            //
+			("cheap-us", "Microseconds it takes to evaluate a cheap query.", cxxopts::value<size_t>()->default_value("200"))                                                 //
+			("expensive-ms", "Mean milliseconds it takes to evaluate an expensive query.", cxxopts::value<size_t>()->default_value("100"))                                  //
+			("expensive-every", "Every n-th request is an expensive query; 0 for none.", cxxopts::value<size_t>()->default_value("100"))                                    //
+			("max-running", "Expensive queries that the scheduler evaluates at a time.", cxxopts::value<size_t>()->default_value("1"))                                     //
+			("slice-ms", "Milliseconds an expensive query runs before the scheduler may suspend it.", cxxopts::value<size_t>()->default_value("10"))                      //
+			("h,help", "Print this help page.")                                                                                                                               //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	Options const run_options{
+			.workers = std::max<size_t>(parsed_args["workers"].as<size_t>(), 1),
+			.requests = parsed_args["requests"].as<size_t>(),
+			.arrival_gap = std::chrono::microseconds{std::max<size_t>(parsed_args["gap-us"].as<size_t>(), 1)},
+			.cheap_time = std::chrono::microseconds{parsed_args["cheap-us"].as<size_t>()},
+			.expensive_time = std::chrono::milliseconds{parsed_args["expensive-ms"].as<size_t>()},
+			.expensive_every = parsed_args["expensive-every"].as<size_t>(),
+			.max_running = std::max<size_t>(parsed_args["max-running"].as<size_t>(), 1),
+			.time_slice = std::chrono::milliseconds{std::max<size_t>(parsed_args["slice-ms"].as<size_t>(), 1)}};
+
+	std::cout << "mode, queries, count, p50 ms, p95 ms, p99 ms, p99.9 ms, max ms" << std::endl;
+	measure("unscheduled", run_options, false);
+	measure("scheduled", run_options, true);
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <dice/endpoint/SparqlEndpoint.hpp>
+#include <dice/endpoint/SparqlJsonResultSAXWriter.hpp>
+#include <dice/node-store/PersistentNodeStorageBackend.hpp>
+#include <dice/triple-store/TripleStore.hpp>
+
+/*
+ * Counts the heap allocations of the steps of a /sparql request, before and after the per-request temporaries were removed.
+ * The "before" variants reproduce the previous code: slice keys were built per request, the query parameter was copied, the
+ * response body was copied out of the JSON writer, and the query features were serialized through an nlohmann JSON tree.
+ * Evaluation itself is only measured as it is now; it is the baseline that a per-request arena would have to improve on.
+ *
+ * Allocations are counted by replacing the global operator new. Allocations within the metall segment and by malloc are not counted.
+ */
+
+namespace {
+	struct AllocationCounter {
+		size_t allocations = 0;
+		size_t bytes = 0;
+	};
+
+	thread_local AllocationCounter counter;
+
+	void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+		++counter.allocations;
+		counter.bytes += size;
+		void *ptr = (alignment > alignof(std::max_align_t))
+							? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+							: std::malloc(size == 0 ? 1 : size);
+		if (ptr == nullptr)
+			throw std::bad_alloc{};
+		return ptr;
+	}
+}// namespace
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate(size, static_cast<std::size_t>(alignment)); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+	namespace fs = std::filesystem;
+	using namespace dice;
+	using metall_manager = rdf_tensor::metall_manager;
+
+	/**
+	 * @return the allocations that f makes
+	 */
+	template<class F>
+	AllocationCounter count_allocations(F &&f) {
+		auto const before = counter;
+		f();
+		return {counter.allocations - before.allocations, counter.bytes - before.bytes};
+	}
+
+	/**
+	 * Writes a dataset of people who know each other, with classes and labels.
+	 */
+	void write_dataset(fs::path const &path, size_t people) {
+		std::ofstream out{path};
+		for (size_t i = 0; i < people; ++i) {
+			out << fmt::format("<http://example.com/person/{}> <http://www.w3.org/1999/02/22-rdf-syntax-ns#type> <http://example.com/Class{}> .\n", i, i % 10);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/knows> <http://example.com/person/{}> .\n", i, (i * 7 + 1) % people);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/knows> <http://example.com/person/{}> .\n", i, (i * 13 + 5) % people);
+			out << fmt::format("<http://example.com/person/{}> <http://example.com/label> \"Person {}\"@en .\n", i, i);
+		}
+	}
+
+	std::vector<std::string> const default_queries{
+			"SELECT ?s WHERE { ?s a <http://example.com/Class1> }",
+			"SELECT ?s ?o WHERE { ?s <http://example.com/knows> ?o . ?o a <http://example.com/Class2> }",
+			"SELECT ?s ?l WHERE { ?s <http://example.com/knows> ?o . ?o <http://example.com/knows> ?s2 . ?s2 <http://example.com/label> ?l } LIMIT 1000",
+	};
+
+	/**
+	 * The features of a query as SPARQLEndpoint extracts them, without the cardinality estimates.
+	 */
+	endpoint::QueryFeatures make_features(sparql2tensor::SPARQLQuery const &query) {
+		endpoint::QueryFeatures features;
+		for (auto const &[var, var_id] : query.var_to_id_)
+			features.variable_names.emplace_back(var.name());
+		for (auto const &var : query.projected_variables_)
+			features.projection_variables.emplace_back(var.name());
+		features.join_variables = query.get_join_variable_names();
+		features.non_join_variables = query.get_non_join_variable_names();
+		features.num_triple_patterns = query.triple_patterns_.size();
+		features.is_distinct = query.distinct_;
+		auto const num_vars = query.var_to_id_.size();
+		features.adjacency_matrix.assign(num_vars, std::vector<int>(num_vars, 1));
+		features.variable_degrees.assign(num_vars, 2);
+		features.variable_cardinalities.assign(num_vars, 1000.0);
+		features.min_cardinality_variable = 'a';
+		features.num_connected_components = 1;
+		features.graph_density = 1.0;
+		features.max_variable_degree = 2;
+		features.min_variable_degree = 2;
+		features.avg_variable_degree = 2.0;
+		return features;
+	}
+
+	/**
+	 * QueryFeatures::to_json before it used a SAX writer.
+	 */
+	std::string features_to_json_with_tree(endpoint::QueryFeatures const &features) {
+		nlohmann::json j;
+		j["variable_names"] = features.variable_names;
+		j["projection_variables"] = features.projection_variables;
+		j["join_variables"] = features.join_variables;
+		j["non_join_variables"] = features.non_join_variables;
+		j["num_triple_patterns"] = features.num_triple_patterns;
+		j["is_distinct"] = features.is_distinct;
+		j["variable_cardinalities"] = features.variable_cardinalities;
+		j["total_query_cardinality"] = features.total_query_cardinality;
+		j["min_cardinality_variable"] = std::string(1, features.min_cardinality_variable);
+		j["adjacency_matrix"] = features.adjacency_matrix;
+		j["variable_degrees"] = features.variable_degrees;
+		j["max_variable_degree"] = features.max_variable_degree;
+		j["min_variable_degree"] = features.min_variable_degree;
+		j["avg_variable_degree"] = features.avg_variable_degree;
+		j["graph_density"] = features.graph_density;
+		j["num_connected_components"] = features.num_connected_components;
+		return j.dump();
+	}
+
+	struct Step {
+		std::string name;
+		AllocationCounter before;
+		AllocationCounter after;
+	};
+
+	/**
+	 * Counts the allocations of each step of one request for query_str.
+	 */
+	std::vector<Step> measure_request(triple_store::TripleStore &triplestore, std::string const &query_str) {
+		std::vector<Step> steps;
+		// the parsed query comes from the query cache
+		sparql2tensor::SPARQLQuery const query{query_str};
+		std::vector<std::string> result_variable_names;
+		for (auto const &var : query.projected_variables_)
+			result_variable_names.emplace_back(var.name());
+
+		{
+			std::string_view const query_param = query_str;
+			steps.push_back({"query parameter",
+							 count_allocations([&]() { std::string copy{query_param}; }),
+							 count_allocations([&]() { [[maybe_unused]] std::string_view view{query_param}; })});
+		}
+		steps.push_back({"slice keys",
+						 count_allocations([&]() { std::vector<rdf_tensor::SliceKey> slice_keys = query.get_slice_keys(); }),
+						 count_allocations([&]() { [[maybe_unused]] auto const &slice_keys = query.get_slice_keys(); })});
+		{
+			auto const features = make_features(query);
+			steps.push_back({"features json",
+							 count_allocations([&]() { auto json = features_to_json_with_tree(features); }),
+							 count_allocations([&]() { auto json = features.to_json(); })});
+		}
+
+		AllocationCounter evaluation;
+		auto const serialize = [&](bool copy_body) {
+			return count_allocations([&]() {
+				endpoint::SparqlJsonResultSAXWriter json_writer{result_variable_names, 100'000};
+				evaluation = count_allocations([&]() {
+					for (auto const &entry : triplestore.eval_select(query))
+						json_writer.add(entry);
+				});
+				json_writer.close();
+				if (copy_body) {
+					// the body was copied out of the writer's buffer
+					auto body = std::make_shared<std::string const>(json_writer.string_view());
+				} else {
+					auto body = std::make_shared<std::string const>(json_writer.release());
+				}
+			});
+		};
+		auto serialization_before = serialize(true);
+		auto serialization_after = serialize(false);
+		// the allocations of the evaluation are reported on their own
+		serialization_before.allocations -= evaluation.allocations;
+		serialization_before.bytes -= evaluation.bytes;
+		serialization_after.allocations -= evaluation.allocations;
+		serialization_after.bytes -= evaluation.bytes;
+		steps.push_back({"serialization", serialization_before, serialization_after});
+		steps.push_back({"evaluation", evaluation, evaluation});
+		return steps;
+	}
+}// namespace
+
+int main(int argc, char *argv[]) {
+	cxxopts::Options options("request_allocation_benchmark",
+							 "Counts the heap allocations of the steps of /sparql requests before and after removing per-request temporaries.");
+	options.add_options()                                                                                                                                  //
+			("f,file", "An N-Triples file to query. Without it, a generated dataset is used.", cxxopts::value<std::string>())                              //
+			("people", "Number of people in the generated dataset.", cxxopts::value<size_t>()->default_value("10000"))                                    //
+			("q,queries", "A file with one query per line. Without it, a few built-in queries for the generated dataset are used.", cxxopts::value<std::string>())//
+			("h,help", "Print this help page.")                                                                                                            //
+			;
+	auto parsed_args = options.parse(argc, argv);
+	if (parsed_args.count("help")) {
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+
+	auto const work_dir = fs::temp_directory_path() / fmt::format("tentris_allocation_benchmark_{}", ::getpid());
+	fs::remove_all(work_dir);
+	fs::create_directories(work_dir);
+	auto dataset = work_dir / "dataset.nt";
+	if (parsed_args.count("file"))
+		dataset = parsed_args["file"].as<std::string>();
+	else
+		write_dataset(dataset, parsed_args["people"].as<size_t>());
+
+	auto queries = default_queries;
+	if (parsed_args.count("queries")) {
+		queries.clear();
+		std::ifstream file{parsed_args["queries"].as<std::string>()};
+		for (std::string line; std::getline(file, line);) {
+			if (not line.empty())
+				queries.push_back(std::move(line));
+		}
+	}
+
+	{
+		using namespace rdf4cpp::rdf::storage::node;
+		metall_manager storage_manager{metall::create_only, (work_dir / "storage").c_str()};
+		auto *nodestore_backend = storage_manager.construct<node_store::PersistentNodeStorageBackendImpl>(metall::anonymous_instance)(storage_manager.get_allocator());
+		NodeStorage::set_default_instance(NodeStorage::new_instance<node_store::PersistentNodeStorageBackend>(nodestore_backend));
+		auto *ht_context = storage_manager.construct<rdf_tensor::HypertrieContext>(metall::anonymous_instance)(storage_manager.get_allocator());
+		auto *rdf_tensor = storage_manager.construct<rdf_tensor::BoolHypertrie>(metall::anonymous_instance)(3, rdf_tensor::HypertrieContext_ptr{ht_context});
+		triple_store::TripleStore triplestore{*rdf_tensor};
+		triplestore.load_ttl(dataset.string());
+
+		std::cout << "query, step, allocations before, allocations after, KiB before, KiB after" << std::endl;
+		for (size_t i = 0; i < queries.size(); ++i) {
+			std::vector<Step> steps;
+			try {
+				steps = measure_request(triplestore, queries[i]);
+			} catch (std::exception const &error) {
+				std::cerr << fmt::format("Query {} failed: {}", i, error.what()) << std::endl;
+				continue;
+			}
+			Step total{"total"};
+			for (auto const &step : steps) {
+				std::cout << fmt::format("{}, {}, {}, {}, {:.1f}, {:.1f}", i, step.name, step.before.allocations, step.after.allocations,
+										 double(step.before.bytes) / 1024, double(step.after.bytes) / 1024)
+						  << std::endl;
+				total.before.allocations += step.before.allocations;
+				total.before.bytes += step.before.bytes;
+				total.after.allocations += step.after.allocations;
+				total.after.bytes += step.after.bytes;
+			}
+			std::cout << fmt::format("{}, {}, {}, {}, {:.1f}, {:.1f}", i, total.name, total.before.allocations, total.after.allocations,
+									 double(total.before.bytes) / 1024, double(total.after.bytes) / 1024)
+					  << std::endl;
+		}
+	}
+	fs::remove_all(work_dir);
+}
@@ -13,10 +13,12 @@ class Recipe(ConanFile):
     options = {
         "shared": [True, False],
         "fPIC": [True, False],
+        "with_test_deps": [True, False],
     }
     default_options = {
         "shared": False,
         "fPIC": True,
+        "with_test_deps": False,
         "restinio/*:asio": "boost",
     }
 
@@ -44,6 +46,11 @@ class Recipe(ConanFile):
         self.requires("dice-sparse-map/0.2.5", transitive_headers=True)
         self.requires("dice-template-library/1.9.1", transitive_headers=True)
         self.requires("boost/1.84.0", transitive_headers=True, libs=False, force=True)
+        if self.options.with_test_deps:
+            self.requires("doctest/2.4.11")
+
+    def package_id(self):
+        del self.info.options.with_test_deps
 
     def set_name(self):
         if not hasattr(self, 'name') or self.version is None:
@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <chrono>
+#include <exception>
 #include <filesystem>
+#include <mutex>
+#include <thread>
 
 #include <cxxopts.hpp>
 #include <fmt/format.h>
@@ -10,6 +14,7 @@
 #include <spdlog/stopwatch.h>
 
 #include <dice/node-store/PersistentNodeStorageBackend.hpp>
+#include <dice/triple-store/DatasetStatistics.hpp>
 #include <dice/triple-store/TripleStore.hpp>
 
 #include <dice/tentris/tentris_version.hpp>
@@ -25,6 +30,9 @@ int main(int argc, char *argv[]) {
 			("s,storage", "Location where the index is stored.", cxxopts::value<std::string>()->default_value(fs::current_path().string()))
 			("f,file", "A N-Triples or Turtle file.", cxxopts::value<std::string>())                      //
 			("b,bulksize", "Bulk-size for loading RDF files. A larger value results in a higher memory consumption during loading RDF data but may result in shorter loading times.", cxxopts::value<uint32_t>()->default_value("1000000"))//
+			("parser-threads", "Number of threads that parse N-Triples files (extension .nt) and intern their terms concurrently. Other files are parsed by a single thread.", cxxopts::value<size_t>()->default_value(std::to_string(std::max(1U, std::thread::hardware_concurrency()))))//
+			("statistics-top-k", "Number of subjects and of objects with the most triples that are stored per predicate in the dataset statistics.", cxxopts::value<size_t>()->default_value(std::to_string(triple_store::DatasetStatistics::default_top_k)))//
+			("characteristic-sets", "Maximum number of characteristic sets of subjects that are stored in the dataset statistics.", cxxopts::value<size_t>()->default_value(std::to_string(triple_store::DatasetStatistics::default_max_characteristic_sets)))//
 			("l,loglevel", fmt::format("Details of logging. Available values are: [{}, {}, {}, {}, {}, {}, {}]",                                                                                                                         //
 									   spdlog::level::to_string_view(spdlog::level::trace),                                                                                                                                              //
 									   spdlog::level::to_string_view(spdlog::level::debug),                                                                                                                                              //
@@ -96,12 +104,20 @@ int main(int argc, char *argv[]) {
 	{ // load
 		metall_manager storage_manager{metall::open_only, storage_path.c_str()};
 		// set up node store
+		node_store::PersistentNodeStorageBackendImpl *nodestore_backend;
+		// the first term that could not be stored, e.g., because there are too many distinct language tags
+		std::mutex insertion_error_mutex;
+		std::exception_ptr insertion_error;
 		{
 			using namespace rdf4cpp::rdf::storage::node;
 			using namespace dice::node_store;
-			auto *nodestore_backend = storage_manager.find_or_construct<PersistentNodeStorageBackendImpl>("node-store")(storage_manager.get_allocator());
+			nodestore_backend = storage_manager.find_or_construct<PersistentNodeStorageBackendImpl>("node-store")(storage_manager.get_allocator());
 			NodeStorage::set_default_instance(
-					NodeStorage::new_instance<PersistentNodeStorageBackend>(nodestore_backend));
+					NodeStorage::new_instance<PersistentNodeStorageBackend>(nodestore_backend, true, [&](std::exception_ptr error) {
+						std::unique_lock lock{insertion_error_mutex};
+						if (not insertion_error)
+							insertion_error = std::move(error);
+					}));
 		}
 		// setup triple store
 		auto &ht_context = *storage_manager.find_or_construct<rdf_tensor::HypertrieContext>("hypertrie-context")(storage_manager.get_allocator());
@@ -137,12 +153,37 @@ int main(int argc, char *argv[]) {
 						std::ostringstream oss;
 						oss << error;
 						spdlog::warn(oss.str());// spdlog does not want to use the ostream operator for ParsingError
-					});
+					},
+					parsed_args["parser-threads"].as<size_t>());
+			if (insertion_error) {
+				try {
+					std::rethrow_exception(insertion_error);
+				} catch (std::exception const &error) {
+					spdlog::error("Loading failed, a term could not be stored: {}", error.what());
+				} catch (...) {
+					spdlog::error("Loading failed, a term could not be stored.");
+				}
+				spdlog::error("The index at {} is incomplete. Please remove it.", storage_path.string());
+				spdlog::default_logger()->flush();
+				exit(EXIT_FAILURE);
+			}
 			spdlog::info("loading finished: {} triples processed, {} triples added, {} elapsed, {} triples in storage.",
 						 total_processed_entries, total_inserted_entries, std::chrono::duration<double>(loading_time.elapsed()).count(), final_hypertrie_size_after);
-			const auto cards = triplestore.get_hypertrie().get_cards({0, 1, 2});
+			spdlog::stopwatch filter_time;
+			auto const filter_bytes = nodestore_backend->rebuild_lookup_filters();
+			spdlog::info("Built node lookup filters: {:.3} MiB, {} elapsed.",
+						 double(filter_bytes) / (1024 * 1024), std::chrono::duration<double>(filter_time.elapsed()).count());
+			// identifies this load, so statistics that were built before it are recognized as outdated
+			auto &load_id = *storage_manager.find_or_construct<uint64_t>("load-id")(0);
+			++load_id;
+			spdlog::stopwatch statistics_time;
+			auto &statistics = *storage_manager.find_or_construct<triple_store::DatasetStatistics>("dataset-statistics")(storage_manager.get_allocator());
+			statistics.build(rdf_tensor, load_id, parsed_args["statistics-top-k"].as<size_t>(), parsed_args["characteristic-sets"].as<size_t>());
+			spdlog::info("Built dataset statistics: {} characteristic sets stored of {}, {} elapsed.",
+						 statistics.characteristic_sets().size(), statistics.total_characteristic_sets(),
+						 std::chrono::duration<double>(statistics_time.elapsed()).count());
 			spdlog::info("Storage stats: {} triples ({} distinct subjects, {} distinct predicates, {} distinct objects)",
-						 triplestore.size(), cards[0], cards[1], cards[2]);
+						 statistics.triples(), statistics.distinct_subjects(), statistics.distinct_predicates(), statistics.distinct_objects());
 		}
 	}
 
@@ -33,6 +33,19 @@ int main(int argc, char *argv[]) {
 			("t,timeout", "Time out in seconds for answering requests.", cxxopts::value<uint>()->default_value("180"))                                                                       //
 			("j,threads", "Number of threads used by the endpoint.", cxxopts::value<uint16_t>()->default_value(std::to_string(std::thread::hardware_concurrency())))                         //
 			("p,port", "Port to be used by the endpoint.", cxxopts::value<uint16_t>()->default_value("9080"))                                                                                //
+			("query-cache-entries", "Maximum number of parsed queries that are cached.", cxxopts::value<size_t>()->default_value("1000"))                                                   //
+			("query-cache-bytes", "Maximum estimated memory in bytes used by cached parsed queries.", cxxopts::value<size_t>()->default_value("268435456"))                                 //
+			("result-cache-bytes", "Maximum memory in bytes used by cached responses. 0 disables the result cache.", cxxopts::value<size_t>()->default_value("536870912"))                 //
+			("result-cache-min-ms", "Responses that are computed faster than this are not cached.", cxxopts::value<uint>()->default_value("10"))                                             //
+			("warmup-queries", "Maximum number of hottest queries that are saved on shutdown and parsed again on startup. 0 disables the warm-up.", cxxopts::value<size_t>()->default_value("1000"))//
+			("warmup-evaluate", "Also evaluate the warm-up queries in the background to load the index pages they touch.", cxxopts::value<bool>()->default_value("false"))                   //
+			("expensive-query-cardinality", "Queries whose estimated number of solutions is at least this are expensive. They are evaluated cheapest first and may be suspended in favor of cheaper ones.", cxxopts::value<double>()->default_value("1000000"))//
+			("reserved-threads", "Number of threads that only evaluate cheap queries. Default is a quarter of the threads.", cxxopts::value<uint16_t>())//
+			("time-slice-ms", "Time after which an expensive query may be suspended in favor of a waiting query with a lower estimate.", cxxopts::value<uint>()->default_value("100"))//
+			("query-partitions", "Maximum number of partitions that a single large query is split into for parallel evaluation. 0 disables the parallel evaluation.", cxxopts::value<size_t>()->default_value("0"))//
+			("partition-min-cardinality", "Queries whose smallest triple pattern has fewer matches are not split into partitions.", cxxopts::value<size_t>()->default_value("100000"))   //
+			("partition-max-domain-scan", "Queries whose partitioned variable would have to be read from more entries are not split into partitions.", cxxopts::value<size_t>()->default_value("1000000"))//
+			("sort-memory-solutions", "Number of solutions of an ORDER BY without LIMIT that are sorted in memory before they are spilled to temporary files.", cxxopts::value<size_t>()->default_value("1000000"))//
 			("l,loglevel", fmt::format("Details of logging. Available values are: [{}, {}, {}, {}, {}, {}, {}]",                                                                             //
 									   spdlog::level::to_string_view(spdlog::level::trace),                                                                                                  //
 									   spdlog::level::to_string_view(spdlog::level::debug),                                                                                                  //
@@ -100,7 +113,19 @@ int main(int argc, char *argv[]) {
 				if (arg == 0U)
 					return std::nullopt;
 				return std::chrono::seconds{arg};
-			}()};
+			}(),
+			.query_cache_max_entries = parsed_args["query-cache-entries"].as<size_t>(),
+			.query_cache_max_bytes = parsed_args["query-cache-bytes"].as<size_t>(),
+			.result_cache_max_bytes = parsed_args["result-cache-bytes"].as<size_t>(),
+			.result_cache_min_cost = std::chrono::milliseconds{parsed_args["result-cache-min-ms"].as<uint>()},
+			.warmup_file = fs::absolute(fs::path{parsed_args["storage"].as<std::string>()}).append("tentris_warmup"),
+			.warmup_max_queries = parsed_args["warmup-queries"].as<size_t>(),
+			.warmup_evaluate = parsed_args["warmup-evaluate"].as<bool>(),
+			.expensive_query_cardinality = parsed_args["expensive-query-cardinality"].as<double>(),
+			.reserved_threads = (parsed_args.count("reserved-threads"))
+										? parsed_args["reserved-threads"].as<uint16_t>()
+										: static_cast<uint16_t>(parsed_args["threads"].as<uint16_t>() / 4),
+			.time_slice = std::chrono::milliseconds{parsed_args["time-slice-ms"].as<uint>()}};
 
 	using metall_manager = rdf_tensor::metall_manager;
 
@@ -129,8 +154,9 @@ int main(int argc, char *argv[]) {
 		using namespace rdf4cpp::rdf::storage::node;
 		using namespace dice::node_store;
 		auto *nodestore_backend = storage_manager.find_or_construct<PersistentNodeStorageBackendImpl>("node-store")(storage_manager.get_allocator());
+		// terms of queries are not added to the index; those that are not in it are kept in memory
 		NodeStorage::set_default_instance(
-				NodeStorage::new_instance<PersistentNodeStorageBackend>(nodestore_backend));
+				NodeStorage::new_instance<PersistentNodeStorageBackend>(nodestore_backend, false));
 	}
 
 	// setup triple store
@@ -142,20 +168,41 @@ int main(int argc, char *argv[]) {
 		}
 		return *ptr;
 	}();
+	// statistics are outdated if data was loaded after they were built, even if the number of triples is the same.
+	// Indexes created by older loaders have no load id and possibly no statistics; they are built once and stored with the index.
+	auto *load_id = storage_manager.find<uint64_t>("load-id").first;
+	bool const unidentified_load = load_id == nullptr;
+	if (unidentified_load)
+		load_id = storage_manager.construct<uint64_t>("load-id")(1);
+	auto *statistics_ptr = storage_manager.find<triple_store::DatasetStatistics>("dataset-statistics").first;
+	if (unidentified_load or statistics_ptr == nullptr or not statistics_ptr->built() or statistics_ptr->load_id() != *load_id) {
+		spdlog::info("No up-to-date dataset statistics found. Building them.");
+		statistics_ptr = storage_manager.find_or_construct<triple_store::DatasetStatistics>("dataset-statistics")(storage_manager.get_allocator());
+		statistics_ptr->build(rdf_tensor, *load_id);
+	}
 	{
 		triple_store::TripleStore triplestore{rdf_tensor};
+		triplestore.set_statistics(*statistics_ptr);
 		// initialize task runners
 		tf::Executor executor(endpoint_cfg.threads);
+		triplestore.enable_parallel_evaluation(executor, {.max_partitions = parsed_args["query-partitions"].as<size_t>(),
+														  .min_cardinality = parsed_args["partition-min-cardinality"].as<size_t>(),
+														  .max_domain_scan = parsed_args["partition-max-domain-scan"].as<size_t>()});
+		triplestore.set_sort_memory_budget(parsed_args["sort-memory-solutions"].as<size_t>());
 		// setup and configure endpoints
 		endpoint::HTTPServer http_server{executor, triplestore, endpoint_cfg};
-		const auto cards = triplestore.get_hypertrie().get_cards({0, 1, 2});
+		auto const &statistics = *statistics_ptr;
 		spdlog::info("Storage stats: {} triples ({} distinct subjects, {} distinct predicates, {} distinct objects)",
-					 triplestore.size(), cards[0], cards[1], cards[2]);
+					 statistics.triples(), statistics.distinct_subjects(), statistics.distinct_predicates(), statistics.distinct_objects());
 		spdlog::info("SPARQL endpoint serving sparkling linked data treasures on {} threads at http://0.0.0.0:{}/ with {} request timeout.",
 					 endpoint_cfg.threads, endpoint_cfg.port, endpoint_cfg.opt_timeout_duration.value());
 
 		// start http server
 		http_server();
+
+		auto const decode_stats = node_store::PersistentNodeStorageBackendImpl::decoded_term_cache_stats();
+		spdlog::info("Decoded-term cache: {} lookups, {} hits ({:.1f}% hit rate)",
+					 decode_stats.lookups(), decode_stats.hits, decode_stats.hit_rate() * 100);
 	}
 
 	// warping up node storage
@@ -2,15 +2,23 @@
 #define TENTRIS_COUNTENDPOINT_HPP
 
 #include <dice/endpoint/Endpoint.hpp>
+#include <dice/endpoint/ParseSPARQLQueryParam.hpp>
 
 namespace dice::endpoint {
 
 	class CountEndpoint final : public Endpoint {
 	public:
-		CountEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, EndpointCfg const &endpoint_cfg);
+		CountEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, ResultCache &result_cache, QueryScheduler &scheduler, EndpointCfg const &endpoint_cfg);
 
 	protected:
 		void handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) override;
+
+	private:
+		/**
+		 * Counts the solutions of a query in a single slice, responds with the count and offers it to the result cache.
+		 */
+		Evaluation count_query(restinio::request_handle_t req, RequestedQuery sparql_query, std::string result_key, uint64_t generation,
+							   std::chrono::steady_clock::time_point timeout);
 	};
 }// namespace dice::endpoint
 #endif//TENTRIS_COUNTENDPOINT_HPP
\ No newline at end of file
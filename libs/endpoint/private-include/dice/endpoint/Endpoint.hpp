@@ -12,25 +12,96 @@
 #include <dice/triple-store/TripleStore.hpp>
 
 #include <dice/endpoint/EndpointCfg.hpp>
+#include <dice/endpoint/QueryScheduler.hpp>
+#include <dice/endpoint/ResultCache.hpp>
 #include <dice/endpoint/SparqlQueryCache.hpp>
 
+#include <string_view>
+#include <variant>
+
 namespace dice::endpoint {
 
+	/**
+	 * Tells an evaluation when its time slice is over. The clock is only read on every check_interval-th call of over().
+	 */
+	class TimeSlice {
+		static constexpr size_t check_interval = 1024;
+
+		std::chrono::steady_clock::duration length_;
+		std::chrono::steady_clock::time_point end_;
+		size_t calls_ = 0;
+
+	public:
+		explicit TimeSlice(std::chrono::steady_clock::duration length) noexcept
+			: length_(length), end_(std::chrono::steady_clock::now() + length) {}
+
+		[[nodiscard]] bool over() noexcept {
+			return ++calls_ % check_interval == 0 and std::chrono::steady_clock::now() >= end_;
+		}
+
+		/**
+		 * Starts the next slice now.
+		 */
+		void restart() noexcept { end_ = std::chrono::steady_clock::now() + length_; }
+	};
+
 	class Endpoint {
 	protected:
+		/**
+		 * The evaluation of a query that responds to its request. It yields at the points where it can be suspended, i.e., between
+		 * two time slices; it starts when it is first resumed.
+		 */
+		using Evaluation = std::generator<std::monostate>;
+
 		tf::Executor &executor_;
 
 		triple_store::TripleStore &triplestore_;
 
 		SparqlQueryCache &sparql_query_cache_;
 
+		ResultCache &result_cache_;
+
+		QueryScheduler &scheduler_;
+
 		EndpointCfg const cfg_;
 
 	protected:
 		virtual void handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) = 0;
 
+		/**
+		 * Responds to a request whose processing reached its timeout.
+		 */
+		void respond_timeout(restinio::request_handle_t const &req) const;
+
+		/**
+		 * Responds to a request whose processing threw: with 504 if its timeout is reached, as the evaluation stops by throwing
+		 * then, and with 500 otherwise.
+		 * @param timeout the timeout of the request
+		 * @param detail what went wrong; it is logged, but not sent
+		 */
+		void respond_failure(restinio::request_handle_t const &req, std::chrono::steady_clock::time_point timeout, std::string_view detail) const;
+
+		/**
+		 * Estimates the number of solutions of a query with TripleStore::estimate, which neither builds the tables of VALUES blocks
+		 * nor follows property paths.
+		 * @param query a query
+		 * @return the estimate; NaN if the query could not be estimated
+		 */
+		[[nodiscard]] double estimate_cost(sparql2tensor::SPARQLQuery const &query) const;
+
+		/**
+		 * Evaluates a cheap query to its end on the calling thread. An expensive query is passed to the scheduler, which evaluates it
+		 * slice by slice, possibly later and on other threads. Exceptions of a cheap evaluation are passed on; an expensive
+		 * evaluation that throws is answered with respond_failure.
+		 * @param req the request of the query
+		 * @param cost the estimated cost of the query; see QueryScheduler::is_expensive
+		 * @param timeout the timeout of the request
+		 * @param evaluation the evaluation of the query
+		 */
+		void evaluate(restinio::request_handle_t req, double cost, std::chrono::steady_clock::time_point timeout, Evaluation evaluation);
+
 	public:
-		Endpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, EndpointCfg const &endpoint_cfg);
+		Endpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, ResultCache &result_cache, QueryScheduler &scheduler, EndpointCfg const &endpoint_cfg);
 		virtual ~Endpoint() = default;
 		virtual restinio::request_handling_status_t operator()(restinio::request_handle_t req, restinio::router::route_params_t params) final;
 	};
@@ -0,0 +1,58 @@
+#ifndef TENTRIS_EXPLAINENDPOINT_HPP
+#define TENTRIS_EXPLAINENDPOINT_HPP
+
+#include <dice/endpoint/Endpoint.hpp>
+#include <dice/endpoint/ParseSPARQLQueryParam.hpp>
+
+#include <robin_hood.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dice::endpoint {
+
+	/**
+	 * Describes how a query would be evaluated without evaluating it: its triple patterns with their numbers of matches, its property
+	 * paths with their estimated matches, the components of its operands, the variable order and the cardinality estimates, and
+	 * whether /sparql would answer it from the result cache. The estimates come from TripleStore::estimate: triple patterns are
+	 * estimated from the dataset statistics, VALUES blocks are counted, not built, and property paths are estimated, not evaluated.
+	 * Only the matches of the triple patterns are counted on their slices, which are views, so no operand is built.
+	 * The variable order is the one of the learned planner if it answers within planner_timeout; otherwise, it is the default order
+	 * by ascending estimates.
+	 */
+	class ExplainEndpoint final : public Endpoint {
+		static constexpr std::chrono::milliseconds planner_timeout{200};
+
+		/**
+		 * The variable orders that the learned planner answered, by query key. An order is only valid for the generation of the
+		 * triple store that it was planned for, as the features of a query depend on the data. Copies of the endpoint share it.
+		 */
+		struct PlannerCache {
+			static constexpr size_t max_entries = 1024;
+
+			std::mutex mutex;
+			robin_hood::unordered_node_map<std::string, std::pair<uint64_t, std::vector<std::string>>> plans;
+		};
+
+		std::shared_ptr<PlannerCache> planner_cache_ = std::make_shared<PlannerCache>();
+
+		/**
+		 * Asks the learned planner for the variable order of a query, unless it is cached. The planner is given at most
+		 * planner_timeout, and never more than the time until the timeout of the request.
+		 * @return the variable order of the planner; nullopt if the planner did not answer
+		 */
+		[[nodiscard]] std::optional<std::vector<std::string>> planned_variable_order(RequestedQuery const &sparql_query,
+																					  std::chrono::steady_clock::time_point timeout);
+
+	public:
+		ExplainEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, ResultCache &result_cache, QueryScheduler &scheduler, EndpointCfg const &endpoint_cfg);
+
+	protected:
+		void handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) override;
+	};
+}// namespace dice::endpoint
+#endif//TENTRIS_EXPLAINENDPOINT_HPP
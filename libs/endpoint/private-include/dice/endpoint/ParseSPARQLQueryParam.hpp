@@ -6,13 +6,46 @@
 #include <restinio/request_handler.hpp>
 #include <restinio/uri_helpers.hpp>
 
+#include <dice/sparql2tensor/QueryCanonicalizer.hpp>
 #include <dice/sparql2tensor/SPARQLQuery.hpp>
 
 #include <dice/endpoint/SparqlQueryCache.hpp>
 
 namespace dice::endpoint {
 
-	inline std::shared_ptr<sparql2tensor::SPARQLQuery const> parse_sparql_query_param(restinio::request_handle_t &req, SparqlQueryCache &cache) {
+	/**
+	 * A parsed query of a request. The parsed query is shared between equivalent requests and may use canonical variable names.
+	 */
+	struct RequestedQuery {
+		std::shared_ptr<sparql2tensor::SPARQLQuery const> query;
+		// names of the projected variables as written in the request; result_variable_names[i] belongs to query->projected_variables_[i]
+		std::vector<std::string> result_variable_names;
+		// the key of query in the query cache, i.e., the canonical text or the query string of the request
+		std::string query_key;
+
+		/**
+		 * @param endpoint name of the endpoint that computes the response
+		 * @return a key that identifies the response body of this request at the endpoint
+		 */
+		[[nodiscard]] std::string result_key(std::string_view endpoint) const {
+			std::string key{endpoint};
+			for (auto const &name : result_variable_names) {
+				key.push_back(' ');
+				key.append(name);
+			}
+			key.push_back('\n');
+			key.append(query_key);
+			return key;
+		}
+
+		explicit operator bool() const noexcept { return bool(query); }
+
+		sparql2tensor::SPARQLQuery const &operator*() const noexcept { return *query; }
+
+		sparql2tensor::SPARQLQuery const *operator->() const noexcept { return query.get(); }
+	};
+
+	inline RequestedQuery parse_sparql_query_param(restinio::request_handle_t &req, SparqlQueryCache &cache) {
 		using namespace dice::sparql2tensor;
 		using namespace restinio;
 		const auto qp = parse_query<restinio::parse_query_traits::javascript_compatible>(req->header().query());
@@ -22,10 +55,18 @@ namespace dice::endpoint {
 			req->create_response(status_bad_request()).set_body(message).done();
 			return {};
 		}
-		std::string sparql_query_str = std::string{qp["query"]};
-		SPARQLQuery sparql_query;
+		auto const sparql_query_view = qp["query"];
 		try {
-			return cache[sparql_query_str];
+			// equivalent basic graph pattern queries share one cache entry
+			if (auto canonical = canonicalize(sparql_query_view); canonical) {
+				auto query = cache[canonical->text];
+				return {std::move(query), std::move(canonical->result_variable_names), std::move(canonical->text)};
+			}
+			std::string sparql_query_str{sparql_query_view};
+			RequestedQuery requested{cache[sparql_query_str], {}, std::move(sparql_query_str)};
+			for (auto const &var : requested.query->projected_variables_)
+				requested.result_variable_names.emplace_back(var.name());
+			return requested;
 		} catch (std::exception &ex) {
 			static auto const message = "Value of query parameter 'query' is not parsable.";
 			spdlog::warn("HTTP response {}: {} (detail: {})", status_bad_request(), message, ex.what());
@@ -34,4 +75,4 @@ namespace dice::endpoint {
 		}
 	}
 }// namespace dice::endpoint
-#endif//TENTRIS_PARSESPARQLQUERYPARAM_HPP
+#endif//TENTRIS_PARSESPARQLQUERYPARAM_HPP
\ No newline at end of file
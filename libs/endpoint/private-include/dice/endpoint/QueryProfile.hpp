@@ -0,0 +1,89 @@
+#ifndef TENTRIS_QUERYPROFILE_HPP
+#define TENTRIS_QUERYPROFILE_HPP
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <restinio/request_handler.hpp>
+
+#include <dice/node-store/DecodedTermCache.hpp>
+#include <dice/triple-store/TripleStore.hpp>
+
+namespace dice::endpoint {
+
+	/**
+	 * Timings and sizes of the processing of one request. A request with the query parameter profile=true gets them as JSON in
+	 * the response header Tentris-Profile, so the response body, which may be cached, is the same as without profiling.
+	 * The phases are measured one after another. While the request is suspended, e.g., waiting for the scheduler, no phase is measured;
+	 * the time is reported separately. The decoded-term lookups are counted on each thread that continues the request.
+	 */
+	class QueryProfile {
+		using clock = std::chrono::steady_clock;
+
+		clock::time_point phase_start_ = clock::now();
+		// the names are string literals
+		std::vector<std::pair<std::string_view, clock::duration>> phases_;
+		// the decoded-term lookups of the current thread before the request continued on it
+		node_store::DecodedTermCacheStats decodes_at_start_;
+		// the decoded-term lookups of the request on the threads that it left when it was suspended
+		node_store::DecodedTermCacheStats decodes_before_;
+		clock::time_point suspended_at_;
+		// the time that the request was suspended within the current phase and in total
+		clock::duration suspended_in_phase_{};
+		clock::duration suspended_{};
+
+		QueryProfile();
+
+	public:
+		static constexpr std::string_view header = "Tentris-Profile";
+
+		triple_store::EvaluationProfile evaluation;
+		// the cardinality estimate of each variable
+		std::vector<std::pair<std::string, double>> variable_cardinalities;
+		size_t solutions = 0;
+		size_t bindings = 0;
+		bool result_cached = false;
+
+		/**
+		 * Looks for the parameter without parsing the query string if the string does not contain it.
+		 * @param req a request
+		 * @return a profile that starts now if the request has the parameter profile=true; std::nullopt otherwise
+		 */
+		[[nodiscard]] static std::optional<QueryProfile> of(restinio::request_handle_t const &req);
+
+		/**
+		 * Ends the current phase; the next one starts now.
+		 * @param name the name of the phase; a string literal
+		 * @param nested time within the phase that is reported as phases of its own; it is not counted for this phase
+		 */
+		void end_phase(std::string_view name, clock::duration nested = {});
+
+		/**
+		 * Adds a phase that was measured separately, e.g., piecewise while another phase was running.
+		 * @param name the name of the phase; a string literal
+		 * @param duration the duration of the phase
+		 */
+		void add_phase(std::string_view name, clock::duration duration);
+
+		/**
+		 * Stops measuring until resume() is called, e.g., because the request waits for the scheduler.
+		 */
+		void suspend();
+
+		/**
+		 * Continues measuring after suspend(), possibly on another thread than the one that suspended the request.
+		 */
+		void resume();
+
+		/**
+		 * @return the profile as JSON. The decoded-term lookups are counted up to this call.
+		 */
+		[[nodiscard]] std::string to_json() const;
+	};
+}// namespace dice::endpoint
+
+#endif//TENTRIS_QUERYPROFILE_HPP
@@ -2,6 +2,14 @@
 #define TENTRIS_SPARQLENDPOINT_HPP
 
 #include <dice/endpoint/Endpoint.hpp>
+#include <dice/endpoint/ParseSPARQLQueryParam.hpp>
+#include <dice/endpoint/QueryProfile.hpp>
+
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace dice::endpoint {
 
@@ -16,9 +24,13 @@ namespace dice::endpoint {
 
 		// Cardinality features
 		std::vector<double> variable_cardinalities;
-		double total_query_cardinality;
+		double total_query_cardinality = std::numeric_limits<double>::quiet_NaN();
 		char min_cardinality_variable;
 
+		// Dataset statistics features
+		std::vector<double> triple_pattern_cardinalities;  // Estimated matches of each triple pattern
+		std::vector<double> star_cardinalities;            // Estimated solutions of each subject star with two or more constant predicates; empty if the store has no up-to-date statistics
+
 		// ODG features (numerical representation)
 		std::vector<std::vector<int>> adjacency_matrix;  // Variable connectivity
 		std::vector<int> variable_degrees;               // How many TPs each variable appears in
@@ -34,15 +46,41 @@ namespace dice::endpoint {
 		std::string to_json() const;
 	};
 
+	/**
+	 * Extracts the features of a query for the learned planner. The cardinality features come from TripleStore::estimate, so
+	 * they are looked up in the dataset statistics instead of being computed on the operands.
+	 */
+	QueryFeatures extract_query_features(triple_store::TripleStore const &triplestore, const sparql2tensor::SPARQLQuery &sparql_query);
+
+	/**
+	 * Sends the features of a query to the learned planner.
+	 * @param timeout how long to wait for the planner; unlimited if not set
+	 * @return the response of the planner; empty if it did not answer
+	 */
+	std::string send_query_features_to_api(const QueryFeatures &features, std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+	/**
+	 * @param api_response a response of the learned planner
+	 * @return the variable order of the plan in the response
+	 * @throws nlohmann::json::exception if the response is no plan
+	 */
+	std::vector<std::string> parse_query_plan(const std::string &api_response);
+
 	class SPARQLEndpoint final : public Endpoint {
 	public:
-		SPARQLEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, EndpointCfg const &endpoint_cfg);
+		SPARQLEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, ResultCache &result_cache, QueryScheduler &scheduler, EndpointCfg const &endpoint_cfg);
 
 	protected:
 		void handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) override;
 	private:
-		QueryFeatures extract_query_features(const sparql2tensor::SPARQLQuery &sparql_query,
-										   std::chrono::steady_clock::time_point timeout);
+		/**
+		 * Evaluates a planned query, responds with its result and offers the result to the result cache. A SELECT query yields
+		 * whenever a time slice is over; ASK and COUNT queries are evaluated in a single slice.
+		 * @param compute_start_time when computing the result started; the cost of the result for the result cache counts from here
+		 */
+		Evaluation evaluate_query(restinio::request_handle_t req, RequestedQuery sparql_query, std::vector<std::string> query_plan,
+								  std::optional<QueryProfile> profile, std::string result_key, uint64_t generation,
+								  std::chrono::steady_clock::time_point compute_start_time, std::chrono::steady_clock::time_point timeout);
 
 
 	};
@@ -1,6 +1,7 @@
 #ifndef TENTRIS_SPARQLJSONRESULTSAXWRITER_HPP
 #define TENTRIS_SPARQLJSONRESULTSAXWRITER_HPP
 
+#include <string>
 #include <utility>
 
 #define RAPIDJSON_HAS_STDSTRING 1
@@ -26,28 +27,55 @@ namespace dice::endpoint {
 		using Variable = rdf4cpp::rdf::query::Variable;
 		using Entry = dice::rdf_tensor::Entry;
 
+		/**
+		 * rapidjson output stream that writes into a std::string, so the written JSON can be handed out without copying it.
+		 */
+		struct StringOutputStream {
+			using Ch = char;
+
+			std::string str;
+
+			void Put(char c) { str.push_back(c); }
+
+			void Flush() {}
+		};
+
 		std::size_t number_of_solutions_ = 0;
 		std::size_t number_of_bindings_ = 0;
 
 		size_t buffer_size;
-		rapidjson::StringBuffer buffer;
-		rapidjson::Writer<rapidjson::StringBuffer> writer;
+		StringOutputStream buffer;
+		rapidjson::Writer<StringOutputStream> writer;
 
 		std::vector<std::string> variables_;
 
 		inline static auto to_rapidjson(std::string_view view) {
 			return rapidjson::GenericStringRef<char>(view.data() ? view.data() : "", view.size());
 		}
+
+		static std::vector<std::string> names_of(const std::vector<Variable> &variables) {
+			std::vector<std::string> names;
+			names.reserve(variables.size());
+			for (auto const &var : variables)
+				names.emplace_back(var.name());
+			return names;
+		}
+
 	public:
 		explicit SparqlJsonResultSAXWriter(const std::vector<Variable>& variables, size_t buffer_size)
+			: SparqlJsonResultSAXWriter(names_of(variables), buffer_size) {}
+
+		/**
+		 * @param variable_names names (without ?) of the result variables in the order of the entries' keys
+		 * @param buffer_size number of bytes after which the writer reports to be full()
+		 */
+		explicit SparqlJsonResultSAXWriter(std::vector<std::string> variable_names, size_t buffer_size)
 			: buffer_size(buffer_size),
-			  buffer(nullptr, size_t(buffer_size * 1.3)),
-			  writer(buffer) {
+			  writer(buffer),
+			  variables_(std::move(variable_names)) {
+			buffer.str.reserve(size_t(buffer_size * 1.3));
 			writer.StartObject();
 			writer.Key("head");
-			for (auto const &var : variables) {
-				variables_.emplace_back(var.name());
-			}
 			{
 				writer.StartObject();
 				writer.Key("vars");
@@ -125,7 +153,7 @@ namespace dice::endpoint {
 		}
 
 		[[nodiscard]] std::size_t size() const {
-			return buffer.GetSize();
+			return buffer.str.size();
 		}
 
 		[[nodiscard]] std::size_t number_of_written_solutions() const {
@@ -137,16 +165,26 @@ namespace dice::endpoint {
 		}
 
 		[[nodiscard]] bool full() const {
-			return buffer.GetSize() > this->buffer_size;
+			return buffer.str.size() > this->buffer_size;
 		};
 
 		std::string_view string_view() {
-			writer.Flush();
-			return {buffer.GetString(), buffer.GetSize()};
+			return buffer.str;
+		}
+
+		/**
+		 * Hands out the JSON written so far and clears the writer's buffer.
+		 * @return the written JSON
+		 */
+		std::string release() {
+			std::string released = std::move(buffer.str);
+			buffer.str = {};
+			buffer.str.reserve(size_t(buffer_size * 1.3));
+			return released;
 		}
 
 		void clear() {
-			this->buffer.Clear();
+			this->buffer.str.clear();
 		}
 	};
 }// namespace dice::endpoint
@@ -2,16 +2,23 @@
 #define TENTRIS_SPARQLSTREAMINGENDPOINT_HPP
 
 #include <dice/endpoint/Endpoint.hpp>
+#include <dice/endpoint/ParseSPARQLQueryParam.hpp>
 
 namespace dice::endpoint {
 
     class SPARQLStreamingEndpoint final : public Endpoint {
 
     public:
-        SPARQLStreamingEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, EndpointCfg const &endpoint_cfg);
+        SPARQLStreamingEndpoint(tf::Executor &executor, triple_store::TripleStore &triplestore, SparqlQueryCache &sparql_query_cache, ResultCache &result_cache, QueryScheduler &scheduler, EndpointCfg const &endpoint_cfg);
 
     protected:
         void handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) override;
+
+    private:
+        /**
+         * Evaluates a query and streams its solutions in chunks. It yields whenever a time slice is over.
+         */
+        Evaluation stream_query(restinio::request_handle_t req, RequestedQuery sparql_query, std::chrono::steady_clock::time_point timeout);
     };
 }// namespace dice::endpoint
 
@@ -0,0 +1,323 @@
+#ifndef TENTRIS_CONCURRENTQUERYCACHE_HPP
+#define TENTRIS_CONCURRENTQUERYCACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include <robin_hood.h>
+#include <spdlog/spdlog.h>
+
+#include <dice/hash/DiceHash.hpp>
+
+#include <dice/endpoint/FrequencySketch.hpp>
+
+namespace dice::endpoint {
+
+	/**
+	 * Counters of a ConcurrentQueryCache.
+	 */
+	struct QueryCacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		// values that were built but not admitted into the cache
+		size_t rejected = 0;
+		size_t evicted = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+	};
+
+	/**
+	 * Default weigher: the size of the value object and the key.
+	 */
+	template<class Key, class Value>
+	struct DefaultCacheWeigher {
+		size_t operator()(Key const &key, [[maybe_unused]] Value const &value) const noexcept {
+			return sizeof(Value) + sizeof(Key) + key.size();
+		}
+	};
+
+	/**
+	 * Lock-striped cache that constructs values from their keys.
+	 *
+	 * Recency is tracked with CLOCK: a hit only sets the reference bit of its entry if it is not yet set, and takes a shared lock of its shard.
+	 * New values are admitted with TinyLFU: if the shard is full, a value is only cached if its key was accessed more often recently than the eviction victim.
+	 * So one-off queries cannot flush frequently used ones.
+	 * Every miss is recorded in the frequency sketch, but only every hit_sample_rate-th hit of a thread is, with that weight. Hits are
+	 * counted per thread. So a hit on a hot key usually writes no memory that other threads read.
+	 *
+	 * Values are built outside of the locks. Concurrent requests for a key that is being built wait for that build (single-flight).
+	 * If the build throws, the exception is rethrown to all waiting requests and nothing is cached.
+	 * @tparam Key key type; must be hashable with dice::hash::DiceHashMartinus
+	 * @tparam Value value type; must be constructible from Key
+	 * @tparam Weigher function (Key, Value) -> size in bytes of an entry
+	 */
+	template<class Key, class Value, class Weigher = DefaultCacheWeigher<Key, Value>>
+	class ConcurrentQueryCache {
+		using value_ptr = std::shared_ptr<Value const>;
+		using future_type = std::shared_future<value_ptr>;
+		using hash_type = dice::hash::DiceHashMartinus<Key>;
+
+		static constexpr size_t shard_bits = 4;
+		static constexpr size_t shard_count = size_t(1) << shard_bits;
+		static constexpr uint8_t hit_sample_rate = 8;
+		static constexpr size_t hit_counter_count = 64;
+
+		struct Entry {
+			value_ptr value;
+			size_t hash;
+			size_t bytes;
+			size_t ring_index;
+			mutable std::atomic<bool> referenced{false};
+		};
+
+		using entry_map = robin_hood::unordered_node_map<Key, Entry, hash_type>;
+		using entry_node = typename entry_map::value_type;
+
+		struct alignas(64) Shard {
+			mutable std::shared_mutex mutex;
+			entry_map entries;
+			// CLOCK ring over the entries
+			std::vector<entry_node *> ring;
+			size_t hand = 0;
+			size_t bytes = 0;
+			// values that are currently built
+			robin_hood::unordered_map<Key, future_type, hash_type> in_flight;
+			size_t misses = 0;
+			size_t rejected = 0;
+			size_t evicted = 0;
+		};
+
+		size_t const max_entries_;
+		size_t const max_bytes_;
+		size_t const max_shard_entries_;
+		size_t const max_shard_bytes_;
+		std::unique_ptr<Shard[]> shards_;
+		FrequencySketch sketch_;
+
+		struct alignas(64) HitCounter {
+			std::atomic<size_t> hits{0};
+		};
+		// each thread counts its hits in its own counter, unless there are more threads than counters
+		std::unique_ptr<HitCounter[]> hit_counters_;
+		static inline std::atomic<size_t> next_hit_counter_{0};
+
+		[[nodiscard]] static size_t shard_index(size_t hash) noexcept {
+			// the maps within the shards use the lower bits
+			return hash >> (std::numeric_limits<size_t>::digits - shard_bits);
+		}
+
+		static void touch(Entry const &entry) noexcept {
+			if (not entry.referenced.load(std::memory_order_relaxed))
+				entry.referenced.store(true, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Counts a hit in the counter of the calling thread and records every hit_sample_rate-th hit of the thread in the sketch.
+		 */
+		void count_hit(size_t hash) noexcept {
+			static thread_local size_t const hit_counter = next_hit_counter_.fetch_add(1, std::memory_order_relaxed) % hit_counter_count;
+			static thread_local uint8_t unsampled_hits = 0;
+			auto &counter = hit_counters_[hit_counter].hits;
+			// only this thread writes the counter, unless there are more threads than counters
+			counter.fetch_add(1, std::memory_order_relaxed);
+			if (++unsampled_hits == hit_sample_rate) {
+				unsampled_hits = 0;
+				sketch_.increment(hash, hit_sample_rate);
+			}
+		}
+
+		/**
+		 * Moves the clock hand to the next entry without reference bit. The unique lock of the shard must be held and the shard must not be empty.
+		 */
+		static entry_node *clock_victim(Shard &shard) noexcept {
+			while (true) {
+				if (shard.hand >= shard.ring.size())
+					shard.hand = 0;
+				auto *node = shard.ring[shard.hand];
+				if (not node->second.referenced.load(std::memory_order_relaxed))
+					return node;
+				node->second.referenced.store(false, std::memory_order_relaxed);
+				++shard.hand;
+			}
+		}
+
+		static void evict(Shard &shard, entry_node *node) noexcept {
+			auto const ring_index = node->second.ring_index;
+			shard.ring[ring_index] = shard.ring.back();
+			shard.ring[ring_index]->second.ring_index = ring_index;
+			shard.ring.pop_back();
+			shard.bytes -= node->second.bytes;
+			++shard.evicted;
+			shard.entries.erase(node->first);
+		}
+
+		/**
+		 * Inserts a built value if the admission policy accepts it. The unique lock of the shard must be held.
+		 */
+		void admit(Shard &shard, Key const &key, size_t hash, value_ptr const &value) {
+			size_t const bytes = Weigher{}(key, *value);
+			if (bytes > max_shard_bytes_) {
+				++shard.rejected;
+				return;
+			}
+			auto const frequency = sketch_.frequency(hash);
+			while (not shard.ring.empty() and (shard.entries.size() >= max_shard_entries_ or shard.bytes + bytes > max_shard_bytes_)) {
+				auto *victim = clock_victim(shard);
+				if (frequency <= sketch_.frequency(victim->second.hash)) {
+					++shard.rejected;
+					return;
+				}
+				evict(shard, victim);
+			}
+			auto [iter, inserted] = shard.entries.try_emplace(key);
+			if (not inserted)
+				return;
+			auto &entry = iter->second;
+			entry.value = value;
+			entry.hash = hash;
+			entry.bytes = bytes;
+			entry.ring_index = shard.ring.size();
+			shard.ring.push_back(&*iter);
+			shard.bytes += bytes;
+		}
+
+	public:
+		/**
+		 * @param max_entries maximum number of cached values
+		 * @param max_bytes maximum total size of the cached values as estimated by Weigher
+		 */
+		explicit ConcurrentQueryCache(size_t max_entries = 1000, size_t max_bytes = size_t(256) << 20)
+			: max_entries_(std::max<size_t>(max_entries, 1)),
+			  max_bytes_(std::max<size_t>(max_bytes, 1)),
+			  max_shard_entries_((max_entries_ + shard_count - 1) / shard_count),
+			  max_shard_bytes_((max_bytes_ + shard_count - 1) / shard_count),
+			  shards_(std::make_unique<Shard[]>(shard_count)),
+			  sketch_(max_entries_),
+			  hit_counters_(std::make_unique<HitCounter[]>(hit_counter_count)) {}
+
+		// Disallow copying.
+		ConcurrentQueryCache(ConcurrentQueryCache const &) = delete;
+
+		ConcurrentQueryCache &operator=(ConcurrentQueryCache const &) = delete;
+
+		/**
+		 * Returns the value for key and builds it on a miss.
+		 * @throws any exception that is thrown by constructing Value from key
+		 */
+		[[nodiscard]] value_ptr operator[](Key const &key) {
+			auto const hash = hash_type{}(key);
+			auto &shard = shards_[shard_index(hash)];
+			{
+				std::shared_lock<std::shared_mutex> lock{shard.mutex};
+				if (auto iter = shard.entries.find(key); iter != shard.entries.end()) {
+					touch(iter->second);
+					count_hit(hash);
+					return iter->second.value;
+				}
+			}
+
+			std::promise<value_ptr> promise;
+			future_type future;
+			{
+				std::unique_lock<std::shared_mutex> lock{shard.mutex};
+				if (auto iter = shard.entries.find(key); iter != shard.entries.end()) {
+					touch(iter->second);
+					count_hit(hash);
+					return iter->second.value;
+				}
+				++shard.misses;
+				sketch_.increment(hash);
+				if (auto iter = shard.in_flight.find(key); iter != shard.in_flight.end()) {
+					future = iter->second;
+				} else {
+					shard.in_flight.emplace(key, promise.get_future().share());
+				}
+			}
+			if (future.valid())// another request builds the value
+				return future.get();
+
+			value_ptr value;
+			try {
+				value = std::make_shared<Value const>(key);
+			} catch (...) {
+				promise.set_exception(std::current_exception());
+				std::unique_lock<std::shared_mutex> lock{shard.mutex};
+				shard.in_flight.erase(key);
+				throw;
+			}
+			promise.set_value(value);
+			{
+				std::unique_lock<std::shared_mutex> lock{shard.mutex};
+				shard.in_flight.erase(key);
+				admit(shard, key, hash, value);
+			}
+			spdlog::trace("Query cache: built value for a key with {} bytes", key.size());
+			return value;
+		}
+
+		/**
+		 * @param n maximum number of keys to return
+		 * @return the cached keys with their estimated recent access counts, most frequently accessed first
+		 */
+		[[nodiscard]] std::vector<std::pair<Key, size_t>> hottest(size_t n) const {
+			std::vector<std::pair<Key, size_t>> keys;
+			for (size_t i = 0; i < shard_count; ++i) {
+				auto &shard = shards_[i];
+				std::shared_lock<std::shared_mutex> lock{shard.mutex};
+				for (auto const &[key, entry] : shard.entries)
+					keys.emplace_back(key, sketch_.frequency(entry.hash));
+			}
+			auto const count = std::min(n, keys.size());
+			std::ranges::partial_sort(keys, keys.begin() + count, [](auto const &lhs, auto const &rhs) { return lhs.second > rhs.second; });
+			keys.resize(count);
+			return keys;
+		}
+
+		void clear() noexcept {
+			for (size_t i = 0; i < shard_count; ++i) {
+				auto &shard = shards_[i];
+				std::unique_lock<std::shared_mutex> lock{shard.mutex};
+				shard.entries.clear();
+				shard.ring.clear();
+				shard.hand = 0;
+				shard.bytes = 0;
+			}
+		}
+
+		[[nodiscard]] QueryCacheStats stats() const noexcept {
+			QueryCacheStats stats;
+			for (size_t i = 0; i < hit_counter_count; ++i)
+				stats.hits += hit_counters_[i].hits.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < shard_count; ++i) {
+				auto &shard = shards_[i];
+				std::shared_lock<std::shared_mutex> lock{shard.mutex};
+				stats.misses += shard.misses;
+				stats.rejected += shard.rejected;
+				stats.evicted += shard.evicted;
+				stats.entries += shard.entries.size();
+				stats.bytes += shard.bytes;
+			}
+			return stats;
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return stats().entries; }
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		[[nodiscard]] size_t max_entries() const noexcept { return max_entries_; }
+
+		[[nodiscard]] size_t max_bytes() const noexcept { return max_bytes_; }
+	};
+
+}// namespace dice::endpoint
+
+#endif//TENTRIS_CONCURRENTQUERYCACHE_HPP
@@ -2,14 +2,17 @@
 #include <spdlog/spdlog.h>
 
 #include <dice/endpoint/ParseSPARQLQueryParam.hpp>
+#include <dice/endpoint/TimeoutCheck.hpp>
 
 namespace dice::endpoint {
 
     CountEndpoint::CountEndpoint(tf::Executor &executor,
                                  triple_store::TripleStore &triplestore,
                                  SparqlQueryCache &sparql_query_cache,
+                                 ResultCache &result_cache,
+                                 QueryScheduler &scheduler,
                                  EndpointCfg const &endpoint_cfg)
-        : Endpoint(executor, triplestore, sparql_query_cache, endpoint_cfg) {}
+        : Endpoint(executor, triplestore, sparql_query_cache, result_cache, scheduler, endpoint_cfg) {}
 
     void CountEndpoint::handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) {
         using namespace dice::sparql2tensor;
@@ -19,11 +22,35 @@ namespace dice::endpoint {
         if (not sparql_query)
             return;
 
+        auto const generation = this->triplestore_.generation();
+        auto result_key = sparql_query.result_key("count");
+        if (auto cached = this->result_cache_.find(result_key, generation)) {
+            req->create_response(status_ok())
+                    .set_body(std::move(cached))
+                    .done();
+            spdlog::info("HTTP response {}: served from the result cache", status_ok());
+            return;
+        }
+
+        auto const cost = this->estimate_cost(*sparql_query);
+        this->evaluate(req, cost, timeout, count_query(req, std::move(sparql_query), std::move(result_key), generation, timeout));
+    }
+
+    Endpoint::Evaluation CountEndpoint::count_query(restinio::request_handle_t req, RequestedQuery sparql_query, std::string result_key,
+                                                    uint64_t generation, std::chrono::steady_clock::time_point timeout) {
+        using namespace restinio;
+
+        // the query may have waited for the scheduler
+        check_timeout(timeout);
+        auto const start_time = std::chrono::steady_clock::now();
         auto const count = this->triplestore_.count(*sparql_query, timeout);
+        auto body = std::make_shared<std::string const>(fmt::format("{}", count));
+        this->result_cache_.offer(result_key, body, std::chrono::steady_clock::now() - start_time, generation);
 
         req->create_response(status_ok())
-                .set_body(fmt::format("{}", count))
+                .set_body(std::move(body))
                 .done();
         spdlog::info("HTTP response {}: counted {} results", status_ok(), count);
+        co_return;
     }
 }// namespace dice::endpoint
\ No newline at end of file
@@ -1,15 +1,86 @@
 #include "dice/endpoint/Endpoint.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string_view>
+
 namespace dice::endpoint {
     Endpoint::Endpoint(tf::Executor &executor,
                        triple_store::TripleStore &triplestore,
                        SparqlQueryCache &sparql_query_cache,
+                       ResultCache &result_cache,
+                       QueryScheduler &scheduler,
                        EndpointCfg const &endpoint_cfg)
         : executor_{executor},
           triplestore_{triplestore},
           sparql_query_cache_{sparql_query_cache},
+          result_cache_{result_cache},
+          scheduler_{scheduler},
           cfg_{endpoint_cfg} {}// endpoint
 
+    void Endpoint::respond_timeout(restinio::request_handle_t const &req) const {
+        const auto timeout_message = fmt::format("Request processing timed out after {}.",
+                                                 this->cfg_.opt_timeout_duration.value());
+        spdlog::warn("HTTP response {}: {}", restinio::status_gateway_time_out(), timeout_message);
+        req->create_response(restinio::status_gateway_time_out())
+                .connection_close()
+                .set_body(timeout_message)
+                .done();
+    }
+
+    void Endpoint::respond_failure(restinio::request_handle_t const &req, std::chrono::steady_clock::time_point timeout,
+                                   std::string_view detail) const {
+        // timeouts are thrown by several libraries as std::runtime_error; they are recognized by the time
+        if (timeout <= std::chrono::steady_clock::now()) {
+            this->respond_timeout(req);
+            return;
+        }
+        constexpr std::string_view failure_message = "Processing the request failed.";
+        spdlog::error("HTTP response {}: {} (detail: {})", restinio::status_internal_server_error(), failure_message, detail);
+        req->create_response(restinio::status_internal_server_error())
+                .connection_close()
+                .set_body(failure_message)
+                .done();
+    }
+
+    double Endpoint::estimate_cost(sparql2tensor::SPARQLQuery const &query) const {
+        try {
+            return this->triplestore_.estimate(query).total();
+        } catch (std::exception const &ex) {
+            spdlog::debug("Estimating the cost of a query failed: {}", ex.what());
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    void Endpoint::evaluate(restinio::request_handle_t req, double cost, std::chrono::steady_clock::time_point timeout, Evaluation evaluation) {
+        if (not this->scheduler_.is_expensive(cost)) {
+            this->scheduler_.count_cheap();
+            for ([[maybe_unused]] auto const &slice_end : evaluation) {
+            }
+            return;
+        }
+        spdlog::debug("Scheduling an expensive query with an estimated cost of {}.", cost);
+        this->scheduler_.schedule(cost, [this, req = std::move(req), timeout, evaluation = std::move(evaluation),
+                                         position = std::optional<std::ranges::iterator_t<Evaluation>>{}]() mutable {
+            // the request is answered here, because nobody else is left to answer it
+            try {
+                if (not position)
+                    position = evaluation.begin();
+                else
+                    ++*position;
+                return *position == evaluation.end();
+            } catch (std::exception const &ex) {
+                this->respond_failure(req, timeout, ex.what());
+            } catch (...) {
+                this->respond_failure(req, timeout, "unknown exception");
+            }
+            return true;
+        });
+    }
+
 
     restinio::request_handling_status_t Endpoint::operator()(
             restinio::request_handle_t req,
@@ -20,15 +91,11 @@ namespace dice::endpoint {
         if (executor_.num_topologies() < executor_.num_workers()) {
             executor_.silent_async([req = std::move(req), this, timeout]() mutable {
                 try {
-                    this->handle_query(std::move(req), timeout);
-                } catch (std::runtime_error const &) {
-                    const auto timeout_message = fmt::format("Request processing timed out after {}.",
-                                                             this->cfg_.opt_timeout_duration.value());
-                    spdlog::warn("HTTP response {}: {}", restinio::status_gateway_time_out(), timeout_message);
-                    req->create_response(restinio::status_gateway_time_out())
-                            .connection_close()
-                            .set_body(timeout_message)
-                            .done();
+                    this->handle_query(req, timeout);
+                } catch (std::exception const &ex) {
+                    this->respond_failure(req, timeout, ex.what());
+                } catch (...) {
+                    this->respond_failure(req, timeout, "unknown exception");
                 }
             });
             spdlog::debug("Request was accepted.");
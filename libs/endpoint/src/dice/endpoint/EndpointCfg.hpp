@@ -2,7 +2,9 @@
 #define ENDOINTCFG_HPP
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <optional>
 
 namespace dice::endpoint {
@@ -11,6 +13,22 @@ namespace dice::endpoint {
         uint16_t port;
         uint16_t threads;
         std::optional<std::chrono::steady_clock::duration> opt_timeout_duration;
+        // limits of the cache of parsed queries
+        size_t query_cache_max_entries = 1000;
+        size_t query_cache_max_bytes = size_t(256) << 20;
+        // limits of the cache of response bodies; 0 bytes disables it. Results that are computed faster than the minimum cost are not cached.
+        size_t result_cache_max_bytes = size_t(512) << 20;
+        std::chrono::steady_clock::duration result_cache_min_cost = std::chrono::milliseconds{10};
+        // the hottest cached queries are written to this file on shutdown and parsed again on startup
+        std::optional<std::filesystem::path> warmup_file;
+        size_t warmup_max_queries = 1000;
+        // additionally evaluate the warm-up queries to fault in the index pages they touch
+        bool warmup_evaluate = false;
+        // queries whose estimated number of solutions reaches this are expensive. At most threads - reserved_threads expensive
+        // queries are evaluated at a time, cheapest first, and they may be suspended after each time slice.
+        double expensive_query_cardinality = 1'000'000;
+        uint16_t reserved_threads = 0;
+        std::chrono::steady_clock::duration time_slice = std::chrono::milliseconds{100};
     };
 }// namespace dice::endpoint
 #endif//ENDOINTCFG_HPP
\ No newline at end of file
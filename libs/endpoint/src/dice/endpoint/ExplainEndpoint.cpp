@@ -0,0 +1,246 @@
+#include "dice/endpoint/ExplainEndpoint.hpp"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <spdlog/spdlog.h>
+
+#include <dice/endpoint/ParseSPARQLQueryParam.hpp>
+#include <dice/endpoint/SparqlEndpoint.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <optional>
+
+namespace dice::endpoint {
+    namespace {
+        using JsonWriter = rapidjson::Writer<rapidjson::StringBuffer>;
+
+        void write_string(JsonWriter &json, std::string_view str) {
+            json.String(str.data(), rapidjson::SizeType(str.size()));
+        }
+
+        // JSON has no NaN or infinity
+        void write_double(JsonWriter &json, double d) {
+            if (std::isfinite(d))
+                json.Double(d);
+            else
+                json.Null();
+        }
+
+        /**
+         * @param sparql_query the query
+         * @param operands the number of operands of the query
+         * @return the operands grouped into connected components, where operands are connected if they share a variable
+         */
+        std::vector<std::vector<size_t>> operand_components(sparql2tensor::SPARQLQuery const &sparql_query, size_t operands) {
+            std::vector<size_t> parent(operands);
+            std::iota(parent.begin(), parent.end(), size_t(0));
+            auto const find = [&parent](size_t operand) {
+                while (parent[operand] != operand)
+                    operand = parent[operand] = parent[parent[operand]];
+                return operand;
+            };
+            std::map<char, size_t> first_operand;
+            for (size_t operand = 0; operand < operands; ++operand) {
+                for (auto const var_id : sparql_query.odg_.operand_var_ids(operand)) {
+                    auto const [first, inserted] = first_operand.emplace(var_id, operand);
+                    if (not inserted)
+                        parent[find(operand)] = find(first->second);
+                }
+            }
+            std::vector<std::vector<size_t>> components;
+            std::vector<size_t> component_of(operands, operands);
+            for (size_t operand = 0; operand < operands; ++operand) {
+                auto const root = find(operand);
+                if (component_of[root] == operands) {
+                    component_of[root] = components.size();
+                    components.emplace_back();
+                }
+                components[component_of[root]].push_back(operand);
+            }
+            return components;
+        }
+    }// namespace
+
+    ExplainEndpoint::ExplainEndpoint(tf::Executor &executor,
+                                     triple_store::TripleStore &triplestore,
+                                     SparqlQueryCache &sparql_query_cache,
+                                     ResultCache &result_cache,
+                                     QueryScheduler &scheduler,
+                                     EndpointCfg const &endpoint_cfg)
+        : Endpoint(executor, triplestore, sparql_query_cache, result_cache, scheduler, endpoint_cfg) {}
+
+    std::optional<std::vector<std::string>> ExplainEndpoint::planned_variable_order(RequestedQuery const &sparql_query,
+                                                                                    std::chrono::steady_clock::time_point timeout) {
+        auto const generation = this->triplestore_.generation();
+        {
+            std::unique_lock lock{planner_cache_->mutex};
+            auto const cached = planner_cache_->plans.find(sparql_query.query_key);
+            if (cached != planner_cache_->plans.end() and cached->second.first == generation)
+                return cached->second.second;
+        }
+        auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(timeout - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+            return std::nullopt;
+        std::vector<std::string> plan;
+        try {
+            auto const response = send_query_features_to_api(extract_query_features(this->triplestore_, *sparql_query),
+                                                             std::min(remaining, planner_timeout));
+            if (response.empty())
+                return std::nullopt;
+            plan = parse_query_plan(response);
+        } catch (std::exception const &ex) {
+            spdlog::debug("The learned planner gave no variable order: {}", ex.what());
+            return std::nullopt;
+        }
+        std::unique_lock lock{planner_cache_->mutex};
+        auto &plans = planner_cache_->plans;
+        // the cache only spares repeated explanations of a query the planner, so it simply starts over when it is full
+        if (plans.size() >= PlannerCache::max_entries and plans.count(sparql_query.query_key) == 0)
+            plans.clear();
+        plans[sparql_query.query_key] = {generation, plan};
+        return plan;
+    }
+
+    void ExplainEndpoint::handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) {
+        using namespace restinio;
+
+        auto const start_time = std::chrono::steady_clock::now();
+        auto sparql_query = parse_sparql_query_param(req, this->sparql_query_cache_);
+        if (not sparql_query)
+            return;
+
+        rapidjson::StringBuffer buffer;
+        JsonWriter json{buffer};
+        json.StartObject();
+
+        // the estimate uses the dataset statistics, counts the rows of VALUES blocks and estimates property paths without following them
+        std::optional<triple_store::QueryEstimate> estimate;
+        std::string estimation_error;
+        try {
+            estimate = this->triplestore_.estimate(*sparql_query);
+        } catch (std::exception const &ex) {
+            estimation_error = ex.what();
+        }
+        auto const *statistics = this->triplestore_.statistics();
+        json.Key("triple_patterns");
+        json.StartArray();
+        for (size_t tp = 0; tp < sparql_query->triple_patterns_.size(); ++tp) {
+            auto const &triple_pattern = sparql_query->triple_patterns_[tp];
+            auto const &slice_key = sparql_query->get_slice_keys()[tp];
+            json.StartObject();
+            json.Key("subject");
+            write_string(json, std::string(triple_pattern.subject()));
+            json.Key("predicate");
+            write_string(json, std::string(triple_pattern.predicate()));
+            json.Key("object");
+            write_string(json, std::string(triple_pattern.object()));
+            json.Key("matches");
+            // slices of the stored hypertrie are views, so the matches are counted exactly
+            if (slice_key.get_fixed_depth() == 3)
+                json.Uint64(std::get<bool>(this->triplestore_.get_hypertrie()[slice_key]) ? 1 : 0);
+            else
+                json.Uint64(std::get<rdf_tensor::const_BoolHypertrie>(this->triplestore_.get_hypertrie()[slice_key]).size());
+            if (statistics != nullptr) {
+                json.Key("estimated_matches");
+                write_double(json, statistics->estimate_matches(slice_key));
+            }
+            json.EndObject();
+        }
+        json.EndArray();
+        json.Key("values_blocks");
+        json.Uint64(sparql_query->values_.size());
+        json.Key("path_patterns");
+        json.Uint64(sparql_query->path_patterns_.size());
+        // property paths are explained by their estimates from the statistics of their predicates; they are not followed
+        json.Key("paths");
+        json.StartArray();
+        for (size_t path = 0; path < sparql_query->path_patterns_.size(); ++path) {
+            auto const &path_pattern = sparql_query->path_patterns_[path];
+            json.StartObject();
+            json.Key("subject");
+            write_string(json, std::string(path_pattern.subject));
+            json.Key("object");
+            write_string(json, std::string(path_pattern.object));
+            json.Key("nullable");
+            json.Bool(path_pattern.path.nullable());
+            json.Key("estimated_matches");
+            if (estimate)
+                write_double(json, estimate->operands()[sparql_query->triple_patterns_.size() + sparql_query->values_.size() + path].matches);
+            else
+                json.Null();
+            json.EndObject();
+        }
+        json.EndArray();
+
+        json.Key("operand_components");
+        json.StartArray();
+        auto const operands = sparql_query->triple_patterns_.size() + sparql_query->values_.size() + sparql_query->path_patterns_.size();
+        for (auto const &component : operand_components(*sparql_query, operands)) {
+            json.StartArray();
+            for (auto const operand : component)
+                json.Uint64(operand);
+            json.EndArray();
+        }
+        json.EndArray();
+        json.Key("union_branches");
+        json.Uint64(sparql_query->union_branches_.size());
+
+        // /sparql asks the learned planner for the variable order, except for COUNT aggregates, which need no plan. Without its plan,
+        // the evaluation starts with the variable with the smallest estimate, so the variables are reported in ascending order of
+        // their estimates.
+        auto const planned_order = (sparql_query->count_) ? std::nullopt : this->planned_variable_order(sparql_query, timeout);
+        json.Key("variable_order_source");
+        write_string(json, (planned_order) ? "planner" : "default");
+        if (planned_order) {
+            json.Key("variable_order");
+            json.StartArray();
+            for (auto const &name : *planned_order)
+                write_string(json, name);
+            json.EndArray();
+        }
+        if (estimate) {
+            std::vector<std::pair<double, std::string>> estimates;
+            for (auto const &[var, var_id] : sparql_query->var_to_id_) {
+                auto const cardinality = std::ranges::find(estimate->variable_cardinalities(), var_id, &std::pair<char, double>::first);
+                estimates.emplace_back(cardinality->second, std::string(var.name()));
+            }
+            std::ranges::sort(estimates);
+            if (not planned_order) {
+                json.Key("variable_order");
+                json.StartArray();
+                for (auto const &[cardinality, name] : estimates)
+                    write_string(json, name);
+                json.EndArray();
+            }
+            json.Key("variable_cardinalities");
+            json.StartObject();
+            for (auto const &[cardinality, name] : estimates) {
+                json.Key(name.data(), rapidjson::SizeType(name.size()));
+                write_double(json, cardinality);
+            }
+            json.EndObject();
+            json.Key("total_cardinality");
+            write_double(json, estimate->total());
+        } else {
+            json.Key("estimation_error");
+            write_string(json, estimation_error);
+        }
+
+        json.Key("trivially_empty");
+        json.Bool(this->triplestore_.has_empty_mandatory_operand(*sparql_query));
+        json.Key("result_cached");
+        json.Bool(this->result_cache_.contains(sparql_query.result_key("sparql"), this->triplestore_.generation()));
+        json.Key("explain_time_us");
+        json.Uint64(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count()));
+        json.EndObject();
+
+        req->create_response(status_ok())
+                .append_header(http_field::content_type, "application/json")
+                .set_body(std::string{buffer.GetString(), buffer.GetSize()})
+                .done();
+        spdlog::info("HTTP response {}: explained a query with {} triple patterns", status_ok(), sparql_query->triple_patterns_.size());
+    }
+}// namespace dice::endpoint
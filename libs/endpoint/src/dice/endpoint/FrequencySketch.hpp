@@ -0,0 +1,82 @@
+#ifndef TENTRIS_FREQUENCYSKETCH_HPP
+#define TENTRIS_FREQUENCYSKETCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dice::endpoint {
+
+	/**
+	 * Count-min sketch with small saturating counters that estimates how often a key was accessed recently (TinyLFU).
+	 * After sample_size increments all counters are halved, so old popularity fades out.
+	 *
+	 * The counters are relaxed atomics and updates may be lost under contention; the estimate is approximate anyway.
+	 * Saturated counters are not written, so accesses to very hot keys only read the sketch.
+	 */
+	class FrequencySketch {
+		static constexpr size_t depth = 4;
+		static constexpr uint8_t max_count = 15;
+		static constexpr uint64_t seeds[depth] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+		std::vector<std::atomic<uint8_t>> counters_;
+		size_t width_mask_;
+		size_t sample_size_;
+		std::atomic<size_t> additions_{0};
+
+		[[nodiscard]] size_t index(size_t hash, size_t row) const noexcept {
+			uint64_t x = (hash + seeds[row]) * seeds[(row + 1) % depth];
+			x ^= x >> 32;
+			return row * (width_mask_ + 1) + (x & width_mask_);
+		}
+
+		void age() noexcept {
+			for (auto &counter : counters_)
+				counter.store(counter.load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+			// subtract instead of overwriting, so that concurrent increments are not lost and the threshold is hit again
+			additions_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+		}
+
+	public:
+		/**
+		 * @param expected_entries number of entries of the cache that the sketch is used for
+		 */
+		explicit FrequencySketch(size_t expected_entries)
+			: counters_(depth * std::bit_ceil(std::max<size_t>(expected_entries * 4, 64))),
+			  width_mask_(counters_.size() / depth - 1),
+			  sample_size_(std::max<size_t>(expected_entries * 10, 64)) {}
+
+		/**
+		 * Records weight accesses of a key. Callers that only record every n-th access pass n as weight.
+		 */
+		void increment(size_t hash, uint8_t weight = 1) noexcept {
+			bool added = false;
+			for (size_t row = 0; row < depth; ++row) {
+				auto &counter = counters_[index(hash, row)];
+				auto const count = counter.load(std::memory_order_relaxed);
+				if (count < max_count) {
+					counter.store(uint8_t(std::min<size_t>(size_t(count) + weight, max_count)), std::memory_order_relaxed);
+					added = true;
+				}
+			}
+			if (not added)
+				return;
+			auto const additions = additions_.fetch_add(weight, std::memory_order_relaxed);
+			if (additions < sample_size_ and additions + weight >= sample_size_)
+				age();
+		}
+
+		[[nodiscard]] uint8_t frequency(size_t hash) const noexcept {
+			uint8_t frequency = max_count;
+			for (size_t row = 0; row < depth; ++row)
+				frequency = std::min(frequency, counters_[index(hash, row)].load(std::memory_order_relaxed));
+			return frequency;
+		}
+	};
+
+}// namespace dice::endpoint
+
+#endif//TENTRIS_FREQUENCYSKETCH_HPP
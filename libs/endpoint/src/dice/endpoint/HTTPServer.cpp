@@ -1,9 +1,12 @@
 #include "HTTPServer.hpp"
 
 #include <dice/endpoint/CountEndpoint.hpp>
+#include <dice/endpoint/ExplainEndpoint.hpp>
 #include <dice/endpoint/SparqlEndpoint.hpp>
 #include <dice/endpoint/SparqlStreamingEndpoint.hpp>
 
+#include <dice/node-store/PersistentNodeStorageBackendImpl.hpp>
+
 #include <csignal>
 #include <cstring>
 #include <unistd.h>
@@ -48,24 +51,118 @@ namespace dice::endpoint {
 	HTTPServer::HTTPServer(tf::Executor &executor, triple_store::TripleStore &triplestore, EndpointCfg const &cfg)
 		: executor_(executor),
 		  triplestore_(triplestore),
-		  sparql_query_cache_(),// TODO: override default parameter
+		  sparql_query_cache_(cfg.query_cache_max_entries, cfg.query_cache_max_bytes),
+		  result_cache_(cfg.result_cache_max_bytes, cfg.result_cache_min_cost),
+		  scheduler_((cfg.threads > cfg.reserved_threads) ? cfg.threads - cfg.reserved_threads : 1, cfg.expensive_query_cardinality, cfg.time_slice),
 		  router_(std::make_unique<restinio::router::express_router_t<>>()),
 		  cfg_(cfg) {}
 
+	void HTTPServer::warm_up(std::vector<WarmupQuery> const &queries) {
+		auto const start_time = std::chrono::steady_clock::now();
+		for (auto const &warmup_query : queries) {
+			if (stopping_.load(std::memory_order_relaxed)) {
+				spdlog::info("Warm-up stopped after {} of {} queries.", warmup_done_.load(), queries.size());
+				return;
+			}
+			try {
+				auto query = sparql_query_cache_[warmup_query.query];
+				if (cfg_.warmup_evaluate) {
+					auto const timeout = (cfg_.opt_timeout_duration)
+												 ? std::chrono::steady_clock::now() + cfg_.opt_timeout_duration.value()
+												 : std::chrono::steady_clock::time_point::max();
+					[[maybe_unused]] auto const count = triplestore_.count(*query, timeout);
+				}
+			} catch (std::exception const &ex) {
+				warmup_failed_.fetch_add(1, std::memory_order_relaxed);
+				spdlog::debug("Warm-up query failed: {}", ex.what());
+			}
+			auto const done = warmup_done_.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (done % 100 == 0)
+				spdlog::info("Warm-up: {} of {} queries done.", done, queries.size());
+		}
+		spdlog::info("Warm-up finished: {} queries ({} failed) in {} ms.", queries.size(), warmup_failed_.load(),
+					 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count());
+	}
+
+	void HTTPServer::save_warmup_queries() const {
+		std::vector<WarmupQuery> queries;
+		for (auto &[query_str, hits] : sparql_query_cache_.hottest(cfg_.warmup_max_queries))
+			queries.push_back(WarmupQuery{std::move(query_str), hits});
+		try {
+			write_warmup_file(*cfg_.warmup_file, queries);
+			spdlog::info("Wrote {} warm-up queries to {}.", queries.size(), cfg_.warmup_file->string());
+		} catch (std::exception const &ex) {
+			spdlog::warn("Writing the warm-up file failed: {}", ex.what());
+		}
+	}
+
+	std::string HTTPServer::metrics() const {
+		std::string out;
+		auto metric = [&](std::string_view name, std::string_view type, std::string_view help, size_t value) {
+			fmt::format_to(std::back_inserter(out), "# HELP {0} {1}\n# TYPE {0} {2}\n{0} {3}\n", name, help, type, value);
+		};
+		auto const query_cache = sparql_query_cache_.stats();
+		metric("tentris_query_cache_hits_total", "counter", "Parsed query cache hits.", query_cache.hits);
+		metric("tentris_query_cache_misses_total", "counter", "Parsed query cache misses.", query_cache.misses);
+		metric("tentris_query_cache_rejected_total", "counter", "Parsed queries not admitted to the cache.", query_cache.rejected);
+		metric("tentris_query_cache_evicted_total", "counter", "Parsed queries evicted from the cache.", query_cache.evicted);
+		metric("tentris_query_cache_entries", "gauge", "Parsed queries in the cache.", query_cache.entries);
+		metric("tentris_query_cache_bytes", "gauge", "Estimated size of the parsed queries in the cache.", query_cache.bytes);
+		// each thread adds its lookups to these totals every few thousand lookups, so they lag slightly behind
+		auto const decoded_terms = node_store::PersistentNodeStorageBackendImpl::decoded_term_cache_stats();
+		metric("tentris_decoded_term_cache_hits_total", "counter", "Term lookups served from the thread-local decoded-term caches.", decoded_terms.hits);
+		metric("tentris_decoded_term_cache_misses_total", "counter", "Term lookups that missed the thread-local decoded-term caches.", decoded_terms.misses);
+		auto const result_cache = result_cache_.stats();
+		metric("tentris_result_cache_hits_total", "counter", "Responses served from the result cache.", result_cache.hits);
+		metric("tentris_result_cache_misses_total", "counter", "Result cache misses.", result_cache.misses);
+		metric("tentris_result_cache_admitted_total", "counter", "Responses admitted to the result cache.", result_cache.admitted);
+		metric("tentris_result_cache_rejected_total", "counter", "Responses not admitted to the result cache.", result_cache.rejected);
+		metric("tentris_result_cache_evicted_total", "counter", "Responses evicted from the result cache.", result_cache.evicted);
+		metric("tentris_result_cache_invalidated_total", "counter", "Cached responses dropped because the store changed.", result_cache.invalidated);
+		metric("tentris_result_cache_entries", "gauge", "Responses in the result cache.", result_cache.entries);
+		metric("tentris_result_cache_bytes", "gauge", "Size of the responses in the result cache.", result_cache.bytes);
+		auto const scheduler = scheduler_.stats();
+		metric("tentris_scheduler_cheap_queries_total", "counter", "Queries evaluated right away because they are cheap.", scheduler.cheap);
+		metric("tentris_scheduler_expensive_queries_total", "counter", "Queries evaluated by the scheduler because they are expensive.", scheduler.expensive);
+		metric("tentris_scheduler_queued_total", "counter", "Expensive queries that waited before they were started.", scheduler.queued);
+		metric("tentris_scheduler_suspended_total", "counter", "Expensive queries suspended in favor of a cheaper one.", scheduler.suspended);
+		metric("tentris_scheduler_waiting", "gauge", "Expensive queries waiting to be started or resumed.", scheduler.waiting);
+		metric("tentris_scheduler_running", "gauge", "Expensive queries being evaluated.", scheduler.running);
+		metric("tentris_warmup_queries", "gauge", "Queries scheduled for warm-up.", warmup_total_.load());
+		metric("tentris_warmup_queries_done", "gauge", "Warm-up queries processed so far.", warmup_done_.load());
+		metric("tentris_warmup_queries_failed", "gauge", "Warm-up queries that could not be parsed or evaluated.", warmup_failed_.load());
+		metric("tentris_store_generation", "gauge", "Generation of the triple store.", triplestore_.generation());
+		metric("tentris_store_triples", "gauge", "Number of triples in the store.", triplestore_.size());
+		return out;
+	}
+
 	void HTTPServer::operator()() {
 		spdlog::info("Available endpoints:");
 		router_->http_get(R"(/sparql)",
-						  SPARQLEndpoint{executor_, triplestore_, sparql_query_cache_, cfg_});
+						  SPARQLEndpoint{executor_, triplestore_, sparql_query_cache_, result_cache_, scheduler_, cfg_});
 		spdlog::info("  GET /sparql?query= for normal queries");
 
 		router_->http_get(R"(/stream)",
-						  SPARQLStreamingEndpoint{executor_, triplestore_, sparql_query_cache_, cfg_});
+						  SPARQLStreamingEndpoint{executor_, triplestore_, sparql_query_cache_, result_cache_, scheduler_, cfg_});
 		spdlog::info("  GET  /stream?query= for queries with huge results");
 
 		router_->http_get(R"(/count)",
-						  CountEndpoint{executor_, triplestore_, sparql_query_cache_, cfg_});
+						  CountEndpoint{executor_, triplestore_, sparql_query_cache_, result_cache_, scheduler_, cfg_});
 		spdlog::info("  GET  /count?query= as a workaround for count");
 
+		router_->http_get(R"(/explain)",
+						  ExplainEndpoint{executor_, triplestore_, sparql_query_cache_, result_cache_, scheduler_, cfg_});
+		spdlog::info("  GET  /explain?query= for the plan and cardinality estimates of a query without evaluating it");
+
+		router_->http_get(R"(/metrics)",
+						  [this](auto req, auto) {
+							  return req->create_response(restinio::status_ok())
+									  .append_header(restinio::http_field::content_type, "text/plain; version=0.0.4")
+									  .set_body(this->metrics())
+									  .done();
+						  });
+		spdlog::info("  GET  /metrics for cache and scheduler statistics in the Prometheus format");
+
 
 		router_->non_matched_request_handler(
 				[](auto req) -> restinio::request_handling_status_t {
@@ -92,6 +189,23 @@ namespace dice::endpoint {
 												  .cleanup_func([this]() { this->executor_.wait_for_all(); }),
 										  pool_size);
 
+		// warm up the caches in the background while requests are already served
+		if (cfg_.warmup_file and cfg_.warmup_max_queries > 0) {
+			try {
+				auto queries = read_warmup_file(*cfg_.warmup_file);
+				if (queries.size() > cfg_.warmup_max_queries)
+					queries.resize(cfg_.warmup_max_queries);
+				if (not queries.empty()) {
+					warmup_total_ = queries.size();
+					spdlog::info("Warming up with {} queries from {}{}.", queries.size(), cfg_.warmup_file->string(),
+								 cfg_.warmup_evaluate ? ", evaluating them" : "");
+					executor_.silent_async([this, queries = std::move(queries)]() { this->warm_up(queries); });
+				}
+			} catch (std::exception const &ex) {
+				spdlog::warn("Reading the warm-up file failed: {}", ex.what());
+			}
+		}
+
 
 		auto signal_handler = [](int signum) {
 			spdlog::info("Interrupt signal ({}) received.\n", signum);
@@ -114,7 +228,22 @@ namespace dice::endpoint {
 		while (!signalReceived) {
 			pause();
 		}
+		stopping_ = true;
 		server->stop();
 		server->wait();
+
+		if (cfg_.warmup_file and cfg_.warmup_max_queries > 0)
+			save_warmup_queries();
+
+		auto const cache_stats = sparql_query_cache_.stats();
+		spdlog::info("Query cache: {} hits, {} misses, {} rejected, {} evicted, {} entries, {} bytes",
+					 cache_stats.hits, cache_stats.misses, cache_stats.rejected, cache_stats.evicted, cache_stats.entries, cache_stats.bytes);
+		auto const result_cache_stats = result_cache_.stats();
+		spdlog::info("Result cache: {} hits, {} misses, {} admitted, {} rejected, {} evicted, {} invalidated, {} entries, {} bytes",
+					 result_cache_stats.hits, result_cache_stats.misses, result_cache_stats.admitted, result_cache_stats.rejected,
+					 result_cache_stats.evicted, result_cache_stats.invalidated, result_cache_stats.entries, result_cache_stats.bytes);
+		auto const scheduler_stats = scheduler_.stats();
+		spdlog::info("Scheduler: {} cheap queries, {} expensive queries, {} queued, {} suspended",
+					 scheduler_stats.cheap, scheduler_stats.expensive, scheduler_stats.queued, scheduler_stats.suspended);
 	}
 }// namespace dice::endpoint
\ No newline at end of file
@@ -8,9 +8,14 @@
 #include <restinio/all.hpp>
 #include <taskflow/taskflow.hpp>
 
+#include <atomic>
+
 #include <dice/triple-store/TripleStore.hpp>
 
 #include <dice/endpoint/EndpointCfg.hpp>
+#include <dice/endpoint/QueryScheduler.hpp>
+#include <dice/endpoint/QueryWarmup.hpp>
+#include <dice/endpoint/ResultCache.hpp>
 #include <dice/endpoint/SparqlQueryCache.hpp>
 
 
@@ -21,8 +26,26 @@ namespace dice::endpoint {
 		tf::Executor &executor_;
 		triple_store::TripleStore &triplestore_;
 		SparqlQueryCache sparql_query_cache_;
+		ResultCache result_cache_;
+		QueryScheduler scheduler_;
 		std::unique_ptr<restinio::router::express_router_t<>> router_;
 		EndpointCfg cfg_;
+		// progress of the warm-up from cfg_.warmup_file
+		std::atomic<size_t> warmup_total_{0};
+		std::atomic<size_t> warmup_done_{0};
+		std::atomic<size_t> warmup_failed_{0};
+		std::atomic<bool> stopping_{false};
+
+		/**
+		 * Parses the queries into the query cache and, if configured, evaluates them. Stops early when the server shuts down.
+		 * @param queries the queries, hottest first
+		 */
+		void warm_up(std::vector<WarmupQuery> const &queries);
+
+		/**
+		 * Writes the hottest queries of the query cache to cfg_.warmup_file.
+		 */
+		void save_warmup_queries() const;
 
 	public:
 		HTTPServer(tf::Executor &executor, triple_store::TripleStore &triplestore, EndpointCfg const &cfg);
@@ -31,6 +54,11 @@ namespace dice::endpoint {
 			return *router_;
 		}
 
+		/**
+		 * @return the cache and scheduler counters in the Prometheus text exposition format
+		 */
+		[[nodiscard]] std::string metrics() const;
+
 		void operator()();
 	};
 }// namespace dice::endpoint
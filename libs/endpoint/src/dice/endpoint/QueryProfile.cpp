@@ -0,0 +1,110 @@
+#include "dice/endpoint/QueryProfile.hpp"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <restinio/uri_helpers.hpp>
+
+#include <cmath>
+
+#include <dice/node-store/PersistentNodeStorageBackendImpl.hpp>
+
+namespace dice::endpoint {
+
+    QueryProfile::QueryProfile()
+        : decodes_at_start_(node_store::PersistentNodeStorageBackendImpl::thread_decoded_term_cache_stats()) {}
+
+    std::optional<QueryProfile> QueryProfile::of(restinio::request_handle_t const &req) {
+        auto const query_string = req->header().query();
+        // requests without profiling pay only for this search
+        if (query_string.find("profile") == std::string_view::npos)
+            return std::nullopt;
+        auto const qp = restinio::parse_query<restinio::parse_query_traits::javascript_compatible>(query_string);
+        if (not qp.has("profile") or qp["profile"] != "true")
+            return std::nullopt;
+        return QueryProfile{};
+    }
+
+    void QueryProfile::end_phase(std::string_view name, clock::duration nested) {
+        auto const now = clock::now();
+        phases_.emplace_back(name, now - phase_start_ - nested - suspended_in_phase_);
+        phase_start_ = now;
+        suspended_in_phase_ = {};
+    }
+
+    void QueryProfile::suspend() {
+        suspended_at_ = clock::now();
+        auto const decodes = node_store::PersistentNodeStorageBackendImpl::thread_decoded_term_cache_stats();
+        decodes_before_.hits += decodes.hits - decodes_at_start_.hits;
+        decodes_before_.misses += decodes.misses - decodes_at_start_.misses;
+    }
+
+    void QueryProfile::resume() {
+        auto const suspended = clock::now() - suspended_at_;
+        suspended_in_phase_ += suspended;
+        suspended_ += suspended;
+        decodes_at_start_ = node_store::PersistentNodeStorageBackendImpl::thread_decoded_term_cache_stats();
+    }
+
+    void QueryProfile::add_phase(std::string_view name, clock::duration duration) {
+        phases_.emplace_back(name, duration);
+    }
+
+    std::string QueryProfile::to_json() const {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> json{buffer};
+        auto const key = [&json](std::string_view name) { json.Key(name.data(), rapidjson::SizeType(name.size())); };
+        json.StartObject();
+
+        key("phases_us");
+        json.StartObject();
+        for (auto const &[name, duration] : phases_) {
+            key(name);
+            json.Double(std::chrono::duration<double, std::micro>(duration).count());
+        }
+        json.EndObject();
+        key("suspended_us");
+        json.Double(std::chrono::duration<double, std::micro>(suspended_).count());
+
+        key("result_cached");
+        json.Bool(result_cached);
+        key("operand_sizes");
+        json.StartArray();
+        for (auto const size : evaluation.operand_sizes)
+            json.Uint64(size);
+        json.EndArray();
+        key("partitions");
+        json.Uint64(evaluation.partitions);
+        key("joined_entries");
+        json.Uint64(evaluation.joined_entries);
+        key("selected_entries");
+        json.Uint64(evaluation.selected_entries);
+        key("solutions");
+        json.Uint64(solutions);
+        key("bindings");
+        json.Uint64(bindings);
+
+        key("variable_cardinalities");
+        json.StartObject();
+        for (auto const &[name, cardinality] : variable_cardinalities) {
+            key(name);
+            // JSON has no NaN or infinity
+            if (std::isfinite(cardinality))
+                json.Double(cardinality);
+            else
+                json.Null();
+        }
+        json.EndObject();
+
+        auto const decodes = node_store::PersistentNodeStorageBackendImpl::thread_decoded_term_cache_stats();
+        key("decoded_terms");
+        json.StartObject();
+        key("lookups");
+        json.Uint64(decodes_before_.lookups() + decodes.lookups() - decodes_at_start_.lookups());
+        key("misses");
+        json.Uint64(decodes_before_.misses + decodes.misses - decodes_at_start_.misses);
+        json.EndObject();
+
+        json.EndObject();
+        return {buffer.GetString(), buffer.GetSize()};
+    }
+}// namespace dice::endpoint
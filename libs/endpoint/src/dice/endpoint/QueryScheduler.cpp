@@ -0,0 +1,94 @@
+#include "QueryScheduler.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+
+namespace dice::endpoint {
+
+	namespace {
+		// orders a heap so that the query with the lowest cost and, among equal costs, the earliest arrival is on top
+		constexpr auto later = [](auto const &lhs, auto const &rhs) noexcept {
+			return (lhs.cost != rhs.cost) ? lhs.cost > rhs.cost : lhs.arrival > rhs.arrival;
+		};
+	}// namespace
+
+	QueryScheduler::QueryScheduler(size_t max_running, double expensive_cost, std::chrono::steady_clock::duration time_slice)
+		: max_running_(std::max<size_t>(max_running, 1)),
+		  expensive_cost_(expensive_cost),
+		  time_slice_(time_slice) {}
+
+	void QueryScheduler::count_cheap() noexcept {
+		std::unique_lock lock{mutex_};
+		++stats_.cheap;
+	}
+
+	void QueryScheduler::schedule(double cost, Slice slice) {
+		// NaN is not ordered; queries without an estimate are scheduled last
+		Waiting query{std::isnan(cost) ? std::numeric_limits<double>::infinity() : cost, 0, std::move(slice)};
+		{
+			std::unique_lock lock{mutex_};
+			++stats_.expensive;
+			query.arrival = next_arrival_++;
+			if (running_ == max_running_) {
+				++stats_.queued;
+				waiting_.push_back(std::move(query));
+				std::ranges::push_heap(waiting_, later);
+				return;
+			}
+			++running_;
+		}
+		run(std::move(query));
+	}
+
+	void QueryScheduler::run(Waiting query) {
+		auto const pop = [this]() {
+			std::ranges::pop_heap(waiting_, later);
+			auto next = std::move(waiting_.back());
+			waiting_.pop_back();
+			return next;
+		};
+		while (true) {
+			bool finished = true;
+			try {
+				finished = query.slice();
+			} catch (std::exception const &ex) {
+				// slices respond to their request themselves; this only keeps the slot from leaking
+				spdlog::error("Scheduled query failed: {}", ex.what());
+			} catch (...) {
+				spdlog::error("Scheduled query failed with an unknown exception.");
+			}
+
+			std::unique_lock lock{mutex_};
+			if (not finished) {
+				if (waiting_.empty())
+					continue;
+				// the query continues unless a query with a lower estimate waits
+				auto const arrival = query.arrival;
+				waiting_.push_back(std::move(query));
+				std::ranges::push_heap(waiting_, later);
+				query = pop();
+				if (query.arrival != arrival)
+					++stats_.suspended;
+				continue;
+			}
+			if (waiting_.empty()) {
+				--running_;
+				return;
+			}
+			query = pop();
+		}
+	}
+
+	QuerySchedulerStats QueryScheduler::stats() const noexcept {
+		std::unique_lock lock{mutex_};
+		auto stats = stats_;
+		stats.waiting = waiting_.size();
+		stats.running = running_;
+		return stats;
+	}
+
+}// namespace dice::endpoint
@@ -0,0 +1,108 @@
+#ifndef TENTRIS_QUERYSCHEDULER_HPP
+#define TENTRIS_QUERYSCHEDULER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace dice::endpoint {
+
+	/**
+	 * Counters of a QueryScheduler.
+	 */
+	struct QuerySchedulerStats {
+		// queries that were evaluated directly by the worker that accepted them
+		size_t cheap = 0;
+		size_t expensive = 0;
+		// expensive queries that had to wait for a free slot before their first slice
+		size_t queued = 0;
+		// slices after which an expensive query was suspended because another one was waiting
+		size_t suspended = 0;
+		size_t waiting = 0;
+		size_t running = 0;
+	};
+
+	/**
+	 * Schedules queries by their estimated cost, i.e., the cardinality estimate of their result.
+	 *
+	 * Cheap queries are evaluated directly by the worker that accepted them. At most max_running expensive queries are evaluated at
+	 * a time, so the remaining workers stay free for cheap queries. Further expensive queries wait and are started shortest expected
+	 * job first, i.e., in ascending order of their estimate and in arrival order for equal estimates.
+	 *
+	 * Expensive queries are evaluated in slices. When a slice ends while another expensive query waits, the query is suspended
+	 * and waits again with its estimate, so a single long query cannot hold a slot while shorter ones queue up behind it.
+	 * Waiting does not stop the timeout of a query; a query that is resumed after its timeout fails on its next slice.
+	 */
+	class QueryScheduler {
+	public:
+		/**
+		 * Evaluates the next slice of a query. It must respond to the request itself, also if the evaluation fails.
+		 * @return true if the query is finished, false if it may continue with another slice
+		 */
+		using Slice = std::move_only_function<bool()>;
+
+	private:
+		struct Waiting {
+			double cost;
+			uint64_t arrival;
+			Slice slice;
+		};
+
+		mutable std::mutex mutex_;
+		// a min-heap by cost and arrival
+		std::vector<Waiting> waiting_;
+		size_t running_ = 0;
+		uint64_t next_arrival_ = 0;
+		QuerySchedulerStats stats_;
+
+		size_t max_running_;
+		double expensive_cost_;
+		std::chrono::steady_clock::duration time_slice_;
+
+		/**
+		 * Evaluates a query slice by slice on the calling thread. When the query is finished, the slot is passed on to the waiting
+		 * query with the lowest estimate, which is evaluated on the same thread.
+		 */
+		void run(Waiting query);
+
+	public:
+		/**
+		 * @param max_running the number of expensive queries that are evaluated at a time; at least one
+		 * @param expensive_cost queries whose estimated cost is at least this are expensive
+		 * @param time_slice how long an expensive query runs before it may be suspended
+		 */
+		QueryScheduler(size_t max_running, double expensive_cost, std::chrono::steady_clock::duration time_slice);
+
+		/**
+		 * @param cost the estimated cost of a query; NaN if it could not be estimated
+		 * @return if the query is expensive. Queries without an estimate are expensive.
+		 */
+		[[nodiscard]] bool is_expensive(double cost) const noexcept {
+			return not(cost < expensive_cost_);
+		}
+
+		[[nodiscard]] std::chrono::steady_clock::duration time_slice() const noexcept { return time_slice_; }
+
+		/**
+		 * Counts a query that is evaluated without the scheduler because it is cheap.
+		 */
+		void count_cheap() noexcept;
+
+		/**
+		 * Evaluates an expensive query. If fewer than max_running expensive queries are evaluated, it is evaluated on the calling
+		 * thread right away, and the thread continues with waiting queries afterwards. Otherwise, the query waits and this returns
+		 * immediately.
+		 * @param cost the estimated cost of the query
+		 * @param slice evaluates the next slice of the query
+		 */
+		void schedule(double cost, Slice slice);
+
+		[[nodiscard]] QuerySchedulerStats stats() const noexcept;
+	};
+
+}// namespace dice::endpoint
+
+#endif//TENTRIS_QUERYSCHEDULER_HPP
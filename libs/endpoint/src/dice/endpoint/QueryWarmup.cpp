@@ -0,0 +1,101 @@
+#include "QueryWarmup.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+
+namespace dice::endpoint {
+
+	namespace {
+		// one query per line: <hits>\t<query>, where backslashes, tabs and line breaks in the query are escaped
+		constexpr std::string_view header = "# tentris query warm-up v1";
+
+		std::string escape(std::string_view query) {
+			std::string escaped;
+			escaped.reserve(query.size());
+			for (char c : query) {
+				switch (c) {
+					case '\\':
+						escaped.append("\\\\");
+						break;
+					case '\t':
+						escaped.append("\\t");
+						break;
+					case '\n':
+						escaped.append("\\n");
+						break;
+					case '\r':
+						escaped.append("\\r");
+						break;
+					default:
+						escaped.push_back(c);
+				}
+			}
+			return escaped;
+		}
+
+		std::string unescape(std::string_view escaped) {
+			std::string query;
+			query.reserve(escaped.size());
+			for (size_t i = 0; i < escaped.size(); ++i) {
+				if (escaped[i] != '\\') {
+					query.push_back(escaped[i]);
+					continue;
+				}
+				if (++i == escaped.size())
+					throw std::runtime_error{"Warm-up file ends with an incomplete escape sequence."};
+				switch (escaped[i]) {
+					case 't':
+						query.push_back('\t');
+						break;
+					case 'n':
+						query.push_back('\n');
+						break;
+					case 'r':
+						query.push_back('\r');
+						break;
+					default:
+						query.push_back(escaped[i]);
+				}
+			}
+			return query;
+		}
+	}// namespace
+
+	void write_warmup_file(std::filesystem::path const &path, std::vector<WarmupQuery> const &queries) {
+		auto tmp_path = path;
+		tmp_path += ".tmp";
+		{
+			std::ofstream out{tmp_path, std::ios::trunc};
+			if (not out)
+				throw std::runtime_error{"Unable to open warm-up file " + tmp_path.string() + " for writing."};
+			out << header << '\n';
+			for (auto const &[query, hits] : queries)
+				out << hits << '\t' << escape(query) << '\n';
+			if (not out.flush())
+				throw std::runtime_error{"Unable to write warm-up file " + tmp_path.string() + "."};
+		}
+		std::filesystem::rename(tmp_path, path);
+	}
+
+	std::vector<WarmupQuery> read_warmup_file(std::filesystem::path const &path) {
+		std::vector<WarmupQuery> queries;
+		std::ifstream in{path};
+		if (not in)
+			return queries;
+		std::string line;
+		if (not std::getline(in, line) or line != header)
+			throw std::runtime_error{"Warm-up file " + path.string() + " has an unknown format."};
+		while (std::getline(in, line)) {
+			if (line.empty())
+				continue;
+			auto const tab = line.find('\t');
+			size_t hits = 0;
+			if (tab == std::string::npos or std::from_chars(line.data(), line.data() + tab, hits).ptr != line.data() + tab)
+				throw std::runtime_error{"Warm-up file " + path.string() + " contains a malformed line."};
+			queries.push_back(WarmupQuery{unescape(std::string_view{line}.substr(tab + 1)), hits});
+		}
+		return queries;
+	}
+
+}// namespace dice::endpoint
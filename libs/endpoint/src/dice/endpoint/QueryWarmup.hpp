@@ -0,0 +1,38 @@
+#ifndef TENTRIS_QUERYWARMUP_HPP
+#define TENTRIS_QUERYWARMUP_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace dice::endpoint {
+
+	/**
+	 * A query string from the query cache together with its estimated recent access count.
+	 */
+	struct WarmupQuery {
+		std::string query;
+		size_t hits;
+	};
+
+	/**
+	 * Writes the queries to a warm-up file. The file is written next to its final location and then renamed,
+	 * so a crash during writing leaves the previous file intact.
+	 * @param path the warm-up file
+	 * @param queries the queries, hottest first
+	 * @throws std::runtime_error if the file cannot be written
+	 */
+	void write_warmup_file(std::filesystem::path const &path, std::vector<WarmupQuery> const &queries);
+
+	/**
+	 * Reads a warm-up file that was written by write_warmup_file.
+	 * @param path the warm-up file
+	 * @return the queries in the order of the file; empty if the file does not exist
+	 * @throws std::runtime_error if the file exists but is malformed
+	 */
+	std::vector<WarmupQuery> read_warmup_file(std::filesystem::path const &path);
+
+}// namespace dice::endpoint
+
+#endif//TENTRIS_QUERYWARMUP_HPP
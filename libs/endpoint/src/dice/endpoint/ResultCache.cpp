@@ -0,0 +1,121 @@
+#include "ResultCache.hpp"
+
+#include <algorithm>
+
+namespace dice::endpoint {
+
+	ResultCache::ResultCache(size_t max_bytes, std::chrono::nanoseconds min_cost)
+		: max_bytes_(max_bytes),
+		  max_shard_bytes_(max_bytes / shard_count),
+		  min_cost_(min_cost),
+		  shards_(std::make_unique<Shard[]>(shard_count)) {}
+
+	ResultCache::Shard &ResultCache::shard_of(std::string const &key) const noexcept {
+		auto const hash = hash_type{}(key);
+		return shards_[hash >> (std::numeric_limits<size_t>::digits - shard_bits)];
+	}
+
+	void ResultCache::erase(Shard &shard, robin_hood::unordered_node_map<std::string, Entry, hash_type>::iterator iter) {
+		shard.bytes -= iter->second.bytes;
+		shard.priorities.erase(iter->second.position);
+		shard.entries.erase(iter);
+	}
+
+	ResultCache::body_ptr ResultCache::find(std::string const &key, uint64_t generation) {
+		if (not enabled())
+			return nullptr;
+		auto &shard = shard_of(key);
+		std::unique_lock lock{shard.mutex};
+		auto iter = shard.entries.find(key);
+		if (iter == shard.entries.end()) {
+			++shard.stats.misses;
+			return nullptr;
+		}
+		auto &entry = iter->second;
+		if (entry.generation != generation) {
+			erase(shard, iter);
+			++shard.stats.invalidated;
+			++shard.stats.misses;
+			return nullptr;
+		}
+		++shard.stats.hits;
+		++entry.frequency;
+		shard.priorities.erase(entry.position);
+		auto const priority = shard.inflation + double(entry.frequency) * entry.cost / double(entry.bytes);
+		entry.position = shard.priorities.emplace(priority, &iter->first).first;
+		return entry.body;
+	}
+
+	bool ResultCache::contains(std::string const &key, uint64_t generation) const {
+		if (not enabled())
+			return false;
+		auto &shard = shard_of(key);
+		std::unique_lock lock{shard.mutex};
+		auto const iter = shard.entries.find(key);
+		return iter != shard.entries.end() and iter->second.generation == generation;
+	}
+
+	void ResultCache::offer(std::string const &key, body_ptr body, std::chrono::nanoseconds cost, uint64_t generation) {
+		if (not enabled())
+			return;
+		auto &shard = shard_of(key);
+		// the key is stored alongside the body
+		auto const bytes = std::max<size_t>(body->size() + key.size(), 1);
+		std::unique_lock lock{shard.mutex};
+		if (cost < min_cost_ or bytes > max_shard_bytes_) {
+			++shard.stats.rejected;
+			return;
+		}
+		if (auto iter = shard.entries.find(key); iter != shard.entries.end()) {
+			// a concurrent request for the same key was faster
+			if (iter->second.generation == generation)
+				return;
+			erase(shard, iter);
+			++shard.stats.invalidated;
+		}
+
+		auto const cost_value = double(cost.count());
+		auto const priority = shard.inflation + cost_value / double(bytes);
+		// admit only if the entries that must make room are all less valuable than the new one
+		size_t freed = 0;
+		auto victim = shard.priorities.begin();
+		while (shard.bytes - freed + bytes > max_shard_bytes_) {
+			if (victim == shard.priorities.end() or victim->first >= priority) {
+				++shard.stats.rejected;
+				return;
+			}
+			freed += shard.entries.find(*victim->second)->second.bytes;
+			++victim;
+		}
+		while (shard.bytes + bytes > max_shard_bytes_) {
+			auto const lowest = shard.priorities.begin();
+			shard.inflation = lowest->first;
+			erase(shard, shard.entries.find(*lowest->second));
+			++shard.stats.evicted;
+		}
+
+		auto iter = shard.entries.try_emplace(key, Entry{std::move(body), generation, bytes, cost_value}).first;
+		auto &entry = iter->second;
+		entry.position = shard.priorities.emplace(priority, &iter->first).first;
+		shard.bytes += bytes;
+		++shard.stats.admitted;
+	}
+
+	ResultCacheStats ResultCache::stats() const noexcept {
+		ResultCacheStats total;
+		for (size_t i = 0; i < shard_count; ++i) {
+			auto &shard = shards_[i];
+			std::unique_lock lock{shard.mutex};
+			total.hits += shard.stats.hits;
+			total.misses += shard.stats.misses;
+			total.admitted += shard.stats.admitted;
+			total.rejected += shard.stats.rejected;
+			total.evicted += shard.stats.evicted;
+			total.invalidated += shard.stats.invalidated;
+			total.entries += shard.entries.size();
+			total.bytes += shard.bytes;
+		}
+		return total;
+	}
+
+}// namespace dice::endpoint
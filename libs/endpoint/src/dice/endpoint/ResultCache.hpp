@@ -0,0 +1,123 @@
+#ifndef TENTRIS_RESULTCACHE_HPP
+#define TENTRIS_RESULTCACHE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <robin_hood.h>
+
+#include <dice/hash/DiceHash.hpp>
+
+namespace dice::endpoint {
+
+	/**
+	 * Counters of a ResultCache.
+	 */
+	struct ResultCacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t admitted = 0;
+		// results that were offered but not cached, because they were too cheap to compute or too large
+		size_t rejected = 0;
+		size_t evicted = 0;
+		// entries dropped because the store changed after they were computed
+		size_t invalidated = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+	};
+
+	/**
+	 * Memory-bounded cache of finished response bodies.
+	 *
+	 * Admission and eviction follow GreedyDual-Size-Frequency: an entry's priority is the cost of computing it times its hit count
+	 * divided by its size, plus an inflation value that ages out old entries. The entry with the lowest priority is evicted,
+	 * and a new result is only admitted if its priority exceeds that of the entries it would replace.
+	 *
+	 * Every entry is tagged with the generation of the store that it was computed on. Lookups with another generation miss and drop the entry.
+	 */
+	class ResultCache {
+		static constexpr size_t shard_bits = 4;
+		static constexpr size_t shard_count = size_t(1) << shard_bits;
+
+		using body_ptr = std::shared_ptr<std::string const>;
+		using hash_type = dice::hash::DiceHashMartinus<std::string>;
+
+		// ordered by priority; the keys point into the entry map, whose nodes do not move
+		using priority_set = std::set<std::pair<double, std::string const *>>;
+
+		struct Entry {
+			body_ptr body;
+			uint64_t generation;
+			size_t bytes;
+			double cost;
+			size_t frequency = 1;
+			priority_set::iterator position;
+		};
+
+		struct alignas(64) Shard {
+			std::mutex mutex;
+			robin_hood::unordered_node_map<std::string, Entry, hash_type> entries;
+			priority_set priorities;
+			// GDSF inflation; the priority of the last evicted entry
+			double inflation = 0;
+			size_t bytes = 0;
+			ResultCacheStats stats;
+		};
+
+		size_t const max_bytes_;
+		size_t const max_shard_bytes_;
+		std::chrono::nanoseconds const min_cost_;
+		std::unique_ptr<Shard[]> shards_;
+
+		[[nodiscard]] Shard &shard_of(std::string const &key) const noexcept;
+
+		static void erase(Shard &shard, robin_hood::unordered_node_map<std::string, Entry, hash_type>::iterator iter);
+
+	public:
+		/**
+		 * @param max_bytes maximum total size of the cached bodies; 0 disables the cache
+		 * @param min_cost results that took less time to compute are not cached
+		 */
+		ResultCache(size_t max_bytes, std::chrono::nanoseconds min_cost);
+
+		[[nodiscard]] bool enabled() const noexcept { return max_bytes_ != 0; }
+
+		/**
+		 * @param key identifies the request, including everything that influences the response body
+		 * @param generation the current generation of the store
+		 * @return the cached body or nullptr
+		 */
+		[[nodiscard]] body_ptr find(std::string const &key, uint64_t generation);
+
+		/**
+		 * Checks for a cached body without counting a hit or a miss and without changing the priority of the entry.
+		 * @param key identifies the request, including everything that influences the response body
+		 * @param generation the current generation of the store
+		 * @return true if find would return a body
+		 */
+		[[nodiscard]] bool contains(std::string const &key, uint64_t generation) const;
+
+		/**
+		 * Offers a computed body to the cache.
+		 * @param key identifies the request, including everything that influences the response body
+		 * @param body the response body
+		 * @param cost the time it took to compute the body
+		 * @param generation the generation of the store that the body was computed on
+		 */
+		void offer(std::string const &key, body_ptr body, std::chrono::nanoseconds cost, uint64_t generation);
+
+		[[nodiscard]] ResultCacheStats stats() const noexcept;
+
+		[[nodiscard]] size_t max_bytes() const noexcept { return max_bytes_; }
+	};
+
+}// namespace dice::endpoint
+
+#endif//TENTRIS_RESULTCACHE_HPP
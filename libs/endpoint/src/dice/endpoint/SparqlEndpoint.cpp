@@ -2,6 +2,11 @@
 
 #include <dice/endpoint/TimeoutCheck.hpp>
 #include <nlohmann/json.hpp>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <algorithm>
+#include <cmath>
 
 #include <dice/query/OperandDependencyGraph.hpp>
 #include <spdlog/spdlog.h>
@@ -9,49 +14,100 @@
 #include <curl/curl.h>
 #include <string>
 #include <iostream>
-#include <dice/query/operators/CardinalityEstimation.hpp>
 
 #include <dice/endpoint/ParseSPARQLQueryParam.hpp>
+#include <dice/endpoint/QueryProfile.hpp>
 #include <dice/endpoint/SparqlJsonResultSAXWriter.hpp>
 
 namespace dice::endpoint {
+    namespace {
+        /**
+         * Writes the features with a SAX writer; building a JSON tree would allocate a node per value.
+         */
+        class FeatureJsonWriter {
+            rapidjson::StringBuffer buffer_;
+            rapidjson::Writer<rapidjson::StringBuffer> writer_{buffer_};
+
+        public:
+            void value(std::string const &str) { writer_.String(str.data(), rapidjson::SizeType(str.size())); }
+
+            void value(bool b) { writer_.Bool(b); }
+
+            void value(int i) { writer_.Int(i); }
+
+            void value(size_t i) { writer_.Uint64(i); }
+
+            // JSON has no NaN or infinity
+            void value(double d) {
+                if (std::isfinite(d))
+                    writer_.Double(d);
+                else
+                    writer_.Null();
+            }
+
+            template<typename T>
+            void value(std::vector<T> const &values) {
+                writer_.StartArray();
+                for (auto const &element : values)
+                    value(element);
+                writer_.EndArray();
+            }
+
+            template<typename T>
+            void member(std::string_view key, T const &member_value) {
+                writer_.Key(key.data(), rapidjson::SizeType(key.size()));
+                value(member_value);
+            }
+
+            void start() { writer_.StartObject(); }
+
+            std::string finish() {
+                writer_.EndObject();
+                return {buffer_.GetString(), buffer_.GetSize()};
+            }
+        };
+    }// namespace
+
     std::string QueryFeatures::to_json() const {
-        nlohmann::json j;
+        FeatureJsonWriter json;
+        json.start();
 
         // Directly add basic query info
-        j["variable_names"] = variable_names;
-        j["projection_variables"] = projection_variables;
-        j["join_variables"] = join_variables;
-        j["non_join_variables"] = non_join_variables;
-        j["num_triple_patterns"] = num_triple_patterns;
-        j["is_distinct"] = is_distinct;
+        json.member("variable_names", variable_names);
+        json.member("projection_variables", projection_variables);
+        json.member("join_variables", join_variables);
+        json.member("non_join_variables", non_join_variables);
+        json.member("num_triple_patterns", num_triple_patterns);
+        json.member("is_distinct", is_distinct);
 
         // Directly add cardinality features
-        j["variable_cardinalities"] = variable_cardinalities;
-        j["total_query_cardinality"] = total_query_cardinality;
-        j["min_cardinality_variable"] = std::string(1, min_cardinality_variable);
+        json.member("variable_cardinalities", variable_cardinalities);
+        json.member("total_query_cardinality", total_query_cardinality);
+        json.member("min_cardinality_variable", std::string(1, min_cardinality_variable));
+        json.member("triple_pattern_cardinalities", triple_pattern_cardinalities);
+        json.member("star_cardinalities", star_cardinalities);
 
         // Directly add graph features
-        j["adjacency_matrix"] = adjacency_matrix;
-        j["variable_degrees"] = variable_degrees;
-        j["max_variable_degree"] = max_variable_degree;
-        j["min_variable_degree"] = min_variable_degree;
-        j["avg_variable_degree"] = avg_variable_degree;
-        j["graph_density"] = graph_density;
-        j["num_connected_components"] = num_connected_components;
-
-
-        return j.dump();
+        json.member("adjacency_matrix", adjacency_matrix);
+        json.member("variable_degrees", variable_degrees);
+        json.member("max_variable_degree", max_variable_degree);
+        json.member("min_variable_degree", min_variable_degree);
+        json.member("avg_variable_degree", avg_variable_degree);
+        json.member("graph_density", graph_density);
+        json.member("num_connected_components", num_connected_components);
+
+        return json.finish();
     }
 
     SPARQLEndpoint::SPARQLEndpoint(tf::Executor &executor,
                                    triple_store::TripleStore &triplestore,
                                    SparqlQueryCache &sparql_query_cache,
+                                   ResultCache &result_cache,
+                                   QueryScheduler &scheduler,
                                    EndpointCfg const &endpoint_cfg)
-        : Endpoint(executor, triplestore, sparql_query_cache, endpoint_cfg) {}
+        : Endpoint(executor, triplestore, sparql_query_cache, result_cache, scheduler, endpoint_cfg) {}
 
-    QueryFeatures SPARQLEndpoint::extract_query_features(const sparql2tensor::SPARQLQuery &sparql_query,
-                                                         std::chrono::steady_clock::time_point timeout) {
+    QueryFeatures extract_query_features(triple_store::TripleStore const &triplestore, const sparql2tensor::SPARQLQuery &sparql_query) {
         QueryFeatures features;
 
         // Basic query information
@@ -92,8 +148,6 @@ namespace dice::endpoint {
         // Extract ODG features
         auto& odg = const_cast<query::OperandDependencyGraph&>(sparql_query.odg_);
         features.num_connected_components = odg.union_components().size();
-        auto operands = this->triplestore_.get_query_operands(this->triplestore_.get_hypertrie(),
-                                                             sparql_query.get_slice_keys());
         // Create adjacency matrix for ODG
         size_t num_vars = sparql_query.var_to_id_.size();
         features.adjacency_matrix = std::vector<std::vector<int>>(num_vars, std::vector<int>(num_vars, 0));
@@ -167,14 +221,31 @@ namespace dice::endpoint {
         std::cout << "Graph Density: " << features.graph_density << "\n";
 
 
-    // Calculate cardinality features
-    using CardEst = query::operators::CardinalityEstimation<dice::rdf_tensor::htt_t, dice::rdf_tensor::allocator_type>;
-
+    // Calculate cardinality features; they are best-effort, so a failed estimate leaves them empty
     try {
-        double min_cardinality = std::numeric_limits<double>::max();
+        // the cardinality features are estimated from the persistent dataset statistics; no operand is built or estimated per request
+        auto const estimate = triplestore.estimate(sparql_query);
+        for (size_t tp = 0; tp < sparql_query.triple_patterns_.size(); ++tp)
+            features.triple_pattern_cardinalities.push_back(estimate.operands()[tp].matches);
+        if (auto const *statistics = triplestore.statistics()) {
+            // subject stars: the constant predicates of the triple patterns that share a subject variable
+            std::vector<std::pair<rdf4cpp::rdf::Node, std::vector<rdf_tensor::NodeWrapper>>> stars;
+            for (auto const &tp : sparql_query.triple_patterns_) {
+                if (not tp.subject().is_variable() or tp.predicate().is_variable())
+                    continue;
+                auto star = std::ranges::find(stars, tp.subject(), &decltype(stars)::value_type::first);
+                if (star == stars.end())
+                    star = stars.insert(stars.end(), {tp.subject(), {}});
+                star->second.emplace_back(tp.predicate());
+            }
+            for (auto const &[subject, predicates] : stars) {
+                if (predicates.size() > 1)
+                    features.star_cardinalities.push_back(statistics->estimate_star(predicates));
+            }
+        }
 
-        for (const auto &[var, var_id] : sparql_query.var_to_id_) {
-            double card = CardEst::calcCard(odg, operands, var_id);
+        double min_cardinality = std::numeric_limits<double>::max();
+        for (auto const &[var_id, card] : estimate.variable_cardinalities()) {
             features.variable_cardinalities.push_back(card);
 
             if (card < min_cardinality) {
@@ -182,24 +253,16 @@ namespace dice::endpoint {
                 features.min_cardinality_variable = var_id;
             }
         }
-
-        std::cout << "Variable Cardinalities: ";
-        for (double card : features.variable_cardinalities) {
-            std::cout << card << " ";
-        }
-        std::cout << "\nMin Cardinality Variable: " << features.min_cardinality_variable << "\n";
-
-        // Create rdf_tensor::Query for total estimate
-        std::vector<char> proj_vars_id;
-        for (auto const &proj_var : sparql_query.projected_variables_) {
-            proj_vars_id.push_back(sparql_query.var_to_id_.at(proj_var));
+        if (spdlog::should_log(spdlog::level::debug)) {
+            std::string cardinalities;
+            for (double card : features.variable_cardinalities)
+                cardinalities += std::to_string(card) + " ";
+            spdlog::debug("Variable Cardinalities: {}", cardinalities);
+            spdlog::debug("Min Cardinality Variable: {}", features.min_cardinality_variable);
         }
-        rdf_tensor::Query rdf_query{odg, operands, proj_vars_id, timeout};
-
-        features.total_query_cardinality = CardEst::estimate(odg, operands, rdf_query);
-
-        std::cout << "Total Query Cardinality: " << features.total_query_cardinality << "\n";
 
+        features.total_query_cardinality = estimate.total();
+        spdlog::debug("Total Query Cardinality: {}", features.total_query_cardinality);
     } catch (const std::exception& e) {
         spdlog::warn("Error calculating cardinality: {}", e.what());
     }
@@ -213,7 +276,7 @@ namespace dice::endpoint {
         return size * nmemb;
     }
 
-    std::string send_query_features_to_api(const dice::endpoint::QueryFeatures& features) {
+    std::string send_query_features_to_api(const dice::endpoint::QueryFeatures& features, std::optional<std::chrono::milliseconds> timeout) {
         CURL* curl = curl_easy_init();
         std::string response_data;
 
@@ -241,12 +304,20 @@ namespace dice::endpoint {
             curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
             curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
 
+            if (timeout) {
+                // without signals, as the timeout would otherwise be raised with SIGALRM on a thread of the server
+                curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+                curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(std::max<std::chrono::milliseconds::rep>(timeout->count(), 1)));
+            }
+
             // Perform the request
             res = curl_easy_perform(curl);
 
             // Check for errors
             if (res != CURLE_OK) {
                 std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
+                // a partial response is no answer
+                response_data.clear();
             } else {
                 std::cout << "Query features sent successfully!" << std::endl;
                 std::cout << "Response: " << response_data << std::endl;
@@ -304,49 +375,172 @@ namespace dice::endpoint {
         return response_json["query_plan"].get<std::vector<std::string>>();
     }
 
+    namespace {
+        /**
+         * Responds with a body of SPARQL results. The profile is sent in a header, so the body is the same with and without profiling.
+         */
+        template<typename Body>
+        void respond(restinio::request_handle_t const &req, std::optional<QueryProfile> const &profile, Body body) {
+            using namespace restinio;
+            auto response = req->create_response(status_ok());
+            response.append_header(http_field::content_type, "application/sparql-results+json");
+            if (profile)
+                response.append_header(std::string{QueryProfile::header}, profile->to_json());
+            response.set_body(std::move(body));
+            response.done();
+        }
+    }// namespace
+
     void SPARQLEndpoint::handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) {
         using namespace dice::sparql2tensor;
         using namespace restinio;
 
+        auto profile = QueryProfile::of(req);
+
         auto sparql_query = parse_sparql_query_param(req, this->sparql_query_cache_);
         if (not sparql_query)
             return;
+        if (profile)
+            profile->end_phase("parse");
+
+        // the generation is read before evaluating, so a result that overlaps a load is never valid afterwards
+        auto const generation = this->triplestore_.generation();
+        auto result_key = sparql_query.result_key("sparql");
+        if (auto cached = this->result_cache_.find(result_key, generation)) {
+            if (profile) {
+                profile->end_phase("result_cache");
+                profile->result_cached = true;
+            }
+            respond(req, profile, std::move(cached));
+            spdlog::info("HTTP response {}: served from the result cache", status_ok());
+            return;
+        }
+        if (profile)
+            profile->end_phase("result_cache");
+
+        // queries with a mandatory triple pattern that has no match are answered without planning and evaluation.
+        // COUNT aggregates still have one solution with the count 0.
+        bool const trivially_empty = not sparql_query->count_ and this->triplestore_.has_empty_mandatory_operand(*sparql_query);
+        if (profile)
+            profile->end_phase("empty_check");
+        if (trivially_empty) {
+            if (sparql_query->ask_) {
+                respond(req, profile, std::string{R"({ "head" : {}, "boolean" : false })"});
+            } else {
+                SparqlJsonResultSAXWriter json_writer{sparql_query.result_variable_names, 1'000};
+                json_writer.close();
+                respond(req, profile, json_writer.release());
+            }
+            spdlog::info("HTTP response {}: empty result; a mandatory triple pattern has no match", status_ok());
+            return;
+        }
 
-        // Collect query features for DRL
-        QueryFeatures features = extract_query_features(*sparql_query, timeout);
+        auto const compute_start_time = std::chrono::steady_clock::now();
+
+        // COUNT aggregates are contracted without projected variables, so they need no plan
+        std::vector<std::string> query_plan;
+        double cost;
+        if (not sparql_query->count_) {
+            // Collect query features for DRL
+            QueryFeatures features = extract_query_features(this->triplestore_, *sparql_query);
+            cost = features.total_query_cardinality;
+            if (profile) {
+                profile->end_phase("features");
+                if (features.variable_cardinalities.size() == features.variable_names.size()) {
+                    for (size_t i = 0; i < features.variable_names.size(); ++i)
+                        profile->variable_cardinalities.emplace_back(features.variable_names[i], features.variable_cardinalities[i]);
+                }
+            }
 
-        // Method 3: Send to API immediately
-        // Send query features to API and get the response
-        std::string api_response = send_query_features_to_api(features);
-        std::cout << "API Response: " << api_response << std::endl;
-        std::vector<std::string> query_plan = parse_query_plan(api_response);
+            // Method 3: Send to API immediately
+            // Send query features to API and get the response
+            std::string api_response = send_query_features_to_api(features);
+            std::cout << "API Response: " << api_response << std::endl;
+            query_plan = parse_query_plan(api_response);
+            if (profile)
+                profile->end_phase("planner");
+        } else {
+            cost = this->estimate_cost(*sparql_query);
+        }
         // for (const std::string& s : query_plan) {
         //     std::cout << s << "\t";
         // }
         // std::cout << std::endl;
 
+        // the evaluation may wait for the scheduler and continue on another thread
+        if (profile)
+            profile->suspend();
+        this->evaluate(req, cost, timeout,
+                       evaluate_query(req, std::move(sparql_query), std::move(query_plan), std::move(profile), std::move(result_key),
+                                      generation, compute_start_time, timeout));
+    }
+
+    Endpoint::Evaluation SPARQLEndpoint::evaluate_query(restinio::request_handle_t req, RequestedQuery sparql_query, std::vector<std::string> query_plan,
+                                                        std::optional<QueryProfile> profile, std::string result_key, uint64_t generation,
+                                                        std::chrono::steady_clock::time_point compute_start_time, std::chrono::steady_clock::time_point timeout) {
+        using namespace restinio;
+
+        if (profile)
+            profile->resume();
+        // the query may have waited for the scheduler
+        check_timeout(timeout);
         auto start_time = std::chrono::steady_clock::now(); // Start timing
 
+        auto *const evaluation_profile = (profile) ? &profile->evaluation : nullptr;
         if (sparql_query->ask_) {
-            bool ask_res = this->triplestore_.eval_ask(*sparql_query, timeout);
+            bool ask_res = this->triplestore_.eval_ask(*sparql_query, timeout, evaluation_profile);
+            if (profile) {
+                // the slicing happens within the evaluation; it is reported separately
+                profile->end_phase("evaluation", profile->evaluation.slicing);
+                profile->add_phase("slicing", profile->evaluation.slicing);
+            }
             std::string res = ask_res ? "true" : "false";
-            req->create_response(status_ok())
-                    .append_header(http_field::content_type, "application/sparql-results+json")
-                    .set_body(R"({ "head" : {}, "boolean" : )" + res + " }")
-                    .done();
+            auto body = std::make_shared<std::string const>(R"({ "head" : {}, "boolean" : )" + res + " }");
+            this->result_cache_.offer(result_key, body, std::chrono::steady_clock::now() - compute_start_time, generation);
+            respond(req, profile, std::move(body));
         } else {
-            SparqlJsonResultSAXWriter json_writer{sparql_query->projected_variables_, 100'000};
-
-            for (auto const &entry : this->triplestore_.eval_select(*sparql_query, timeout, query_plan)) {
-                json_writer.add(entry);
+            SparqlJsonResultSAXWriter json_writer{sparql_query.result_variable_names, 100'000};
+
+            // the solutions are serialized while they are evaluated; with profiling, the serialization is timed per solution
+            std::chrono::steady_clock::duration serialization{};
+            TimeSlice time_slice{this->scheduler_.time_slice()};
+            for (auto const &entry : this->triplestore_.eval_select(*sparql_query, timeout, query_plan, evaluation_profile)) {
+                if (profile) {
+                    auto const serialization_start = std::chrono::steady_clock::now();
+                    json_writer.add(entry);
+                    serialization += std::chrono::steady_clock::now() - serialization_start;
+                } else {
+                    json_writer.add(entry);
+                }
+                // between two solutions, the evaluation may be suspended in favor of cheaper queries
+                if (time_slice.over()) {
+                    if (profile)
+                        profile->suspend();
+                    co_yield std::monostate{};
+                    if (profile)
+                        profile->resume();
+                    check_timeout(timeout);
+                    time_slice.restart();
+                }
+            }
+            if (profile) {
+                auto const serialization_start = std::chrono::steady_clock::now();
+                json_writer.close();
+                serialization += std::chrono::steady_clock::now() - serialization_start;
+                // the slicing and the serialization happen within the evaluation; they are reported separately
+                profile->end_phase("evaluation", profile->evaluation.slicing + serialization);
+                profile->add_phase("slicing", profile->evaluation.slicing);
+                profile->add_phase("serialization", serialization);
+                profile->solutions = json_writer.number_of_written_solutions();
+                profile->bindings = json_writer.number_of_written_bindings();
+            } else {
+                json_writer.close();
             }
-            json_writer.close();
             check_timeout(timeout);
 
-            req->create_response(status_ok())
-                    .append_header(http_field::content_type, "application/sparql-results+json")
-                    .set_body(std::string{json_writer.string_view()})
-                    .done();
+            auto body = std::make_shared<std::string const>(json_writer.release());
+            this->result_cache_.offer(result_key, body, std::chrono::steady_clock::now() - compute_start_time, generation);
+            respond(req, profile, std::move(body));
             spdlog::info("HTTP response {}: {} variables, {} solutions, {} bindings",
                          status_ok(),
                          sparql_query->projected_variables_.size(),
@@ -359,8 +553,6 @@ namespace dice::endpoint {
         double runtime_seconds = execution_time / 1000.0;
         send_runtime_to_api(runtime_seconds);
         spdlog::info("Query execution time: {} ms", execution_time); // Log execution time
-
-
     }
 
 }// namespace dice::endpoint
\ No newline at end of file
@@ -3,5 +3,35 @@
 #include <dice/sparql2tensor/SPARQLQuery.hpp>
 
 namespace dice::endpoint {
-	template class SyncedLRUCache<std::string, dice::sparql2tensor::SPARQLQuery>;
-}// namespace dice::endpoint
\ No newline at end of file
+	namespace {
+		/**
+		 * @return the bytes of the tables of the VALUES blocks
+		 */
+		size_t values_bytes(sparql2tensor::SPARQLQuery const &query) noexcept {
+			size_t bytes = 0;
+			for (auto const &values : query.values_)
+				bytes += values.rows.size() * (sizeof(std::vector<rdf4cpp::rdf::Node>) + values.variables.size() * sizeof(rdf4cpp::rdf::Node));
+			return bytes;
+		}
+	}// namespace
+
+	size_t SparqlQueryWeigher::operator()(std::string const &query_str, sparql2tensor::SPARQLQuery const &query) const noexcept {
+		// per operand: the triple pattern, its slice key and its node in the operand dependency graph
+		static constexpr size_t bytes_per_operand = sizeof(rdf4cpp::rdf::query::TriplePattern) + 3 * sizeof(std::optional<rdf4cpp::rdf::Node>) + 128;
+		// per variable: entries in var_to_id_, id_to_var_ and the feature name vectors
+		static constexpr size_t bytes_per_variable = 2 * sizeof(rdf4cpp::rdf::query::Variable) + 64;
+		// per FILTER conjunct: a small expression tree
+		static constexpr size_t bytes_per_filter = 4 * sizeof(sparql2tensor::FilterExpression);
+		// per property path pattern: a small path tree and its node in the operand dependency graph
+		static constexpr size_t bytes_per_path = sizeof(sparql2tensor::PathPattern) + 4 * sizeof(sparql2tensor::PropertyPath) + 128;
+		return sizeof(std::string) + query_str.capacity() + sizeof(sparql2tensor::SPARQLQuery) +
+			   query.triple_patterns_.size() * bytes_per_operand +
+			   query.var_to_id_.size() * bytes_per_variable +
+			   query.filters_.size() * bytes_per_filter +
+			   values_bytes(query) +
+			   query.path_patterns_.size() * bytes_per_path +
+			   query.projected_variables_.size() * sizeof(rdf4cpp::rdf::query::Variable);
+	}
+
+	template class ConcurrentQueryCache<std::string, dice::sparql2tensor::SPARQLQuery, SparqlQueryWeigher>;
+}// namespace dice::endpoint
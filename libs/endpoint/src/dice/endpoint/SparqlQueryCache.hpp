@@ -3,11 +3,18 @@
 
 #include <dice/sparql2tensor/SPARQLQuery.hpp>
 
-#include <dice/endpoint/SyncedLRUCache.hpp>
+#include <dice/endpoint/ConcurrentQueryCache.hpp>
 
 namespace dice::endpoint {
 
-	using SparqlQueryCache = SyncedLRUCache<std::string, sparql2tensor::SPARQLQuery>;
+	/**
+	 * Estimates the memory footprint of a parsed query together with its query string.
+	 */
+	struct SparqlQueryWeigher {
+		size_t operator()(std::string const &query_str, sparql2tensor::SPARQLQuery const &query) const noexcept;
+	};
+
+	using SparqlQueryCache = ConcurrentQueryCache<std::string, sparql2tensor::SPARQLQuery, SparqlQueryWeigher>;
 
 }
 #endif//TENTRIS_SPARQLQUERYCACHE_HPP
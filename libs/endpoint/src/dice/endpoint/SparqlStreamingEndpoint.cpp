@@ -4,6 +4,7 @@
 
 #include <dice/endpoint/ParseSPARQLQueryParam.hpp>
 #include <dice/endpoint/SparqlJsonResultSAXWriter.hpp>
+#include <dice/endpoint/TimeoutCheck.hpp>
 
 namespace dice::endpoint {
 
@@ -11,38 +12,59 @@ namespace dice::endpoint {
     SPARQLStreamingEndpoint::SPARQLStreamingEndpoint(tf::Executor &executor,
                                                      triple_store::TripleStore &triplestore,
                                                      SparqlQueryCache &sparql_query_cache,
+                                                     ResultCache &result_cache,
+                                                     QueryScheduler &scheduler,
                                                      EndpointCfg const &endpoint_cfg)
-        : Endpoint(executor, triplestore, sparql_query_cache, endpoint_cfg) {}
+        : Endpoint(executor, triplestore, sparql_query_cache, result_cache, scheduler, endpoint_cfg) {}
 
     void SPARQLStreamingEndpoint::handle_query(restinio::request_handle_t req, std::chrono::steady_clock::time_point timeout) {
         using namespace dice::sparql2tensor;
         using namespace restinio;
 
-        std::shared_ptr<SPARQLQuery const> sparql_query = parse_sparql_query_param(req, this->sparql_query_cache_);
+        auto sparql_query = parse_sparql_query_param(req, this->sparql_query_cache_);
         if (not sparql_query)
             return;
 
+        auto const cost = this->estimate_cost(*sparql_query);
+        this->evaluate(req, cost, timeout, stream_query(req, std::move(sparql_query), timeout));
+    }
+
+    Endpoint::Evaluation SPARQLStreamingEndpoint::stream_query(restinio::request_handle_t req, RequestedQuery sparql_query,
+                                                               std::chrono::steady_clock::time_point timeout) {
+        using namespace restinio;
+
+        // the query may have waited for the scheduler
+        check_timeout(timeout);
         bool asio_write_failed = false;
 
-        SparqlJsonResultSAXWriter json_writer{sparql_query->projected_variables_, 100'000};
+        SparqlJsonResultSAXWriter json_writer{sparql_query.result_variable_names, 100'000};
 
         response_builder_t<chunked_output_t> resp = req->template create_response<chunked_output_t>();
         resp.append_header(http_field::content_type, "application/sparql-results+json");
 
-        for (auto const &entry : this->triplestore_.eval_select(*sparql_query, timeout)) {
-            json_writer.add(entry);
-            if (json_writer.full()) {
-                resp.append_chunk(std::string{json_writer.string_view()});
-                resp.flush([&](auto const &status) { asio_write_failed = status.failed(); });
-                if (asio_write_failed) {
-                    spdlog::warn("Writing chunked HTTP response failed.");
-                    return;
+        // queries with a mandatory triple pattern that has no match are not evaluated, except COUNT aggregates, which still have one solution
+        if (sparql_query->count_ or not this->triplestore_.has_empty_mandatory_operand(*sparql_query)) {
+            TimeSlice time_slice{this->scheduler_.time_slice()};
+            for (auto const &entry : this->triplestore_.eval_select(*sparql_query, timeout)) {
+                json_writer.add(entry);
+                if (json_writer.full()) {
+                    resp.append_chunk(json_writer.release());
+                    resp.flush([&](auto const &status) { asio_write_failed = status.failed(); });
+                    if (asio_write_failed) {
+                        spdlog::warn("Writing chunked HTTP response failed.");
+                        co_return;
+                    }
+                }
+                // the stream is only suspended between solutions, so each chunk holds complete solutions
+                if (time_slice.over()) {
+                    co_yield std::monostate{};
+                    check_timeout(timeout);
+                    time_slice.restart();
                 }
-                json_writer.clear();
             }
         }
         json_writer.close();
-        resp.append_chunk(std::string{json_writer.string_view()});
+        resp.append_chunk(json_writer.release());
         resp.done();
         spdlog::info("HTTP response {}: {} variables, {} solutions, {} bindings",
                      status_ok(),
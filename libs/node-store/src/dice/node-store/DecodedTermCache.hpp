@@ -0,0 +1,143 @@
+#ifndef TENTRIS_DECODEDTERMCACHE_HPP
+#define TENTRIS_DECODEDTERMCACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace dice::node_store {
+
+	/**
+	 * Hit/miss counters of the decoded-term caches.
+	 */
+	struct DecodedTermCacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+
+		[[nodiscard]] size_t lookups() const noexcept { return hits + misses; }
+
+		[[nodiscard]] double hit_rate() const noexcept {
+			return (lookups() == 0) ? 0.0 : double(hits) / double(lookups());
+		}
+	};
+
+	/**
+	 * Counters shared by all decoded-term caches of a thread.
+	 * The counters are kept thread-local and are flushed into process-wide totals every flush_interval lookups and when the thread exits.
+	 * Thus, the hot path never writes to memory that is shared between threads.
+	 */
+	class DecodedTermCacheCounters {
+		static constexpr size_t flush_interval = 4096;
+
+		inline static std::atomic<size_t> total_hits_{0};
+		inline static std::atomic<size_t> total_misses_{0};
+
+		DecodedTermCacheStats local_;
+		DecodedTermCacheStats unflushed_;
+
+		DecodedTermCacheCounters() noexcept = default;
+
+		void flush() noexcept {
+			total_hits_.fetch_add(unflushed_.hits, std::memory_order_relaxed);
+			total_misses_.fetch_add(unflushed_.misses, std::memory_order_relaxed);
+			unflushed_ = {};
+		}
+
+		void maybe_flush() noexcept {
+			if (unflushed_.lookups() >= flush_interval)
+				flush();
+		}
+
+	public:
+		~DecodedTermCacheCounters() { flush(); }
+
+		static DecodedTermCacheCounters &this_thread() noexcept {
+			thread_local DecodedTermCacheCounters counters;
+			return counters;
+		}
+
+		void hit() noexcept {
+			++local_.hits;
+			++unflushed_.hits;
+			maybe_flush();
+		}
+
+		void miss() noexcept {
+			++local_.misses;
+			++unflushed_.misses;
+			maybe_flush();
+		}
+
+		/**
+		 * @return exact counters of the calling thread
+		 */
+		[[nodiscard]] DecodedTermCacheStats const &stats() const noexcept { return local_; }
+
+		/**
+		 * @return counters of all threads. Lookups of running threads are included with a lag of at most flush_interval per thread.
+		 */
+		[[nodiscard]] static DecodedTermCacheStats global_stats() noexcept {
+			return {.hits = total_hits_.load(std::memory_order_relaxed),
+					.misses = total_misses_.load(std::memory_order_relaxed)};
+		}
+	};
+
+	/**
+	 * Direct-mapped cache from raw NodeIDs to the backend views of a MetallNodeTypeStorage.
+	 * It is meant to be used thread_local and needs no synchronization.
+	 *
+	 * Caching is safe because node backends are never moved or erased once they are stored in the persistent node storage.
+	 * So a view into the metall segment stays valid for the lifetime of the storage.
+	 * @tparam View the backend view type that is cached
+	 * @tparam capacity number of slots, must be a power of two
+	 */
+	template<typename View, size_t capacity = 1024>
+	class DecodedTermCache {
+		static_assert(std::has_single_bit(capacity), "capacity must be a power of two.");
+		static constexpr int index_shift = 64 - std::countr_zero(capacity);
+
+		struct Slot {
+			uint64_t id = 0;// 0 is the null NodeID and is never stored
+			View view{};
+		};
+
+		void const *owner_ = nullptr;
+		std::array<Slot, capacity> slots_{};
+
+		static size_t slot_index(uint64_t id) noexcept {
+			// fibonacci hashing spreads consecutive IDs over the slots
+			return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> index_shift);
+		}
+
+	public:
+		/**
+		 * Returns the cached view for id or resolves, caches and returns it.
+		 * @param owner the storage the id belongs to. If it changes, the cache is invalidated.
+		 * @param id raw NodeID
+		 * @param resolve function that resolves the view if it is not cached. Exceptions are propagated and nothing is cached.
+		 */
+		template<typename Resolve>
+		View get_or_resolve(void const *owner, uint64_t id, Resolve &&resolve) {
+			if (owner != owner_) [[unlikely]] {
+				slots_.fill(Slot{});
+				owner_ = owner;
+			}
+			auto &counters = DecodedTermCacheCounters::this_thread();
+			Slot &slot = slots_[slot_index(id)];
+			if (slot.id == id and id != 0) [[likely]] {
+				counters.hit();
+				return slot.view;
+			}
+			counters.miss();
+			View view = resolve();
+			slot.id = id;
+			slot.view = view;
+			return view;
+		}
+	};
+
+}// namespace dice::node_store
+
+#endif//TENTRIS_DECODEDTERMCACHE_HPP
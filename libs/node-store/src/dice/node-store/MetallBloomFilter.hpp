@@ -0,0 +1,85 @@
+#ifndef TENTRIS_METALLBLOOMFILTER_HPP
+#define TENTRIS_METALLBLOOMFILTER_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/container/vector.hpp>
+
+#include <dice/node-store/metall_manager.hpp>
+
+namespace dice::node_store {
+
+	/**
+	 * Blocked Bloom filter over term hashes that is stored in the metall segment.
+	 * All bits of a key are set within one cache line, so a negative lookup costs a single cache miss.
+	 * An empty (not yet built) filter answers every query with "maybe".
+	 * The filter is not synchronized; it is guarded by the mutex of the storage that owns it.
+	 */
+	class MetallBloomFilter {
+		static constexpr size_t words_per_block = 8;// 512 bit = one cache line
+		static constexpr size_t bits_per_key = 10;
+		static constexpr size_t bits_per_lookup = 6;
+
+		boost::container::vector<uint64_t, metall_manager::allocator_type<uint64_t>> words_;
+
+		static uint64_t remix(size_t hash) noexcept {
+			// the hash is also used by the hash maps; decorrelate the bits that the filter uses
+			uint64_t x = hash;
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			return x;
+		}
+
+		template<typename F>
+		void for_each_bit(size_t hash, F &&f) const noexcept {
+			auto const mixed = remix(hash);
+			size_t const blocks = words_.size() / words_per_block;
+			size_t const block = static_cast<size_t>((mixed >> 32) & (blocks - 1)) * words_per_block;
+			uint32_t bits = static_cast<uint32_t>(mixed);
+			for (size_t i = 0; i < bits_per_lookup; ++i) {
+				// 9 bits address one of the 512 bits of the block
+				auto const bit = bits & 511U;
+				f(block + (bit >> 6), uint64_t(1) << (bit & 63U));
+				bits = std::rotr(bits, 9) + static_cast<uint32_t>(mixed >> 40);
+			}
+		}
+
+	public:
+		explicit MetallBloomFilter(metall_manager::allocator_type<std::byte> const &alloc) : words_(alloc) {}
+
+		[[nodiscard]] bool built() const noexcept { return not words_.empty(); }
+
+		/**
+		 * Clears the filter and sizes it for the expected number of keys.
+		 */
+		void reset(size_t expected_keys) {
+			size_t const blocks = std::bit_ceil(std::max<size_t>(1, expected_keys * bits_per_key / (64 * words_per_block)));
+			words_.assign(blocks * words_per_block, 0);
+		}
+
+		void insert(size_t hash) noexcept {
+			if (not built())
+				return;
+			for_each_bit(hash, [this](size_t word, uint64_t mask) { words_[word] |= mask; });
+		}
+
+		/**
+		 * @return false if no key with this hash was inserted. true if it might have been inserted or if the filter is not built.
+		 */
+		[[nodiscard]] bool may_contain(size_t hash) const noexcept {
+			if (not built())
+				return true;
+			bool contained = true;
+			for_each_bit(hash, [this, &contained](size_t word, uint64_t mask) { contained &= (words_[word] & mask) != 0; });
+			return contained;
+		}
+
+		[[nodiscard]] size_t size_in_bytes() const noexcept { return words_.size() * sizeof(uint64_t); }
+	};
+}// namespace dice::node_store
+
+#endif//TENTRIS_METALLBLOOMFILTER_HPP
@@ -0,0 +1,48 @@
+#include "MetallLanguageTagTable.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+namespace dice::node_store {
+
+	MetallLanguageTagTable::MetallLanguageTagTable(metall_manager::allocator_type<std::byte> const &allocator)
+		: allocator_(allocator), chunks_(), size_(0), tag2id_(allocator) {
+		string_allocator_type string_allocator{allocator_};
+		chunks_[0] = string_allocator.allocate(chunk_size);
+		// ID 0 is the empty language tag
+		std::construct_at(&slot(0), std::string_view{}, allocator_);
+		size_.store(1, std::memory_order_release);
+	}
+
+	MetallLanguageTagTable::~MetallLanguageTagTable() {
+		string_allocator_type string_allocator{allocator_};
+		auto const size = this->size();
+		for (size_t id = 0; id < size; ++id)
+			std::destroy_at(&slot(static_cast<id_type>(id)));
+		for (auto &chunk : chunks_) {
+			if (chunk)
+				string_allocator.deallocate(chunk, chunk_size);
+		}
+	}
+
+	MetallLanguageTagTable::id_type MetallLanguageTagTable::find_or_make_id(std::string_view tag) {
+		if (tag.empty())
+			return 0;
+		std::unique_lock lock{mutex_};
+		if (auto found = tag2id_.find(tag); found != tag2id_.end())
+			return found->second;
+
+		auto const id = static_cast<id_type>(size_.load(std::memory_order_relaxed));
+		if (id == max_size)
+			throw std::runtime_error{"Too many distinct language tags."};
+		string_allocator_type string_allocator{allocator_};
+		if (id % chunk_size == 0)
+			chunks_[id / chunk_size] = string_allocator.allocate(chunk_size);
+		std::construct_at(&slot(id), tag, allocator_);
+		tag2id_.emplace(metall_string{tag, allocator_}, id);
+		// the slot is complete before readers can observe the new size
+		size_.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+}// namespace dice::node_store
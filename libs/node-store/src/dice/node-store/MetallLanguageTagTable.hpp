@@ -0,0 +1,101 @@
+#ifndef TENTRIS_METALLLANGUAGETAGTABLE_HPP
+#define TENTRIS_METALLLANGUAGETAGTABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+#include <dice/hash/DiceHash.hpp>
+#include <dice/sparse-map/sparse_map.hpp>
+
+#include <dice/node-store/metall_manager.hpp>
+
+namespace dice::node_store {
+
+	/**
+	 * Persistent table of interned language tags. Literals reference their language tag by a small integer ID.
+	 * ID 0 is reserved for the empty language tag, i.e., literals without a language tag.
+	 *
+	 * Tags are stored in fixed-size chunks that are never moved. So resolving an ID is lock-free, while interning is synchronized by a mutex.
+	 */
+	class MetallLanguageTagTable {
+	public:
+		using id_type = uint32_t;
+
+		static constexpr size_t chunk_size = 256;
+		static constexpr size_t max_chunks = 4096;
+		static constexpr size_t max_size = chunk_size * max_chunks;
+
+	private:
+		using string_allocator_type = metall_manager::allocator_type<metall_string>;
+		using chunk_ptr = typename string_allocator_type::pointer;
+
+		struct TagHash {
+			[[nodiscard]] size_t operator()(std::string_view tag) const noexcept {
+				return dice::hash::DiceHashwyhash<std::string_view>{}(tag);
+			}
+			[[nodiscard]] size_t operator()(metall_string const &tag) const noexcept {
+				return (*this)(std::string_view{tag});
+			}
+		};
+
+		struct TagEqual {
+			using is_transparent = void;
+
+			[[nodiscard]] bool operator()(metall_string const &lhs, metall_string const &rhs) const noexcept {
+				return lhs == rhs;
+			}
+			[[nodiscard]] bool operator()(std::string_view lhs, metall_string const &rhs) const noexcept {
+				return lhs == std::string_view{rhs};
+			}
+		};
+
+		mutable std::mutex mutex_;
+		metall_manager::allocator_type<std::byte> allocator_;
+		std::array<chunk_ptr, max_chunks> chunks_;
+		std::atomic<id_type> size_;
+		dice::sparse_map::sparse_map<metall_string, id_type, TagHash, TagEqual,
+									 metall_manager::allocator_type<std::pair<metall_string, id_type>>>
+				tag2id_;
+
+		[[nodiscard]] metall_string &slot(id_type id) const noexcept {
+			return chunks_[id / chunk_size][id % chunk_size];
+		}
+
+	public:
+		explicit MetallLanguageTagTable(metall_manager::allocator_type<std::byte> const &allocator);
+
+		~MetallLanguageTagTable();
+
+		MetallLanguageTagTable(MetallLanguageTagTable const &) = delete;
+		MetallLanguageTagTable &operator=(MetallLanguageTagTable const &) = delete;
+
+		/**
+		 * Returns the ID of a language tag and interns the tag if it is new.
+		 * @param tag a language tag; the empty tag always has ID 0
+		 * @return the ID of tag
+		 * @throws std::runtime_error if the table is full
+		 */
+		[[nodiscard]] id_type find_or_make_id(std::string_view tag);
+
+		/**
+		 * @param id an ID that was returned by find_or_make_id
+		 * @return the language tag with the ID
+		 */
+		[[nodiscard]] std::string_view operator[](id_type id) const noexcept {
+			return slot(id);
+		}
+
+		/**
+		 * @return number of interned tags including the empty tag
+		 */
+		[[nodiscard]] size_t size() const noexcept {
+			return size_.load(std::memory_order_acquire);
+		}
+	};
+
+}// namespace dice::node_store
+
+#endif//TENTRIS_METALLLANGUAGETAGTABLE_HPP
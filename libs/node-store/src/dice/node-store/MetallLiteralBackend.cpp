@@ -2,14 +2,14 @@
 #include <dice/hash/DiceHash.hpp>
 #include <tuple>
 namespace dice::node_store {
-	MetallLiteralBackend::MetallLiteralBackend(rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView view, metall_manager::allocator_type<std::byte> const &allocator) noexcept
+	MetallLiteralBackend::MetallLiteralBackend(View view, MetallLanguageTagTable &language_tags, metall_manager::allocator_type<std::byte> const &allocator)
 		: hash_(view.hash()),
-          datatype_id_(view.datatype_id),
 		  lexical(view.lexical_form, allocator),
-		  lang_tag(view.language_tag, allocator),
+		  datatype_id_(view.datatype_id),
+		  lang_tag_id_(language_tags.find_or_make_id(view.language_tag)),
 		  needs_escape_(view.needs_escape) {}
-	std::string_view MetallLiteralBackend::language_tag() const noexcept {
-		return lang_tag;
+	std::string_view MetallLiteralBackend::language_tag(MetallLanguageTagTable const &language_tags) const noexcept {
+		return language_tags[lang_tag_id_];
 	}
 	const rdf4cpp::rdf::storage::node::identifier::NodeID &MetallLiteralBackend::datatype_id() const noexcept {
 		return datatype_id_;
@@ -20,10 +20,10 @@ namespace dice::node_store {
     bool MetallLiteralBackend::needs_escape() const noexcept {
 	    return needs_escape_;
 	}
-	MetallLiteralBackend::operator rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView() const noexcept {
+	MetallLiteralBackend::View MetallLiteralBackend::view(MetallLanguageTagTable const &language_tags) const noexcept {
 		return {.datatype_id = datatype_id(),
 				.lexical_form = lexical_form(),
-				.language_tag = language_tag(),
+				.language_tag = language_tag(language_tags),
 		        .needs_escape = needs_escape()};
 	}
 
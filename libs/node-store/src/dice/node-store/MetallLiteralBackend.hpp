@@ -3,33 +3,77 @@
 
 #include <rdf4cpp/rdf/storage/node/view/LiteralBackendView.hpp>
 
+#include <dice/node-store/MetallLanguageTagTable.hpp>
 #include <dice/node-store/metall_manager.hpp>
 
 namespace dice::node_store {
 
+	/**
+	 * Compact literal record. The language tag is referenced by its ID in the MetallLanguageTagTable of the node store.
+	 * Fields are ordered by alignment, so that the record has no internal padding.
+	 */
 	class MetallLiteralBackend {
 		size_t hash_;
-		rdf4cpp::rdf::storage::node::identifier::NodeID datatype_id_;
 		metall_string lexical;
-		metall_string lang_tag;
+		rdf4cpp::rdf::storage::node::identifier::NodeID datatype_id_;
+		MetallLanguageTagTable::id_type lang_tag_id_;
 		bool needs_escape_;
 
 	public:
 		using View = rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView;
 
-		MetallLiteralBackend(rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView view, metall_manager::allocator_type<std::byte> const &allocator) noexcept;
+		/**
+		 * @param view the literal
+		 * @param language_tags the language tag table of the node store; the language tag of the literal is interned in it
+		 * @param allocator allocator for the lexical form
+		 * @throws std::runtime_error if the language tag table is full
+		 */
+		MetallLiteralBackend(View view, MetallLanguageTagTable &language_tags, metall_manager::allocator_type<std::byte> const &allocator);
 
 		[[nodiscard]] std::string_view lexical_form() const noexcept;
 
 		[[nodiscard]] const rdf4cpp::rdf::storage::node::identifier::NodeID &datatype_id() const noexcept;
 
-		[[nodiscard]] std::string_view language_tag() const noexcept;
+		/**
+		 * @param language_tags the table that the literal was constructed with
+		 */
+		[[nodiscard]] std::string_view language_tag(MetallLanguageTagTable const &language_tags) const noexcept;
 
 		[[nodiscard]] bool needs_escape() const noexcept;
 
 		[[nodiscard]] size_t hash() const noexcept { return hash_; }
 
-		explicit operator rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView() const noexcept;
+		/**
+		 * @param language_tags the table that the literal was constructed with
+		 */
+		[[nodiscard]] View view(MetallLanguageTagTable const &language_tags) const noexcept;
+	};
+
+	/**
+	 * Constructs and decodes MetallLiteralBackends with the language tag table of their node store.
+	 * It is stored in the metall segment together with the table, so the table is referenced by an offset pointer.
+	 */
+	class MetallLiteralBackendCodec {
+		using Backend_allocator_type = metall_manager::allocator_type<MetallLiteralBackend>;
+
+		metall_manager::allocator_type<MetallLanguageTagTable>::pointer language_tags_;
+
+	public:
+		using Backend = MetallLiteralBackend;
+		using View = MetallLiteralBackend::View;
+
+		explicit MetallLiteralBackendCodec(MetallLanguageTagTable *language_tags) noexcept : language_tags_(language_tags) {}
+
+		/**
+		 * @throws std::runtime_error if the language tag table is full
+		 */
+		void construct(Backend_allocator_type &allocator, Backend_allocator_type::pointer mem, View const &view) const {
+			allocator.construct(mem, view, *language_tags_, allocator);
+		}
+
+		[[nodiscard]] View decode(MetallLiteralBackend const &backend) const noexcept {
+			return backend.view(*language_tags_);
+		}
 	};
 
 }// namespace dice::node_store
@@ -6,18 +6,41 @@
 
 #include <rdf4cpp/rdf/storage/node/identifier/NodeID.hpp>
 
+#include "dice/node-store/MetallBloomFilter.hpp"
+
 #include <shared_mutex>
 
 
 namespace dice::node_store {
 	/**
+	 * Constructs Node Backends from views and decodes them back, for Node Backends that are self-contained.
+	 * @tparam BackendType_t one of BNodeBackend, IRIBackend and VariableBackend.
+	 */
+	template<class BackendType_t>
+	struct MetallBackendCodec {
+		using Backend = BackendType_t;
+		using Backend_allocator_type = metall_manager::allocator_type<Backend>;
+		using View = typename Backend::View;
+
+		void construct(Backend_allocator_type &allocator, typename Backend_allocator_type::pointer mem, View const &view) const {
+			allocator.construct(mem, view, allocator);
+		}
+
+		[[nodiscard]] View decode(Backend const &backend) const noexcept {
+			return View(backend);
+		}
+	};
+
+	/**
  * Storage for one of the Node Backend types. Includes a shared mutex to synchronize access and bidirectional mappings between the Backend type and identifier::NodeID.
  * @tparam BackendType_t one of BNodeBackend, IRIBackend, LiteralBackend and VariableBackend.
+ * @tparam Codec_t constructs Node Backends from views and decodes them
  */
-	template<class BackendType_t>
+	template<class BackendType_t, class Codec_t = MetallBackendCodec<BackendType_t>>
 	struct MetallNodeTypeStorage {
 		using allocator_type = rdf_tensor::allocator_type;
 		using Backend = BackendType_t;
+		using Codec = Codec_t;
 		using Backend_allocator_type = metall_manager::allocator_type<Backend>;
 		using Backend_ptr = typename Backend_allocator_type::pointer;
 		using BackendView = typename Backend::View;
@@ -33,6 +56,8 @@ namespace dice::node_store {
 		struct BackendTypeEqual {
 			using is_transparent = void;
 
+			Codec codec;
+
 			bool operator()(Backend_ptr const &lhs, Backend_ptr const &rhs) const noexcept {
 				if (bool(lhs) and bool(rhs))
 					return lhs.get() == rhs.get();
@@ -41,7 +66,7 @@ namespace dice::node_store {
 			}
 			bool operator()(BackendView const &lhs, Backend_ptr const &rhs) const noexcept {
 				if (rhs)
-					return lhs == BackendView(*rhs);
+					return lhs == codec.decode(*rhs);
 				else
 					return false;
 			}
@@ -61,9 +86,42 @@ namespace dice::node_store {
 						metall_manager::allocator_type<std::pair<Backend_ptr, rdf4cpp::rdf::storage::node::identifier::NodeID>>>
 				data2id;
 
+		// filter over the hashes of the keys of data2id; lets lookups of absent terms skip probing data2id
+		MetallBloomFilter filter;
+
 		Backend_allocator_type backend_allocator;
+		Codec codec;
+
+		explicit MetallNodeTypeStorage(rdf_tensor::allocator_type const &alloc, Codec const &codec = {})
+			: mutex(), id2data(alloc), data2id(0, BackendTypeHash{}, BackendTypeEqual{codec}, alloc), filter(alloc), backend_allocator(alloc), codec(codec) {}
+
+		/**
+		 * Allocates and constructs a Node Backend. The unique lock must be held.
+		 * @throws std::bad_alloc or the exceptions of the codec, e.g., if a language tag cannot be interned
+		 */
+		[[nodiscard]] Backend_ptr make_backend(BackendView const &view) {
+			auto mem = backend_allocator.allocate(1);
+			try {
+				codec.construct(backend_allocator, mem, view);
+			} catch (...) {
+				backend_allocator.deallocate(mem, 1);
+				throw;
+			}
+			return mem;
+		}
+
+		[[nodiscard]] BackendView view(Backend const &backend) const noexcept {
+			return codec.decode(backend);
+		}
 
-		explicit MetallNodeTypeStorage(rdf_tensor::allocator_type const &alloc) : mutex(), id2data(alloc), data2id(alloc), backend_allocator(alloc) {}
+		/**
+		 * Rebuilds the filter from data2id. The unique lock must be held.
+		 */
+		void rebuild_filter() {
+			filter.reset(data2id.size());
+			for (auto const &[backend_ptr, id] : data2id)
+				filter.insert(backend_ptr->hash());
+		}
 	};
 }// namespace dice::node_store
 
@@ -1,48 +1,118 @@
 #include "PersistentNodeStorageBackend.hpp"
+
+#include <type_traits>
+
 namespace dice::node_store {
 
-	PersistentNodeStorageBackend::PersistentNodeStorageBackend(PersistentNodeStorageBackendImpl *impl)
-		: INodeStorageBackend(), impl_(impl) {}
+	PersistentNodeStorageBackend::PersistentNodeStorageBackend(PersistentNodeStorageBackendImpl *impl, bool persist_new_terms,
+															   InsertionErrorHandler on_insertion_error)
+		: INodeStorageBackend(),
+		  impl_(impl),
+		  transient_(persist_new_terms ? nullptr : std::make_unique<TransientNodeStorage>()),
+		  on_insertion_error_(std::move(on_insertion_error)) {}
+
+	// IRIs and literals are sharded and can be interned in bulk
+	template<typename View>
+	static constexpr bool stageable = std::is_same_v<View, rdf4cpp::rdf::storage::node::view::IRIBackendView> or
+									  std::is_same_v<View, rdf4cpp::rdf::storage::node::view::LiteralBackendView>;
+
+	/**
+	 * If new terms are not persisted, a term is looked up in the persistent storage first, which rejects most absent terms by its
+	 * Bloom filter, and it is kept in the transient storage if it is absent.
+	 * If they are persisted and the calling thread stages terms, IRIs and literals are staged, so that they are interned
+	 * together with the other terms of the batch.
+	 */
+	template<typename View>
+	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_or_make_id_impl(View const &view) noexcept {
+		try {
+			if (transient_ == nullptr) {
+				if constexpr (stageable<View>) {
+					if (auto *staging = TermStaging::of_this_thread(); staging != nullptr)
+						return staging->stage(*impl_, view);
+				}
+				return impl_->find_or_make_id(view);
+			}
+			if (auto const id = impl_->find_id(view); not id.null())
+				return id;
+			return transient_->find_or_make_id(view);
+		} catch (...) {
+			if (not on_insertion_error_)
+				std::terminate();
+			on_insertion_error_(std::current_exception());
+			return {};
+		}
+	}
+
+	template<typename View>
+	static rdf4cpp::rdf::storage::node::identifier::NodeID find_id_impl(PersistentNodeStorageBackendImpl const &impl, TransientNodeStorage const *transient, View const &view) noexcept {
+		if constexpr (stageable<View>) {
+			if (auto const *staging = TermStaging::of_this_thread(); transient == nullptr and staging != nullptr) {
+				if (auto const id = staging->find_id(view); not id.null())
+					return id;
+			}
+		}
+		auto const id = impl.find_id(view);
+		if (transient == nullptr or not id.null())
+			return id;
+		return transient->find_id(view);
+	}
+
     size_t PersistentNodeStorageBackend::size() const noexcept {
-	    return impl_->size();
+	    return impl_->size() + ((transient_) ? transient_->size() : 0);
 	}
     bool PersistentNodeStorageBackend::has_specialized_storage_for(rdf4cpp::rdf::storage::node::identifier::LiteralType datatype) const noexcept {
 	    return impl_->has_specialized_storage_for(datatype);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_or_make_id(const rdf4cpp::rdf::storage::node::view::BNodeBackendView &view) noexcept {
-		return impl_->find_or_make_id(view);
+		return find_or_make_id_impl(view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_or_make_id(const rdf4cpp::rdf::storage::node::view::IRIBackendView &view) noexcept {
-		return impl_->find_or_make_id(view);
+		return find_or_make_id_impl(view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_or_make_id(const rdf4cpp::rdf::storage::node::view::LiteralBackendView &view) noexcept {
-		return impl_->find_or_make_id(view);
+		return find_or_make_id_impl(view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_or_make_id(const rdf4cpp::rdf::storage::node::view::VariableBackendView &view) noexcept {
-		return impl_->find_or_make_id(view);
+		return find_or_make_id_impl(view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_id(const rdf4cpp::rdf::storage::node::view::BNodeBackendView &view) const noexcept {
-		return impl_->find_id(view);
+		return find_id_impl(*impl_, transient_.get(), view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_id(const rdf4cpp::rdf::storage::node::view::IRIBackendView &view) const noexcept {
-		return impl_->find_id(view);
+		return find_id_impl(*impl_, transient_.get(), view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_id(const rdf4cpp::rdf::storage::node::view::LiteralBackendView &view) const noexcept {
-		return impl_->find_id(view);
+		return find_id_impl(*impl_, transient_.get(), view);
 	}
 	rdf4cpp::rdf::storage::node::identifier::NodeID PersistentNodeStorageBackend::find_id(const rdf4cpp::rdf::storage::node::view::VariableBackendView &view) const noexcept {
-		return impl_->find_id(view);
+		return find_id_impl(*impl_, transient_.get(), view);
 	}
 	rdf4cpp::rdf::storage::node::view::IRIBackendView PersistentNodeStorageBackend::find_iri_backend_view(rdf4cpp::rdf::storage::node::identifier::NodeID id) const {
+		if (TransientNodeStorage::is_transient_id(id)) {
+			if (transient_)
+				return transient_->find_iri_backend_view(id);
+			if (auto const *staging = TermStaging::of_this_thread(); staging != nullptr)
+				return staging->find_iri_backend_view(id);
+		}
 		return impl_->find_iri_backend_view(id);
 	}
 	rdf4cpp::rdf::storage::node::view::LiteralBackendView PersistentNodeStorageBackend::find_literal_backend_view(rdf4cpp::rdf::storage::node::identifier::NodeID id) const {
+		if (TransientNodeStorage::is_transient_literal_id(id)) {
+			if (transient_)
+				return transient_->find_literal_backend_view(id);
+			if (auto const *staging = TermStaging::of_this_thread(); staging != nullptr)
+				return staging->find_literal_backend_view(id);
+		}
 		return impl_->find_literal_backend_view(id);
 	}
 	rdf4cpp::rdf::storage::node::view::BNodeBackendView PersistentNodeStorageBackend::find_bnode_backend_view(rdf4cpp::rdf::storage::node::identifier::NodeID id) const {
+		if (transient_ and TransientNodeStorage::is_transient_id(id))
+			return transient_->find_bnode_backend_view(id);
 		return impl_->find_bnode_backend_view(id);
 	}
 	rdf4cpp::rdf::storage::node::view::VariableBackendView PersistentNodeStorageBackend::find_variable_backend_view(rdf4cpp::rdf::storage::node::identifier::NodeID id) const {
+		if (transient_ and TransientNodeStorage::is_transient_id(id))
+			return transient_->find_variable_backend_view(id);
 		return impl_->find_variable_backend_view(id);
 	}
 	bool PersistentNodeStorageBackend::erase_iri([[maybe_unused]] rdf4cpp::rdf::storage::node::identifier::NodeID id) {
@@ -2,14 +2,42 @@
 #define TENTRIS_PERSISTENTNODESTORAGEBACKEND_HPP
 
 #include "dice/node-store/PersistentNodeStorageBackendImpl.hpp"
+#include "dice/node-store/TermStaging.hpp"
+#include "dice/node-store/TransientNodeStorage.hpp"
+
+#include <exception>
+#include <functional>
+#include <memory>
 
 namespace dice::node_store {
 
 	class PersistentNodeStorageBackend : public rdf4cpp::rdf::storage::node::INodeStorageBackend {
+	public:
+		/**
+		 * Is called with the exception if a term cannot be stored, e.g., because the language tag table is full.
+		 * The INodeStorageBackend interface does not allow find_or_make_id to throw, so it returns a null ID afterwards.
+		 */
+		using InsertionErrorHandler = std::function<void(std::exception_ptr)>;
+
+	private:
 		PersistentNodeStorageBackendImpl *impl_;
+		// terms that are not in impl_ if new terms are not persisted; nullptr otherwise
+		std::unique_ptr<TransientNodeStorage> transient_;
+		InsertionErrorHandler on_insertion_error_;
+
+		template<typename View>
+		rdf4cpp::rdf::storage::node::identifier::NodeID find_or_make_id_impl(View const &view) noexcept;
 
 	public:
-		explicit PersistentNodeStorageBackend(PersistentNodeStorageBackendImpl *impl);
+		/**
+		 * @param impl the persistent node storage
+		 * @param persist_new_terms if new terms are added to impl. Otherwise, impl is only read and terms that are not in it,
+		 * e.g., constants of queries that do not occur in the dataset, are kept in a process-local TransientNodeStorage.
+		 * If new terms are persisted, new IRIs and literals of threads with an active TermStaging::Scope are staged instead.
+		 * @param on_insertion_error is called if a term cannot be stored. If it is empty, such an error terminates the process.
+		 */
+		explicit PersistentNodeStorageBackend(PersistentNodeStorageBackendImpl *impl, bool persist_new_terms = true,
+											  InsertionErrorHandler on_insertion_error = {});
 
 		~PersistentNodeStorageBackend() override = default;
 
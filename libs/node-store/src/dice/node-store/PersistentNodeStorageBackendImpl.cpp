@@ -1,25 +1,34 @@
 #include "PersistentNodeStorageBackendImpl.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <utility>
+#include <vector>
 
 namespace dice::node_store {
 	using namespace rdf4cpp::rdf::storage::node;
 	PersistentNodeStorageBackendImpl::PersistentNodeStorageBackendImpl(metall_manager::allocator_type<std::byte> const &allocator)
 		: allocator(allocator),
+		  language_tags_(allocator),
 		  bnode_storage_(allocator),
-		  iri_storage_(allocator),
-		  literal_storage_(allocator),
+		  iri_storage_(allocator, identifier::NodeID::min_iri_id.value()),
+		  literal_storage_(allocator, identifier::NodeID::min_literal_id.to_underlying(), MetallLiteralBackendCodec{&language_tags_}),
 		  variable_storage_(allocator) {
 		// some iri's like xsd:string are there by default
+		// their IDs are fixed, so the term and the ID might be stored in different shards
 		using namespace rdf4cpp::rdf;
 		for (const auto &[iri, id] : rdf4cpp::rdf::datatypes::registry::reserved_datatype_ids) {
-			auto mem = iri_storage_.backend_allocator.allocate(1);
-			iri_storage_.backend_allocator.construct(mem, iri, allocator);
-			auto [iter, inserted_successfully] = iri_storage_.data2id.emplace(mem, id.to_underlying());
+			identifier::NodeID const node_id{id.to_underlying()};
+			auto &data_shard = iri_storage_.shards[iri_storage_.shard_index_of_hash(view::IRIBackendView{.identifier = iri}.hash())];
+			auto &id_shard = iri_storage_.shards[iri_storage_.shard_index_of_raw_id(node_id.value())];
+			auto mem = data_shard.backend_allocator.allocate(1);
+			data_shard.backend_allocator.construct(mem, iri, allocator);
+			auto [iter, inserted_successfully] = data_shard.data2id.emplace(mem, node_id);
 			assert(inserted_successfully);
-			iri_storage_.id2data.emplace(id.to_underlying(), iter->first);
+			id_shard.id2data.emplace(node_id, iter->first);
 		}
 	}
 
@@ -30,7 +39,23 @@ namespace dice::node_store {
 	}
 
     size_t PersistentNodeStorageBackendImpl::size() const noexcept {
-	    return lookup_size(bnode_storage_) + lookup_size(iri_storage_) + lookup_size(literal_storage_) + lookup_size(variable_storage_);
+	    return lookup_size(bnode_storage_) + iri_storage_.size() + literal_storage_.size() + lookup_size(variable_storage_);
+	}
+
+	template<typename Storage>
+	static size_t rebuild_lookup_filter(Storage &storage) {
+		std::unique_lock l{storage.mutex};
+		storage.rebuild_filter();
+		return storage.filter.size_in_bytes();
+	}
+
+	size_t PersistentNodeStorageBackendImpl::rebuild_lookup_filters() {
+		size_t size_in_bytes = rebuild_lookup_filter(bnode_storage_) + rebuild_lookup_filter(variable_storage_);
+		for (auto &shard : iri_storage_.shards)
+			size_in_bytes += rebuild_lookup_filter(shard);
+		for (auto &shard : literal_storage_.shards)
+			size_in_bytes += rebuild_lookup_filter(shard);
+		return size_in_bytes;
 	}
 
     bool PersistentNodeStorageBackendImpl::has_specialized_storage_for([[maybe_unused]] identifier::LiteralType type) {
@@ -46,26 +71,29 @@ namespace dice::node_store {
      * @param storage the storage where the Node Backend is looked up
      * @param next_id_func function to generate the next ID which is assigned in case a new Node Backend is created
      * @return the NodeID for the looked up Node Backend. Result is null() if there was no matching Node Backend.
+     * @throws the exceptions of MetallNodeTypeStorage::make_backend if a Node Backend is created
      */
 	template<class Backend_t, bool create_if_not_present, class NextIDFromView_func = void *>
 	inline identifier::NodeID lookup_or_insert_impl(typename Backend_t::View const &view,
 													auto &storage,
-													NextIDFromView_func next_id_func = nullptr) noexcept {
+													NextIDFromView_func next_id_func = nullptr) {
+		auto const hash = view.hash();
 		std::shared_lock<std::shared_mutex> shared_lock{storage.mutex};
-		auto found = storage.data2id.find(view);
+		// a negative answer of the filter is definite, so data2id is not probed for absent terms
+		auto found = storage.filter.may_contain(hash) ? storage.data2id.find(view, hash) : storage.data2id.end();
 		if (found == storage.data2id.end()) {
 			if constexpr (create_if_not_present) {
 				shared_lock.unlock();
 				std::unique_lock<std::shared_mutex> unique_lock{storage.mutex};
 				// update found (might have changed in the meantime)
-				found = storage.data2id.find(view);
+				found = storage.data2id.find(view, hash);
 				if (found == storage.data2id.end()) {
+					auto mem = storage.make_backend(view);
 					identifier::NodeID id = next_id_func(view);
-					auto mem = storage.backend_allocator.allocate(1);
-					storage.backend_allocator.construct(mem, view, storage.backend_allocator);
 					auto [found2, inserted_successfully] = storage.data2id.emplace(mem, id);
 					assert(inserted_successfully);
 					storage.id2data.emplace(id, found2->first);
+					storage.filter.insert(hash);
 					return id;
 				} else {
 					unique_lock.unlock();
@@ -80,31 +108,157 @@ namespace dice::node_store {
 		}
 	}
 
-	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::LiteralBackendView const &view) noexcept {
+	/**
+	 * Synchronized bulk lookup and creation of IDs in a sharded storage.
+	 * The views are deduplicated, grouped by shard and sorted by hash. Each shard is probed under one shared lock and
+	 * all misses of a shard are inserted under one unique lock.
+	 * @tparam Backend_t the Backend type. One of IRIBackend or LiteralBackend
+	 * @tparam NextIDFromView_func type of a function (shard_index, view) -> NodeID that generates the ID for a new Node Backend.
+	 * It is called while the unique lock of the shard is held.
+	 * @param views contain the data of the requested Node Backends
+	 * @param storage the sharded storage where the Node Backends are looked up
+	 * @param ids output; ids[i] is set to the NodeID of views[i]
+	 * @param next_id_func function to generate the ID which is assigned in case a new Node Backend is created
+	 * @throws the exceptions of MetallNodeTypeStorage::make_backend; the views before the failing one may be stored already
+	 */
+	template<class Backend_t, class NextIDFromView_func>
+	void bulk_lookup_or_insert_impl(std::span<typename Backend_t::View const> views,
+									auto &storage,
+									std::span<identifier::NodeID> ids,
+									NextIDFromView_func next_id_func) {
+		assert(views.size() == ids.size());
+		using Storage = std::remove_reference_t<decltype(storage)>;
+
+		std::vector<size_t> hashes;
+		hashes.reserve(views.size());
+		for (auto const &view : views)
+			hashes.push_back(view.hash());
+
+		// sort by (shard, hash); equal views end up in the same run of equal hashes
+		std::vector<size_t> order(views.size());
+		std::iota(order.begin(), order.end(), size_t(0));
+		std::ranges::sort(order, [&](size_t lhs, size_t rhs) {
+			auto const lhs_key = std::make_pair(Storage::shard_index_of_hash(hashes[lhs]), hashes[lhs]);
+			auto const rhs_key = std::make_pair(Storage::shard_index_of_hash(hashes[rhs]), hashes[rhs]);
+			return lhs_key < rhs_key;
+		});
+
+		// deduplicate: representative[pos] is the first position in order with a view equal to views[order[pos]]
+		std::vector<size_t> representative(order.size());
+		for (size_t pos = 0, run_begin = 0; pos < order.size(); ++pos) {
+			if (hashes[order[pos]] != hashes[order[run_begin]])
+				run_begin = pos;
+			representative[pos] = pos;
+			for (size_t candidate = run_begin; candidate < pos; ++candidate) {
+				if (representative[candidate] == candidate and views[order[candidate]] == views[order[pos]]) {
+					representative[pos] = candidate;
+					break;
+				}
+			}
+		}
+
+		std::vector<size_t> misses;
+		for (size_t shard_begin = 0; shard_begin < order.size();) {
+			auto const shard_index = Storage::shard_index_of_hash(hashes[order[shard_begin]]);
+			size_t shard_end = shard_begin;
+			while (shard_end < order.size() and Storage::shard_index_of_hash(hashes[order[shard_end]]) == shard_index)
+				++shard_end;
+			auto &shard = storage.shards[shard_index];
+
+			misses.clear();
+			{
+				std::shared_lock<std::shared_mutex> shared_lock{shard.mutex};
+				for (size_t pos = shard_begin; pos < shard_end; ++pos) {
+					if (representative[pos] != pos)
+						continue;
+					auto const view_index = order[pos];
+					auto const hash = hashes[view_index];
+					// a negative answer of the filter is definite, so data2id is not probed for absent terms
+					auto found = shard.filter.may_contain(hash) ? shard.data2id.find(views[view_index], hash) : shard.data2id.end();
+					if (found == shard.data2id.end())
+						misses.push_back(pos);
+					else
+						ids[view_index] = found->second;
+				}
+			}
+			if (not misses.empty()) {
+				std::unique_lock<std::shared_mutex> unique_lock{shard.mutex};
+				for (auto const pos : misses) {
+					auto const view_index = order[pos];
+					auto const &view = views[view_index];
+					auto const hash = hashes[view_index];
+					// might have been inserted in the meantime
+					if (auto found = shard.data2id.find(view, hash); found != shard.data2id.end()) {
+						ids[view_index] = found->second;
+						continue;
+					}
+					auto mem = shard.make_backend(view);
+					identifier::NodeID id = next_id_func(shard_index, view);
+					auto [found, inserted_successfully] = shard.data2id.emplace(mem, id);
+					assert(inserted_successfully);
+					shard.id2data.emplace(id, found->first);
+					shard.filter.insert(hash);
+					ids[view_index] = id;
+				}
+			}
+
+			for (size_t pos = shard_begin; pos < shard_end; ++pos) {
+				if (representative[pos] != pos)
+					ids[order[pos]] = ids[order[representative[pos]]];
+			}
+			shard_begin = shard_end;
+		}
+	}
+
+	void PersistentNodeStorageBackendImpl::find_or_make_ids(std::span<view::IRIBackendView const> views, std::span<identifier::NodeID> ids) {
+		bulk_lookup_or_insert_impl<MetallIRIBackend>(
+				views, iri_storage_, ids,
+				[this](size_t shard_index, [[maybe_unused]] view::IRIBackendView const &view) {
+					return identifier::NodeID{iri_storage_.allocate_raw_id(shard_index)};
+				});
+	}
+
+	void PersistentNodeStorageBackendImpl::find_or_make_ids(std::span<view::LiteralBackendView const> views, std::span<identifier::NodeID> ids) {
+		std::vector<view::LexicalFormLiteralBackendView> lexical_views;
+		lexical_views.reserve(views.size());
+		for (auto const &view : views)
+			lexical_views.push_back(view.get_lexical());
+		bulk_lookup_or_insert_impl<MetallLiteralBackend>(
+				std::span<view::LexicalFormLiteralBackendView const>{lexical_views}, literal_storage_, ids,
+				[this](size_t shard_index, view::LexicalFormLiteralBackendView const &literal_view) {
+					return identifier::NodeID{identifier::LiteralID{literal_storage_.allocate_raw_id(shard_index)},
+											  identifier::iri_node_id_to_literal_type(literal_view.datatype_id)};
+				});
+	}
+
+	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::LiteralBackendView const &view) {
+		auto const lexical_view = view.get_lexical();
+		auto const shard_index = literal_storage_.shard_index_of_hash(lexical_view.hash());
 		return lookup_or_insert_impl<MetallLiteralBackend, true>(
-				view.get_lexical(), literal_storage_,
-				[this](view::LexicalFormLiteralBackendView const &literal_view) {
-					return identifier::NodeID{next_literal_id++,
+				lexical_view, literal_storage_.shards[shard_index],
+				[this, shard_index](view::LexicalFormLiteralBackendView const &literal_view) {
+					return identifier::NodeID{identifier::LiteralID{literal_storage_.allocate_raw_id(shard_index)},
 											  identifier::iri_node_id_to_literal_type(literal_view.datatype_id)};
 				});
 	}
 
-	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::IRIBackendView const &view) noexcept {
+	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::IRIBackendView const &view) {
+		auto const shard_index = iri_storage_.shard_index_of_hash(view.hash());
 		return lookup_or_insert_impl<MetallIRIBackend, true>(
-				view, iri_storage_,
-				[this]([[maybe_unused]] view::IRIBackendView const &view) {
-					return next_iri_id++;
+				view, iri_storage_.shards[shard_index],
+				[this, shard_index]([[maybe_unused]] view::IRIBackendView const &view) {
+					return identifier::NodeID{iri_storage_.allocate_raw_id(shard_index)};
 				});
 	}
 
-	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::BNodeBackendView const &view) noexcept {
+	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::BNodeBackendView const &view) {
 		return lookup_or_insert_impl<MetallBNodeBackend, true>(
 				view, bnode_storage_,
 				[this]([[maybe_unused]] view::BNodeBackendView const &view) {
 					return next_bnode_id++;
 				});
 	}
-	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::VariableBackendView const &view) noexcept {
+	identifier::NodeID PersistentNodeStorageBackendImpl::find_or_make_id(view::VariableBackendView const &view) {
 		return lookup_or_insert_impl<MetallVariableBackend, true>(
 				view, variable_storage_,
 				[this]([[maybe_unused]] view::VariableBackendView const &view) {
@@ -118,34 +272,54 @@ namespace dice::node_store {
 	}
 	identifier::NodeID PersistentNodeStorageBackendImpl::find_id(const view::IRIBackendView &view) const noexcept {
 		return lookup_or_insert_impl<MetallIRIBackend, false>(
-				view, iri_storage_);
+				view, iri_storage_.shards[iri_storage_.shard_index_of_hash(view.hash())]);
 	}
 	identifier::NodeID PersistentNodeStorageBackendImpl::find_id(const view::LiteralBackendView &view) const noexcept {
+		auto const lexical_view = view.get_lexical();
 		return lookup_or_insert_impl<MetallLiteralBackend, false>(
-				view.get_lexical(), literal_storage_);
+				lexical_view, literal_storage_.shards[literal_storage_.shard_index_of_hash(lexical_view.hash())]);
 	}
 	identifier::NodeID PersistentNodeStorageBackendImpl::find_id(const view::VariableBackendView &view) const noexcept {
 		return lookup_or_insert_impl<MetallVariableBackend, false>(
 				view, variable_storage_);
 	}
 
-	template<typename NodeTypeStorage>
-	typename NodeTypeStorage::BackendView find_backend_view(NodeTypeStorage &storage, identifier::NodeID id) {
-		std::shared_lock<std::shared_mutex> shared_lock{storage.mutex};
-		return typename NodeTypeStorage::BackendView(*storage.id2data.at(id));
+	/**
+	 * Resolves the view of a Node Backend by its ID. Resolved views are kept in a thread-local DecodedTermCache.
+	 * @tparam cache_capacity number of slots of the thread-local cache for this node type
+	 * @param owner the (possibly sharded) storage of the node type; identifies the cache content
+	 * @param storage the storage (shard) that maps id to its Node Backend
+	 */
+	template<size_t cache_capacity, typename NodeTypeStorage>
+	typename NodeTypeStorage::BackendView find_backend_view(void const *owner, NodeTypeStorage &storage, identifier::NodeID id) {
+		using BackendView = typename NodeTypeStorage::BackendView;
+		thread_local DecodedTermCache<BackendView, cache_capacity> cache;
+		return cache.get_or_resolve(owner, id.value(), [&]() {
+			std::shared_lock<std::shared_mutex> shared_lock{storage.mutex};
+			return storage.view(*storage.id2data.at(id));
+		});
 	}
 
 	view::IRIBackendView PersistentNodeStorageBackendImpl::find_iri_backend_view(identifier::NodeID id) const {
-		return find_backend_view(iri_storage_, id);
+		// classes and predicates are decoded most often
+		return find_backend_view<4096>(&iri_storage_, iri_storage_.shards[iri_storage_.shard_index_of_raw_id(id.value())], id);
 	}
 	view::LiteralBackendView PersistentNodeStorageBackendImpl::find_literal_backend_view(identifier::NodeID id) const {
-		return find_backend_view(literal_storage_, id);
+		return find_backend_view<1024>(&literal_storage_, literal_storage_.shards[literal_storage_.shard_index_of_raw_id(id.literal_id().to_underlying())], id);
 	}
 	view::BNodeBackendView PersistentNodeStorageBackendImpl::find_bnode_backend_view(identifier::NodeID id) const {
-		return find_backend_view(bnode_storage_, id);
+		return find_backend_view<1024>(&bnode_storage_, bnode_storage_, id);
 	}
 	view::VariableBackendView PersistentNodeStorageBackendImpl::find_variable_backend_view(identifier::NodeID id) const {
-		return find_backend_view(variable_storage_, id);
+		return find_backend_view<256>(&variable_storage_, variable_storage_, id);
+	}
+
+	DecodedTermCacheStats PersistentNodeStorageBackendImpl::decoded_term_cache_stats() noexcept {
+		return DecodedTermCacheCounters::global_stats();
+	}
+
+	DecodedTermCacheStats PersistentNodeStorageBackendImpl::thread_decoded_term_cache_stats() noexcept {
+		return DecodedTermCacheCounters::this_thread().stats();
 	}
 
 }// namespace dice::node_store
\ No newline at end of file
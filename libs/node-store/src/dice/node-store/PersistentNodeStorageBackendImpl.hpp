@@ -3,15 +3,19 @@
 
 #include <boost/container/vector.hpp>
 #include <shared_mutex>
+#include <span>
 
 #include <dice/hash/DiceHash.hpp>
 #include <rdf4cpp/rdf/storage/node/INodeStorageBackend.hpp>
 
+#include "dice/node-store/DecodedTermCache.hpp"
 #include "dice/node-store/MetallBNodeBackend.hpp"
 #include "dice/node-store/MetallIRIBackend.hpp"
+#include "dice/node-store/MetallLanguageTagTable.hpp"
 #include "dice/node-store/MetallLiteralBackend.hpp"
 #include "dice/node-store/MetallNodeTypeStorage.hpp"
 #include "dice/node-store/MetallVariableBackend.hpp"
+#include "dice/node-store/ShardedMetallNodeTypeStorage.hpp"
 
 
 namespace dice::node_store {
@@ -32,16 +36,18 @@ namespace dice::node_store {
 
 	private:
 		metall_manager::allocator_type<std::byte> allocator;
+		// language tags of all literals; literals only store the ID of their tag
+		MetallLanguageTagTable language_tags_;
 		MetallNodeTypeStorage<MetallBNodeBackend> bnode_storage_;
-		MetallNodeTypeStorage<MetallIRIBackend> iri_storage_;
-		MetallNodeTypeStorage<MetallLiteralBackend> literal_storage_;
+		// IRIs and literals are sharded, so that parser threads can intern them concurrently
+		ShardedMetallNodeTypeStorage<MetallIRIBackend> iri_storage_;
+		ShardedMetallNodeTypeStorage<MetallLiteralBackend, MetallLiteralBackendCodec> literal_storage_;
 		MetallNodeTypeStorage<MetallVariableBackend> variable_storage_;
 
 		constexpr static rdf4cpp::rdf::storage::node::identifier::NodeStorageID manager_id = rdf4cpp::rdf::storage::node::identifier::NodeStorageID{0};
 
-		LiteralID next_literal_id = NodeID::min_literal_id;
+		// IDs of IRIs and literals are allocated by their storages
 		NodeID next_bnode_id = NodeID::min_bnode_id;
-		NodeID next_iri_id = NodeID::min_iri_id;
 		NodeID next_variable_id = NodeID::min_variable_id;
 
 
@@ -49,12 +55,40 @@ namespace dice::node_store {
 		explicit PersistentNodeStorageBackendImpl(metall_manager::allocator_type<std::byte> const &allocator);
 
 		size_t size() const noexcept;
+
+		/**
+		 * (Re)builds the Bloom filters of all node type storages from their current content.
+		 * Until it is called once, find_id has to probe the hash maps for every lookup. Afterwards, the filters are maintained on insertion.
+		 * Call it after bulk loading, so that the filters are sized for the dataset.
+		 * @return total size of the filters in bytes
+		 */
+		size_t rebuild_lookup_filters();
 		bool has_specialized_storage_for(rdf4cpp::rdf::storage::node::identifier::LiteralType type);
 
-		[[nodiscard]] NodeID find_or_make_id(BNodeBackendView const &) noexcept;
-		[[nodiscard]] NodeID find_or_make_id(IRIBackendView const &) noexcept;
-		[[nodiscard]] NodeID find_or_make_id(LiteralBackendView const &) noexcept;
-		[[nodiscard]] NodeID find_or_make_id(VariableBackendView const &) noexcept;
+		/**
+		 * @throws std::bad_alloc if the term cannot be stored
+		 * @throws std::runtime_error if the language tag of a literal cannot be interned because the language tag table is full
+		 */
+		[[nodiscard]] NodeID find_or_make_id(BNodeBackendView const &);
+		[[nodiscard]] NodeID find_or_make_id(IRIBackendView const &);
+		[[nodiscard]] NodeID find_or_make_id(LiteralBackendView const &);
+		[[nodiscard]] NodeID find_or_make_id(VariableBackendView const &);
+
+		/**
+		 * Interns a batch of IRIs. Duplicates within the batch are resolved once and all misses of a shard are inserted under a single lock.
+		 * @param views IRIs to intern
+		 * @param ids output, must have the same size as views; ids[i] is set to the NodeID of views[i]
+		 * @throws std::bad_alloc if a term cannot be stored
+		 */
+		void find_or_make_ids(std::span<IRIBackendView const> views, std::span<NodeID> ids);
+		/**
+		 * Interns a batch of literals. Duplicates within the batch are resolved once and all misses of a shard are inserted under a single lock.
+		 * @param views literals to intern
+		 * @param ids output, must have the same size as views; ids[i] is set to the NodeID of views[i]
+		 * @throws std::bad_alloc if a literal cannot be stored
+		 * @throws std::runtime_error if the language tag of a literal cannot be interned because the language tag table is full
+		 */
+		void find_or_make_ids(std::span<LiteralBackendView const> views, std::span<NodeID> ids);
 
 		[[nodiscard]] NodeID find_id(BNodeBackendView const &) const noexcept;
 		[[nodiscard]] NodeID find_id(IRIBackendView const &) const noexcept;
@@ -65,6 +99,16 @@ namespace dice::node_store {
 		[[nodiscard]] LiteralBackendView find_literal_backend_view(NodeID id) const;
 		[[nodiscard]] BNodeBackendView find_bnode_backend_view(NodeID id) const;
 		[[nodiscard]] VariableBackendView find_variable_backend_view(NodeID id) const;
+
+		/**
+		 * @return hit/miss counters of the thread-local caches in front of the find_*_backend_view methods, accumulated over all threads
+		 */
+		[[nodiscard]] static DecodedTermCacheStats decoded_term_cache_stats() noexcept;
+
+		/**
+		 * @return hit/miss counters of the thread-local caches of the calling thread
+		 */
+		[[nodiscard]] static DecodedTermCacheStats thread_decoded_term_cache_stats() noexcept;
 	};
 
 }// namespace dice::node_store
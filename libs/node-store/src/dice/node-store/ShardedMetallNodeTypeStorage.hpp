@@ -0,0 +1,91 @@
+#ifndef TENTRIS_SHARDEDMETALLNODETYPESTORAGE_HPP
+#define TENTRIS_SHARDEDMETALLNODETYPESTORAGE_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "dice/node-store/MetallNodeTypeStorage.hpp"
+
+namespace dice::node_store {
+	/**
+	 * Storage for one of the Node Backend types that is split into hash-sharded MetallNodeTypeStorages, each with its own mutex.
+	 * Terms are assigned to shards by their hash. IDs are allocated from per-shard strided ranges:
+	 * shard i only hands out raw IDs x with x % shard_count == i. So the shard of an ID can be computed from the ID alone,
+	 * and a new term is inserted into both mappings of a single shard while only holding the lock of that shard.
+	 * @tparam BackendType_t one of IRIBackend and LiteralBackend.
+	 * @tparam Codec_t constructs Node Backends from views and decodes them
+	 * @tparam shard_bits_ log2 of the number of shards
+	 */
+	template<class BackendType_t, class Codec_t = MetallBackendCodec<BackendType_t>, size_t shard_bits_ = 4>
+	struct ShardedMetallNodeTypeStorage {
+		using Shard = MetallNodeTypeStorage<BackendType_t, Codec_t>;
+		using Codec = Codec_t;
+		using Backend = BackendType_t;
+		using BackendView = typename Shard::BackendView;
+
+		static constexpr size_t shard_bits = shard_bits_;
+		static constexpr size_t shard_count = size_t(1) << shard_bits;
+
+		std::array<Shard, shard_count> shards;
+
+	private:
+		// next raw ID per shard; guarded by the mutex of the respective shard
+		std::array<uint64_t, shard_count> next_raw_ids_;
+
+		template<size_t... shard_indices>
+		static std::array<Shard, shard_count> make_shards(rdf_tensor::allocator_type const &alloc, Codec const &codec, std::index_sequence<shard_indices...>) {
+			return {Shard(((void) shard_indices, alloc), codec)...};
+		}
+
+	public:
+		/**
+		 * @param alloc allocator for the shards
+		 * @param min_raw_id the smallest raw ID that is handed out by allocate_raw_id
+		 * @param codec the codec of the shards
+		 */
+		ShardedMetallNodeTypeStorage(rdf_tensor::allocator_type const &alloc, uint64_t min_raw_id, Codec const &codec = {})
+			: shards(make_shards(alloc, codec, std::make_index_sequence<shard_count>{})) {
+			for (size_t shard_index = 0; shard_index < shard_count; ++shard_index)
+				next_raw_ids_[shard_index] = min_raw_id + ((shard_index + shard_count - (min_raw_id % shard_count)) % shard_count);
+		}
+
+		/**
+		 * The upper bits of the hash are used, because the maps within the shards use the lower bits.
+		 * @param hash hash of a term
+		 * @return index of the shard that stores the term
+		 */
+		[[nodiscard]] static constexpr size_t shard_index_of_hash(size_t hash) noexcept {
+			return hash >> (std::numeric_limits<size_t>::digits - shard_bits);
+		}
+
+		/**
+		 * @param raw_id raw ID as handed out by allocate_raw_id
+		 * @return index of the shard that maps the ID to its term
+		 */
+		[[nodiscard]] static constexpr size_t shard_index_of_raw_id(uint64_t raw_id) noexcept {
+			return raw_id % shard_count;
+		}
+
+		/**
+		 * Allocates the next raw ID of a shard. The unique lock of that shard must be held.
+		 */
+		[[nodiscard]] uint64_t allocate_raw_id(size_t shard_index) noexcept {
+			auto const raw_id = next_raw_ids_[shard_index];
+			next_raw_ids_[shard_index] += shard_count;
+			return raw_id;
+		}
+
+		[[nodiscard]] size_t size() const noexcept {
+			size_t size = 0;
+			for (auto const &shard : shards) {
+				std::shared_lock l{shard.mutex};
+				size += shard.id2data.size();
+			}
+			return size;
+		}
+	};
+}// namespace dice::node_store
+
+#endif//TENTRIS_SHARDEDMETALLNODETYPESTORAGE_HPP
@@ -0,0 +1,142 @@
+#include "TermStaging.hpp"
+#include "TransientNodeStorage.hpp"
+
+#include <stdexcept>
+
+#include <dice/rdf-tensor/TransientNodes.hpp>
+
+namespace dice::node_store {
+	using namespace rdf4cpp::rdf::storage::node;
+
+	namespace {
+		thread_local TermStaging *this_thread_staging = nullptr;
+
+		/**
+		 * Node's constructor from a handle is not public.
+		 */
+		struct HandleNode : rdf4cpp::rdf::Node {
+			explicit HandleNode(NodeBackendHandle handle) noexcept : Node(handle) {}
+		};
+	}// namespace
+
+	template<typename Record>
+	uint64_t TermStaging::TypeStaging<Record>::stage(View const &view) {
+		if (auto found = view2index.find(view); found != view2index.end())
+			return found->second;
+		auto const &record = records.emplace_back(view);
+		auto const index = records.size() - 1;
+		try {
+			// the key refers to the record, not to the view of the caller
+			view2index.emplace(record.view(), index);
+		} catch (...) {
+			records.pop_back();
+			throw;
+		}
+		return index;
+	}
+
+	template<typename Record>
+	void TermStaging::TypeStaging<Record>::clear() noexcept {
+		view2index.clear();
+		records.clear();
+		persistent_ids.clear();
+	}
+
+	TermStaging::Scope::Scope(TermStaging &staging) noexcept : previous_(this_thread_staging) {
+		this_thread_staging = &staging;
+	}
+
+	TermStaging::Scope::~Scope() {
+		this_thread_staging = previous_;
+	}
+
+	TermStaging *TermStaging::of_this_thread() noexcept {
+		return this_thread_staging;
+	}
+
+	identifier::NodeID TermStaging::stage(PersistentNodeStorageBackendImpl &impl, view::IRIBackendView const &view) {
+		// datatype IRIs keep their reserved IDs, so literals of a datatype get their literal type while they are parsed
+		if (view.identifier.starts_with("http://www.w3.org/")) {
+			if (auto const id = impl.find_id(view); not id.null())
+				return id;
+		}
+		impl_ = &impl;
+		return identifier::NodeID{rdf_tensor::min_transient_node_id + iris_.stage(view)};
+	}
+
+	identifier::NodeID TermStaging::stage(PersistentNodeStorageBackendImpl &impl, view::LiteralBackendView const &view) {
+		impl_ = &impl;
+		auto const lexical_view = view.get_lexical();
+		return identifier::NodeID{identifier::LiteralID{rdf_tensor::min_transient_literal_id + literals_.stage(lexical_view)},
+								  identifier::iri_node_id_to_literal_type(lexical_view.datatype_id)};
+	}
+
+	identifier::NodeID TermStaging::find_id(view::IRIBackendView const &view) const noexcept {
+		auto found = iris_.view2index.find(view);
+		return (found == iris_.view2index.end()) ? identifier::NodeID{} : identifier::NodeID{rdf_tensor::min_transient_node_id + found->second};
+	}
+
+	identifier::NodeID TermStaging::find_id(view::LiteralBackendView const &view) const noexcept {
+		auto const lexical_view = view.get_lexical();
+		auto found = literals_.view2index.find(lexical_view);
+		return (found == literals_.view2index.end())
+					   ? identifier::NodeID{}
+					   : identifier::NodeID{identifier::LiteralID{rdf_tensor::min_transient_literal_id + found->second},
+											identifier::iri_node_id_to_literal_type(lexical_view.datatype_id)};
+	}
+
+	view::IRIBackendView TermStaging::find_iri_backend_view(identifier::NodeID id) const {
+		auto const index = id.value() - rdf_tensor::min_transient_node_id;
+		if (id.value() < rdf_tensor::min_transient_node_id or index >= iris_.records.size())
+			throw std::out_of_range{"Unknown staged node ID."};
+		return iris_.records[index].view();
+	}
+
+	view::LiteralBackendView TermStaging::find_literal_backend_view(identifier::NodeID id) const {
+		auto const literal_id = id.literal_id().to_underlying();
+		auto const index = literal_id - rdf_tensor::min_transient_literal_id;
+		if (literal_id < rdf_tensor::min_transient_literal_id or index >= literals_.records.size())
+			throw std::out_of_range{"Unknown staged node ID."};
+		return literals_.records[index].view();
+	}
+
+	void TermStaging::intern() {
+		if (impl_ == nullptr)
+			return;
+
+		std::vector<view::IRIBackendView> iri_views;
+		iri_views.reserve(iris_.records.size());
+		for (auto const &record : iris_.records)
+			iri_views.push_back(record.view());
+		iris_.persistent_ids.resize(iri_views.size());
+		impl_->find_or_make_ids(iri_views, iris_.persistent_ids);
+
+		std::vector<view::LiteralBackendView> literal_views;
+		literal_views.reserve(literals_.records.size());
+		for (auto const &record : literals_.records) {
+			auto literal_view = record.view();
+			if (TransientNodeStorage::is_transient_id(literal_view.datatype_id))
+				literal_view.datatype_id = iris_.persistent_ids[literal_view.datatype_id.value() - rdf_tensor::min_transient_node_id];
+			literal_views.emplace_back(literal_view);
+		}
+		literals_.persistent_ids.resize(literal_views.size());
+		impl_->find_or_make_ids(literal_views, literals_.persistent_ids);
+	}
+
+	rdf4cpp::rdf::Node TermStaging::persistent(rdf4cpp::rdf::Node node) const {
+		auto const &handle = node.backend_handle();
+		if (not rdf_tensor::is_transient(node) or not(handle.is_iri() or handle.is_literal()))
+			return node;
+		auto const id = handle.is_literal()
+								? literals_.persistent_ids.at(handle.node_id().literal_id().to_underlying() - rdf_tensor::min_transient_literal_id)
+								: iris_.persistent_ids.at(handle.node_id().value() - rdf_tensor::min_transient_node_id);
+		return HandleNode{NodeBackendHandle{id, handle.type(), handle.node_storage_id()}};
+	}
+
+	void TermStaging::clear() noexcept {
+		impl_ = nullptr;
+		iris_.clear();
+		literals_.clear();
+	}
+
+}// namespace dice::node_store
@@ -0,0 +1,146 @@
+#ifndef TENTRIS_TERMSTAGING_HPP
+#define TENTRIS_TERMSTAGING_HPP
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <rdf4cpp/rdf.hpp>
+
+#include "dice/node-store/PersistentNodeStorageBackendImpl.hpp"
+
+namespace dice::node_store {
+
+	/**
+	 * New IRIs and literals that a loader thread parsed but did not add to the persistent node storage yet.
+	 * While a TermStaging::Scope is active on a thread, a PersistentNodeStorageBackend that persists new terms does not lock a
+	 * shard per term of that thread. Instead, it stages the term and hands out a staging ID. intern() adds all staged terms
+	 * with PersistentNodeStorageBackendImpl::find_or_make_ids, i.e., with one lock per shard, and persistent() replaces the
+	 * staging IDs of nodes by their persistent IDs.
+	 * Staging IDs are taken from the transient ranges of dice::rdf_tensor::is_transient. They are only valid on the thread of
+	 * the scope and until clear().
+	 */
+	class TermStaging {
+		using NodeID = rdf4cpp::rdf::storage::node::identifier::NodeID;
+		using IRIBackendView = rdf4cpp::rdf::storage::node::view::IRIBackendView;
+		using LiteralBackendView = rdf4cpp::rdf::storage::node::view::LiteralBackendView;
+		using LexicalFormLiteralBackendView = rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView;
+
+		struct IRIRecord {
+			std::string identifier;
+
+			explicit IRIRecord(IRIBackendView const &view) : identifier(view.identifier) {}
+			[[nodiscard]] IRIBackendView view() const noexcept { return {.identifier = identifier}; }
+		};
+
+		struct LiteralRecord {
+			NodeID datatype_id;
+			std::string lexical_form;
+			std::string language_tag;
+			bool needs_escape;
+
+			explicit LiteralRecord(LexicalFormLiteralBackendView const &view)
+				: datatype_id(view.datatype_id), lexical_form(view.lexical_form), language_tag(view.language_tag), needs_escape(view.needs_escape) {}
+			[[nodiscard]] LexicalFormLiteralBackendView view() const noexcept {
+				return {.datatype_id = datatype_id, .lexical_form = lexical_form, .language_tag = language_tag, .needs_escape = needs_escape};
+			}
+		};
+
+		/**
+		 * Staged terms of one node type. The staging ID of a term is the index of its record plus the first ID of the type.
+		 * Records are never moved, so views of them stay valid until clear().
+		 */
+		template<typename Record>
+		struct TypeStaging {
+			using View = decltype(std::declval<Record>().view());
+			struct ViewHash {
+				[[nodiscard]] size_t operator()(View const &view) const noexcept { return view.hash(); }
+			};
+
+			std::deque<Record> records;
+			std::unordered_map<View, uint64_t, ViewHash> view2index;
+			// persistent IDs of the records, set by intern()
+			std::vector<NodeID> persistent_ids;
+
+			/**
+			 * @return the index of the record of view
+			 */
+			[[nodiscard]] uint64_t stage(View const &view);
+			void clear() noexcept;
+		};
+
+		PersistentNodeStorageBackendImpl *impl_ = nullptr;
+		TypeStaging<IRIRecord> iris_;
+		TypeStaging<LiteralRecord> literals_;
+
+	public:
+		/**
+		 * Makes a staging area the one of the calling thread while the scope lives.
+		 */
+		class Scope {
+			TermStaging *previous_;
+
+		public:
+			explicit Scope(TermStaging &staging) noexcept;
+			~Scope();
+			Scope(Scope const &) = delete;
+			Scope &operator=(Scope const &) = delete;
+		};
+
+		TermStaging() = default;
+		TermStaging(TermStaging const &) = delete;
+		TermStaging &operator=(TermStaging const &) = delete;
+
+		/**
+		 * @return the staging area of the innermost active Scope of the calling thread, or nullptr
+		 */
+		[[nodiscard]] static TermStaging *of_this_thread() noexcept;
+
+		/**
+		 * @param impl the storage that intern() adds the term to; must be the same for all terms until clear()
+		 * @return the staging ID of the term
+		 * @throws std::bad_alloc if the term cannot be stored
+		 */
+		[[nodiscard]] NodeID stage(PersistentNodeStorageBackendImpl &impl, IRIBackendView const &view);
+		[[nodiscard]] NodeID stage(PersistentNodeStorageBackendImpl &impl, LiteralBackendView const &view);
+
+		/**
+		 * @return the staging ID of the term or a null ID if it is not staged
+		 */
+		[[nodiscard]] NodeID find_id(IRIBackendView const &view) const noexcept;
+		[[nodiscard]] NodeID find_id(LiteralBackendView const &view) const noexcept;
+
+		/**
+		 * @param id a staging ID that was returned by stage
+		 * @throws std::out_of_range if id is not a staging ID of this staging area
+		 */
+		[[nodiscard]] IRIBackendView find_iri_backend_view(NodeID id) const;
+		[[nodiscard]] LiteralBackendView find_literal_backend_view(NodeID id) const;
+
+		/**
+		 * Adds all staged terms to the persistent storage. IRIs are added first, because the datatype of a staged literal
+		 * may be a staged IRI.
+		 * @throws the exceptions of PersistentNodeStorageBackendImpl::find_or_make_ids
+		 */
+		void intern();
+
+		/**
+		 * @param node a node of the default node storage; intern() must have been called since its term was staged
+		 * @return node with its persistent ID if it has a staging ID, node otherwise
+		 */
+		[[nodiscard]] rdf4cpp::rdf::Node persistent(rdf4cpp::rdf::Node node) const;
+
+		/**
+		 * Drops all staged terms. Their staging IDs may be handed out again.
+		 */
+		void clear() noexcept;
+
+		[[nodiscard]] bool empty() const noexcept {
+			return iris_.records.empty() and literals_.records.empty();
+		}
+	};
+
+}// namespace dice::node_store
+
+#endif//TENTRIS_TERMSTAGING_HPP
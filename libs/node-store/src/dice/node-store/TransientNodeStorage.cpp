@@ -0,0 +1,98 @@
+#include "TransientNodeStorage.hpp"
+
+#include <mutex>
+#include <stdexcept>
+
+namespace dice::node_store {
+	using namespace rdf4cpp::rdf::storage::node;
+
+	template<typename Record>
+	uint64_t TransientNodeStorage::TypeStorage<Record>::find_raw_id(View const &view) const {
+		std::shared_lock lock{mutex};
+		auto found = view2raw_id.find(view);
+		return (found == view2raw_id.end()) ? 0 : found->second;
+	}
+
+	template<typename Record>
+	uint64_t TransientNodeStorage::TypeStorage<Record>::find_or_make_raw_id(View const &view) {
+		if (auto const raw_id = find_raw_id(view); raw_id != 0)
+			return raw_id;
+		std::unique_lock lock{mutex};
+		if (auto found = view2raw_id.find(view); found != view2raw_id.end())
+			return found->second;
+		auto const &record = records.emplace_back(view);
+		auto const raw_id = min_raw_id + records.size() - 1;
+		try {
+			// the key refers to the record, not to the view of the caller
+			view2raw_id.emplace(record.view(), raw_id);
+		} catch (...) {
+			records.pop_back();
+			throw;
+		}
+		return raw_id;
+	}
+
+	template<typename Record>
+	typename TransientNodeStorage::TypeStorage<Record>::View TransientNodeStorage::TypeStorage<Record>::view(uint64_t raw_id) const {
+		std::shared_lock lock{mutex};
+		if (raw_id < min_raw_id or raw_id - min_raw_id >= records.size())
+			throw std::out_of_range{"Unknown transient node ID."};
+		return records[raw_id - min_raw_id].view();
+	}
+
+	identifier::NodeID TransientNodeStorage::find_or_make_id(view::BNodeBackendView const &view) {
+		return identifier::NodeID{bnodes_.find_or_make_raw_id(view)};
+	}
+	identifier::NodeID TransientNodeStorage::find_or_make_id(view::IRIBackendView const &view) {
+		return identifier::NodeID{iris_.find_or_make_raw_id(view)};
+	}
+	identifier::NodeID TransientNodeStorage::find_or_make_id(view::LiteralBackendView const &view) {
+		auto const lexical_view = view.get_lexical();
+		return identifier::NodeID{identifier::LiteralID{literals_.find_or_make_raw_id(lexical_view)},
+								  identifier::iri_node_id_to_literal_type(lexical_view.datatype_id)};
+	}
+	identifier::NodeID TransientNodeStorage::find_or_make_id(view::VariableBackendView const &view) {
+		return identifier::NodeID{variables_.find_or_make_raw_id(view)};
+	}
+
+	identifier::NodeID TransientNodeStorage::find_id(view::BNodeBackendView const &view) const {
+		auto const raw_id = bnodes_.find_raw_id(view);
+		return (raw_id == 0) ? identifier::NodeID{} : identifier::NodeID{raw_id};
+	}
+	identifier::NodeID TransientNodeStorage::find_id(view::IRIBackendView const &view) const {
+		auto const raw_id = iris_.find_raw_id(view);
+		return (raw_id == 0) ? identifier::NodeID{} : identifier::NodeID{raw_id};
+	}
+	identifier::NodeID TransientNodeStorage::find_id(view::LiteralBackendView const &view) const {
+		auto const lexical_view = view.get_lexical();
+		auto const raw_id = literals_.find_raw_id(lexical_view);
+		return (raw_id == 0) ? identifier::NodeID{}
+							 : identifier::NodeID{identifier::LiteralID{raw_id}, identifier::iri_node_id_to_literal_type(lexical_view.datatype_id)};
+	}
+	identifier::NodeID TransientNodeStorage::find_id(view::VariableBackendView const &view) const {
+		auto const raw_id = variables_.find_raw_id(view);
+		return (raw_id == 0) ? identifier::NodeID{} : identifier::NodeID{raw_id};
+	}
+
+	view::IRIBackendView TransientNodeStorage::find_iri_backend_view(identifier::NodeID id) const {
+		return iris_.view(id.value());
+	}
+	view::LiteralBackendView TransientNodeStorage::find_literal_backend_view(identifier::NodeID id) const {
+		return literals_.view(id.literal_id().to_underlying());
+	}
+	view::BNodeBackendView TransientNodeStorage::find_bnode_backend_view(identifier::NodeID id) const {
+		return bnodes_.view(id.value());
+	}
+	view::VariableBackendView TransientNodeStorage::find_variable_backend_view(identifier::NodeID id) const {
+		return variables_.view(id.value());
+	}
+
+	size_t TransientNodeStorage::size() const noexcept {
+		auto const type_size = [](auto const &storage) {
+			std::shared_lock lock{storage.mutex};
+			return storage.records.size();
+		};
+		return type_size(bnodes_) + type_size(iris_) + type_size(literals_) + type_size(variables_);
+	}
+
+}// namespace dice::node_store
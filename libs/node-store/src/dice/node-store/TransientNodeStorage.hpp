@@ -0,0 +1,146 @@
+#ifndef TENTRIS_TRANSIENTNODESTORAGE_HPP
+#define TENTRIS_TRANSIENTNODESTORAGE_HPP
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <rdf4cpp/rdf/storage/node/identifier/NodeID.hpp>
+#include <rdf4cpp/rdf/storage/node/view/BNodeBackendView.hpp>
+#include <rdf4cpp/rdf/storage/node/view/IRIBackendView.hpp>
+#include <rdf4cpp/rdf/storage/node/view/LiteralBackendView.hpp>
+#include <rdf4cpp/rdf/storage/node/view/VariableBackendView.hpp>
+
+#include <dice/rdf-tensor/TransientNodes.hpp>
+
+namespace dice::node_store {
+
+	/**
+	 * Process-local storage of query terms that are not in the persistent node storage, e.g., constants that do not occur in
+	 * the dataset and the variables of queries. It lives on the heap and is dropped with the process.
+	 * IDs are assigned from the transient ranges of dice::rdf_tensor::is_transient, so transient terms match no triple.
+	 */
+	class TransientNodeStorage {
+		using NodeID = rdf4cpp::rdf::storage::node::identifier::NodeID;
+		using BNodeBackendView = rdf4cpp::rdf::storage::node::view::BNodeBackendView;
+		using IRIBackendView = rdf4cpp::rdf::storage::node::view::IRIBackendView;
+		using LiteralBackendView = rdf4cpp::rdf::storage::node::view::LiteralBackendView;
+		using LexicalFormLiteralBackendView = rdf4cpp::rdf::storage::node::view::LexicalFormLiteralBackendView;
+		using VariableBackendView = rdf4cpp::rdf::storage::node::view::VariableBackendView;
+
+		struct IRIRecord {
+			std::string identifier;
+
+			explicit IRIRecord(IRIBackendView const &view) : identifier(view.identifier) {}
+			[[nodiscard]] IRIBackendView view() const noexcept { return {.identifier = identifier}; }
+		};
+
+		struct BNodeRecord {
+			std::string identifier;
+
+			explicit BNodeRecord(BNodeBackendView const &view) : identifier(view.identifier) {}
+			[[nodiscard]] BNodeBackendView view() const noexcept { return {.identifier = identifier, .scope = nullptr}; }
+		};
+
+		struct LiteralRecord {
+			NodeID datatype_id;
+			std::string lexical_form;
+			std::string language_tag;
+			bool needs_escape;
+
+			explicit LiteralRecord(LexicalFormLiteralBackendView const &view)
+				: datatype_id(view.datatype_id), lexical_form(view.lexical_form), language_tag(view.language_tag), needs_escape(view.needs_escape) {}
+			[[nodiscard]] LexicalFormLiteralBackendView view() const noexcept {
+				return {.datatype_id = datatype_id, .lexical_form = lexical_form, .language_tag = language_tag, .needs_escape = needs_escape};
+			}
+		};
+
+		struct VariableRecord {
+			std::string name;
+			bool is_anonymous;
+
+			explicit VariableRecord(VariableBackendView const &view) : name(view.name), is_anonymous(view.is_anonymous) {}
+			[[nodiscard]] VariableBackendView view() const noexcept { return {.name = name, .is_anonymous = is_anonymous}; }
+		};
+
+		/**
+		 * Terms of one node type. The raw ID of a term is the index of its record plus the first raw ID of the type.
+		 * Records are never moved, so views of them stay valid.
+		 */
+		template<typename Record>
+		struct TypeStorage {
+			using View = decltype(std::declval<Record>().view());
+			struct ViewHash {
+				[[nodiscard]] size_t operator()(View const &view) const noexcept { return view.hash(); }
+			};
+
+			mutable std::shared_mutex mutex;
+			std::deque<Record> records;
+			std::unordered_map<View, uint64_t, ViewHash> view2raw_id;
+			uint64_t min_raw_id;
+
+			explicit TypeStorage(uint64_t min_raw_id) noexcept : min_raw_id(min_raw_id) {}
+
+			[[nodiscard]] uint64_t find_raw_id(View const &view) const;
+			[[nodiscard]] uint64_t find_or_make_raw_id(View const &view);
+			[[nodiscard]] View view(uint64_t raw_id) const;
+		};
+
+		TypeStorage<BNodeRecord> bnodes_{rdf_tensor::min_transient_node_id};
+		TypeStorage<IRIRecord> iris_{rdf_tensor::min_transient_node_id};
+		TypeStorage<LiteralRecord> literals_{rdf_tensor::min_transient_literal_id};
+		TypeStorage<VariableRecord> variables_{rdf_tensor::min_transient_node_id};
+
+	public:
+		/**
+		 * @throws std::bad_alloc if the term cannot be stored
+		 */
+		[[nodiscard]] NodeID find_or_make_id(BNodeBackendView const &view);
+		[[nodiscard]] NodeID find_or_make_id(IRIBackendView const &view);
+		[[nodiscard]] NodeID find_or_make_id(LiteralBackendView const &view);
+		[[nodiscard]] NodeID find_or_make_id(VariableBackendView const &view);
+
+		/**
+		 * @return the ID of the term or a null ID if it is not stored
+		 */
+		[[nodiscard]] NodeID find_id(BNodeBackendView const &view) const;
+		[[nodiscard]] NodeID find_id(IRIBackendView const &view) const;
+		[[nodiscard]] NodeID find_id(LiteralBackendView const &view) const;
+		[[nodiscard]] NodeID find_id(VariableBackendView const &view) const;
+
+		/**
+		 * @param id an ID that was returned by find_or_make_id
+		 * @throws std::out_of_range if id is not a transient ID of this storage
+		 */
+		[[nodiscard]] IRIBackendView find_iri_backend_view(NodeID id) const;
+		[[nodiscard]] LiteralBackendView find_literal_backend_view(NodeID id) const;
+		[[nodiscard]] BNodeBackendView find_bnode_backend_view(NodeID id) const;
+		[[nodiscard]] VariableBackendView find_variable_backend_view(NodeID id) const;
+
+		/**
+		 * @return number of stored terms
+		 */
+		[[nodiscard]] size_t size() const noexcept;
+
+		/**
+		 * @param id the ID of a literal
+		 * @return true if id was assigned by a TransientNodeStorage
+		 */
+		[[nodiscard]] static bool is_transient_literal_id(NodeID id) noexcept {
+			return id.literal_id().to_underlying() >= rdf_tensor::min_transient_literal_id;
+		}
+
+		/**
+		 * @param id the ID of an IRI, blank node or variable
+		 * @return true if id was assigned by a TransientNodeStorage
+		 */
+		[[nodiscard]] static bool is_transient_id(NodeID id) noexcept {
+			return id.value() >= rdf_tensor::min_transient_node_id;
+		}
+	};
+
+}// namespace dice::node_store
+
+#endif//TENTRIS_TRANSIENTNODESTORAGE_HPP
@@ -0,0 +1,34 @@
+#ifndef TENTRIS_TRANSIENTNODES_HPP
+#define TENTRIS_TRANSIENTNODES_HPP
+
+#include <cstdint>
+
+#include <rdf4cpp/rdf.hpp>
+
+namespace dice::rdf_tensor {
+
+	/**
+	 * Terms of queries that are not in the dataset are not added to the persistent node storage. They get IDs from ranges that
+	 * persistent terms never use, so they are valid for the query but match no triple.
+	 */
+	// the smallest ID of a transient IRI, blank node or variable
+	inline constexpr uint64_t min_transient_node_id = uint64_t(1) << 47;
+	// the smallest literal ID of a transient literal; literal IDs have 42 bits
+	inline constexpr uint64_t min_transient_literal_id = uint64_t(1) << 41;
+
+	/**
+	 * @param node a term
+	 * @return true if node is a transient term, i.e., it is not in the dataset
+	 */
+	[[nodiscard]] inline bool is_transient(rdf4cpp::rdf::Node const &node) noexcept {
+		auto const &handle = node.backend_handle();
+		if (node.null() or handle.is_inlined())
+			return false;
+		if (handle.is_literal())
+			return handle.node_id().literal_id().to_underlying() >= min_transient_literal_id;
+		return handle.node_id().value() >= min_transient_node_id;
+	}
+
+}// namespace dice::rdf_tensor
+
+#endif//TENTRIS_TRANSIENTNODES_HPP
@@ -0,0 +1,53 @@
+#ifndef DICE_SPARQL_GROUPOPERANDS_HPP
+#define DICE_SPARQL_GROUPOPERANDS_HPP
+
+#include <boost/container/flat_set.hpp>
+
+#include <dice/query/OperandDependencyGraph.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * @brief: Creates a new node in the operand dependency graph and the dependencies between
+	 * the new node and the nodes of the same group graph pattern.
+	 * @param odg the operand dependency graph
+	 * @param group the nodes of the group graph pattern; the new node is appended
+	 * @param var_ids the variable ids of the new node
+	 * @return the new node
+	 */
+	inline uint8_t add_group_operand(query::OperandDependencyGraph &odg, std::vector<uint8_t> &group, std::vector<char> const &var_ids) {
+		auto v_id = odg.add_operand(var_ids);
+		// iterate over the tps of the group and capture dependencies
+		for (auto iter = group.rbegin(); iter != group.rend(); iter++) {
+			boost::container::flat_set<char> done{};// only one edge per label between two nodes
+			auto const &tp_vars = odg.operand_var_ids(*iter);
+			bool cart = true;
+			for (auto const &var : var_ids) {
+				for (auto const &tp_var : tp_vars) {
+					if (var == tp_var) {
+						cart = false;
+						if (done.contains(var))
+							continue;
+						done.insert(var);
+						odg.add_dependency(*iter, v_id, var);
+						odg.add_dependency(v_id, *iter, var);
+					}
+				}
+			}
+			// the triple patterns do not share a variable --> cartesian join
+			if (cart) {
+				odg.add_dependency(*iter, v_id);
+				odg.add_dependency(v_id, *iter);
+			}
+		}
+		// add current tp/node to the active group pattern
+		group.push_back(v_id);
+		return v_id;
+	}
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_GROUPOPERANDS_HPP
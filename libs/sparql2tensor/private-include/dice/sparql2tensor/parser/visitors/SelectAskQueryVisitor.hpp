@@ -19,6 +19,8 @@ namespace dice::sparql2tensor::parser::visitors {
 		SPARQLQuery *const query;
 		rdf4cpp::rdf::Node active_subject;
 		rdf4cpp::rdf::Node active_predicate;
+		// the property path of the active verb; std::nullopt if the verb is a single predicate, which is active_predicate
+		std::optional<PropertyPath> active_path;
 		char var_id = 'a';
 		/* for the construction of the operand dependency graph */
 		// stack of group graph patterns
@@ -29,6 +31,10 @@ namespace dice::sparql2tensor::parser::visitors {
 		// it is used to avoid creating cartesian connections between optional operands of the same union pattern
 		// once an optional sub graph pattern is visited, this vector needs to be cleared
 		std::vector<std::vector<uint8_t>> union_operands;
+		// set once a UNION is found outside of optional patterns; then no operand is mandatory
+		bool root_union = false;
+		// the group graph pattern of the WHERE clause; FILTERs and VALUES are only supported there
+		SparqlParser::GroupGraphPatternSubContext *top_level_pattern = nullptr;
 		/* for the "query rewriting" */
 		std::vector<std::vector<SparqlParser::TriplesBlockContext *>> triples_blocks;
 		std::vector<std::vector<SparqlParser::OptionalGraphPatternContext *>> optional_blocks;
@@ -93,6 +99,36 @@ namespace dice::sparql2tensor::parser::visitors {
 	private:
 		void register_var(rdf4cpp::rdf::query::Variable const &var);
 
+		/**
+		 * @param var a variable of a triple pattern
+		 * @return the constant that a FILTER fixes var to, or var if it is not fixed
+		 */
+		[[nodiscard]] rdf4cpp::rdf::Node substitute_fixed(rdf4cpp::rdf::query::Variable const &var) const;
+
+		/**
+		 * @brief: Reads the constraint of a FILTER and adds its conjuncts to the filters of the query.
+		 * @param ctx A Constraint context.
+		 */
+		void add_filter(SparqlParser::ConstraintContext *ctx);
+
+		/**
+		 * @brief: Sets the active verb to a path; a single predicate becomes active_predicate.
+		 * @param path The path of the verb.
+		 */
+		void set_active_path(PropertyPath path);
+
+		/**
+		 * @brief: Adds the pattern of the active subject, the active verb and an object.
+		 * @param object The object.
+		 */
+		void add_pattern(rdf4cpp::rdf::Node const &object);
+
+		/**
+		 * @brief: Adds an operand for each VALUES block and each property path pattern of the query to the top-level group of the
+		 * operand dependency graph. It must be called after the triple patterns are visited.
+		 */
+		void add_table_operands();
+
 		/**
 		 * @brief: Creates a new node in the operand dependency graph and the dependencies between
 		 * the new node and the nodes corresponding to triple patterns of the same group graph pattern.
@@ -0,0 +1,375 @@
+#include "FilterExpression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dice::sparql2tensor {
+
+	namespace {
+		constexpr std::string_view xsd = "http://www.w3.org/2001/XMLSchema#";
+		constexpr std::string_view xsd_string = "http://www.w3.org/2001/XMLSchema#string";
+		constexpr std::string_view xsd_boolean = "http://www.w3.org/2001/XMLSchema#boolean";
+		constexpr std::string_view xsd_date_time = "http://www.w3.org/2001/XMLSchema#dateTime";
+		constexpr std::string_view xsd_date = "http://www.w3.org/2001/XMLSchema#date";
+
+		bool is_numeric_datatype(std::string_view datatype) noexcept {
+			static constexpr std::array<std::string_view, 16> numeric_types{
+					"integer", "decimal", "double", "float", "int", "long", "short", "byte",
+					"nonNegativeInteger", "positiveInteger", "negativeInteger", "nonPositiveInteger",
+					"unsignedInt", "unsignedLong", "unsignedShort", "unsignedByte"};
+			return datatype.starts_with(xsd) and std::ranges::find(numeric_types, datatype.substr(xsd.size())) != numeric_types.end();
+		}
+
+		bool equals_ignore_case(std::string_view lhs, std::string_view rhs) noexcept {
+			return std::ranges::equal(lhs, rhs, [](char l, char r) { return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r)); });
+		}
+
+		/**
+		 * The value of a (sub-)expression. Terms are classified once when they are looked up, so that the operators do not need to
+		 * inspect the datatypes again.
+		 */
+		struct Value {
+			enum struct Type : uint8_t {
+				Error,
+				IRI,
+				BlankNode,
+				// the following are literals
+				Boolean,
+				Numeric,
+				// simple literals, xsd:string and language-tagged strings
+				String,
+				// xsd:dateTime and xsd:date; they are compared by their lexical form
+				DateTime,
+				OtherLiteral
+			};
+
+			Type type = Type::Error;
+			bool boolean = false;
+			double number = 0;
+			// the IRI, the blank node label, or the lexical form of a literal
+			std::string lexical;
+			// the language tag of a String; empty if it has none
+			std::string language;
+			// the datatype IRI of a literal
+			std::string datatype;
+
+			[[nodiscard]] bool is_literal() const noexcept {
+				return type >= Type::Boolean;
+			}
+
+			static Value of_boolean(bool value) {
+				return Value{.type = Type::Boolean, .boolean = value, .lexical = value ? "true" : "false", .datatype = std::string(xsd_boolean)};
+			}
+
+			static Value of_string(std::string lexical) {
+				return Value{.type = Type::String, .lexical = std::move(lexical), .datatype = std::string(xsd_string)};
+			}
+
+			static Value of_iri(std::string iri) {
+				return Value{.type = Type::IRI, .lexical = std::move(iri)};
+			}
+
+			static Value of_term(rdf4cpp::rdf::Node const &term) {
+				Value value;
+				if (term.null())
+					return value;
+				if (term.is_iri())
+					return of_iri(std::string(term.as_iri().identifier()));
+				if (term.is_blank_node()) {
+					value.type = Type::BlankNode;
+					value.lexical = std::string(term.as_blank_node().identifier());
+					return value;
+				}
+				if (not term.is_literal())
+					return value;
+				auto const literal = term.as_literal();
+				value.lexical = std::string(literal.lexical_form());
+				value.language = std::string(literal.language_tag());
+				value.datatype = std::string(literal.datatype().identifier());
+				if (not value.language.empty() or value.datatype == xsd_string) {
+					value.type = Type::String;
+				} else if (value.datatype == xsd_boolean) {
+					value.type = Type::Boolean;
+					if (value.lexical == "true" or value.lexical == "1")
+						value.boolean = true;
+					else if (value.lexical != "false" and value.lexical != "0")
+						value.type = Type::OtherLiteral;// ill-typed
+				} else if (is_numeric_datatype(value.datatype)) {
+					std::string_view lexical = value.lexical;
+					if (lexical.starts_with('+'))
+						lexical.remove_prefix(1);
+					auto const [end, ec] = std::from_chars(lexical.data(), lexical.data() + lexical.size(), value.number);
+					value.type = (ec == std::errc{} and end == lexical.data() + lexical.size()) ? Type::Numeric : Type::OtherLiteral;
+				} else if (value.datatype == xsd_date_time or value.datatype == xsd_date) {
+					value.type = Type::DateTime;
+				} else {
+					value.type = Type::OtherLiteral;
+				}
+				return value;
+			}
+		};
+
+		/**
+		 * @return the effective boolean value; std::nullopt if it is an error
+		 */
+		std::optional<bool> effective_boolean_value(Value const &value) noexcept {
+			switch (value.type) {
+				case Value::Type::Boolean:
+					return value.boolean;
+				case Value::Type::Numeric:
+					return value.number != 0 and value.number == value.number;
+				case Value::Type::String:
+					return not value.lexical.empty();
+				default:
+					return std::nullopt;
+			}
+		}
+
+		/**
+		 * The = operator: values of the same kind are compared by value, other terms by RDF term equality.
+		 * @return std::nullopt if it is an error
+		 */
+		std::optional<bool> equal(Value const &lhs, Value const &rhs) noexcept {
+			using Type = Value::Type;
+			if (lhs.type == Type::Error or rhs.type == Type::Error)
+				return std::nullopt;
+			if (lhs.type != rhs.type or lhs.type == Type::OtherLiteral) {
+				// literals that are not known to be comparable are only equal if they are the same term
+				if (lhs.is_literal() and rhs.is_literal()) {
+					if (lhs.datatype == rhs.datatype and lhs.lexical == rhs.lexical and lhs.language == rhs.language)
+						return true;
+					return std::nullopt;
+				}
+				return lhs.type == rhs.type and lhs.lexical == rhs.lexical;
+			}
+			switch (lhs.type) {
+				case Type::Boolean:
+					return lhs.boolean == rhs.boolean;
+				case Type::Numeric:
+					return lhs.number == rhs.number;
+				case Type::String:
+					return lhs.lexical == rhs.lexical and equals_ignore_case(lhs.language, rhs.language);
+				case Type::DateTime:
+					if (lhs.datatype != rhs.datatype)
+						return std::nullopt;
+					return lhs.lexical == rhs.lexical;
+				default:
+					return lhs.lexical == rhs.lexical;
+			}
+		}
+
+		/**
+		 * The < operator for numbers, booleans, strings without language tag, and dates of the same datatype.
+		 * @return std::nullopt if it is an error
+		 */
+		std::optional<bool> less(Value const &lhs, Value const &rhs) noexcept {
+			using Type = Value::Type;
+			if (lhs.type != rhs.type)
+				return std::nullopt;
+			switch (lhs.type) {
+				case Type::Boolean:
+					return lhs.boolean < rhs.boolean;
+				case Type::Numeric:
+					return lhs.number < rhs.number;
+				case Type::String:
+					if (not lhs.language.empty() or not rhs.language.empty())
+						return std::nullopt;
+					return lhs.lexical < rhs.lexical;
+				case Type::DateTime:
+					if (lhs.datatype != rhs.datatype)
+						return std::nullopt;
+					return lhs.lexical < rhs.lexical;
+				default:
+					return std::nullopt;
+			}
+		}
+
+		std::optional<bool> compare(FilterExpression::Kind kind, Value const &lhs, Value const &rhs) noexcept {
+			using Kind = FilterExpression::Kind;
+			auto const negate = [](std::optional<bool> result) { return (result) ? std::optional<bool>{not *result} : std::nullopt; };
+			switch (kind) {
+				case Kind::Equal:
+					return equal(lhs, rhs);
+				case Kind::NotEqual:
+					return negate(equal(lhs, rhs));
+				case Kind::Less:
+					return less(lhs, rhs);
+				case Kind::Greater:
+					return less(rhs, lhs);
+				case Kind::LessEqual:
+					return negate(less(rhs, lhs));
+				default:
+					return negate(less(lhs, rhs));
+			}
+		}
+
+		/**
+		 * LANGMATCHES with basic filtering as defined in RFC 4647.
+		 */
+		bool lang_matches(std::string_view tag, std::string_view range) noexcept {
+			if (range == "*")
+				return not tag.empty();
+			if (tag.size() < range.size() or not equals_ignore_case(tag.substr(0, range.size()), range))
+				return false;
+			return tag.size() == range.size() or tag[range.size()] == '-';
+		}
+
+		Value evaluate(FilterExpression const &expression, FilterExpression::Binding const &binding);
+
+		Value evaluate_operand(FilterExpression const &expression, size_t operand, FilterExpression::Binding const &binding) {
+			return evaluate(expression.operands[operand], binding);
+		}
+
+		Value evaluate(FilterExpression const &expression, FilterExpression::Binding const &binding) {
+			using Kind = FilterExpression::Kind;
+			using Type = Value::Type;
+			auto const from_optional = [](std::optional<bool> result) { return (result) ? Value::of_boolean(*result) : Value{}; };
+			switch (expression.kind) {
+				case Kind::Variable:
+					return Value::of_term(binding(expression.term.as_variable()));
+				case Kind::Constant:
+					return Value::of_term(expression.term);
+				case Kind::Or: {
+					// true if one operand is true, even if the other one is an error
+					auto const lhs = effective_boolean_value(evaluate_operand(expression, 0, binding));
+					if (lhs and *lhs)
+						return Value::of_boolean(true);
+					auto const rhs = effective_boolean_value(evaluate_operand(expression, 1, binding));
+					if (rhs and *rhs)
+						return Value::of_boolean(true);
+					return (lhs and rhs) ? Value::of_boolean(false) : Value{};
+				}
+				case Kind::And: {
+					// false if one operand is false, even if the other one is an error
+					auto const lhs = effective_boolean_value(evaluate_operand(expression, 0, binding));
+					if (lhs and not *lhs)
+						return Value::of_boolean(false);
+					auto const rhs = effective_boolean_value(evaluate_operand(expression, 1, binding));
+					if (rhs and not *rhs)
+						return Value::of_boolean(false);
+					return (lhs and rhs) ? Value::of_boolean(true) : Value{};
+				}
+				case Kind::Not: {
+					auto const operand = effective_boolean_value(evaluate_operand(expression, 0, binding));
+					return (operand) ? Value::of_boolean(not *operand) : Value{};
+				}
+				case Kind::Equal:
+				case Kind::NotEqual:
+				case Kind::Less:
+				case Kind::LessEqual:
+				case Kind::Greater:
+				case Kind::GreaterEqual:
+					return from_optional(compare(expression.kind, evaluate_operand(expression, 0, binding), evaluate_operand(expression, 1, binding)));
+				case Kind::Bound:
+					return Value::of_boolean(not binding(expression.operands[0].term.as_variable()).null());
+				default:
+					break;
+			}
+
+			// the remaining kinds are functions; all of them raise an error if an argument is an error
+			auto const argument = evaluate_operand(expression, 0, binding);
+			if (argument.type == Type::Error)
+				return {};
+			switch (expression.kind) {
+				case Kind::IsIRI:
+					return Value::of_boolean(argument.type == Type::IRI);
+				case Kind::IsBlank:
+					return Value::of_boolean(argument.type == Type::BlankNode);
+				case Kind::IsLiteral:
+					return Value::of_boolean(argument.is_literal());
+				case Kind::IsNumeric:
+					return Value::of_boolean(argument.type == Type::Numeric);
+				case Kind::Str:
+					if (argument.type == Type::BlankNode)
+						return {};
+					return Value::of_string(argument.lexical);
+				case Kind::Lang:
+					if (not argument.is_literal())
+						return {};
+					return Value::of_string(argument.language);
+				case Kind::Datatype:
+					if (not argument.is_literal())
+						return {};
+					if (not argument.language.empty())
+						return Value::of_iri("http://www.w3.org/1999/02/22-rdf-syntax-ns#langString");
+					return Value::of_iri(argument.datatype);
+				default:
+					break;
+			}
+
+			auto const second = evaluate_operand(expression, 1, binding);
+			if (second.type == Type::Error)
+				return {};
+			if (expression.kind == Kind::SameTerm)
+				return Value::of_boolean(argument.type == second.type and argument.lexical == second.lexical and
+										 argument.language == second.language and argument.datatype == second.datatype);
+			// the string functions take string literals
+			if (argument.type != Type::String or second.type != Type::String)
+				return {};
+			switch (expression.kind) {
+				case Kind::LangMatches:
+					return Value::of_boolean(lang_matches(argument.lexical, second.lexical));
+				case Kind::Contains:
+					return Value::of_boolean(argument.lexical.find(second.lexical) != std::string::npos);
+				case Kind::StrStarts:
+					return Value::of_boolean(argument.lexical.starts_with(second.lexical));
+				case Kind::StrEnds:
+					return Value::of_boolean(argument.lexical.ends_with(second.lexical));
+				default:
+					return {};
+			}
+		}
+
+		// the rank of each Value::Type in ORDER BY; unbound terms are errors
+		constexpr std::array<uint8_t, 8> sort_rank{/*Error*/ 0, /*IRI*/ 2, /*BlankNode*/ 1, /*Boolean*/ 3, /*Numeric*/ 4,
+												   /*String*/ 5, /*DateTime*/ 6, /*OtherLiteral*/ 7};
+	}// namespace
+
+	bool FilterExpression::satisfied(Binding const &binding) const {
+		return effective_boolean_value(evaluate(*this, binding)).value_or(false);
+	}
+
+	void FilterExpression::collect_variables(std::vector<rdf4cpp::rdf::query::Variable> &variables) const {
+		if (kind == Kind::Variable) {
+			auto const variable = term.as_variable();
+			if (std::ranges::find(variables, variable) == variables.end())
+				variables.push_back(variable);
+			return;
+		}
+		for (auto const &operand : operands)
+			operand.collect_variables(variables);
+	}
+
+	TermSortKey TermSortKey::of(rdf4cpp::rdf::Node const &term) {
+		auto value = Value::of_term(term);
+		TermSortKey key{.rank = sort_rank[static_cast<size_t>(value.type)],
+						.number = (value.type == Value::Type::Boolean) ? double(value.boolean) : value.number,
+						.lexical = std::move(value.lexical)};
+		if (value.is_literal()) {
+			key.detail = std::move(value.datatype);
+			if (not value.language.empty())
+				(key.detail += '@') += value.language;
+		}
+		return key;
+	}
+
+	int TermSortKey::compare(TermSortKey const &other) const noexcept {
+		if (rank != other.rank)
+			return rank < other.rank ? -1 : 1;
+		// booleans and numbers; NaN falls through to the lexical form
+		if (number < other.number)
+			return -1;
+		if (other.number < number)
+			return 1;
+		// equal lexical forms, e.g., of "a" and "a"@en, are ordered by datatype and language tag
+		if (auto const order = lexical.compare(other.lexical); order != 0)
+			return order;
+		return detail.compare(other.detail);
+	}
+
+}// namespace dice::sparql2tensor
@@ -0,0 +1,101 @@
+#ifndef DICE_SPARQL_FILTEREXPRESSION_HPP
+#define DICE_SPARQL_FILTEREXPRESSION_HPP
+
+#include <rdf4cpp/rdf.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dice::sparql2tensor {
+
+	/**
+	 * An expression of a FILTER constraint.
+	 * Supported are the logical operators, the comparison operators, and the functions BOUND, isIRI, isURI, isBlank, isLiteral,
+	 * isNumeric, STR, LANG, DATATYPE, LANGMATCHES, sameTerm, CONTAINS, STRSTARTS and STRENDS.
+	 */
+	struct FilterExpression {
+		enum struct Kind : uint8_t {
+			Variable,
+			Constant,
+			Or,
+			And,
+			Not,
+			Equal,
+			NotEqual,
+			Less,
+			LessEqual,
+			Greater,
+			GreaterEqual,
+			Bound,
+			IsIRI,
+			IsBlank,
+			IsLiteral,
+			IsNumeric,
+			Str,
+			Lang,
+			Datatype,
+			LangMatches,
+			SameTerm,
+			Contains,
+			StrStarts,
+			StrEnds
+		};
+
+		/**
+		 * Looks up the term that a variable is bound to in a solution.
+		 * It returns a null node if the variable is unbound.
+		 */
+		using Binding = std::function<rdf4cpp::rdf::Node(rdf4cpp::rdf::query::Variable const &)>;
+
+		Kind kind = Kind::Constant;
+
+		// the variable of a Variable, or the term of a Constant
+		rdf4cpp::rdf::Node term;
+
+		std::vector<FilterExpression> operands;
+
+		/**
+		 * Evaluates the expression for a solution.
+		 * An expression that raises an error, e.g., by comparing a number with an IRI or by using an unbound variable, is not satisfied.
+		 * @param binding the bindings of the solution
+		 * @return if the effective boolean value of the expression is true
+		 */
+		[[nodiscard]] bool satisfied(Binding const &binding) const;
+
+		/**
+		 * Adds the variables that the expression uses to variables, if they are not contained yet.
+		 * @param variables the variables
+		 */
+		void collect_variables(std::vector<rdf4cpp::rdf::query::Variable> &variables) const;
+	};
+
+	/**
+	 * The key by which ORDER BY sorts a term. Unbound < blank nodes < IRIs < literals. Booleans, numbers, strings and dates are
+	 * ordered as by the < operator of FILTER; the remaining ties are broken by datatype, language tag and lexical form, so that the
+	 * order is total.
+	 */
+	struct TermSortKey {
+		uint8_t rank = 0;
+		double number = 0;
+		// the IRI, the blank node label, or the lexical form of a literal
+		std::string lexical;
+		// the datatype and language tag of a literal
+		std::string detail;
+
+		/**
+		 * @param term a term; a null node is unbound
+		 * @return the sort key of term
+		 */
+		static TermSortKey of(rdf4cpp::rdf::Node const &term);
+
+		/**
+		 * @return a negative number if this sorts before other, a positive number if it sorts after other, and 0 otherwise
+		 */
+		[[nodiscard]] int compare(TermSortKey const &other) const noexcept;
+	};
+
+}// namespace dice::sparql2tensor
+
+#endif//DICE_SPARQL_FILTEREXPRESSION_HPP
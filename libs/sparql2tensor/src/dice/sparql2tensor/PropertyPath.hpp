@@ -0,0 +1,84 @@
+#ifndef DICE_SPARQL_PROPERTYPATH_HPP
+#define DICE_SPARQL_PROPERTYPATH_HPP
+
+#include <rdf4cpp/rdf.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace dice::sparql2tensor {
+
+	/**
+	 * A property path, e.g., ex:p, ^ex:p, ex:p/ex:q, ex:p|ex:q, ex:p*, ex:p+ or ex:p?.
+	 * Negated property sets are not supported.
+	 */
+	struct PropertyPath {
+		enum struct Kind : uint8_t {
+			// a single predicate
+			Link,
+			// the operand with subject and object swapped
+			Inverse,
+			// the operands one after another
+			Sequence,
+			// any of the operands
+			Alternative,
+			// the operand repeated any number of times
+			ZeroOrMore,
+			OneOrMore,
+			ZeroOrOne
+		};
+
+		Kind kind = Kind::Link;
+
+		// the predicate of a Link
+		rdf4cpp::rdf::IRI iri;
+
+		std::vector<PropertyPath> operands;
+
+		/**
+		 * @return true if the path connects every node with itself, i.e., if it matches with length zero
+		 */
+		[[nodiscard]] bool nullable() const noexcept {
+			switch (kind) {
+				case Kind::Link:
+					return false;
+				case Kind::Inverse:
+				case Kind::OneOrMore:
+					return operands.front().nullable();
+				case Kind::Sequence:
+					return std::ranges::all_of(operands, &PropertyPath::nullable);
+				case Kind::Alternative:
+					return std::ranges::any_of(operands, &PropertyPath::nullable);
+				default:
+					return true;
+			}
+		}
+	};
+
+	/**
+	 * A triple pattern whose predicate is a property path other than a single predicate.
+	 */
+	struct PathPattern {
+		rdf4cpp::rdf::Node subject;
+
+		PropertyPath path;
+
+		rdf4cpp::rdf::Node object;
+
+		/**
+		 * @return the variables of subject and object without repetition; they are the dimensions of the operand of the pattern
+		 */
+		[[nodiscard]] std::vector<rdf4cpp::rdf::query::Variable> variables() const {
+			std::vector<rdf4cpp::rdf::query::Variable> variables;
+			if (subject.is_variable())
+				variables.push_back(subject.as_variable());
+			if (object.is_variable() and object != subject)
+				variables.push_back(object.as_variable());
+			return variables;
+		}
+	};
+
+}// namespace dice::sparql2tensor
+
+#endif//DICE_SPARQL_PROPERTYPATH_HPP
@@ -0,0 +1,160 @@
+#include "QueryCanonicalizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include <rdf4cpp/rdf.hpp>
+#include <robin_hood.h>
+
+#include "dice/sparql2tensor/parser/BGPQueryReader.hpp"
+
+namespace dice::sparql2tensor {
+
+	namespace {
+		using parser::BGPTerm;
+
+		/**
+		 * @return the IRI in angle brackets. Prefixed names are expanded like the parser expands them, so the canonical query denotes the same IRIs.
+		 * @throws std::runtime_error if a prefixed name cannot be expanded
+		 */
+		std::string render_iri(std::string const &iri, bool prefixed, rdf4cpp::rdf::IRIFactory &prefixes) {
+			if (not prefixed)
+				return "<" + iri + ">";
+			auto const split = iri.find(':');
+			auto maybe_iri = prefixes.from_prefix(iri.substr(0, split), iri.substr(split + 1));
+			if (not maybe_iri.has_value())
+				throw std::runtime_error("Invalid prefixed IRI");
+			return "<" + std::string(maybe_iri->identifier()) + ">";
+		}
+
+		/**
+		 * @return the term in N-Triples like syntax; variables are rendered as ?
+		 */
+		std::string render_constant(BGPTerm const &term, rdf4cpp::rdf::IRIFactory &prefixes) {
+			switch (term.kind) {
+				case BGPTerm::Kind::Variable:
+					return "?";
+				case BGPTerm::Kind::IRI:
+					return render_iri(term.value, term.prefixed, prefixes);
+				case BGPTerm::Kind::Literal:
+					if (not term.language_tag.empty())
+						return term.value + "@" + term.language_tag;
+					if (not term.datatype.empty())
+						return term.value + "^^" + render_iri(term.datatype, term.datatype_prefixed, prefixes);
+					return term.value;
+				default:
+					return term.value;
+			}
+		}
+	}// namespace
+
+	std::optional<CanonicalQuery> canonicalize(std::string_view query_str) {
+		auto reader = parser::read_bgp_query(query_str);
+		if (not reader)
+			return std::nullopt;
+		auto const &patterns = reader->triples;
+		rdf4cpp::rdf::IRIFactory prefixes;
+		for (auto const &[prefix, ns] : reader->prefixes)
+			prefixes.assign_prefix(prefix, ns);
+		// a prefixed name that cannot be expanded makes the query fail; it is left to the parser to report that
+		std::vector<std::string> constants;
+		try {
+			for (auto const &pattern : patterns) {
+				for (auto const &term : pattern)
+					constants.push_back(render_constant(term, prefixes));
+			}
+		} catch (std::runtime_error const &) {
+			return std::nullopt;
+		}
+
+		// order the patterns by their constants; variables are not considered, because their names are arbitrary
+		std::vector<std::string> shapes;
+		shapes.reserve(patterns.size());
+		for (size_t index = 0; index < patterns.size(); ++index) {
+			std::string shape;
+			for (size_t position = 0; position < 3; ++position) {
+				shape.append(constants[3 * index + position]);
+				shape.push_back(' ');
+			}
+			shapes.push_back(std::move(shape));
+		}
+		std::vector<size_t> order(patterns.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::stable_sort(order, [&](size_t lhs, size_t rhs) { return shapes[lhs] < shapes[rhs]; });
+
+		// number the variables in the order of first occurrence in the sorted patterns
+		robin_hood::unordered_map<std::string_view, std::string> canonical_names;
+		auto canonical_name = [&](std::string_view name) -> std::string const & {
+			auto [iter, inserted] = canonical_names.try_emplace(name);
+			if (inserted)
+				iter->second = "?v" + std::to_string(canonical_names.size() - 1);
+			return iter->second;
+		};
+		for (auto const index : order) {
+			for (auto const &term : patterns[index]) {
+				if (term.is_variable())
+					canonical_name(term.value);
+			}
+		}
+
+		std::vector<std::string> rendered;
+		rendered.reserve(patterns.size());
+		for (size_t index = 0; index < patterns.size(); ++index) {
+			std::string text;
+			for (size_t position = 0; position < 3; ++position) {
+				auto const &term = patterns[index][position];
+				text.append(term.is_variable() ? canonical_name(term.value) : constants[3 * index + position]);
+				text.push_back(' ');
+			}
+			text.push_back('.');
+			rendered.push_back(std::move(text));
+		}
+		std::ranges::sort(rendered);
+		auto const duplicates = std::ranges::unique(rendered);
+		rendered.erase(duplicates.begin(), duplicates.end());
+
+		CanonicalQuery canonical;
+		if (reader->ask) {
+			canonical.text = "ASK";
+		} else {
+			if (reader->project_all) {
+				// SELECT * projects the variables in the order of their first occurrence in the request
+				for (auto const &pattern : patterns) {
+					for (auto const &term : pattern) {
+						if (term.is_variable() and std::ranges::find(canonical.result_variable_names, term.value) == canonical.result_variable_names.end())
+							canonical.result_variable_names.push_back(term.value);
+					}
+				}
+				if (canonical.result_variable_names.empty())
+					return std::nullopt;
+			} else {
+				canonical.result_variable_names = std::move(reader->projection);
+			}
+			canonical.text = reader->distinct ? "SELECT DISTINCT" : "SELECT";
+			if (reader->count) {
+				// the name of the aggregate is only relevant for the response
+				canonical.text.append(reader->count->distinct ? " (COUNT(DISTINCT " : " (COUNT(");
+				canonical.text.append(reader->count->variable.empty() ? "*" : canonical_name(reader->count->variable));
+				canonical.text.append(") AS ?count)");
+			} else {
+				for (auto const &name : canonical.result_variable_names) {
+					canonical.text.push_back(' ');
+					canonical.text.append(canonical_name(name));
+				}
+			}
+		}
+		canonical.text.append(" WHERE {");
+		for (auto const &pattern : rendered) {
+			canonical.text.push_back(' ');
+			canonical.text.append(pattern);
+		}
+		canonical.text.append(" }");
+		if (reader->limit)
+			canonical.text.append(" LIMIT " + std::to_string(*reader->limit));
+		if (reader->offset != 0)
+			canonical.text.append(" OFFSET " + std::to_string(reader->offset));
+		return canonical;
+	}
+
+}// namespace dice::sparql2tensor
@@ -0,0 +1,36 @@
+#ifndef DICE_SPARQL_QUERYCANONICALIZER_HPP
+#define DICE_SPARQL_QUERYCANONICALIZER_HPP
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dice::sparql2tensor {
+
+	/**
+	 * Normalized form of a query. Equivalent requests that differ only in whitespace, comments, prefix declarations,
+	 * variable names or the order of their triple patterns have the same text.
+	 */
+	struct CanonicalQuery {
+		// the normalized query: full IRIs, variables named ?v0, ?v1, ..., triple patterns sorted and deduplicated
+		std::string text;
+		// names (without ?) of the projected variables in the request, in projection order.
+		// result_variable_names[i] is the name in the request of the i-th projected variable of text.
+		std::vector<std::string> result_variable_names;
+	};
+
+	/**
+	 * Canonicalizes SELECT and ASK queries whose WHERE clause is a single basic graph pattern.
+	 * Supported are PREFIX declarations, DISTINCT, SELECT *, a COUNT aggregate, triple patterns with the abbreviations ; , and a, LIMIT and OFFSET.
+	 *
+	 * The canonical form is a fingerprint, not a full graph canonicalization: variables are numbered in the order of triple patterns
+	 * sorted by their constants, so some isomorphic queries with symmetric patterns still get different texts.
+	 * @param query_str a SPARQL query
+	 * @return the canonical form, or std::nullopt if the query uses anything else (then the query should be used as it is)
+	 */
+	std::optional<CanonicalQuery> canonicalize(std::string_view query_str);
+
+}// namespace dice::sparql2tensor
+
+#endif//DICE_SPARQL_QUERYCANONICALIZER_HPP
@@ -1,8 +1,13 @@
 #include "SPARQLQuery.hpp"
 
+#include <algorithm>
+
 #include <SparqlLexer/SparqlLexer.h>
 #include <SparqlParser/SparqlParser.h>
 
+#include "dice/sparql2tensor/parser/BGPQueryReader.hpp"
+#include "dice/sparql2tensor/parser/GroupOperands.hpp"
+
 #include "dice/sparql2tensor/parser/visitors/PrologueVisitor.hpp"
 
 #include "dice/sparql2tensor/parser/visitors/SelectAskQueryVisitor.hpp"
@@ -10,29 +15,241 @@
 
 namespace dice::sparql2tensor {
 
-	SPARQLQuery dice::sparql2tensor::SPARQLQuery::parse(std::string const &sparql_query_str) {
-		antlr4::ANTLRInputStream input(sparql_query_str);
-		dice::sparql_parser::base::SparqlLexer lexer(&input);
-		antlr4::CommonTokenStream tokens(&lexer);
-		dice::sparql_parser::base::SparqlParser parser(&tokens);
+	namespace {
+		/**
+		 * @param iri an IRI or, if prefixed is set, a prefixed name. Prefixed names are expanded with prefixes, like SelectAskQueryVisitor does.
+		 */
+		rdf4cpp::rdf::IRI make_iri(std::string const &iri, bool prefixed, rdf4cpp::rdf::IRIFactory &prefixes) {
+			if (not prefixed)
+				return rdf4cpp::rdf::IRI(iri);
+			auto const split = iri.find(':');
+			auto maybe_iri = prefixes.from_prefix(iri.substr(0, split), iri.substr(split + 1));
+			if (not maybe_iri.has_value())
+				throw std::runtime_error("Invalid prefixed IRI");
+			return *maybe_iri;
+		}
+
+		rdf4cpp::rdf::Node make_node(parser::BGPTerm const &term, rdf4cpp::rdf::IRIFactory &prefixes) {
+			using Kind = parser::BGPTerm::Kind;
+			using namespace rdf4cpp::rdf;
+			switch (term.kind) {
+				case Kind::Variable:
+					return rdf4cpp::rdf::query::Variable(term.value);
+				case Kind::IRI:
+					return make_iri(term.value, term.prefixed, prefixes);
+				case Kind::Literal: {
+					auto const &quoted = term.value;
+					size_t const quotes = (quoted.size() >= 6 and quoted[1] == quoted[0] and quoted[2] == quoted[0]) ? 3 : 1;
+					auto const lexical = quoted.substr(quotes, quoted.size() - 2 * quotes);
+					if (not term.language_tag.empty())
+						return Literal::make_lang_tagged(lexical, term.language_tag);
+					if (not term.datatype.empty())
+						return Literal::make_typed(lexical, make_iri(term.datatype, term.datatype_prefixed, prefixes));
+					return Literal::make_simple(lexical);
+				}
+				case Kind::Number:
+					if (term.value.find_first_of("eE") != std::string::npos)
+						return Literal::make_typed(term.value, IRI("http://www.w3.org/2001/XMLSchema#double"));
+					if (term.value.find('.') != std::string::npos)
+						return Literal::make_typed(term.value, IRI("http://www.w3.org/2001/XMLSchema#decimal"));
+					return Literal::make_typed(term.value, IRI("http://www.w3.org/2001/XMLSchema#integer"));
+				case Kind::Boolean:
+					return Literal::make_boolean(term.value == "true");
+			}
+			throw std::runtime_error("Unknown term kind.");
+		}
+
+		/**
+		 * Builds a query that consists of a single basic graph pattern directly from its tokens, without the ANTLR parser.
+		 * The result is the same as the one of the SelectAskQueryVisitor: variable ids are assigned in order of appearance,
+		 * every triple pattern is a mandatory operand, and all operands form one group in the operand dependency graph.
+		 * @return the query, or std::nullopt if the query is not a plain basic graph pattern query
+		 */
+		std::optional<SPARQLQuery> from_bgp(std::string const &sparql_query_str) {
+			auto bgp = parser::read_bgp_query(sparql_query_str);
+			if (not bgp)
+				return std::nullopt;
+
+			SPARQLQuery p_sparql{};
+			for (auto const &[prefix, ns] : bgp->prefixes)
+				p_sparql.prefixes_.assign_prefix(prefix, ns);
+			p_sparql.ask_ = bgp->ask;
+			p_sparql.distinct_ = bgp->distinct;
+			p_sparql.project_all_variables_ = bgp->project_all;
+			p_sparql.limit_ = bgp->limit;
+			p_sparql.offset_ = bgp->offset;
 
-		auto q_ctx = parser.query();
+			char next_var_id = 'a';
+			auto register_var = [&](rdf4cpp::rdf::query::Variable const &var) {
+				if (p_sparql.var_to_id_.try_emplace(var, next_var_id).second)
+					++next_var_id;
+			};
 
-		if (not q_ctx->selectQuery() and not q_ctx->askQuery())
-			throw std::runtime_error("Only SELECT & ASK queries are supported currently.");
+			std::vector<uint8_t> group;
+			p_sparql.triple_patterns_.reserve(bgp->triples.size());
+			for (auto const &triple : bgp->triples) {
+				auto const &tp = p_sparql.triple_patterns_.emplace_back(make_node(triple[0], p_sparql.prefixes_),
+																		make_node(triple[1], p_sparql.prefixes_),
+																		make_node(triple[2], p_sparql.prefixes_));
+				std::vector<char> var_ids;
+				for (auto const &node : tp) {
+					if (not node.is_variable())
+						continue;
+					register_var(node.as_variable());
+					var_ids.push_back(p_sparql.var_to_id_[node.as_variable()]);
+				}
+				p_sparql.mandatory_operands_.push_back(parser::add_group_operand(p_sparql.odg_, group, var_ids));
+			}
+
+			if (bgp->project_all) {
+				for (auto const &tp : p_sparql.triple_patterns_) {
+					for (auto const &node : tp) {
+						if (node.is_variable() and std::ranges::find(p_sparql.projected_variables_, node.as_variable()) == p_sparql.projected_variables_.end())
+							p_sparql.projected_variables_.push_back(node.as_variable());
+					}
+				}
+			} else if (bgp->count) {
+				CountAggregate count{.distinct = bgp->count->distinct};
+				if (not bgp->count->variable.empty())
+					count.variable = rdf4cpp::rdf::query::Variable{bgp->count->variable};
+				p_sparql.count_ = std::move(count);
+				p_sparql.projected_variables_.emplace_back(bgp->projection.front());
+			} else {
+				for (auto const &name : bgp->projection) {
+					rdf4cpp::rdf::query::Variable var{name};
+					register_var(var);
+					p_sparql.projected_variables_.push_back(var);
+				}
+			}
+			return p_sparql;
+		}
 
-		SPARQLQuery p_sparql{};
-		if (q_ctx->prologue()) {
-			parser::visitors::PrologueVisitor p_visitor{p_sparql.prefixes_};
-		    p_visitor.visitPrologue(q_ctx->prologue());
+		/**
+		 * A variable that equals a constant in every solution can be replaced by the constant, which then becomes part of the slice keys.
+		 * For =, the constant must be an IRI or a string without language tag; for other literals, equal values may be different terms.
+		 * @return if FILTER(?x = term) holds exactly for the solutions that bind ?x to term
+		 */
+		bool equality_is_term_equality(rdf4cpp::rdf::Node const &term) {
+			if (term.is_iri())
+				return true;
+			if (not term.is_literal())
+				return false;
+			auto const literal = term.as_literal();
+			return literal.language_tag().empty() and literal.datatype().identifier() == "http://www.w3.org/2001/XMLSchema#string";
 		}
 
-		parser::visitors::SelectAskQueryVisitor visitor{&p_sparql};
-		if (q_ctx->selectQuery())
-			visitor.visitSelectQuery(q_ctx->selectQuery());
-		else if(q_ctx->askQuery())
-			visitor.visitAskQuery(q_ctx->askQuery());
+		/**
+		 * Finds the FILTER conjuncts ?x = term and sameTerm(?x, term) that fix a variable to a constant and removes them from query.filters_.
+		 * Only variables of mandatory triple patterns are fixed, because every solution binds them. Variables of VALUES blocks are not
+		 * fixed, because the blocks are not rewritten.
+		 * @param query a parsed query
+		 * @return the fixed variables and their constants
+		 */
+		auto extract_fixed_variables(SPARQLQuery &query) {
+			using Kind = FilterExpression::Kind;
+			decltype(SPARQLQuery::fixed_variables_) fixed_variables;
+			auto const in_mandatory_pattern = [&](rdf4cpp::rdf::Node const &var) {
+				return std::ranges::any_of(query.mandatory_operands_, [&](auto operand) {
+					auto const &tp = query.triple_patterns_[operand];
+					return std::ranges::find(tp, var) != tp.end();
+				});
+			};
+			std::erase_if(query.filters_, [&](FilterExpression const &conjunct) {
+				if (conjunct.kind != Kind::Equal and conjunct.kind != Kind::SameTerm)
+					return false;
+				bool const variable_first = conjunct.operands[0].kind == Kind::Variable;
+				auto const &variable = conjunct.operands[variable_first ? 0 : 1];
+				auto const &constant = conjunct.operands[variable_first ? 1 : 0];
+				if (variable.kind != Kind::Variable or constant.kind != Kind::Constant)
+					return false;
+				if (conjunct.kind == Kind::Equal and not equality_is_term_equality(constant.term))
+					return false;
+				auto const in_values = std::ranges::any_of(query.values_, [&](InlineValues const &values) {
+					return std::ranges::find(values.variables, variable.term) != values.variables.end();
+				});
+				if (not in_mandatory_pattern(variable.term) or in_values or fixed_variables.contains(variable.term.as_variable()))
+					return false;
+				fixed_variables.emplace(variable.term.as_variable(), constant.term);
+				return true;
+			});
+			return fixed_variables;
+		}
+
+		SPARQLQuery from_grammar(std::string const &sparql_query_str) {
+			antlr4::ANTLRInputStream input(sparql_query_str);
+			dice::sparql_parser::base::SparqlLexer lexer(&input);
+			antlr4::CommonTokenStream tokens(&lexer);
+			dice::sparql_parser::base::SparqlParser parser(&tokens);
+
+			auto q_ctx = parser.query();
+
+			if (not q_ctx->selectQuery() and not q_ctx->askQuery())
+				throw std::runtime_error("Only SELECT & ASK queries are supported currently.");
 
+			auto visit = [&](SPARQLQuery &p_sparql) {
+				if (q_ctx->prologue()) {
+					parser::visitors::PrologueVisitor p_visitor{p_sparql.prefixes_};
+					p_visitor.visitPrologue(q_ctx->prologue());
+				}
+
+				parser::visitors::SelectAskQueryVisitor visitor{&p_sparql};
+				if (q_ctx->selectQuery())
+					visitor.visitSelectQuery(q_ctx->selectQuery());
+				else if (q_ctx->askQuery())
+					visitor.visitAskQuery(q_ctx->askQuery());
+			};
+
+			SPARQLQuery p_sparql{};
+			visit(p_sparql);
+			auto fixed_variables = extract_fixed_variables(p_sparql);
+			if (fixed_variables.empty())
+				return p_sparql;
+
+			// the parse tree is visited again with the fixed variables replaced by their constants
+			SPARQLQuery rewritten{};
+			rewritten.fixed_variables_ = std::move(fixed_variables);
+			visit(rewritten);
+			rewritten.filters_ = std::move(p_sparql.filters_);
+			// the fixed variables are still projected, e.g., by SELECT *
+			rewritten.projected_variables_ = std::move(p_sparql.projected_variables_);
+			return rewritten;
+		}
+
+		std::vector<rdf_tensor::SliceKey> make_slice_keys(std::vector<rdf4cpp::rdf::query::TriplePattern> const &triple_patterns) {
+			std::vector<rdf_tensor::SliceKey> slice_keys;
+			slice_keys.reserve(triple_patterns.size());
+			for (auto const &tp : triple_patterns) {
+				rdf_tensor::SliceKey slice_key;
+				slice_key.reserve(3);
+				for (auto const &node : tp) {
+					if (node.is_variable())
+						slice_key.push_back(std::nullopt);
+					else
+						slice_key.push_back(node);
+				}
+				slice_keys.push_back(std::move(slice_key));
+			}
+			return slice_keys;
+		}
+	}// namespace
+
+	SPARQLQuery SPARQLQuery::parse(std::string const &sparql_query_str) {
+		// most queries are plain basic graph patterns; they do not need the full grammar
+		auto bgp_query = parse_bgp(sparql_query_str);
+		return (bgp_query) ? std::move(*bgp_query) : parse_with_grammar(sparql_query_str);
+	}
+
+	std::optional<SPARQLQuery> SPARQLQuery::parse_bgp(std::string const &sparql_query_str) {
+		auto p_sparql = from_bgp(sparql_query_str);
+		// the slice keys are needed by every evaluation; parsed queries are cached, so they are computed only once
+		if (p_sparql)
+			p_sparql->slice_keys_ = make_slice_keys(p_sparql->triple_patterns_);
+		return p_sparql;
+	}
+
+	SPARQLQuery SPARQLQuery::parse_with_grammar(std::string const &sparql_query_str) {
+		auto p_sparql = from_grammar(sparql_query_str);
+		p_sparql.slice_keys_ = make_slice_keys(p_sparql.triple_patterns_);
 		return p_sparql;
 	}
 
@@ -40,20 +257,7 @@ namespace dice::sparql2tensor {
 		return distinct_;
 	}
 
-	std::vector<rdf_tensor::SliceKey> SPARQLQuery::get_slice_keys() const {
-		std::vector<rdf_tensor::SliceKey> slice_keys;
-		slice_keys.reserve(triple_patterns_.size());
-		for (auto const &tp : triple_patterns_) {
-			rdf_tensor::SliceKey slice_key;
-			slice_key.reserve(3);
-			for (auto const &node : tp) {
-				if (node.is_variable())
-					slice_key.push_back(std::nullopt);
-				else
-					slice_key.push_back(node);
-			}
-			slice_keys.push_back(std::move(slice_key));
-		}
-		return slice_keys;
+	std::vector<rdf_tensor::SliceKey> const &SPARQLQuery::get_slice_keys() const noexcept {
+		return slice_keys_;
 	}
 }// namespace dice::sparql2tensor
\ No newline at end of file
@@ -10,8 +10,40 @@
 
 #include <robin_hood.h>
 
+#include "dice/sparql2tensor/FilterExpression.hpp"
+#include "dice/sparql2tensor/PropertyPath.hpp"
+
 namespace dice::sparql2tensor {
 
+	/**
+	 * COUNT aggregate of a query: COUNT(*), COUNT(?x), COUNT(DISTINCT *) or COUNT(DISTINCT ?x).
+	 */
+	struct CountAggregate {
+		// the counted variable; std::nullopt for *
+		std::optional<rdf4cpp::rdf::query::Variable> variable;
+
+		bool distinct = false;
+	};
+
+	/**
+	 * An inline VALUES block: a table of constants for some variables.
+	 */
+	struct InlineValues {
+		std::vector<rdf4cpp::rdf::query::Variable> variables;
+
+		// each row binds variables[i] to row[i]
+		std::vector<std::vector<rdf4cpp::rdf::Node>> rows;
+	};
+
+	/**
+	 * A condition of an ORDER BY clause: ?x, ASC(?x) or DESC(?x).
+	 */
+	struct OrderCondition {
+		rdf4cpp::rdf::query::Variable variable;
+
+		bool descending = false;
+	};
+
 	struct SPARQLQuery {
 		dice::query::OperandDependencyGraph odg_;
 
@@ -21,6 +53,14 @@ namespace dice::sparql2tensor {
 
 		std::vector<rdf4cpp::rdf::query::TriplePattern> triple_patterns_;
 
+		// operands (indices into triple_patterns_) that every solution must match, i.e., those outside of OPTIONAL and UNION.
+		// if one of them has no match, the query has no solution.
+		std::vector<uint8_t> mandatory_operands_;
+
+		// operands of each branch of a top-level UNION, including the operands of its OPTIONALs. The branches are independent
+		// components of odg_; their solutions are united. Empty if the query has no top-level UNION.
+		std::vector<std::vector<uint8_t>> union_branches_;
+
 		rdf4cpp::rdf::IRIFactory prefixes_;
 
 		bool distinct_ = false;
@@ -29,15 +69,67 @@ namespace dice::sparql2tensor {
 
 		bool project_all_variables_ = false;
 
+		// LIMIT; std::nullopt if there is none
+		std::optional<size_t> limit_;
+
+		// OFFSET; 0 if there is none
+		size_t offset_ = 0;
+
+		// the conditions of ORDER BY, most significant first; empty if there is none. Each variable is projected.
+		std::vector<OrderCondition> order_by_;
+
+		// set if the query projects only a COUNT aggregate. Then projected_variables_ holds the variable the count is bound to,
+		// which does not appear in the graph pattern and has no entry in var_to_id_.
+		std::optional<CountAggregate> count_;
+
+		// the conjuncts of the FILTERs of the top-level group graph pattern; every solution must satisfy all of them
+		std::vector<FilterExpression> filters_;
+
+		// variables that a FILTER fixes to a constant, e.g., FILTER(?x = <iri>). They are replaced by their constant in triple_patterns_
+		// and have no entry in var_to_id_; every solution binds them to their constant.
+		robin_hood::unordered_map<rdf4cpp::rdf::query::Variable, rdf4cpp::rdf::Node, dice::hash::DiceHashwyhash<rdf4cpp::rdf::query::Variable>> fixed_variables_;
+
+		// the VALUES blocks of the top-level group graph pattern. Operand triple_patterns_.size() + i of odg_ is the table of values_[i];
+		// it joins with all triple patterns.
+		std::vector<InlineValues> values_;
+
+		// the patterns of the top-level group graph pattern whose predicate is a property path. Operand
+		// triple_patterns_.size() + values_.size() + i of odg_ holds the matches of path_patterns_[i]; it joins with all other operands.
+		std::vector<PathPattern> path_patterns_;
+
+		// the slice key of each triple pattern; see get_slice_keys()
+		std::vector<rdf_tensor::SliceKey> slice_keys_;
+
 		SPARQLQuery() = default;
 
+		/**
+		 * Parses a query. Plain basic graph pattern queries are parsed with parse_bgp, all others with parse_with_grammar.
+		 * @throws std::runtime_error if the query is invalid or not supported
+		 */
 		static SPARQLQuery parse(std::string const &sparql_query_str);
 
+		/**
+		 * Parses a query that consists of a single basic graph pattern directly from its tokens, without the ANTLR parser.
+		 * The result equals the one of parse_with_grammar.
+		 * @return the query, or std::nullopt if the query is not a plain basic graph pattern query (see parser::read_bgp_query)
+		 * @throws std::runtime_error if a prefixed name cannot be expanded
+		 */
+		static std::optional<SPARQLQuery> parse_bgp(std::string const &sparql_query_str);
+
+		/**
+		 * Parses a query with the ANTLR parser.
+		 * @throws std::runtime_error if the query is invalid or not supported
+		 */
+		static SPARQLQuery parse_with_grammar(std::string const &sparql_query_str);
+
 		SPARQLQuery(std::string const &sparql_query_str) : SPARQLQuery(SPARQLQuery::parse(sparql_query_str)) {}
 
 		[[nodiscard]] bool is_distinct() const noexcept;
 
-		std::vector<rdf_tensor::SliceKey> get_slice_keys() const;
+		/**
+		 * @return the slice key of each triple pattern. They are computed when the query is parsed.
+		 */
+		[[nodiscard]] std::vector<rdf_tensor::SliceKey> const &get_slice_keys() const noexcept;
 
 		//the following variables and methods are used to handle variable IDs and names. these are used to find query features.
 		// Add this as a mutable member variable
@@ -0,0 +1,302 @@
+#include "BGPQueryReader.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include <robin_hood.h>
+
+#include "dice/sparql2tensor/parser/SPARQLTokenizer.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	namespace {
+		/**
+		 * Reads COUNT ( [DISTINCT] (* | ?x) ) starting at pos. On success, pos is moved behind the closing parenthesis.
+		 */
+		bool read_count(std::vector<Token> const &tokens, size_t &pos, BGPCount &count) {
+			auto token = [&](size_t offset) -> Token const * { return pos + offset < tokens.size() ? &tokens[pos + offset] : nullptr; };
+			size_t offset = 0;
+			if (not token(offset) or not token(offset)->is_keyword("COUNT"))
+				return false;
+			if (++offset; not token(offset) or not token(offset)->is_punctuation('('))
+				return false;
+			++offset;
+			count.distinct = token(offset) and token(offset)->is_keyword("DISTINCT");
+			if (count.distinct)
+				++offset;
+			if (auto argument = token(offset); argument and argument->is_punctuation('*'))
+				count.variable.clear();
+			else if (argument and argument->type == TokenType::Variable)
+				count.variable = argument->text.substr(1);
+			else
+				return false;
+			if (++offset; not token(offset) or not token(offset)->is_punctuation(')'))
+				return false;
+			pos += offset + 1;
+			return true;
+		}
+
+		/**
+		 * Reads the supported query subset from tokens. Every method returns false if the input is not supported.
+		 */
+		class Reader {
+			std::vector<Token> const &tokens_;
+			size_t pos_ = 0;
+			robin_hood::unordered_map<std::string_view, std::string_view> namespaces_;
+
+		public:
+			BGPQuery query;
+
+			explicit Reader(std::vector<Token> const &tokens) : tokens_(tokens) {}
+
+		private:
+			[[nodiscard]] Token const *peek() const noexcept {
+				return pos_ < tokens_.size() ? &tokens_[pos_] : nullptr;
+			}
+
+			bool accept_punctuation(char c) noexcept {
+				if (auto token = peek(); token and token->is_punctuation(c)) {
+					++pos_;
+					return true;
+				}
+				return false;
+			}
+
+			bool accept_keyword(std::string_view keyword) noexcept {
+				if (auto token = peek(); token and token->is_keyword(keyword)) {
+					++pos_;
+					return true;
+				}
+				return false;
+			}
+
+			/**
+			 * @return if prefixed_name can be expanded: its prefix is declared and its local name is not empty and has no escapes
+			 */
+			[[nodiscard]] bool is_expandable(std::string_view prefixed_name) const {
+				auto const colon = prefixed_name.find(':');
+				auto const local = prefixed_name.substr(colon + 1);
+				// escaped local names are left to the full parser
+				if (local.empty() or local.find('\\') != std::string_view::npos)
+					return false;
+				return namespaces_.contains(prefixed_name.substr(0, colon));
+			}
+
+			bool read_iri(std::string &iri, bool &prefixed) {
+				auto token = peek();
+				if (not token)
+					return false;
+				if (token->type == TokenType::IRIRef) {
+					iri = token->text.substr(1, token->text.size() - 2);
+					prefixed = false;
+				} else if (token->type == TokenType::PrefixedName) {
+					if (not is_expandable(token->text))
+						return false;
+					iri = token->text;
+					prefixed = true;
+				} else {
+					return false;
+				}
+				++pos_;
+				return true;
+			}
+
+			bool read_term(BGPTerm &term, bool predicate_position) {
+				auto token = peek();
+				if (not token)
+					return false;
+				switch (token->type) {
+					case TokenType::Variable:
+						term.kind = BGPTerm::Kind::Variable;
+						term.value = token->text.substr(1);
+						++pos_;
+						return true;
+					case TokenType::IRIRef:
+					case TokenType::PrefixedName:
+						term.kind = BGPTerm::Kind::IRI;
+						return read_iri(term.value, term.prefixed);
+					case TokenType::Word:
+						if (predicate_position and token->text == "a") {
+							term.kind = BGPTerm::Kind::IRI;
+							term.value = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type";
+						} else if (not predicate_position and (token->is_keyword("TRUE") or token->is_keyword("FALSE"))) {
+							term.kind = BGPTerm::Kind::Boolean;
+							term.value = token->is_keyword("TRUE") ? "true" : "false";
+						} else {
+							return false;
+						}
+						++pos_;
+						return true;
+					case TokenType::Number:
+						if (predicate_position)
+							return false;
+						term.kind = BGPTerm::Kind::Number;
+						term.value = token->text;
+						++pos_;
+						return true;
+					case TokenType::String: {
+						if (predicate_position)
+							return false;
+						term.kind = BGPTerm::Kind::Literal;
+						term.value = token->text;
+						++pos_;
+						if (auto next = peek(); next and next->type == TokenType::LangTag) {
+							term.language_tag = next->text.substr(1);
+							++pos_;
+						} else if (next and next->type == TokenType::DoubleCaret) {
+							++pos_;
+							if (not read_iri(term.datatype, term.datatype_prefixed))
+								return false;
+						}
+						return true;
+					}
+					default:
+						return false;
+				}
+			}
+
+			bool read_object_list(BGPTerm const &subject, BGPTerm const &predicate) {
+				do {
+					BGPTerm object;
+					if (not read_term(object, false))
+						return false;
+					query.triples.push_back(BGPTriple{subject, predicate, std::move(object)});
+				} while (accept_punctuation(','));
+				return true;
+			}
+
+			bool read_triples() {
+				while (not accept_punctuation('}')) {
+					BGPTerm subject;
+					if (not read_term(subject, false))
+						return false;
+					while (true) {
+						BGPTerm predicate;
+						if (not read_term(predicate, true) or not read_object_list(subject, predicate))
+							return false;
+						if (not accept_punctuation(';'))
+							break;
+						while (accept_punctuation(';')) {}
+						if (auto next = peek(); next and (next->is_punctuation('.') or next->is_punctuation('}')))
+							break;
+					}
+					if (not accept_punctuation('.')) {
+						if (auto next = peek(); not next or not next->is_punctuation('}'))
+							return false;
+					}
+				}
+				return true;
+			}
+
+			bool read_integer(size_t &value) {
+				auto token = peek();
+				if (not token or token->type != TokenType::Number or
+					not std::ranges::all_of(token->text, [](char c) { return c >= '0' and c <= '9'; }))
+					return false;
+				if (std::from_chars(token->text.data(), token->text.data() + token->text.size(), value).ec != std::errc{})
+					return false;
+				++pos_;
+				return true;
+			}
+
+			bool read_limit_offset() {
+				bool has_limit = false;
+				bool has_offset = false;
+				while (true) {
+					if (not has_limit and accept_keyword("LIMIT")) {
+						size_t limit;
+						if (not read_integer(limit))
+							return false;
+						query.limit = limit;
+						has_limit = true;
+					} else if (not has_offset and accept_keyword("OFFSET")) {
+						if (not read_integer(query.offset))
+							return false;
+						has_offset = true;
+					} else {
+						return true;
+					}
+				}
+			}
+
+		public:
+			bool read() {
+				while (accept_keyword("PREFIX")) {
+					auto prefix = peek();
+					if (not prefix or prefix->type != TokenType::PrefixedName or prefix->text.back() != ':')
+						return false;
+					++pos_;
+					auto ns = peek();
+					if (not ns or ns->type != TokenType::IRIRef)
+						return false;
+					++pos_;
+					auto const prefix_name = prefix->text.substr(0, prefix->text.size() - 1);
+					auto const ns_iri = ns->text.substr(1, ns->text.size() - 2);
+					namespaces_[prefix_name] = ns_iri;
+					query.prefixes.emplace_back(prefix_name, ns_iri);
+				}
+				if (accept_keyword("ASK")) {
+					query.ask = true;
+				} else if (accept_keyword("SELECT")) {
+					query.distinct = accept_keyword("DISTINCT");
+					if (accept_punctuation('*')) {
+						query.project_all = true;
+					} else if (accept_punctuation('(')) {
+						// ( COUNT(...) AS ?x )
+						BGPCount count;
+						if (not read_count(tokens_, pos_, count) or not accept_keyword("AS"))
+							return false;
+						auto result = peek();
+						if (not result or result->type != TokenType::Variable)
+							return false;
+						query.projection.emplace_back(result->text.substr(1));
+						++pos_;
+						if (not accept_punctuation(')'))
+							return false;
+						query.count = std::move(count);
+					} else {
+						while (auto token = peek()) {
+							if (token->type != TokenType::Variable)
+								break;
+							query.projection.emplace_back(token->text.substr(1));
+							++pos_;
+						}
+						if (query.projection.empty())
+							return false;
+					}
+				} else {
+					return false;
+				}
+				accept_keyword("WHERE");
+				if (not accept_punctuation('{') or not read_triples())
+					return false;
+				if (not query.ask and not read_limit_offset())
+					return false;
+				// other solution modifiers and everything else are not supported
+				return pos_ == tokens_.size() and not query.triples.empty();
+			}
+		};
+	}// namespace
+
+	std::optional<BGPQuery> read_bgp_query(std::string_view query_str) {
+		auto tokens = tokenize(query_str);
+		if (not tokens)
+			return std::nullopt;
+		Reader reader{*tokens};
+		if (not reader.read())
+			return std::nullopt;
+		return std::move(reader.query);
+	}
+
+	std::optional<BGPCount> read_count_expression(std::string_view expression_str) {
+		auto tokens = tokenize(expression_str);
+		if (not tokens)
+			return std::nullopt;
+		size_t pos = 0;
+		BGPCount count;
+		if (not read_count(*tokens, pos, count) or pos != tokens->size())
+			return std::nullopt;
+		return count;
+	}
+
+}// namespace dice::sparql2tensor::parser
@@ -0,0 +1,90 @@
+#ifndef DICE_SPARQL_BGPQUERYREADER_HPP
+#define DICE_SPARQL_BGPQUERYREADER_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * A term of a triple pattern as written in the query.
+	 */
+	struct BGPTerm {
+		enum struct Kind : uint8_t {
+			Variable,
+			IRI,
+			Literal,
+			Number,
+			Boolean
+		};
+
+		Kind kind;
+		// Variable: name without sigil; IRI: the IRI without angle brackets or the prefixed name; Literal: the string token including
+		// its quotes; Number: the numeric token; Boolean: true or false
+		std::string value;
+		// IRI only: value is a prefixed name with a declared prefix. It is expanded like the ANTLR parser does it, with the IRIFactory of the query.
+		bool prefixed = false;
+		// Literal only: the language tag without @, if any
+		std::string language_tag;
+		// Literal only: the datatype IRI without angle brackets or the prefixed name, if any
+		std::string datatype;
+		// Literal only: datatype is a prefixed name with a declared prefix
+		bool datatype_prefixed = false;
+
+		[[nodiscard]] bool is_variable() const noexcept { return kind == Kind::Variable; }
+	};
+
+	using BGPTriple = std::array<BGPTerm, 3>;
+
+	/**
+	 * A COUNT aggregate: COUNT(*), COUNT(?x), COUNT(DISTINCT *) or COUNT(DISTINCT ?x).
+	 */
+	struct BGPCount {
+		bool distinct = false;
+		// name (without ?) of the counted variable; empty for *
+		std::string variable;
+	};
+
+	/**
+	 * The syntax of a SELECT or ASK query whose WHERE clause is a single basic graph pattern.
+	 */
+	struct BGPQuery {
+		// prefix (without colon) and namespace IRI of each PREFIX declaration
+		std::vector<std::pair<std::string, std::string>> prefixes;
+		bool ask = false;
+		bool distinct = false;
+		bool project_all = false;
+		// names (without ?) of the projected variables; empty for ASK and SELECT *. For a COUNT aggregate, the name it is bound to.
+		std::vector<std::string> projection;
+		// SELECT (COUNT(...) AS ?x) as the only projection
+		std::optional<BGPCount> count;
+		// the triple patterns in the order they are written
+		std::vector<BGPTriple> triples;
+		// SELECT only: LIMIT and OFFSET
+		std::optional<size_t> limit;
+		size_t offset = 0;
+	};
+
+	/**
+	 * Reads a query that consists only of PREFIX declarations, SELECT [DISTINCT] with variables, * or a single COUNT aggregate, or ASK,
+	 * a WHERE clause with triple patterns using the abbreviations ; , and a, and for SELECT optionally LIMIT and OFFSET.
+	 * @param query_str a SPARQL query
+	 * @return the query, or std::nullopt if it uses anything else, e.g., OPTIONAL, blank nodes, ORDER BY or undeclared prefixes
+	 */
+	std::optional<BGPQuery> read_bgp_query(std::string_view query_str);
+
+	/**
+	 * Reads a COUNT aggregate expression like COUNT(DISTINCT ?x), without the surrounding parentheses and AS.
+	 * @param expression_str the expression
+	 * @return the aggregate, or std::nullopt if the expression is anything else
+	 */
+	std::optional<BGPCount> read_count_expression(std::string_view expression_str);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_BGPQUERYREADER_HPP
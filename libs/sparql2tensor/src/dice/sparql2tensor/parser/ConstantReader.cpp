@@ -0,0 +1,73 @@
+#include "ConstantReader.hpp"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace dice::sparql2tensor::parser {
+
+	namespace {
+		std::optional<rdf4cpp::rdf::IRI> read_iri(std::vector<Token> const &tokens, size_t &pos, rdf4cpp::rdf::IRIFactory &prefixes) {
+			if (pos >= tokens.size())
+				return std::nullopt;
+			auto const &token = tokens[pos];
+			if (token.type == TokenType::IRIRef) {
+				++pos;
+				return rdf4cpp::rdf::IRI(token.text.substr(1, token.text.size() - 2));
+			}
+			if (token.type != TokenType::PrefixedName)
+				return std::nullopt;
+			auto const colon = token.text.find(':');
+			auto maybe_iri = prefixes.from_prefix(token.text.substr(0, colon), token.text.substr(colon + 1));
+			if (not maybe_iri.has_value())
+				throw std::runtime_error("Invalid prefixed IRI");
+			++pos;
+			return *maybe_iri;
+		}
+	}// namespace
+
+	std::optional<rdf4cpp::rdf::Node> read_constant(std::vector<Token> const &tokens, size_t &pos, rdf4cpp::rdf::IRIFactory &prefixes) {
+		using namespace rdf4cpp::rdf;
+		if (pos >= tokens.size())
+			return std::nullopt;
+		auto const &token = tokens[pos];
+		switch (token.type) {
+			case TokenType::IRIRef:
+			case TokenType::PrefixedName:
+				return read_iri(tokens, pos, prefixes);
+			case TokenType::String: {
+				++pos;
+				auto const quoted = token.text;
+				size_t const quotes = (quoted.size() >= 6 and quoted[1] == quoted[0] and quoted[2] == quoted[0]) ? 3 : 1;
+				auto const lexical = quoted.substr(quotes, quoted.size() - 2 * quotes);
+				if (pos < tokens.size() and tokens[pos].type == TokenType::LangTag)
+					return Literal::make_lang_tagged(lexical, tokens[pos++].text.substr(1));
+				if (pos < tokens.size() and tokens[pos].type == TokenType::DoubleCaret) {
+					++pos;
+					auto datatype = read_iri(tokens, pos, prefixes);
+					if (not datatype)
+						throw std::runtime_error("Literal requires a datatype IRI after ^^");
+					return Literal::make_typed(lexical, *datatype);
+				}
+				return Literal::make_simple(lexical);
+			}
+			case TokenType::Number: {
+				++pos;
+				std::string_view datatype = "http://www.w3.org/2001/XMLSchema#integer";
+				if (token.text.find_first_of("eE") != std::string_view::npos)
+					datatype = "http://www.w3.org/2001/XMLSchema#double";
+				else if (token.text.find('.') != std::string_view::npos)
+					datatype = "http://www.w3.org/2001/XMLSchema#decimal";
+				return Literal::make_typed(token.text, IRI(datatype));
+			}
+			case TokenType::Word:
+				if (token.is_keyword("TRUE") or token.is_keyword("FALSE")) {
+					++pos;
+					return Literal::make_boolean(token.is_keyword("TRUE"));
+				}
+				return std::nullopt;
+			default:
+				return std::nullopt;
+		}
+	}
+
+}// namespace dice::sparql2tensor::parser
@@ -0,0 +1,25 @@
+#ifndef DICE_SPARQL_CONSTANTREADER_HPP
+#define DICE_SPARQL_CONSTANTREADER_HPP
+
+#include <rdf4cpp/rdf.hpp>
+
+#include <optional>
+#include <vector>
+
+#include "dice/sparql2tensor/parser/SPARQLTokenizer.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * Reads an IRI, a literal, a number or a boolean that starts at tokens[pos]. On success, pos is moved behind it.
+	 * @param tokens the tokens
+	 * @param pos the position of the first token of the constant
+	 * @param prefixes expands the prefixed names
+	 * @return the constant, or std::nullopt if tokens[pos] does not start a constant
+	 * @throws std::runtime_error if the constant is malformed, e.g., if a prefixed name has an unknown prefix
+	 */
+	std::optional<rdf4cpp::rdf::Node> read_constant(std::vector<Token> const &tokens, size_t &pos, rdf4cpp::rdf::IRIFactory &prefixes);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_CONSTANTREADER_HPP
@@ -0,0 +1,198 @@
+#include "FilterExpressionReader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "dice/sparql2tensor/parser/ConstantReader.hpp"
+#include "dice/sparql2tensor/parser/SPARQLTokenizer.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	namespace {
+		using Kind = FilterExpression::Kind;
+
+		struct Function {
+			std::string_view name;
+			Kind kind;
+			size_t arity;
+		};
+
+		// the supported functions; names are upper case
+		constexpr std::array<Function, 14> functions{{{"BOUND", Kind::Bound, 1},
+													  {"ISIRI", Kind::IsIRI, 1},
+													  {"ISURI", Kind::IsIRI, 1},
+													  {"ISBLANK", Kind::IsBlank, 1},
+													  {"ISLITERAL", Kind::IsLiteral, 1},
+													  {"ISNUMERIC", Kind::IsNumeric, 1},
+													  {"STR", Kind::Str, 1},
+													  {"LANG", Kind::Lang, 1},
+													  {"DATATYPE", Kind::Datatype, 1},
+													  {"LANGMATCHES", Kind::LangMatches, 2},
+													  {"SAMETERM", Kind::SameTerm, 2},
+													  {"CONTAINS", Kind::Contains, 2},
+													  {"STRSTARTS", Kind::StrStarts, 2},
+													  {"STRENDS", Kind::StrEnds, 2}}};
+
+		struct Operator {
+			std::string_view text;
+			Kind kind;
+		};
+
+		constexpr std::array<Operator, 6> relational_operators{{{"=", Kind::Equal},
+																{"!=", Kind::NotEqual},
+																{"<", Kind::Less},
+																{"<=", Kind::LessEqual},
+																{">", Kind::Greater},
+																{">=", Kind::GreaterEqual}}};
+
+		/**
+		 * Recursive descent over the expression grammar of SPARQL, restricted to the supported operators and functions.
+		 */
+		class Reader {
+			std::vector<Token> const &tokens_;
+			size_t pos_ = 0;
+			rdf4cpp::rdf::IRIFactory &prefixes_;
+
+		public:
+			Reader(std::vector<Token> const &tokens, rdf4cpp::rdf::IRIFactory &prefixes) : tokens_(tokens), prefixes_(prefixes) {}
+
+			FilterExpression read() {
+				auto expression = read_or();
+				if (pos_ != tokens_.size())
+					unsupported();
+				return expression;
+			}
+
+		private:
+			[[noreturn]] void unsupported() const {
+				if (pos_ < tokens_.size())
+					throw std::runtime_error("FILTER expression not supported at: " + std::string(tokens_[pos_].text));
+				throw std::runtime_error("FILTER expression ends unexpectedly.");
+			}
+
+			[[nodiscard]] Token const *peek() const noexcept {
+				return pos_ < tokens_.size() ? &tokens_[pos_] : nullptr;
+			}
+
+			bool accept_punctuation(std::string_view text) noexcept {
+				if (auto token = peek(); token and token->type == TokenType::Punctuation and token->text == text) {
+					++pos_;
+					return true;
+				}
+				return false;
+			}
+
+			void expect_punctuation(std::string_view text) {
+				if (not accept_punctuation(text))
+					unsupported();
+			}
+
+			static FilterExpression make(Kind kind, std::vector<FilterExpression> operands) {
+				return FilterExpression{.kind = kind, .operands = std::move(operands)};
+			}
+
+			FilterExpression read_or() {
+				auto expression = read_and();
+				while (accept_punctuation("||"))
+					expression = make(Kind::Or, {std::move(expression), read_and()});
+				return expression;
+			}
+
+			FilterExpression read_and() {
+				auto expression = read_relational();
+				while (accept_punctuation("&&"))
+					expression = make(Kind::And, {std::move(expression), read_relational()});
+				return expression;
+			}
+
+			FilterExpression read_relational() {
+				auto expression = read_unary();
+				if (auto token = peek(); token and token->type == TokenType::Punctuation) {
+					auto const op = std::ranges::find(relational_operators, token->text, &Operator::text);
+					if (op != relational_operators.end()) {
+						++pos_;
+						expression = make(op->kind, {std::move(expression), read_unary()});
+					}
+				}
+				return expression;
+			}
+
+			FilterExpression read_unary() {
+				if (accept_punctuation("!"))
+					return make(Kind::Not, {read_unary()});
+				return read_primary();
+			}
+
+			FilterExpression read_function(Function const &function) {
+				++pos_;
+				expect_punctuation("(");
+				std::vector<FilterExpression> operands;
+				for (size_t argument = 0; argument < function.arity; ++argument) {
+					if (argument != 0)
+						expect_punctuation(",");
+					operands.push_back(read_or());
+				}
+				expect_punctuation(")");
+				if (function.kind == Kind::Bound and operands.front().kind != Kind::Variable)
+					throw std::runtime_error("BOUND requires a variable.");
+				return make(function.kind, std::move(operands));
+			}
+
+			FilterExpression read_primary() {
+				auto token = peek();
+				if (not token)
+					unsupported();
+				switch (token->type) {
+					case TokenType::Punctuation: {
+						expect_punctuation("(");
+						auto expression = read_or();
+						expect_punctuation(")");
+						return expression;
+					}
+					case TokenType::Variable:
+						++pos_;
+						return FilterExpression{.kind = Kind::Variable, .term = rdf4cpp::rdf::query::Variable(token->text.substr(1))};
+					default:
+						break;
+				}
+				if (auto constant = read_constant(tokens_, pos_, prefixes_); constant)
+					return FilterExpression{.kind = Kind::Constant, .term = *constant};
+				if (token->type == TokenType::Word) {
+					auto const function = std::ranges::find_if(functions, [&](Function const &f) { return token->is_keyword(f.name); });
+					if (function == functions.end())
+						throw std::runtime_error("FILTER function " + std::string(token->text) + " is not supported yet.");
+					return read_function(*function);
+				}
+				unsupported();
+			}
+		};
+	}// namespace
+
+	FilterExpression read_filter_expression(std::string_view constraint, rdf4cpp::rdf::IRIFactory &prefixes) {
+		auto tokens = tokenize(constraint);
+		if (not tokens)
+			throw std::runtime_error("Malformed FILTER expression.");
+		return Reader{*tokens, prefixes}.read();
+	}
+
+	std::vector<FilterExpression> split_conjunction(FilterExpression expression) {
+		std::vector<FilterExpression> conjuncts;
+		std::vector<FilterExpression> pending{std::move(expression)};
+		while (not pending.empty()) {
+			auto current = std::move(pending.back());
+			pending.pop_back();
+			if (current.kind == Kind::And) {
+				// keep the written order of the operands
+				pending.push_back(std::move(current.operands[1]));
+				pending.push_back(std::move(current.operands[0]));
+			} else {
+				conjuncts.push_back(std::move(current));
+			}
+		}
+		return conjuncts;
+	}
+
+}// namespace dice::sparql2tensor::parser
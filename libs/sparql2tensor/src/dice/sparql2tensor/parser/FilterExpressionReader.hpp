@@ -0,0 +1,30 @@
+#ifndef DICE_SPARQL_FILTEREXPRESSIONREADER_HPP
+#define DICE_SPARQL_FILTEREXPRESSIONREADER_HPP
+
+#include <rdf4cpp/rdf.hpp>
+
+#include <string_view>
+
+#include "dice/sparql2tensor/FilterExpression.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * Reads the constraint of a FILTER, e.g., (?x > 5 && lang(?y) = "en") or isIRI(?x).
+	 * @param constraint the constraint as written in the query
+	 * @param prefixes expands the prefixed names
+	 * @return the expression of the constraint
+	 * @throws std::runtime_error if the constraint uses an operator or a function that is not supported
+	 */
+	FilterExpression read_filter_expression(std::string_view constraint, rdf4cpp::rdf::IRIFactory &prefixes);
+
+	/**
+	 * Splits an expression into the operands of its top-level conjunctions.
+	 * @param expression an expression
+	 * @return expressions whose conjunction is equivalent to expression
+	 */
+	std::vector<FilterExpression> split_conjunction(FilterExpression expression);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_FILTEREXPRESSIONREADER_HPP
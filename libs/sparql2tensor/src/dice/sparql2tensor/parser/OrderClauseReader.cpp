@@ -0,0 +1,39 @@
+#include "OrderClauseReader.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "dice/sparql2tensor/parser/SPARQLTokenizer.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	std::vector<OrderCondition> read_order_clause(std::string_view clause) {
+		auto tokens = tokenize(clause);
+		if (not tokens or tokens->size() < 3 or not(*tokens)[0].is_keyword("ORDER") or not(*tokens)[1].is_keyword("BY"))
+			throw std::runtime_error("Malformed ORDER BY clause.");
+		auto const is_variable = [&](size_t pos) {
+			return pos < tokens->size() and (*tokens)[pos].type == TokenType::Variable;
+		};
+		auto const make_condition = [&](size_t pos, bool descending) {
+			return OrderCondition{.variable = rdf4cpp::rdf::query::Variable((*tokens)[pos].text.substr(1)), .descending = descending};
+		};
+
+		std::vector<OrderCondition> conditions;
+		size_t pos = 2;
+		while (pos < tokens->size()) {
+			auto const &token = (*tokens)[pos];
+			if (token.type == TokenType::Variable) {
+				conditions.push_back(make_condition(pos, false));
+				pos += 1;
+			} else if ((token.is_keyword("ASC") or token.is_keyword("DESC")) and pos + 3 < tokens->size() and
+					   (*tokens)[pos + 1].is_punctuation('(') and is_variable(pos + 2) and (*tokens)[pos + 3].is_punctuation(')')) {
+				conditions.push_back(make_condition(pos + 2, token.is_keyword("DESC")));
+				pos += 4;
+			} else {
+				throw std::runtime_error("ORDER BY supports only variables yet, not: " + std::string(token.text));
+			}
+		}
+		return conditions;
+	}
+
+}// namespace dice::sparql2tensor::parser
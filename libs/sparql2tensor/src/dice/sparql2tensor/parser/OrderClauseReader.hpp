@@ -0,0 +1,21 @@
+#ifndef DICE_SPARQL_ORDERCLAUSEREADER_HPP
+#define DICE_SPARQL_ORDERCLAUSEREADER_HPP
+
+#include <string_view>
+#include <vector>
+
+#include "dice/sparql2tensor/SPARQLQuery.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * Reads an ORDER BY clause whose conditions are variables, e.g., ORDER BY ?x DESC(?y) ASC(?z).
+	 * @param clause the clause as written in the query, starting with the keyword ORDER
+	 * @return the conditions in the written order
+	 * @throws std::runtime_error if a condition is an expression other than a variable
+	 */
+	std::vector<OrderCondition> read_order_clause(std::string_view clause);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_ORDERCLAUSEREADER_HPP
@@ -0,0 +1,174 @@
+#include "SPARQLTokenizer.hpp"
+
+#include <algorithm>
+
+namespace dice::sparql2tensor::parser {
+
+	namespace {
+		bool is_ws(char c) noexcept {
+			return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+		}
+
+		bool is_alpha(char c) noexcept {
+			return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z');
+		}
+
+		bool is_digit(char c) noexcept {
+			return c >= '0' and c <= '9';
+		}
+
+		// non-ASCII bytes are accepted as name characters; the ANTLR grammar validates them in detail
+		bool is_name_char(char c) noexcept {
+			return is_alpha(c) or is_digit(c) or c == '_' or c == '-' or static_cast<unsigned char>(c) >= 0x80;
+		}
+
+		bool is_iri_char(char c) noexcept {
+			return not(is_ws(c) or c == '<' or c == '"' or c == '{' or c == '}' or c == '|' or c == '^' or c == '`' or c == '\\');
+		}
+	}// namespace
+
+	bool Token::is_keyword(std::string_view keyword) const noexcept {
+		if (type != TokenType::Word or text.size() != keyword.size())
+			return false;
+		return std::ranges::equal(text, keyword, [](char lhs, char rhs) {
+			return (lhs >= 'a' and lhs <= 'z' ? char(lhs - 'a' + 'A') : lhs) == rhs;
+		});
+	}
+
+	std::optional<std::vector<Token>> tokenize(std::string_view query) {
+		std::vector<Token> tokens;
+		tokens.reserve(query.size() / 4);
+		size_t pos = 0;
+		auto const size = query.size();
+		auto peek = [&](size_t offset = 0) -> char { return pos + offset < size ? query[pos + offset] : '\0'; };
+		auto emit = [&](TokenType type, size_t begin) { tokens.push_back(Token{type, query.substr(begin, pos - begin)}); };
+
+		while (pos < size) {
+			char const c = query[pos];
+			size_t const begin = pos;
+			if (is_ws(c)) {
+				++pos;
+			} else if (c == '#') {
+				while (pos < size and query[pos] != '\n')
+					++pos;
+			} else if (c == '<') {
+				// IRI reference or the less-than operator
+				size_t end = pos + 1;
+				while (end < size and is_iri_char(query[end]) and query[end] != '>')
+					++end;
+				if (end < size and query[end] == '>') {
+					pos = end + 1;
+					emit(TokenType::IRIRef, begin);
+				} else {
+					pos += (peek(1) == '=') ? 2 : 1;
+					emit(TokenType::Punctuation, begin);
+				}
+			} else if ((c == '?' or c == '$') and is_name_char(peek(1))) {
+				++pos;
+				while (pos < size and is_name_char(query[pos]) and query[pos] != '-')
+					++pos;
+				emit(TokenType::Variable, begin);
+			} else if (c == '"' or c == '\'') {
+				bool const long_string = peek(1) == c and peek(2) == c;
+				pos += long_string ? 3 : 1;
+				while (true) {
+					if (pos >= size)
+						return std::nullopt;
+					if (query[pos] == '\\') {
+						pos += 2;
+					} else if (query[pos] == c and (not long_string or (peek(1) == c and peek(2) == c))) {
+						pos += long_string ? 3 : 1;
+						break;
+					} else if (not long_string and (query[pos] == '\n' or query[pos] == '\r')) {
+						return std::nullopt;
+					} else {
+						++pos;
+					}
+				}
+				emit(TokenType::String, begin);
+			} else if (c == '@' and is_alpha(peek(1))) {
+				++pos;
+				while (pos < size and (is_alpha(query[pos]) or is_digit(query[pos]) or query[pos] == '-'))
+					++pos;
+				emit(TokenType::LangTag, begin);
+			} else if (c == '^' and peek(1) == '^') {
+				pos += 2;
+				emit(TokenType::DoubleCaret, begin);
+			} else if (is_digit(c) or ((c == '+' or c == '-' or c == '.') and (is_digit(peek(1)) or (c != '.' and peek(1) == '.' and is_digit(peek(2)))))) {
+				if (c == '+' or c == '-')
+					++pos;
+				while (pos < size and is_digit(query[pos]))
+					++pos;
+				if (peek() == '.' and is_digit(peek(1))) {
+					++pos;
+					while (pos < size and is_digit(query[pos]))
+						++pos;
+				}
+				if ((peek() == 'e' or peek() == 'E') and (is_digit(peek(1)) or ((peek(1) == '+' or peek(1) == '-') and is_digit(peek(2))))) {
+					pos += 2;
+					while (pos < size and is_digit(query[pos]))
+						++pos;
+				}
+				emit(TokenType::Number, begin);
+			} else if (c == '_' and peek(1) == ':') {
+				pos += 2;
+				while (pos < size and (is_name_char(query[pos]) or query[pos] == '.'))
+					++pos;
+				while (pos > begin + 2 and query[pos - 1] == '.')// a trailing dot ends the triple
+					--pos;
+				emit(TokenType::BlankNodeLabel, begin);
+			} else if (is_alpha(c) or c == ':' or static_cast<unsigned char>(c) >= 0x80) {
+				while (pos < size and (is_name_char(query[pos]) or query[pos] == '.'))
+					++pos;
+				while (pos > begin and query[pos - 1] == '.')
+					--pos;
+				if (peek() == ':') {
+					++pos;
+					while (pos < size and (is_name_char(query[pos]) or query[pos] == '.' or query[pos] == ':' or query[pos] == '%' or
+										   (query[pos] == '\\' and pos + 1 < size))) {
+						pos += (query[pos] == '\\') ? 2 : 1;
+					}
+					while (query[pos - 1] == '.' and pos - 1 > begin and query[pos - 2] != '\\')
+						--pos;
+					emit(TokenType::PrefixedName, begin);
+				} else {
+					emit(TokenType::Word, begin);
+				}
+			} else {
+				switch (c) {
+					case '{':
+					case '}':
+					case '(':
+					case ')':
+					case '[':
+					case ']':
+					case '.':
+					case ';':
+					case ',':
+					case '*':
+					case '+':
+					case '-':
+					case '/':
+					case '^':
+					case '?':
+						++pos;
+						break;
+					case '=':
+					case '!':
+					case '>':
+						pos += (peek(1) == '=') ? 2 : 1;
+						break;
+					case '|':
+					case '&':
+						pos += (peek(1) == c) ? 2 : 1;
+						break;
+					default:
+						return std::nullopt;
+				}
+				emit(TokenType::Punctuation, begin);
+			}
+		}
+		return tokens;
+	}
+
+}// namespace dice::sparql2tensor::parser
@@ -0,0 +1,50 @@
+#ifndef DICE_SPARQL_SPARQLTOKENIZER_HPP
+#define DICE_SPARQL_SPARQLTOKENIZER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace dice::sparql2tensor::parser {
+
+	enum struct TokenType : uint8_t {
+		IRIRef,        // <http://example.com/x>, text includes the angle brackets
+		PrefixedName,  // ex:x or :x or ex:
+		Variable,      // ?x or $x, text includes the sigil
+		String,        // "x", 'x', """x""" or '''x''', text includes the quotes
+		LangTag,       // @en, text includes the @
+		DoubleCaret,   // ^^
+		Number,        // 1, -1.5, 1e3
+		BlankNodeLabel,// _:b
+		Word,          // keywords like SELECT and the abbreviation a
+		Punctuation    // { } ( ) [ ] . ; , * = ! < > + - / ? | & ^ and the pairs && || != <= >=
+	};
+
+	struct Token {
+		TokenType type;
+		// view into the tokenized query string
+		std::string_view text;
+
+		/**
+		 * @return true if this is a Word that equals keyword case-insensitively; keyword must be upper case
+		 */
+		[[nodiscard]] bool is_keyword(std::string_view keyword) const noexcept;
+
+		[[nodiscard]] bool is_punctuation(char c) const noexcept {
+			return type == TokenType::Punctuation and text.size() == 1 and text[0] == c;
+		}
+	};
+
+	/**
+	 * Splits a SPARQL query string into tokens without building a parse tree.
+	 * It covers the lexical grammar that is needed for basic graph pattern queries and enough of the rest to tokenize most queries.
+	 * Comments and whitespace are dropped.
+	 * @param query a SPARQL query
+	 * @return the tokens, or std::nullopt if the query contains input that is not understood, e.g., an unterminated string
+	 */
+	std::optional<std::vector<Token>> tokenize(std::string_view query);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_SPARQLTOKENIZER_HPP
@@ -0,0 +1,81 @@
+#include "ValuesBlockReader.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "dice/sparql2tensor/parser/ConstantReader.hpp"
+#include "dice/sparql2tensor/parser/SPARQLTokenizer.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	InlineValues read_values_block(std::string_view block, rdf4cpp::rdf::IRIFactory &prefixes) {
+		auto tokens = tokenize(block);
+		if (not tokens)
+			throw std::runtime_error("Malformed VALUES block.");
+		size_t pos = 0;
+		auto const malformed = [&]() {
+			if (pos < tokens->size())
+				return std::runtime_error("VALUES block not supported at: " + std::string((*tokens)[pos].text));
+			return std::runtime_error("VALUES block ends unexpectedly.");
+		};
+		auto const accept_punctuation = [&](char c) {
+			if (pos < tokens->size() and (*tokens)[pos].is_punctuation(c)) {
+				++pos;
+				return true;
+			}
+			return false;
+		};
+		auto const read_variable = [&](InlineValues &values) {
+			if (pos >= tokens->size() or (*tokens)[pos].type != TokenType::Variable)
+				return false;
+			rdf4cpp::rdf::query::Variable var{(*tokens)[pos].text.substr(1)};
+			if (std::ranges::find(values.variables, var) != values.variables.end())
+				throw std::runtime_error("VALUES block repeats variable " + std::string(var.name()) + ".");
+			values.variables.push_back(var);
+			++pos;
+			return true;
+		};
+		auto const read_value = [&](std::vector<rdf4cpp::rdf::Node> &row) {
+			if (pos < tokens->size() and (*tokens)[pos].is_keyword("UNDEF"))
+				throw std::runtime_error("UNDEF in VALUES is not supported yet.");
+			auto value = read_constant(*tokens, pos, prefixes);
+			if (not value)
+				throw malformed();
+			row.push_back(*value);
+		};
+
+		InlineValues values;
+		if (pos >= tokens->size() or not (*tokens)[pos].is_keyword("VALUES"))
+			throw malformed();
+		++pos;
+		// a single variable without parentheses and its values without parentheses, or lists of both
+		bool const single_variable = read_variable(values);
+		if (not single_variable) {
+			if (not accept_punctuation('('))
+				throw malformed();
+			while (read_variable(values)) {}
+			if (not accept_punctuation(')') or values.variables.empty())
+				throw malformed();
+		}
+		if (not accept_punctuation('{'))
+			throw malformed();
+		while (not accept_punctuation('}')) {
+			auto &row = values.rows.emplace_back();
+			row.reserve(values.variables.size());
+			if (single_variable) {
+				read_value(row);
+				continue;
+			}
+			if (not accept_punctuation('('))
+				throw malformed();
+			while (not accept_punctuation(')'))
+				read_value(row);
+			if (row.size() != values.variables.size())
+				throw std::runtime_error("VALUES row has " + std::to_string(row.size()) + " values for " + std::to_string(values.variables.size()) + " variables.");
+		}
+		if (pos != tokens->size())
+			throw malformed();
+		return values;
+	}
+
+}// namespace dice::sparql2tensor::parser
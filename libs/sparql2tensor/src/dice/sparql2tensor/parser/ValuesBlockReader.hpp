@@ -0,0 +1,23 @@
+#ifndef DICE_SPARQL_VALUESBLOCKREADER_HPP
+#define DICE_SPARQL_VALUESBLOCKREADER_HPP
+
+#include <rdf4cpp/rdf.hpp>
+
+#include <string_view>
+
+#include "dice/sparql2tensor/SPARQLQuery.hpp"
+
+namespace dice::sparql2tensor::parser {
+
+	/**
+	 * Reads an inline VALUES block, e.g., VALUES ?x { <a> <b> } or VALUES (?x ?y) { (<a> 1) (<b> 2) }.
+	 * @param block the block as written in the query, starting with the keyword VALUES
+	 * @param prefixes expands the prefixed names
+	 * @return the variables and rows of the block
+	 * @throws std::runtime_error if the block is malformed, repeats a variable or contains UNDEF
+	 */
+	InlineValues read_values_block(std::string_view block, rdf4cpp::rdf::IRIFactory &prefixes);
+
+}// namespace dice::sparql2tensor::parser
+
+#endif//DICE_SPARQL_VALUESBLOCKREADER_HPP
@@ -1,12 +1,26 @@
 #include "dice/sparql2tensor/parser/visitors/SelectAskQueryVisitor.hpp"
 
-#include <boost/container/flat_set.hpp>
+#include "dice/sparql2tensor/parser/BGPQueryReader.hpp"
+#include "dice/sparql2tensor/parser/FilterExpressionReader.hpp"
+#include "dice/sparql2tensor/parser/GroupOperands.hpp"
+#include "dice/sparql2tensor/parser/OrderClauseReader.hpp"
+#include "dice/sparql2tensor/parser/ValuesBlockReader.hpp"
 
 #include <algorithm>
 #include <ranges>
 
 namespace dice::sparql2tensor::parser::visitors {
 
+	namespace {
+		/**
+		 * @return the query text of a context. Unlike getText(), it keeps the whitespace between the tokens.
+		 */
+		std::string source_text(antlr4::ParserRuleContext *ctx) {
+			auto *input = ctx->getStart()->getInputStream();
+			return input->getText(antlr4::misc::Interval(ctx->getStart()->getStartIndex(), ctx->getStop()->getStopIndex()));
+		}
+	}// namespace
+
 	std::any SelectAskQueryVisitor::visitAskQuery(SparqlParser::AskQueryContext *ctx) {
 		if (auto where_clause_ctx = ctx->whereClause(); where_clause_ctx)
 			visitWhereClause(where_clause_ctx);
@@ -21,6 +35,22 @@ namespace dice::sparql2tensor::parser::visitors {
 		else
 			throw std::runtime_error("Query does not contain a WHERE clause");
 		visitSelectClause(ctx->selectClause());
+		if (auto solution_modifier_ctx = ctx->solutionModifier(); solution_modifier_ctx) {
+			// a COUNT has a single solution, so its ORDER BY has no effect
+			if (auto order_ctx = solution_modifier_ctx->orderClause(); order_ctx and not query->count_) {
+				query->order_by_ = read_order_clause(source_text(order_ctx));
+				for (auto const &condition : query->order_by_) {
+					if (std::ranges::find(query->projected_variables_, condition.variable) == query->projected_variables_.end())
+						throw std::runtime_error("ORDER BY supports only projected variables yet.");
+				}
+			}
+			if (auto limit_offset_ctx = solution_modifier_ctx->limitOffsetClauses(); limit_offset_ctx) {
+				if (auto limit_ctx = limit_offset_ctx->limitClause(); limit_ctx)
+					query->limit_ = std::stoull(limit_ctx->INTEGER()->getText());
+				if (auto offset_ctx = limit_offset_ctx->offsetClause(); offset_ctx)
+					query->offset_ = std::stoull(offset_ctx->INTEGER()->getText());
+			}
+		}
 		return nullptr;
 	}
 
@@ -45,28 +75,67 @@ namespace dice::sparql2tensor::parser::visitors {
 					}
 				}
 			}
+			// followed by the variables that only VALUES blocks and property paths bind
+			for (auto const &values : query->values_) {
+				for (auto const &var : values.variables) {
+					if (seen_vars.insert(var).second)
+						query->projected_variables_.push_back(var);
+				}
+			}
+			for (auto const &path_pattern : query->path_patterns_) {
+				for (auto const &var : path_pattern.variables()) {
+					if (not var.is_anonymous() and seen_vars.insert(var).second)
+						query->projected_variables_.push_back(var);
+				}
+			}
 		} else {
-			for (auto sel_ctx : ctx->selectVariables()) {
-				if (auto var_ctx = sel_ctx->var(); var_ctx) {
+			auto const select_variables = ctx->selectVariables();
+			for (auto sel_ctx : select_variables) {
+				if (auto expression_ctx = sel_ctx->expression(); expression_ctx) {
+					// the only supported expression is a COUNT aggregate that is projected alone
+					auto count = read_count_expression(expression_ctx->getText());
+					if (not count or select_variables.size() != 1)
+						throw std::runtime_error("Expressions in SELECT clause are not supported yet.");
+					CountAggregate aggregate{.distinct = count->distinct};
+					if (not count->variable.empty())
+						aggregate.variable = rdf4cpp::rdf::query::Variable{count->variable};
+					query->count_ = std::move(aggregate);
+					query->projected_variables_.push_back(std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(sel_ctx->var())));
+				} else if (auto var_ctx = sel_ctx->var(); var_ctx) {
 					auto var = std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(var_ctx));
-					register_var(var);
+					if (not query->fixed_variables_.contains(var))
+						register_var(var);
 					query->projected_variables_.push_back(var);
 				} else {
 					throw std::runtime_error("Expressions in SELECT clause are not supported yet.");
 				}
 			}
 		}
-		if (query->projected_variables_.empty())
+		// with SELECT *, the variables that a FILTER fixes are projected by SPARQLQuery::parse
+		if (query->projected_variables_.empty() and query->fixed_variables_.empty())
 			throw std::runtime_error("At least one variable should be projected.");
 		return nullptr;
 	}
 
 	std::any SelectAskQueryVisitor::visitWhereClause(SparqlParser::WhereClauseContext *ctx) {
+		// the FILTERs and VALUES blocks of the top-level group apply to all solutions of the query
+		if (auto sub_ctx = ctx->groupGraphPattern()->groupGraphPatternSub(); sub_ctx) {
+			top_level_pattern = sub_ctx;
+			for (auto list_ctx : sub_ctx->groupGraphPatternSubList()) {
+				if (auto graph_pattern_not_triples_ctx = list_ctx->graphPatternNotTriples(); graph_pattern_not_triples_ctx) {
+					if (auto filter_ctx = graph_pattern_not_triples_ctx->filter(); filter_ctx)
+						add_filter(filter_ctx->constraint());
+					else if (auto inline_data_ctx = graph_pattern_not_triples_ctx->inlineData(); inline_data_ctx)
+						query->values_.push_back(read_values_block(source_text(inline_data_ctx), query->prefixes_));
+				}
+			}
+		}
 		// push a new entry into the stacks, as we are about to visit a graph pattern
 		group_patterns.emplace_back();
 		triples_blocks.emplace_back();
 		optional_blocks.emplace_back();
 		visitGroupGraphPattern(ctx->groupGraphPattern());
+		add_table_operands();
 		// pop the top entry of the stacks, as we have finished visiting the graph pattern
 		optional_blocks.pop_back();
 		triples_blocks.pop_back();
@@ -103,6 +172,11 @@ namespace dice::sparql2tensor::parser::visitors {
 				// store all OptionalGraphPatterns that appear in the pattern
 				else if (auto optional_graph_pattern_ctx = sub_ctx->graphPatternNotTriples()->optionalGraphPattern(); optional_graph_pattern_ctx)
 					optional_blocks.back().push_back(optional_graph_pattern_ctx);
+				// the FILTERs of the top-level group were read by visitWhereClause
+				else if (graph_pattern_not_triples_ctx->filter() and ctx != top_level_pattern)
+					throw std::runtime_error("FILTER is only supported in the top-level group graph pattern yet.");
+				else if (graph_pattern_not_triples_ctx->inlineData() and ctx != top_level_pattern)
+					throw std::runtime_error("VALUES is only supported in the top-level group graph pattern yet.");
 			}
 			// store all triples blocks that appear in the pattern
 			if (auto triples_block_ctx = sub_ctx->triplesBlock(); triples_block_ctx)
@@ -110,6 +184,9 @@ namespace dice::sparql2tensor::parser::visitors {
 		}
 		// the current pattern does not contain any GroupOrUnionGraphPatterns
 		if (gou_ctxs.empty()) {
+			// a branch of a top-level UNION; its operands are the ones added from here on
+			bool const root_union_branch = root_union and opt_operands.empty();
+			auto const branch_begin = query->triple_patterns_.size();
 			// visit all triples blocks first
 			for (auto tb_ctx : triples_blocks.back()) {
 				visitTriplesBlock(tb_ctx);
@@ -152,12 +229,19 @@ namespace dice::sparql2tensor::parser::visitors {
 			}
 			union_operands.pop_back();
 			opt_operands.pop_back();
+			if (root_union_branch) {
+				auto &branch = query->union_branches_.emplace_back();
+				for (auto operand = branch_begin; operand < query->triple_patterns_.size(); ++operand)
+					branch.push_back(static_cast<uint8_t>(operand));
+			}
 			// prepare for the next union
 			group_patterns.back().clear();
 		}
 		// the pattern contains at least one GroupOrUnionGraphPattern
 		// in case of multiple GroupOrUnionGraphPatterns, join operations are distributed over unions
 		else {
+			if (opt_operands.empty())
+				root_union = true;
 			SparqlParser::GroupOrUnionGraphPatternContext *cur_gou_ctx = gou_ctxs.back();
 			gou_ctxs.pop_back();
 			size_t current_tbs = triples_blocks.back().size();
@@ -193,11 +277,12 @@ namespace dice::sparql2tensor::parser::visitors {
 
 	std::any SelectAskQueryVisitor::visitPropertyListPathNotEmpty(SparqlParser::PropertyListPathNotEmptyContext *ctx) {
 		if (ctx->verbPath()) {
-			active_predicate = std::any_cast<rdf4cpp::rdf::Node>(visitPath(ctx->verbPath()->path()));
+			set_active_path(std::any_cast<PropertyPath>(visitPath(ctx->verbPath()->path())));
 		} else {
-			auto var = std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(ctx->verbSimple()->var()));
-			register_var(var);
-			active_predicate = rdf4cpp::rdf::Node(var);
+			active_path.reset();
+			active_predicate = substitute_fixed(std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(ctx->verbSimple()->var())));
+			if (active_predicate.is_variable())
+				register_var(active_predicate.as_variable());
 		}
 		auto object_list_path_ctx = ctx->objectListPath();
 		if (not object_list_path_ctx)
@@ -205,11 +290,12 @@ namespace dice::sparql2tensor::parser::visitors {
 		visitObjectListPath(object_list_path_ctx);
 		for (auto prop_ctx : ctx->propertyListPathNotEmptyList()) {
 			if (auto verb_path_ctx = prop_ctx->verbPath(); verb_path_ctx) {
-				active_predicate = std::any_cast<rdf4cpp::rdf::Node>(visitPath(verb_path_ctx->path()));
+				set_active_path(std::any_cast<PropertyPath>(visitPath(verb_path_ctx->path())));
 			} else {
-				auto var = std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(prop_ctx->verbSimple()->var()));
-				register_var(var);
-				active_predicate = rdf4cpp::rdf::Node(var);
+				active_path.reset();
+				active_predicate = substitute_fixed(std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(prop_ctx->verbSimple()->var())));
+				if (active_predicate.is_variable())
+					register_var(active_predicate.as_variable());
 			}
 			auto object_list_ctx = prop_ctx->objectList();
 			if (not object_list_ctx)
@@ -222,7 +308,7 @@ namespace dice::sparql2tensor::parser::visitors {
 	std::any SelectAskQueryVisitor::visitVarOrTerm(SparqlParser::VarOrTermContext *ctx) {
 		return rdf4cpp::rdf::Node([&]() -> rdf4cpp::rdf::Node {
 			if (ctx->var()) {
-				return std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(ctx->var()));
+				return substitute_fixed(std::any_cast<rdf4cpp::rdf::query::Variable>(visitVar(ctx->var())));
 			} else {
 				if (auto iri_ctx = ctx->graphTerm()->iri())
 					return std::any_cast<rdf4cpp::rdf::IRI>(visitIri(iri_ctx));
@@ -283,8 +369,7 @@ namespace dice::sparql2tensor::parser::visitors {
 			auto obj = std::any_cast<rdf4cpp::rdf::Node>(visitVarOrTerm(var_or_term_ctx));
 			if (obj.is_variable())
 				register_var(obj.as_variable());
-			query->triple_patterns_.emplace_back(active_subject, active_predicate, obj);
-			add_tp(query->triple_patterns_.back());
+			add_pattern(obj);
 		} else {
 			throw std::runtime_error("not supported");
 		}
@@ -296,8 +381,7 @@ namespace dice::sparql2tensor::parser::visitors {
 			auto obj = std::any_cast<rdf4cpp::rdf::Node>(visitVarOrTerm(var_or_term_ctx));
 			if (obj.is_variable())
 				register_var(obj.as_variable());
-			query->triple_patterns_.emplace_back(active_subject, active_predicate, obj);
-			add_tp(query->triple_patterns_.back());
+			add_pattern(obj);
 		} else {
 			throw std::runtime_error("not supported");
 		}
@@ -312,33 +396,53 @@ namespace dice::sparql2tensor::parser::visitors {
 	}
 
 	std::any SelectAskQueryVisitor::visitPathAlternative(SparqlParser::PathAlternativeContext *ctx) {
-		if (ctx->pathSequence().size() > 1)
-			throw std::runtime_error("Property paths are not supported yet");
-		return visitPathSequence(ctx->pathSequence(0));
+		auto const sequences = ctx->pathSequence();
+		if (sequences.size() == 1)
+			return visitPathSequence(sequences.front());
+		PropertyPath alternative{.kind = PropertyPath::Kind::Alternative};
+		for (auto sequence_ctx : sequences)
+			alternative.operands.push_back(std::any_cast<PropertyPath>(visitPathSequence(sequence_ctx)));
+		return alternative;
 	}
 
 	std::any SelectAskQueryVisitor::visitPathSequence(SparqlParser::PathSequenceContext *ctx) {
-		if (ctx->pathEltOrInverse().size() > 1)
-			throw std::runtime_error("Property paths are not supported yet");
-		return visitPathEltOrInverse(ctx->pathEltOrInverse(0));
+		auto const elements = ctx->pathEltOrInverse();
+		if (elements.size() == 1)
+			return visitPathEltOrInverse(elements.front());
+		PropertyPath sequence{.kind = PropertyPath::Kind::Sequence};
+		for (auto element_ctx : elements)
+			sequence.operands.push_back(std::any_cast<PropertyPath>(visitPathEltOrInverse(element_ctx)));
+		return sequence;
 	}
 
 	std::any SelectAskQueryVisitor::visitPathEltOrInverse(SparqlParser::PathEltOrInverseContext *ctx) {
-		if (ctx->INVERSE())
-			throw std::runtime_error("Property paths are not supported yet");
-		return visitPathElt(ctx->pathElt());
+		auto path = std::any_cast<PropertyPath>(visitPathElt(ctx->pathElt()));
+		if (not ctx->INVERSE())
+			return path;
+		if (path.kind == PropertyPath::Kind::Inverse)// ^^p is p
+			return std::move(path.operands.front());
+		return PropertyPath{.kind = PropertyPath::Kind::Inverse, .operands = {std::move(path)}};
 	}
 
 	std::any SelectAskQueryVisitor::visitPathElt(SparqlParser::PathEltContext *ctx) {
 		auto path_primary_ctx = ctx->pathPrimary();
+		PropertyPath path;
 		if (auto iri_ctx = path_primary_ctx->iri(); iri_ctx)
-			return rdf4cpp::rdf::Node(std::any_cast<rdf4cpp::rdf::IRI>(visitIri(iri_ctx)));
+			path.iri = std::any_cast<rdf4cpp::rdf::IRI>(visitIri(iri_ctx));
 		else if (path_primary_ctx->A())
-			return rdf4cpp::rdf::Node(rdf4cpp::rdf::IRI("http://www.w3.org/1999/02/22-rdf-syntax-ns#type"));
+			path.iri = rdf4cpp::rdf::IRI("http://www.w3.org/1999/02/22-rdf-syntax-ns#type");
 		else if (path_primary_ctx->NEGATION())
-			throw std::runtime_error("Property paths are not supported yet");
+			throw std::runtime_error("Negated property sets are not supported yet");
 		else
-			return visitPath(ctx->pathPrimary()->path());
+			path = std::any_cast<PropertyPath>(visitPath(path_primary_ctx->path()));
+		auto path_mod_ctx = ctx->pathMod();
+		if (not path_mod_ctx)
+			return path;
+		auto const modifier = path_mod_ctx->getText();
+		auto const kind = (modifier == "*") ? PropertyPath::Kind::ZeroOrMore
+					   : (modifier == "+") ? PropertyPath::Kind::OneOrMore
+										   : PropertyPath::Kind::ZeroOrOne;
+		return PropertyPath{.kind = kind, .operands = {std::move(path)}};
 	}
 
 	std::any SelectAskQueryVisitor::visitRdfLiteral(SparqlParser::RdfLiteralContext *ctx) {
@@ -400,6 +504,59 @@ namespace dice::sparql2tensor::parser::visitors {
 		var_id++;
 	}
 
+	rdf4cpp::rdf::Node SelectAskQueryVisitor::substitute_fixed(rdf4cpp::rdf::query::Variable const &var) const {
+		if (auto fixed = query->fixed_variables_.find(var); fixed != query->fixed_variables_.end())
+			return fixed->second;
+		return var;
+	}
+
+	void SelectAskQueryVisitor::add_filter(SparqlParser::ConstraintContext *ctx) {
+		for (auto &conjunct : split_conjunction(read_filter_expression(source_text(ctx), query->prefixes_)))
+			query->filters_.push_back(std::move(conjunct));
+	}
+
+	void SelectAskQueryVisitor::set_active_path(PropertyPath path) {
+		if (path.kind == PropertyPath::Kind::Link) {
+			active_predicate = std::move(path.iri);
+			active_path.reset();
+		} else {
+			active_path = std::move(path);
+		}
+	}
+
+	void SelectAskQueryVisitor::add_pattern(rdf4cpp::rdf::Node const &object) {
+		if (not active_path) {
+			query->triple_patterns_.emplace_back(active_subject, active_predicate, object);
+			add_tp(query->triple_patterns_.back());
+			return;
+		}
+		// the operands of property paths are added to the top-level group once all triple patterns are known
+		if (not opt_operands.empty() or root_union)
+			throw std::runtime_error("Property paths are only supported outside of OPTIONAL and UNION yet.");
+		query->path_patterns_.push_back(PathPattern{.subject = active_subject, .path = *active_path, .object = object});
+	}
+
+	void SelectAskQueryVisitor::add_table_operands() {
+		if (query->values_.empty() and query->path_patterns_.empty())
+			return;
+		if (root_union or query->mandatory_operands_.size() != query->triple_patterns_.size())
+			throw std::runtime_error("VALUES and property paths are only supported in queries without OPTIONAL and UNION yet.");
+		// each table is an operand of the top-level group, after the operands of the triple patterns
+		auto group = query->mandatory_operands_;
+		auto const add_operand = [&](std::vector<rdf4cpp::rdf::query::Variable> const &variables) {
+			std::vector<char> var_ids;
+			for (auto const &var : variables) {
+				register_var(var);
+				var_ids.push_back(query->var_to_id_[var]);
+			}
+			add_group_operand(query->odg_, group, var_ids);
+		};
+		for (auto const &values : query->values_)
+			add_operand(values.variables);
+		for (auto const &path_pattern : query->path_patterns_)
+			add_operand(path_pattern.variables());
+	}
+
 	void SelectAskQueryVisitor::add_tp(rdf4cpp::rdf::query::TriplePattern const &tp) {
 		std::vector<char> var_ids{};
 		for (auto const &node : tp) {
@@ -407,34 +564,10 @@ namespace dice::sparql2tensor::parser::visitors {
 				continue;
 			var_ids.push_back(query->var_to_id_[node.as_variable()]);
 		}
-		// create new node in the operand dependency graph
-		auto v_id = query->odg_.add_operand(var_ids);
-		auto &gp = group_patterns.back();
-		// iterate over the tps of the group and capture dependencies
-		for (auto iter = gp.rbegin(); iter != gp.rend(); iter++) {
-			boost::container::flat_set<char> done{};// only one edge per label between two nodes
-			auto const &tp_vars = query->odg_.operand_var_ids(*iter);
-			bool cart = true;
-			for (auto const &var : var_ids) {
-				for (auto const &tp_var : tp_vars) {
-					if (var == tp_var) {
-						cart = false;
-						if (done.contains(var))
-							continue;
-						done.insert(var);
-						query->odg_.add_dependency(*iter, v_id, var);
-						query->odg_.add_dependency(v_id, *iter, var);
-					}
-				}
-			}
-			// the triple patterns do not share a variable --> cartesian join
-			if (cart) {
-				query->odg_.add_dependency(*iter, v_id);
-				query->odg_.add_dependency(v_id, *iter);
-			}
-		}
-		// add current tp/node to the active group pattern
-		gp.push_back(v_id);
+		auto v_id = add_group_operand(query->odg_, group_patterns.back(), var_ids);
+		// operands of the top-level group pattern must match for every solution
+		if (opt_operands.empty() and not root_union)
+			query->mandatory_operands_.push_back(v_id);
 	}
 
 	void SelectAskQueryVisitor::group_dependencies(std::vector<uint8_t> const &prev_group,
@@ -0,0 +1,265 @@
+#include "DatasetStatistics.hpp"
+
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace dice::triple_store {
+
+	namespace {
+		using NodeWrapper = rdf_tensor::NodeWrapper;
+
+		template<typename V>
+		using NodeMap = robin_hood::unordered_flat_map<NodeWrapper, V, dice::hash::DiceHashMartinus<NodeWrapper>>;
+
+		// the finalizer of splitmix64; it is deterministic, so hashes stay valid when the statistics are reopened
+		uint64_t mix(uint64_t x) noexcept {
+			x ^= x >> 30;
+			x *= 0xbf58476d1ce4e5b9ULL;
+			x ^= x >> 27;
+			x *= 0x94d049bb133111ebULL;
+			x ^= x >> 31;
+			return x;
+		}
+
+		/**
+		 * @param predicate the position of a predicate
+		 * @return the contribution of the predicate to the signature of a characteristic set, which is the sum over its predicates
+		 */
+		uint64_t signature_of(size_t predicate) noexcept {
+			return mix(predicate + 1);
+		}
+
+		void count_terms(rdf_tensor::const_BoolHypertrie const &predicate_slice, size_t position, NodeMap<uint64_t> &counts) {
+			counts.clear();
+			for (auto const &key : predicate_slice)
+				++counts[key[position]];
+		}
+	}// namespace
+
+	DatasetStatistics::DatasetStatistics(rdf_tensor::metall_manager::allocator_type<std::byte> const &allocator)
+		: predicates_(allocator),
+		  heavy_hitters_(allocator),
+		  characteristic_sets_(allocator),
+		  characteristic_set_predicates_(allocator),
+		  predicate_characteristic_sets_(allocator),
+		  slots_(allocator) {}
+
+	uint64_t DatasetStatistics::slot_hash(rdf_tensor::NodeWrapper const &node) noexcept {
+		return mix(node.backend_handle().raw());
+	}
+
+	void DatasetStatistics::build(rdf_tensor::BoolHypertrie const &hypertrie, uint64_t load_id, size_t top_k, size_t max_characteristic_sets) {
+		built_ = false;
+		load_id_ = load_id;
+		predicates_.clear();
+		heavy_hitters_.clear();
+		characteristic_sets_.clear();
+		characteristic_set_predicates_.clear();
+		predicate_characteristic_sets_.clear();
+		slots_.clear();
+
+		triples_ = hypertrie.size();
+		auto const cards = hypertrie.get_cards({0, 2});
+		distinct_subjects_ = cards[0];
+		distinct_objects_ = cards[1];
+
+		std::vector<NodeWrapper> predicates;
+		{
+			robin_hood::unordered_flat_set<NodeWrapper, dice::hash::DiceHashMartinus<NodeWrapper>> predicate_set;
+			for (auto const &key : hypertrie)
+				predicate_set.insert(key[1]);
+			predicates.assign(predicate_set.begin(), predicate_set.end());
+		}
+		std::ranges::sort(predicates);
+		auto const predicate_slice = [&](size_t predicate) {
+			return std::get<rdf_tensor::const_BoolHypertrie>(hypertrie[rdf_tensor::SliceKey{std::nullopt, predicates[predicate], std::nullopt}]);
+		};
+
+		// per predicate: the counts, the heavy hitters and the contribution to the characteristic set of each subject
+		NodeMap<uint64_t> signatures;
+		NodeMap<uint64_t> counts;
+		std::vector<HeavyHitter> hitters;
+		auto const append_heavy_hitters = [&]() {
+			hitters.clear();
+			for (auto const &[node, triples] : counts)
+				hitters.push_back(HeavyHitter{node, triples});
+			auto const k = std::min(top_k, hitters.size());
+			std::ranges::partial_sort(hitters, hitters.begin() + k, [](HeavyHitter const &lhs, HeavyHitter const &rhs) {
+				return (lhs.triples != rhs.triples) ? lhs.triples > rhs.triples : lhs.node < rhs.node;
+			});
+			heavy_hitters_.insert(heavy_hitters_.end(), hitters.begin(), hitters.begin() + k);
+		};
+		predicates_.reserve(predicates.size());
+		for (size_t predicate = 0; predicate < predicates.size(); ++predicate) {
+			auto const slice = predicate_slice(predicate);
+			PredicateStatistics statistics{.predicate = predicates[predicate], .triples = slice.size()};
+
+			count_terms(slice, 1, counts);
+			statistics.distinct_objects = counts.size();
+			statistics.object_hitters_begin = heavy_hitters_.size();
+			append_heavy_hitters();
+			statistics.object_hitters_end = heavy_hitters_.size();
+
+			count_terms(slice, 0, counts);
+			statistics.distinct_subjects = counts.size();
+			statistics.subject_hitters_begin = heavy_hitters_.size();
+			append_heavy_hitters();
+			statistics.subject_hitters_end = heavy_hitters_.size();
+			for (auto const &[subject, triples] : counts)
+				signatures[subject] += signature_of(predicate);
+
+			predicates_.push_back(statistics);
+		}
+
+		// keep the characteristic sets with the most subjects
+		robin_hood::unordered_flat_map<uint64_t, uint64_t> subjects_per_set;
+		for (auto const &[subject, signature] : signatures)
+			++subjects_per_set[signature];
+		total_characteristic_sets_ = subjects_per_set.size();
+		std::vector<std::pair<uint64_t, uint64_t>> sets(subjects_per_set.begin(), subjects_per_set.end());
+		subjects_per_set.clear();
+		auto const kept_sets = std::min(max_characteristic_sets, sets.size());
+		std::ranges::partial_sort(sets, sets.begin() + kept_sets, [](auto const &lhs, auto const &rhs) {
+			return (lhs.second != rhs.second) ? lhs.second > rhs.second : lhs.first < rhs.first;
+		});
+		sets.resize(kept_sets);
+		robin_hood::unordered_flat_map<uint64_t, size_t> set_positions;
+		for (size_t position = 0; position < sets.size(); ++position)
+			set_positions[sets[position].first] = position;
+
+		// the predicates of the kept sets with their triples; predicates are visited in ascending order, so each list stays sorted
+		std::vector<std::vector<CharacteristicSetPredicate>> set_predicates(sets.size());
+		for (size_t predicate = 0; predicate < predicates.size() and not set_positions.empty(); ++predicate) {
+			count_terms(predicate_slice(predicate), 0, counts);
+			for (auto const &[subject, triples] : counts) {
+				auto const set = set_positions.find(signatures.find(subject)->second);
+				if (set == set_positions.end())
+					continue;
+				auto &set_predicate = set_predicates[set->second];
+				if (set_predicate.empty() or set_predicate.back().predicate != predicate)
+					set_predicate.push_back(CharacteristicSetPredicate{.predicate = predicate, .triples = 0});
+				set_predicate.back().triples += triples;
+			}
+		}
+		characteristic_sets_.reserve(sets.size());
+		std::vector<std::vector<uint64_t>> sets_of_predicate(predicates.size());
+		for (size_t position = 0; position < sets.size(); ++position) {
+			auto const begin = characteristic_set_predicates_.size();
+			characteristic_set_predicates_.insert(characteristic_set_predicates_.end(), set_predicates[position].begin(), set_predicates[position].end());
+			characteristic_sets_.push_back(CharacteristicSet{.subjects = sets[position].second,
+															  .predicates_begin = begin,
+															  .predicates_end = characteristic_set_predicates_.size()});
+			for (auto const &set_predicate : set_predicates[position])
+				sets_of_predicate[set_predicate.predicate].push_back(position);
+		}
+		for (size_t predicate = 0; predicate < predicates.size(); ++predicate) {
+			predicates_[predicate].characteristic_sets_begin = predicate_characteristic_sets_.size();
+			predicate_characteristic_sets_.insert(predicate_characteristic_sets_.end(), sets_of_predicate[predicate].begin(), sets_of_predicate[predicate].end());
+			predicates_[predicate].characteristic_sets_end = predicate_characteristic_sets_.size();
+		}
+
+		if (not predicates_.empty()) {
+			slots_.assign(std::bit_ceil(2 * predicates_.size()), empty_slot);
+			auto const mask = slots_.size() - 1;
+			for (size_t position = 0; position < predicates_.size(); ++position) {
+				auto slot = slot_hash(predicates_[position].predicate) & mask;
+				while (slots_[slot] != empty_slot)
+					slot = (slot + 1) & mask;
+				slots_[slot] = position;
+			}
+		}
+		built_ = true;
+	}
+
+	DatasetStatistics::PredicateStatistics const *DatasetStatistics::find(rdf_tensor::NodeWrapper const &predicate) const noexcept {
+		if (slots_.empty())
+			return nullptr;
+		auto const mask = slots_.size() - 1;
+		// at most half of the slots are used, so the probing ends at an empty slot
+		for (auto slot = slot_hash(predicate) & mask;; slot = (slot + 1) & mask) {
+			auto const position = slots_[slot];
+			if (position == empty_slot)
+				return nullptr;
+			if (predicates_[position].predicate == predicate)
+				return &predicates_[position];
+		}
+	}
+
+	double DatasetStatistics::estimate_bound(PredicateStatistics const &statistics, std::span<HeavyHitter const> hitters,
+											 uint64_t distinct, rdf_tensor::NodeWrapper const &term) noexcept {
+		uint64_t hitter_triples = 0;
+		for (auto const &hitter : hitters) {
+			if (hitter.node == term)
+				return static_cast<double>(hitter.triples);
+			hitter_triples += hitter.triples;
+		}
+		auto const others = distinct - hitters.size();
+		if (others == 0)
+			return 0;
+		return static_cast<double>(statistics.triples - hitter_triples) / static_cast<double>(others);
+	}
+
+	double DatasetStatistics::estimate_matches(rdf_tensor::SliceKey const &slice_key) const noexcept {
+		auto const &subject = slice_key[0];
+		auto const &predicate = slice_key[1];
+		auto const &object = slice_key[2];
+		if (not predicate) {
+			auto matches = static_cast<double>(triples_);
+			if (subject)
+				matches /= static_cast<double>(std::max<uint64_t>(distinct_subjects_, 1));
+			if (object)
+				matches /= static_cast<double>(std::max<uint64_t>(distinct_objects_, 1));
+			return matches;
+		}
+		auto const *statistics = find(*predicate);
+		if (statistics == nullptr)
+			return 0;
+		if (not subject and not object)
+			return static_cast<double>(statistics->triples);
+		if (not object)
+			return estimate_bound(*statistics, subject_hitters(*statistics), statistics->distinct_subjects, *subject);
+		if (not subject)
+			return estimate_bound(*statistics, object_hitters(*statistics), statistics->distinct_objects, *object);
+		// subject and object are assumed to be independent
+		auto const subject_matches = estimate_bound(*statistics, subject_hitters(*statistics), statistics->distinct_subjects, *subject);
+		auto const object_matches = estimate_bound(*statistics, object_hitters(*statistics), statistics->distinct_objects, *object);
+		return std::min(1.0, subject_matches * object_matches / static_cast<double>(statistics->triples));
+	}
+
+	double DatasetStatistics::estimate_star(std::span<rdf_tensor::NodeWrapper const> predicates) const {
+		std::vector<uint64_t> positions;
+		positions.reserve(predicates.size());
+		// a set that contains all predicates of the star is among the sets of each of them, so the shortest list suffices
+		std::span<uint64_t const> candidates;
+		for (auto const &predicate : predicates) {
+			auto const *statistics = find(predicate);
+			if (statistics == nullptr)
+				return 0;
+			positions.push_back(static_cast<uint64_t>(statistics - predicates_.data()));
+			auto const sets = characteristic_sets(*statistics);
+			if (positions.size() == 1 or sets.size() < candidates.size())
+				candidates = sets;
+		}
+		double estimate = 0;
+		for (auto const set_position : candidates) {
+			auto const &characteristic_set = characteristic_sets_[set_position];
+			auto const set_predicates = this->predicates(characteristic_set);
+			auto const subjects = static_cast<double>(characteristic_set.subjects);
+			// each subject of the set has on average triples / subjects objects per predicate
+			double solutions = subjects;
+			for (auto const position : positions) {
+				auto const found = std::ranges::lower_bound(set_predicates, position, {}, &CharacteristicSetPredicate::predicate);
+				if (found == set_predicates.end() or found->predicate != position) {
+					solutions = 0;
+					break;
+				}
+				solutions *= static_cast<double>(found->triples) / subjects;
+			}
+			estimate += solutions;
+		}
+		return estimate;
+	}
+
+}// namespace dice::triple_store
@@ -0,0 +1,189 @@
+#ifndef TENTRIS_STORE_DATASETSTATISTICS
+#define TENTRIS_STORE_DATASETSTATISTICS
+
+#include <dice/rdf-tensor/RDFTensor.hpp>
+
+#include <boost/container/vector.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace dice::triple_store {
+
+	/**
+	 * Statistics of the dataset that are computed once after loading and stored in the metall segment next to the RDF tensor.
+	 * Per predicate, they hold the number of triples, the numbers of distinct subjects and objects and the subjects and objects with
+	 * the most triples (heavy hitters). For subject stars, they hold the most frequent characteristic sets, i.e., the sets of
+	 * predicates that subjects have, with the number of subjects and the number of triples per predicate, and per predicate the
+	 * characteristic sets that contain it.
+	 * Looking up the statistics of a predicate costs O(1). The statistics are read-only once they are built.
+	 */
+	class DatasetStatistics {
+		template<typename T>
+		using persistent_vector = boost::container::vector<T, rdf_tensor::metall_manager::allocator_type<T>>;
+
+	public:
+		static constexpr size_t default_top_k = 16;
+		static constexpr size_t default_max_characteristic_sets = 10'000;
+
+		struct HeavyHitter {
+			rdf_tensor::NodeWrapper node;
+			uint64_t triples;
+		};
+
+		struct PredicateStatistics {
+			rdf_tensor::NodeWrapper predicate;
+			uint64_t triples = 0;
+			uint64_t distinct_subjects = 0;
+			uint64_t distinct_objects = 0;
+			// ranges of the heavy hitters in descending order of triples
+			uint64_t subject_hitters_begin = 0;
+			uint64_t subject_hitters_end = 0;
+			uint64_t object_hitters_begin = 0;
+			uint64_t object_hitters_end = 0;
+			// range of the positions of the characteristic sets that contain the predicate, in ascending order
+			uint64_t characteristic_sets_begin = 0;
+			uint64_t characteristic_sets_end = 0;
+		};
+
+		struct CharacteristicSetPredicate {
+			// the position of the predicate in predicates()
+			uint64_t predicate;
+			// the number of triples with the predicate whose subject has the characteristic set
+			uint64_t triples;
+		};
+
+		struct CharacteristicSet {
+			uint64_t subjects;
+			// range of the predicates, in ascending order of position
+			uint64_t predicates_begin;
+			uint64_t predicates_end;
+		};
+
+	private:
+		static constexpr uint64_t empty_slot = ~uint64_t(0);
+
+		bool built_ = false;
+		// identifies the load of the data that the statistics were built for
+		uint64_t load_id_ = 0;
+		uint64_t triples_ = 0;
+		uint64_t distinct_subjects_ = 0;
+		uint64_t distinct_objects_ = 0;
+		// the number of characteristic sets in the dataset, including those that are not stored
+		uint64_t total_characteristic_sets_ = 0;
+		persistent_vector<PredicateStatistics> predicates_;
+		persistent_vector<HeavyHitter> heavy_hitters_;
+		persistent_vector<CharacteristicSet> characteristic_sets_;
+		persistent_vector<CharacteristicSetPredicate> characteristic_set_predicates_;
+		// the positions of the characteristic sets in characteristic_sets_, grouped by predicate
+		persistent_vector<uint64_t> predicate_characteristic_sets_;
+		// open addressing hash table with linear probing from predicates to their position in predicates_; its size is a power of two
+		persistent_vector<uint64_t> slots_;
+
+		[[nodiscard]] static uint64_t slot_hash(rdf_tensor::NodeWrapper const &node) noexcept;
+
+		/**
+		 * Estimates the number of triples with the predicate that a bound subject or object has.
+		 * @param hitters the heavy hitters of the position of the bound term
+		 * @param distinct the number of distinct terms at the position
+		 */
+		[[nodiscard]] static double estimate_bound(PredicateStatistics const &statistics, std::span<HeavyHitter const> hitters,
+												   uint64_t distinct, rdf_tensor::NodeWrapper const &term) noexcept;
+
+	public:
+		explicit DatasetStatistics(rdf_tensor::metall_manager::allocator_type<std::byte> const &allocator);
+
+		/**
+		 * Computes the statistics of hypertrie and replaces the previous ones.
+		 * @param hypertrie the RDF tensor
+		 * @param load_id identifies the load of the data in hypertrie; see load_id()
+		 * @param top_k the number of heavy hitters that are stored per predicate for subjects and for objects each
+		 * @param max_characteristic_sets the number of characteristic sets that are stored; the ones with the most subjects are kept
+		 */
+		void build(rdf_tensor::BoolHypertrie const &hypertrie,
+				   uint64_t load_id,
+				   size_t top_k = default_top_k,
+				   size_t max_characteristic_sets = default_max_characteristic_sets);
+
+		/**
+		 * @return false if build was never called
+		 */
+		[[nodiscard]] bool built() const noexcept { return built_; }
+
+		/**
+		 * The statistics are outdated if data was loaded since they were built, even if the number of triples did not change.
+		 * @return the load id that was passed to build
+		 */
+		[[nodiscard]] uint64_t load_id() const noexcept { return load_id_; }
+
+		[[nodiscard]] uint64_t triples() const noexcept { return triples_; }
+
+		[[nodiscard]] uint64_t distinct_subjects() const noexcept { return distinct_subjects_; }
+
+		[[nodiscard]] uint64_t distinct_predicates() const noexcept { return predicates_.size(); }
+
+		[[nodiscard]] uint64_t distinct_objects() const noexcept { return distinct_objects_; }
+
+		[[nodiscard]] uint64_t total_characteristic_sets() const noexcept { return total_characteristic_sets_; }
+
+		[[nodiscard]] std::span<PredicateStatistics const> predicates() const noexcept {
+			return {predicates_.data(), predicates_.size()};
+		}
+
+		/**
+		 * @param predicate a predicate
+		 * @return the statistics of predicate; nullptr if no triple has the predicate
+		 */
+		[[nodiscard]] PredicateStatistics const *find(rdf_tensor::NodeWrapper const &predicate) const noexcept;
+
+		[[nodiscard]] std::span<HeavyHitter const> subject_hitters(PredicateStatistics const &statistics) const noexcept {
+			return {heavy_hitters_.data() + statistics.subject_hitters_begin, heavy_hitters_.data() + statistics.subject_hitters_end};
+		}
+
+		[[nodiscard]] std::span<HeavyHitter const> object_hitters(PredicateStatistics const &statistics) const noexcept {
+			return {heavy_hitters_.data() + statistics.object_hitters_begin, heavy_hitters_.data() + statistics.object_hitters_end};
+		}
+
+		/**
+		 * @return the stored characteristic sets in descending order of subjects
+		 */
+		[[nodiscard]] std::span<CharacteristicSet const> characteristic_sets() const noexcept {
+			return {characteristic_sets_.data(), characteristic_sets_.size()};
+		}
+
+		[[nodiscard]] std::span<CharacteristicSetPredicate const> predicates(CharacteristicSet const &characteristic_set) const noexcept {
+			return {characteristic_set_predicates_.data() + characteristic_set.predicates_begin,
+					characteristic_set_predicates_.data() + characteristic_set.predicates_end};
+		}
+
+		/**
+		 * @return the positions in characteristic_sets() of the stored characteristic sets that contain the predicate, in ascending order
+		 */
+		[[nodiscard]] std::span<uint64_t const> characteristic_sets(PredicateStatistics const &statistics) const noexcept {
+			return {predicate_characteristic_sets_.data() + statistics.characteristic_sets_begin,
+					predicate_characteristic_sets_.data() + statistics.characteristic_sets_end};
+		}
+
+		/**
+		 * Estimates the number of matches of a triple pattern in O(1) for a bound predicate. A bound subject or object that is a heavy
+		 * hitter of the predicate is counted exactly; other terms are assumed to share the remaining triples evenly.
+		 * @param slice_key the slice key of a triple pattern
+		 * @return the estimated number of matches
+		 */
+		[[nodiscard]] double estimate_matches(rdf_tensor::SliceKey const &slice_key) const noexcept;
+
+		/**
+		 * Estimates the number of solutions of a subject star, i.e., of triple patterns that share the subject variable and whose
+		 * objects are distinct variables, from the characteristic sets that contain all predicates of the star.
+		 * Only the characteristic sets of the predicate of the star that is in the fewest sets are visited.
+		 * The estimate is a lower bound if not all characteristic sets are stored.
+		 * @param predicates the predicates of the star; at least one
+		 * @return the estimated number of solutions
+		 */
+		[[nodiscard]] double estimate_star(std::span<rdf_tensor::NodeWrapper const> predicates) const;
+	};
+
+}// namespace dice::triple_store
+
+#endif//TENTRIS_STORE_DATASETSTATISTICS
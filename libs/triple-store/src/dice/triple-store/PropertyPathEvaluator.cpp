@@ -0,0 +1,163 @@
+#include "PropertyPathEvaluator.hpp"
+
+#include <stdexcept>
+
+namespace dice::triple_store {
+
+	namespace {
+		// a lookup of one frontier node costs about as much as scanning this many triples of a predicate
+		constexpr size_t scan_ratio = 8;
+		// scans of the hypertrie check the timeout once per this many entries
+		constexpr size_t timeout_check_interval = 65'536;
+	}// namespace
+
+	void PropertyPathEvaluator::check_timeout() const {
+		if (endtime_ <= std::chrono::steady_clock::now())
+			throw std::runtime_error{"timeout reached"};
+	}
+
+	void PropertyPathEvaluator::step(rdf4cpp::rdf::IRI const &predicate, NodeSet const &frontier, bool backward, NodeSet &reached) const {
+		if (frontier.empty())
+			return;
+		auto const from = (backward) ? 1 : 0;
+		auto const predicate_slice = std::get<rdf_tensor::const_BoolHypertrie>(hypertrie_[rdf_tensor::SliceKey{std::nullopt, predicate, std::nullopt}]);
+		if (frontier.size() * scan_ratio >= predicate_slice.size()) {
+			size_t scanned = 0;
+			for (auto const &key : predicate_slice) {
+				if (++scanned % timeout_check_interval == 0)
+					check_timeout();
+				if (frontier.count(key[from]) != 0)
+					reached.insert(key[1 - from]);
+			}
+			return;
+		}
+		for (auto const &node : frontier) {
+			auto const slice_key = (backward) ? rdf_tensor::SliceKey{std::nullopt, predicate, node} : rdf_tensor::SliceKey{node, predicate, std::nullopt};
+			auto const slice = std::get<rdf_tensor::const_BoolHypertrie>(hypertrie_[slice_key]);
+			for (auto const &key : slice)
+				reached.insert(key[0]);
+		}
+	}
+
+	PropertyPathEvaluator::NodeSet PropertyPathEvaluator::reach(PropertyPath const &path, NodeSet const &from, bool backward) const {
+		using Kind = PropertyPath::Kind;
+		NodeSet reached;
+		switch (path.kind) {
+			case Kind::Link:
+				step(path.iri, from, backward, reached);
+				break;
+			case Kind::Inverse:
+				return reach(path.operands.front(), from, not backward);
+			case Kind::Sequence: {
+				// followed backward, the last operand is the first step
+				reached = from;
+				for (size_t i = 0; i < path.operands.size() and not reached.empty(); ++i)
+					reached = reach(path.operands[(backward) ? path.operands.size() - 1 - i : i], reached, backward);
+				break;
+			}
+			case Kind::Alternative:
+				for (auto const &operand : path.operands) {
+					for (auto const &node : reach(operand, from, backward))
+						reached.insert(node);
+				}
+				break;
+			case Kind::ZeroOrOne:
+				reached = reach(path.operands.front(), from, backward);
+				reached.insert(from.begin(), from.end());
+				break;
+			case Kind::ZeroOrMore:
+				return closure(path.operands.front(), from, backward, true);
+			case Kind::OneOrMore:
+				return closure(path.operands.front(), from, backward, false);
+		}
+		return reached;
+	}
+
+	PropertyPathEvaluator::NodeSet PropertyPathEvaluator::closure(PropertyPath const &path, NodeSet const &from, bool backward, bool zero_length) const {
+		NodeSet reached = (zero_length) ? from : NodeSet{};
+		// every node is extended once: the frontier holds the nodes that were reached for the first time by the last step
+		NodeSet frontier = from;
+		while (not frontier.empty()) {
+			check_timeout();
+			NodeSet next;
+			for (auto const &node : reach(path, frontier, backward)) {
+				if (reached.insert(node).second)
+					next.insert(node);
+			}
+			frontier = std::move(next);
+		}
+		return reached;
+	}
+
+	void PropertyPathEvaluator::collect_starts(PropertyPath const &path, bool backward, NodeSet &starts) const {
+		using Kind = PropertyPath::Kind;
+		if (path.kind == Kind::Link) {
+			auto const from = (backward) ? 1 : 0;
+			auto const predicate_slice = std::get<rdf_tensor::const_BoolHypertrie>(hypertrie_[rdf_tensor::SliceKey{std::nullopt, path.iri, std::nullopt}]);
+			size_t scanned = 0;
+			for (auto const &key : predicate_slice) {
+				if (++scanned % timeout_check_interval == 0)
+					check_timeout();
+				starts.insert(key[from]);
+			}
+			return;
+		}
+		// every match of non-zero length starts with a step of one of the predicates
+		for (auto const &operand : path.operands)
+			collect_starts(operand, (path.kind == Kind::Inverse) ? not backward : backward, starts);
+	}
+
+	PropertyPathEvaluator::NodeSet PropertyPathEvaluator::all_nodes() const {
+		NodeSet nodes;
+		size_t scanned = 0;
+		for (auto const &key : hypertrie_) {
+			if (++scanned % timeout_check_interval == 0)
+				check_timeout();
+			nodes.insert(key[0]);
+			nodes.insert(key[2]);
+		}
+		return nodes;
+	}
+
+	bool PropertyPathEvaluator::matches(rdf4cpp::rdf::Node const &subject, PropertyPath const &path, rdf4cpp::rdf::Node const &object) const {
+		return reach(path, NodeSet{rdf_tensor::NodeWrapper(subject)}, false).count(rdf_tensor::NodeWrapper(object)) != 0;
+	}
+
+	void PropertyPathEvaluator::evaluate(sparql2tensor::PathPattern const &pattern, rdf_tensor::BoolHypertrie &table) const {
+		rdf_tensor::Key key;
+		auto const set = [&](auto const &...nodes) {
+			key.clear();
+			(key.push_back(nodes), ...);
+			table.set(key, true);
+		};
+		if (not pattern.subject.is_variable() or not pattern.object.is_variable()) {
+			// one end is fixed; the path is followed from there
+			bool const backward = pattern.subject.is_variable();
+			auto const &start = (backward) ? pattern.object : pattern.subject;
+			for (auto const &node : reach(pattern.path, NodeSet{rdf_tensor::NodeWrapper(start)}, backward))
+				set(node);
+			return;
+		}
+
+		// both ends are variables: the path is followed from each node where a match may start.
+		// With zero length, a path connects every node of the graph with itself.
+		NodeSet starts;
+		if (pattern.path.nullable())
+			starts = all_nodes();
+		else
+			collect_starts(pattern.path, false, starts);
+		bool const same_variable = pattern.subject == pattern.object;
+		for (auto const &start : starts) {
+			check_timeout();
+			auto const reached = reach(pattern.path, NodeSet{start}, false);
+			if (same_variable) {
+				if (reached.count(start) != 0)
+					set(start);
+			} else {
+				for (auto const &node : reached)
+					set(start, node);
+			}
+		}
+	}
+
+}// namespace dice::triple_store
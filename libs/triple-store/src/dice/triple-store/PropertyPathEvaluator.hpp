@@ -0,0 +1,87 @@
+#ifndef TENTRIS_STORE_PROPERTYPATHEVALUATOR
+#define TENTRIS_STORE_PROPERTYPATHEVALUATOR
+
+#include <dice/rdf-tensor/RDFTensor.hpp>
+
+#include <dice/sparql2tensor/PropertyPath.hpp>
+
+#include <robin_hood.h>
+
+#include <chrono>
+
+namespace dice::triple_store {
+
+	/**
+	 * Computes the matches of property path patterns on the RDF tensor.
+	 * Closures and sequences are computed by breadth-first search: the frontier of newly reached nodes is extended by one step at a
+	 * time until no new node is reached. Each step extends the whole frontier at once, either by one [s, p, *] or [*, p, o] slice per
+	 * frontier node or, for large frontiers, by a single scan of the [*, p, *] slice of the predicate.
+	 */
+	class PropertyPathEvaluator {
+		using NodeSet = robin_hood::unordered_flat_set<rdf_tensor::NodeWrapper, dice::hash::DiceHashMartinus<rdf_tensor::NodeWrapper>>;
+		using PropertyPath = sparql2tensor::PropertyPath;
+
+		rdf_tensor::BoolHypertrie const &hypertrie_;
+		std::chrono::steady_clock::time_point endtime_;
+
+		/**
+		 * Adds the nodes that a single predicate connects with the nodes of frontier to reached.
+		 */
+		void step(rdf4cpp::rdf::IRI const &predicate, NodeSet const &frontier, bool backward, NodeSet &reached) const;
+
+		/**
+		 * @param path a path
+		 * @param from the start nodes
+		 * @param backward if the path is followed from its object to its subject
+		 * @return the nodes that path connects with a node of from
+		 */
+		[[nodiscard]] NodeSet reach(PropertyPath const &path, NodeSet const &from, bool backward) const;
+
+		/**
+		 * @param path the repeated path
+		 * @param from the start nodes
+		 * @param backward if the path is followed from its object to its subject
+		 * @param zero_length if the start nodes are reached, too
+		 * @return the nodes that one or more repetitions of path connect with a node of from
+		 */
+		[[nodiscard]] NodeSet closure(PropertyPath const &path, NodeSet const &from, bool backward, bool zero_length) const;
+
+		/**
+		 * Adds a superset of the nodes from which a match of a path with non-zero length can start to starts.
+		 */
+		void collect_starts(PropertyPath const &path, bool backward, NodeSet &starts) const;
+
+		/**
+		 * @return the subjects and objects of all triples
+		 */
+		[[nodiscard]] NodeSet all_nodes() const;
+
+		void check_timeout() const;
+
+	public:
+		/**
+		 * @param hypertrie the RDF tensor
+		 * @param endtime the evaluation throws std::runtime_error once this point in time is passed
+		 */
+		PropertyPathEvaluator(rdf_tensor::BoolHypertrie const &hypertrie, std::chrono::steady_clock::time_point endtime) noexcept
+			: hypertrie_(hypertrie), endtime_(endtime) {}
+
+		/**
+		 * @param subject the subject of a path pattern; not a variable
+		 * @param path the path
+		 * @param object the object of the path pattern; not a variable
+		 * @return if path connects subject with object
+		 */
+		[[nodiscard]] bool matches(rdf4cpp::rdf::Node const &subject, PropertyPath const &path, rdf4cpp::rdf::Node const &object) const;
+
+		/**
+		 * Sets the matches of a path pattern with variables in table, one dimension per variable of pattern.variables().
+		 * @param pattern the path pattern
+		 * @param table an empty hypertrie of depth pattern.variables().size()
+		 */
+		void evaluate(sparql2tensor::PathPattern const &pattern, rdf_tensor::BoolHypertrie &table) const;
+	};
+
+}// namespace dice::triple_store
+
+#endif//TENTRIS_STORE_PROPERTYPATHEVALUATOR
@@ -0,0 +1,101 @@
+#include "QueryEstimate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dice::triple_store {
+
+	void OperandEstimate::add_variable(char var_id, double distinct_values) {
+		distinct_values = std::min(distinct_values, matches);
+		auto variable = std::ranges::find(distinct, var_id, &std::pair<char, double>::first);
+		if (variable == distinct.end())
+			distinct.emplace_back(var_id, distinct_values);
+		else
+			variable->second = std::min(variable->second, distinct_values);
+	}
+
+	QueryEstimate::QueryEstimate(sparql2tensor::SPARQLQuery const &query, std::vector<OperandEstimate> operands, std::vector<StarEstimate> stars)
+		: operands_(std::move(operands)), stars_(std::move(stars)) {
+		// the tables of VALUES blocks and property paths follow the triple patterns; they join with all triple patterns
+		std::vector<size_t> tables;
+		for (size_t operand = query.triple_patterns_.size(); operand < operands_.size(); ++operand)
+			tables.push_back(operand);
+		auto const join_with_tables = [&](std::vector<uint8_t> const &group) {
+			std::vector<size_t> joined{group.begin(), group.end()};
+			joined.insert(joined.end(), tables.begin(), tables.end());
+			return join(joined);
+		};
+		// operands of OPTIONALs do not restrict the solutions, so they are left out
+		if (query.union_branches_.empty()) {
+			total_ = join_with_tables(query.mandatory_operands_);
+		} else {
+			for (auto const &branch : query.union_branches_)
+				total_ += join_with_tables(branch);
+		}
+
+		variable_cardinalities_.reserve(query.var_to_id_.size());
+		for (auto const &[var, var_id] : query.var_to_id_) {
+			double cardinality = std::numeric_limits<double>::infinity();
+			for (auto const &operand : operands_) {
+				for (auto const &[operand_var_id, distinct] : operand.distinct) {
+					if (operand_var_id == var_id)
+						cardinality = std::min(cardinality, distinct);
+				}
+			}
+			// no variable has more distinct bindings than there are solutions
+			variable_cardinalities_.emplace_back(var_id, std::min(cardinality, total_));
+		}
+	}
+
+	double QueryEstimate::join(std::vector<size_t> const &operands) const {
+		// products of many operands overflow, so the estimate is computed with logarithms
+		struct VariableLogs {
+			char var_id;
+			// the sum and the minimum of the logarithms of the distinct values in the operands with the variable
+			double sum;
+			double min;
+		};
+		// a star whose triple patterns are all joined replaces them
+		std::vector<OperandEstimate> joined;
+		std::vector<bool> in_star(operands_.size(), false);
+		auto const is_joined = [&operands](size_t operand) { return std::ranges::find(operands, operand) != operands.end(); };
+		for (auto const &star : stars_) {
+			if (not std::ranges::all_of(star.operands, is_joined))
+				continue;
+			auto &estimate = joined.emplace_back();
+			estimate.matches = star.solutions;
+			for (auto const operand : star.operands) {
+				in_star[operand] = true;
+				for (auto const &[var_id, distinct] : operands_[operand].distinct)
+					estimate.add_variable(var_id, distinct);
+			}
+		}
+		for (auto const operand : operands) {
+			if (not in_star[operand])
+				joined.push_back(operands_[operand]);
+		}
+
+		std::vector<VariableLogs> variables;
+		double log_total = 0;
+		for (auto const &estimate : joined) {
+			if (not(estimate.matches > 0))
+				return 0;
+			log_total += std::log(estimate.matches);
+			for (auto const &[var_id, distinct] : estimate.distinct) {
+				auto const log_distinct = std::log(std::max(distinct, 1.0));
+				auto variable = std::ranges::find(variables, var_id, &VariableLogs::var_id);
+				if (variable == variables.end()) {
+					variables.push_back({var_id, log_distinct, log_distinct});
+				} else {
+					variable->sum += log_distinct;
+					variable->min = std::min(variable->min, log_distinct);
+				}
+			}
+		}
+		for (auto const &variable : variables)
+			log_total -= variable.sum - variable.min;
+		return std::exp(log_total);
+	}
+
+}// namespace dice::triple_store
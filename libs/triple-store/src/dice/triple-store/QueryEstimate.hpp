@@ -0,0 +1,81 @@
+#ifndef TENTRIS_STORE_QUERYESTIMATE
+#define TENTRIS_STORE_QUERYESTIMATE
+
+#include <dice/sparql2tensor/SPARQLQuery.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace dice::triple_store {
+
+	/**
+	 * The estimated matches of one operand of a query and the estimated numbers of distinct values of its variables.
+	 */
+	struct OperandEstimate {
+		double matches = 0;
+		// each variable of the operand with its estimated number of distinct values
+		std::vector<std::pair<char, double>> distinct;
+
+		/**
+		 * Records the number of distinct values of a variable. A variable that occurs twice in the operand keeps the smaller number.
+		 * @param var_id the variable
+		 * @param distinct_values its estimated number of distinct values; at most matches are used
+		 */
+		void add_variable(char var_id, double distinct_values);
+	};
+
+	/**
+	 * The estimated number of solutions of a subject star, i.e., of triple patterns that share their subject variable.
+	 */
+	struct StarEstimate {
+		// the operands of the triple patterns of the star
+		std::vector<size_t> operands;
+		double solutions = 0;
+	};
+
+	/**
+	 * Estimates of the solutions of a query that are computed from estimates of its operands, so no operand is materialized.
+	 * Joins are assumed to be independent: joining the operands that share a variable keeps, for every operand but the one with the
+	 * fewest distinct values of the variable, the fraction 1 / distinct values of its matches. Subject stars are an exception: their
+	 * triple patterns are correlated, so a star whose solutions are estimated as a whole replaces its triple patterns.
+	 */
+	class QueryEstimate {
+		std::vector<OperandEstimate> operands_;
+		std::vector<StarEstimate> stars_;
+		// in the order of var_to_id_ of the query
+		std::vector<std::pair<char, double>> variable_cardinalities_;
+		double total_ = 0;
+
+		/**
+		 * @param operands indices into operands_
+		 * @return the estimated number of solutions of joining operands
+		 */
+		[[nodiscard]] double join(std::vector<size_t> const &operands) const;
+
+	public:
+		/**
+		 * @param query the query
+		 * @param operands the estimate of each operand of query, in the order of TripleStore::get_query_operands
+		 * @param stars estimates of subject stars; each operand belongs to at most one of them
+		 */
+		QueryEstimate(sparql2tensor::SPARQLQuery const &query, std::vector<OperandEstimate> operands, std::vector<StarEstimate> stars = {});
+
+		/**
+		 * @return the estimate of each operand, in the order of TripleStore::get_query_operands
+		 */
+		[[nodiscard]] std::vector<OperandEstimate> const &operands() const noexcept { return operands_; }
+
+		/**
+		 * @return the estimated number of distinct bindings of each variable of the query, in the order of its var_to_id_
+		 */
+		[[nodiscard]] std::vector<std::pair<char, double>> const &variable_cardinalities() const noexcept { return variable_cardinalities_; }
+
+		/**
+		 * @return the estimated number of solutions of the graph pattern, i.e., before FILTERs, projection and DISTINCT
+		 */
+		[[nodiscard]] double total() const noexcept { return total_; }
+	};
+
+}// namespace dice::triple_store
+
+#endif//TENTRIS_STORE_QUERYESTIMATE
@@ -0,0 +1,40 @@
+#include "ScratchHeap.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace dice::triple_store {
+
+	std::filesystem::path ScratchHeap::default_parent() {
+		std::error_code error;
+		if (std::filesystem::is_directory("/dev/shm", error))
+			return "/dev/shm";
+		return std::filesystem::temp_directory_path();
+	}
+
+	ScratchHeap::ScratchHeap(std::filesystem::path const &parent) {
+		std::string directory = (parent / "tentris_scratch_XXXXXX").string();
+		if (::mkdtemp(directory.data()) == nullptr)
+			throw std::runtime_error{"Cannot create a temporary directory for query operands in " + parent.string()};
+		directory_ = directory;
+		try {
+			manager_ = std::make_unique<rdf_tensor::metall_manager>(metall::create_only, (directory_ / "heap").c_str());
+		} catch (...) {
+			std::filesystem::remove_all(directory_);
+			throw;
+		}
+	}
+
+	ScratchHeap::~ScratchHeap() {
+		manager_.reset();
+		std::error_code ignored;
+		std::filesystem::remove_all(directory_, ignored);
+	}
+
+	std::shared_ptr<rdf_tensor::HypertrieContext> ScratchHeap::make_context() const {
+		return std::make_shared<rdf_tensor::HypertrieContext>(manager_->get_allocator());
+	}
+
+}// namespace dice::triple_store
@@ -0,0 +1,48 @@
+#ifndef TENTRIS_STORE_SCRATCHHEAP
+#define TENTRIS_STORE_SCRATCHHEAP
+
+#include <dice/rdf-tensor/RDFTensor.hpp>
+
+#include <filesystem>
+#include <memory>
+
+namespace dice::triple_store {
+
+	/**
+	 * A heap for hypertries that are computed while a query is answered, e.g., the tables of VALUES blocks.
+	 * Hypertries only allocate through the metall allocator, but allocating them in the heap of the index would write to the mapped
+	 * index files and grow them with every request. This heap lives in a temporary directory that is removed when the heap is destroyed.
+	 * By default, the directory is in shared memory, so the pages of query operands are never written back to a disk. Each query
+	 * allocates in a context of its own, which returns its memory to the heap when the query is done.
+	 */
+	class ScratchHeap {
+		std::filesystem::path directory_;
+		std::unique_ptr<rdf_tensor::metall_manager> manager_;
+
+	public:
+		/**
+		 * @return /dev/shm if it exists, otherwise the temporary directory
+		 */
+		[[nodiscard]] static std::filesystem::path default_parent();
+
+		/**
+		 * @param parent the directory in which the temporary directory of the heap is created
+		 * @throws std::runtime_error if the temporary directory cannot be created
+		 */
+		explicit ScratchHeap(std::filesystem::path const &parent = default_parent());
+
+		ScratchHeap(ScratchHeap const &) = delete;
+		ScratchHeap &operator=(ScratchHeap const &) = delete;
+
+		~ScratchHeap();
+
+		/**
+		 * Hypertries that use the same context must not be modified concurrently, so each query gets a context of its own.
+		 * @return a new hypertrie context that allocates in this heap. It must outlive all hypertries that use it.
+		 */
+		[[nodiscard]] std::shared_ptr<rdf_tensor::HypertrieContext> make_context() const;
+	};
+
+}// namespace dice::triple_store
+
+#endif//TENTRIS_STORE_SCRATCHHEAP
@@ -0,0 +1,176 @@
+#include "SolutionSorter.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace dice::triple_store {
+
+	namespace {
+		using Term = std::remove_cvref_t<decltype(std::declval<rdf_tensor::Entry &>().key()[0])>;
+
+		// spilled solutions are written as the bytes of their terms, which stay valid while the node storage is open
+		static_assert(std::is_trivially_copyable_v<Term>);
+	}// namespace
+
+	SolutionSorter::SolutionSorter(std::vector<sparql2tensor::OrderCondition> const &order_by,
+								   std::vector<rdf4cpp::rdf::query::Variable> const &variables,
+								   std::optional<size_t> max_solutions,
+								   size_t memory_budget)
+		: width_(variables.size()),
+		  max_solutions_(max_solutions),
+		  memory_budget_(std::max<size_t>(memory_budget, 1)) {
+		for (auto const &condition : order_by) {
+			auto const column = std::ranges::find(variables, condition.variable);
+			if (column == variables.end())
+				throw std::runtime_error("ORDER BY variable " + std::string(condition.variable.name()) + " is not projected.");
+			columns_.emplace_back(static_cast<size_t>(std::distance(variables.begin(), column)), condition.descending);
+		}
+	}
+
+	SolutionSorter::SortKeys SolutionSorter::sort_keys_of(Entry const &entry) {
+		SortKeys keys;
+		keys.reserve(columns_.size());
+		for (auto const &[column, descending] : columns_) {
+			auto const &term = entry.key()[column];
+			auto found = sort_keys_.find(term);
+			if (found == sort_keys_.end())
+				found = sort_keys_.emplace(term, SortKey::of(term)).first;
+			keys.push_back(&found->second);
+		}
+		return keys;
+	}
+
+	bool SolutionSorter::before(SortKeys const &lhs, SortKeys const &rhs) const noexcept {
+		for (size_t i = 0; i < columns_.size(); ++i) {
+			if (lhs[i] == rhs[i])// the same term
+				continue;
+			if (auto const order = lhs[i]->compare(*rhs[i]); order != 0)
+				return (columns_[i].second) ? order > 0 : order < 0;
+		}
+		return false;
+	}
+
+	void SolutionSorter::prune_sort_keys(std::span<Row const> held, std::span<Row const> heads) {
+		if (sort_keys_.size() <= 2 * (held.size() + heads.size()) * columns_.size() + 1'024)
+			return;
+		robin_hood::unordered_flat_set<SortKey const *> used;
+		for (auto const &row : held)
+			used.insert(row.keys.begin(), row.keys.end());
+		for (auto const &row : heads)
+			used.insert(row.keys.begin(), row.keys.end());
+		for (auto it = sort_keys_.begin(); it != sort_keys_.end();) {
+			if (used.count(&it->second) != 0)
+				++it;
+			else
+				it = sort_keys_.erase(it);
+		}
+	}
+
+	void SolutionSorter::add(Entry const &entry) {
+		if (not max_solutions_) {
+			rows_.push_back(Row{entry, sort_keys_of(entry)});
+			if (rows_.size() >= memory_budget_)
+				spill();
+			return;
+		}
+		if (*max_solutions_ == 0)
+			return;
+		auto keys = sort_keys_of(entry);
+		// once the held rows suffice, a solution that does not come before the last of them is not needed
+		if (held_ >= *max_solutions_ and not before(keys, rows_.front().keys))
+			return;
+		held_ += entry.value();
+		rows_.push_back(Row{entry, std::move(keys)});
+		std::ranges::push_heap(rows_, row_order());
+		while (held_ - static_cast<size_t>(rows_.front().entry.value()) >= *max_solutions_) {
+			held_ -= rows_.front().entry.value();
+			std::ranges::pop_heap(rows_, row_order());
+			rows_.pop_back();
+		}
+		prune_sort_keys(rows_);
+	}
+
+	void SolutionSorter::spill() {
+		std::ranges::sort(rows_, row_order());
+		std::unique_ptr<std::FILE, CloseFile> run{std::tmpfile()};
+		if (not run)
+			throw std::runtime_error("Cannot create a temporary file to sort solutions.");
+		for (auto const &row : rows_) {
+			Multiplicity const multiplicity = row.entry.value();
+			bool written = std::fwrite(&multiplicity, sizeof(multiplicity), 1, run.get()) == 1;
+			for (size_t i = 0; written and i < width_; ++i)
+				written = std::fwrite(&row.entry.key()[i], sizeof(Term), 1, run.get()) == 1;
+			if (not written)
+				throw std::runtime_error("Cannot write solutions to a temporary file.");
+		}
+		std::rewind(run.get());
+		runs_.push_back(std::move(run));
+		rows_.clear();
+		// no row uses a sort key anymore; the keys are computed again when the runs are merged
+		sort_keys_.clear();
+	}
+
+	bool SolutionSorter::read_row(std::FILE *run, Row &row) {
+		Multiplicity multiplicity;
+		if (std::fread(&multiplicity, sizeof(multiplicity), 1, run) != 1)
+			return false;
+		row.entry.key().resize(width_);
+		for (size_t i = 0; i < width_; ++i) {
+			if (std::fread(&row.entry.key()[i], sizeof(Term), 1, run) != 1)
+				throw std::runtime_error("Cannot read solutions from a temporary file.");
+		}
+		row.entry.value() = multiplicity;
+		row.keys = sort_keys_of(row.entry);
+		return true;
+	}
+
+	std::generator<rdf_tensor::Entry const &> SolutionSorter::sorted() {
+		if (max_solutions_) {
+			std::ranges::sort_heap(rows_, row_order());
+			for (auto const &row : rows_)
+				co_yield row.entry;
+			co_return;
+		}
+
+		std::ranges::sort(rows_, row_order());
+		if (runs_.empty()) {
+			for (auto const &row : rows_)
+				co_yield row.entry;
+			co_return;
+		}
+
+		// merge the runs and the rows in memory; the last cursor reads rows_
+		std::vector<Row> heads(runs_.size() + 1);
+		size_t next_row = 0;
+		auto const advance = [&](size_t cursor) {
+			if (cursor < runs_.size())
+				return read_row(runs_[cursor].get(), heads[cursor]);
+			if (next_row == rows_.size())
+				return false;
+			heads[cursor] = std::move(rows_[next_row++]);
+			return true;
+		};
+		// the front of the heap is the cursor whose head comes first
+		auto const cursor_order = [&](size_t lhs, size_t rhs) { return before(heads[rhs].keys, heads[lhs].keys); };
+		std::vector<size_t> open;
+		for (size_t cursor = 0; cursor < heads.size(); ++cursor) {
+			if (advance(cursor))
+				open.push_back(cursor);
+		}
+		std::ranges::make_heap(open, cursor_order);
+		while (not open.empty()) {
+			std::ranges::pop_heap(open, cursor_order);
+			auto const cursor = open.back();
+			co_yield heads[cursor].entry;
+			if (advance(cursor))
+				std::ranges::push_heap(open, cursor_order);
+			else
+				open.pop_back();
+			// the rows of the runs are read one after another, so the keys of the rows that were yielded are dropped
+			prune_sort_keys(std::span<Row const>{rows_}.subspan(next_row), heads);
+		}
+	}
+
+}// namespace dice::triple_store
@@ -0,0 +1,103 @@
+#ifndef TENTRIS_STORE_SOLUTIONSORTER
+#define TENTRIS_STORE_SOLUTIONSORTER
+
+#include <dice/rdf-tensor/Query.hpp>
+
+#include <dice/sparql2tensor/SPARQLQuery.hpp>
+
+#include <robin_hood.h>
+
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace dice::triple_store {
+
+	/**
+	 * Sorts solutions by the ORDER BY of a query while they are streamed in.
+	 * If only the first max_solutions solutions in the order are needed, e.g., OFFSET + LIMIT, they are kept in a bounded heap, so the
+	 * memory does not depend on the number of solutions. Otherwise, sorted runs of memory_budget solutions are spilled to temporary
+	 * files and merged.
+	 * The sort key of a term is computed once and shared by all solutions in memory that contain the term. Only the keys of the
+	 * solutions in memory are kept, so they are bounded by max_solutions or memory_budget as well.
+	 */
+	class SolutionSorter {
+		using Entry = rdf_tensor::Entry;
+		using Multiplicity = std::remove_cvref_t<decltype(std::declval<Entry &>().value())>;
+		using SortKey = sparql2tensor::TermSortKey;
+		using SortKeys = std::vector<SortKey const *>;
+
+		struct Row {
+			Entry entry;
+			// the sort key of each ORDER BY column of entry
+			SortKeys keys;
+		};
+
+		struct CloseFile {
+			void operator()(std::FILE *file) const noexcept {
+				std::fclose(file);
+			}
+		};
+
+		// the column and whether it is descending, for each ORDER BY condition
+		std::vector<std::pair<size_t, bool>> columns_;
+		size_t width_;
+		std::optional<size_t> max_solutions_;
+		size_t memory_budget_;
+		robin_hood::unordered_node_map<rdf_tensor::NodeWrapper, SortKey, dice::hash::DiceHashMartinus<rdf_tensor::NodeWrapper>> sort_keys_;
+		// a heap whose front is the last row in the order if max_solutions_ is set; otherwise, the rows that are not spilled yet
+		std::vector<Row> rows_;
+		// the sum of the multiplicities of rows_
+		size_t held_ = 0;
+		// the spilled runs, each sorted
+		std::vector<std::unique_ptr<std::FILE, CloseFile>> runs_;
+
+		[[nodiscard]] SortKeys sort_keys_of(Entry const &entry);
+
+		[[nodiscard]] bool before(SortKeys const &lhs, SortKeys const &rhs) const noexcept;
+
+		[[nodiscard]] auto row_order() const noexcept {
+			return [this](Row const &lhs, Row const &rhs) { return before(lhs.keys, rhs.keys); };
+		}
+
+		/**
+		 * Drops the sort keys that no row uses, once there are considerably more of them than the rows can use.
+		 * @param held the rows in memory
+		 * @param heads further rows, i.e., the heads of the runs while they are merged
+		 */
+		void prune_sort_keys(std::span<Row const> held, std::span<Row const> heads = {});
+
+		void spill();
+
+		bool read_row(std::FILE *run, Row &row);
+
+	public:
+		/**
+		 * @param order_by the ORDER BY conditions; their variables must be among variables
+		 * @param variables the variables of the solutions
+		 * @param max_solutions if set, only this many first solutions are yielded by sorted()
+		 * @param memory_budget the number of solutions that are held in memory before they are spilled; unused if max_solutions is set
+		 */
+		SolutionSorter(std::vector<sparql2tensor::OrderCondition> const &order_by,
+					   std::vector<rdf4cpp::rdf::query::Variable> const &variables,
+					   std::optional<size_t> max_solutions,
+					   size_t memory_budget);
+
+		/**
+		 * @param entry the next solution
+		 * @throws std::runtime_error if a temporary file cannot be written
+		 */
+		void add(Entry const &entry);
+
+		/**
+		 * Must be called once after all solutions are added.
+		 * @return the solutions in the order; if max_solutions is set, the first ones whose multiplicities sum up to at least max_solutions
+		 */
+		std::generator<Entry const &> sorted();
+	};
+
+}// namespace dice::triple_store
+
+#endif//TENTRIS_STORE_SOLUTIONSORTER
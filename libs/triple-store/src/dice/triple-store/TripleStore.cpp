@@ -1,31 +1,1163 @@
 #include "TripleStore.hpp"
+#include "PropertyPathEvaluator.hpp"
+#include "SolutionSorter.hpp"
+
+#include <dice/node-store/TermStaging.hpp>
+#include <dice/rdf-tensor/TransientNodes.hpp>
 
 #include <rdf4cpp/rdf.hpp>
 
+#include <robin_hood.h>
+#include <taskflow/taskflow.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 namespace dice::triple_store {
-	TripleStore::TripleStore(TripleStore::BoolHypertrie &hypertrie) : hypertrie_(hypertrie) {}
+
+	namespace {
+		/**
+		 * Applies OFFSET and LIMIT to a sequence of solutions with multiplicities.
+		 */
+		class SolutionSlice {
+			size_t offset_;
+			size_t remaining_;
+
+		public:
+			explicit SolutionSlice(sparql2tensor::SPARQLQuery const &query) noexcept
+				: offset_(query.offset_),
+				  remaining_(query.limit_.value_or(std::numeric_limits<size_t>::max())) {}
+
+			/**
+			 * @param multiplicity the multiplicity of the next solution
+			 * @return how many copies of the solution are part of the result
+			 */
+			size_t take(size_t multiplicity) noexcept {
+				if (offset_ >= multiplicity) {
+					offset_ -= multiplicity;
+					return 0;
+				}
+				multiplicity = std::min(multiplicity - offset_, remaining_);
+				offset_ = 0;
+				remaining_ -= multiplicity;
+				return multiplicity;
+			}
+
+			/**
+			 * @return true if no further solution is part of the result
+			 */
+			[[nodiscard]] bool exhausted() const noexcept {
+				return remaining_ == 0;
+			}
+
+			/**
+			 * @param total the number of solutions without OFFSET and LIMIT
+			 * @return the number of solutions with OFFSET and LIMIT
+			 */
+			[[nodiscard]] size_t count(size_t total) const noexcept {
+				return std::min(total - std::min(total, offset_), remaining_);
+			}
+		};
+
+		/**
+		 * Evaluates a query sequentially.
+		 * @param q the query
+		 * @param distinct if the solutions are distinct; then each of them is yielded with multiplicity 1
+		 * @return the solutions
+		 */
+		std::generator<rdf_tensor::Entry const &> evaluate_sequential(rdf_tensor::Query &q, bool distinct) {
+			if (distinct) {
+				rdf_tensor::Entry entry;
+				entry.value() = 1;
+				for (auto const &distinct_entry : dice::query::Evaluation::evaluate<rdf_tensor::htt_t, rdf_tensor::allocator_type, true>(q)) {
+					entry.key().assign(distinct_entry.key().begin(), distinct_entry.key().end());
+					co_yield entry;
+				}
+			} else {
+				for (auto const &entry : dice::query::Evaluation::evaluate<rdf_tensor::htt_t, rdf_tensor::allocator_type>(q))
+					co_yield entry;
+			}
+		}
+
+		/**
+		 * A query that is split into partitions whose solutions together are the solutions of the query. Each partition is the query with
+		 * other operands: either an additional operand that restricts a variable to a part of its domain, or empty operands in place of
+		 * all UNION branches but one.
+		 *
+		 * The partitions are claimed one after another by tasks on an executor and by the consumer of the solutions.
+		 * Tasks pass their solutions to the consumer in batches. The consumer evaluates a partition itself whenever no batch is ready,
+		 * so the evaluation progresses even if all workers of the executor are busy.
+		 *
+		 * Tasks never wait for the consumer, which may be suspended for a long time, e.g., by a scheduler. A task that finds too many
+		 * batches not yet consumed parks its partition and ends, so its worker is free for other work. The consumer continues parked
+		 * partitions itself or starts tasks for them once it consumed the ready batches.
+		 */
+		struct PartitionedQuery {
+			static constexpr size_t batch_size = 1'024;
+			// tasks park their partition if this many batches are not yet consumed
+			static constexpr size_t max_ready_batches = 64;
+
+			using Solutions = std::generator<rdf_tensor::Entry const &>;
+
+			/**
+			 * A partition whose evaluation is started but not finished.
+			 */
+			struct StartedPartition {
+				Solutions solutions;
+				// the next solution that is not in batch; std::nullopt until the evaluation starts
+				std::optional<std::ranges::iterator_t<Solutions>> position;
+				// solutions that the consumer did not take yet
+				std::vector<rdf_tensor::Entry> batch;
+			};
+
+			dice::query::OperandDependencyGraph odg;
+			// the context of the operands that were computed for the query; declared first, so it is destroyed last
+			std::shared_ptr<rdf_tensor::HypertrieContext> context;
+			// the operands of the query followed by the partition's part of the domain
+			std::vector<std::vector<rdf_tensor::const_BoolHypertrie>> partition_operands;
+			std::vector<char> proj_vars_id;
+			std::vector<char> hint_vars_id;
+			std::chrono::steady_clock::time_point endtime;
+			bool distinct;
+			// false if the same solution may occur in several partitions. Then the solutions of DISTINCT queries must be deduplicated.
+			bool disjoint = true;
+			// a partition stops after this many solutions, e.g., because of a LIMIT
+			size_t max_solutions;
+
+			std::atomic<size_t> next_partition = 0;
+			std::atomic<bool> cancelled = false;
+			std::mutex mutex;
+			std::condition_variable cv;
+			std::deque<std::vector<rdf_tensor::Entry>> ready_batches;
+			// declared after the operands, so the evaluations are destroyed before them
+			std::deque<StartedPartition> parked;
+			size_t finished_partitions = 0;
+			std::exception_ptr error;
+
+			[[nodiscard]] size_t partitions() const noexcept {
+				return partition_operands.size();
+			}
+
+			/**
+			 * @return the index of a partition that nobody evaluates yet, or partitions() if there is none
+			 */
+			size_t claim() noexcept {
+				if (cancelled.load(std::memory_order_relaxed))
+					return partitions();
+				return std::min(next_partition.fetch_add(1, std::memory_order_relaxed), partitions());
+			}
+
+			void add_hints(rdf_tensor::Query &q) const {
+				for (auto const var_id : hint_vars_id)
+					q.add_query_hint_variable(var_id);
+			}
+
+			Solutions solutions(size_t partition) {
+				rdf_tensor::Query q{odg, partition_operands[partition], proj_vars_id, endtime};
+				add_hints(q);
+				size_t solutions = 0;
+				for (auto const &entry : evaluate_sequential(q, distinct)) {
+					if (cancelled.load(std::memory_order_relaxed))
+						co_return;
+					co_yield entry;
+					solutions += entry.value();
+					if (solutions >= max_solutions)
+						co_return;
+				}
+			}
+
+			void finish(std::exception_ptr partition_error) {
+				std::unique_lock lock{mutex};
+				++finished_partitions;
+				if (partition_error and not error)
+					error = std::move(partition_error);
+				cv.notify_all();
+			}
+
+			enum struct Offer {
+				taken,
+				// the consumer has max_ready_batches batches that it did not take yet
+				full,
+				// the consumer is gone
+				cancelled
+			};
+
+			/**
+			 * Passes a batch to the consumer without waiting for it.
+			 * @param batch moved from if it is taken
+			 */
+			Offer offer(std::vector<rdf_tensor::Entry> &batch) {
+				std::unique_lock lock{mutex};
+				if (cancelled.load(std::memory_order_relaxed))
+					return Offer::cancelled;
+				if (ready_batches.size() >= max_ready_batches)
+					return Offer::full;
+				ready_batches.push_back(std::move(batch));
+				cv.notify_all();
+				return Offer::taken;
+			}
+
+			/**
+			 * @return a parked partition if the consumer has room for its batches, otherwise a partition that nobody evaluates yet,
+			 * or std::nullopt if there is neither
+			 */
+			std::optional<StartedPartition> next() {
+				{
+					std::unique_lock lock{mutex};
+					if (not parked.empty() and ready_batches.size() < max_ready_batches) {
+						auto partition = std::move(parked.front());
+						parked.pop_front();
+						return partition;
+					}
+				}
+				auto const partition = claim();
+				if (partition == partitions())
+					return std::nullopt;
+				return StartedPartition{solutions(partition), std::nullopt, {}};
+			}
+
+			/**
+			 * Continues the evaluation of a partition and passes its solutions to the consumer in batches.
+			 * @return false if the partition was parked because the consumer did not keep up
+			 */
+			bool produce(StartedPartition &partition) {
+				try {
+					auto &[evaluation, position, batch] = partition;
+					if (not position) {
+						position = evaluation.begin();
+						batch.reserve(batch_size);
+					}
+					while (true) {
+						if (batch.size() == batch_size or (*position == evaluation.end() and not batch.empty())) {
+							switch (offer(batch)) {
+								case Offer::taken:
+									batch = {};
+									batch.reserve(batch_size);
+									break;
+								case Offer::full: {
+									std::unique_lock lock{mutex};
+									parked.push_back(std::move(partition));
+									cv.notify_all();
+									return false;
+								}
+								case Offer::cancelled:
+									finish(nullptr);
+									return true;
+							}
+						}
+						if (*position == evaluation.end())
+							break;
+						batch.push_back(**position);
+						++*position;
+					}
+					finish(nullptr);
+				} catch (...) {
+					finish(std::current_exception());
+				}
+				return true;
+			}
+
+			/**
+			 * Evaluates partitions and passes their solutions to the consumer until no partition is left or one of them is parked.
+			 */
+			void run() {
+				while (auto partition = next()) {
+					if (not produce(*partition))
+						return;
+				}
+			}
+
+			/**
+			 * Evaluates partitions until no partition is left or one of them has a solution, which cancels the others.
+			 * The partitions are evaluated by solutions(), so running evaluations stop at their next solution once the query is cancelled.
+			 */
+			void run_ask() {
+				for (auto partition = claim(); partition < partitions(); partition = claim()) {
+					try {
+						if (proj_vars_id.empty()) {
+							// without variables, the partition is answered by lookups of its triple patterns
+							rdf_tensor::Query q{odg, partition_operands[partition], {}, endtime};
+							if (dice::query::Evaluation::evaluate_ask<rdf_tensor::htt_t, rdf_tensor::allocator_type>(q))
+								cancel();
+						} else {
+							for ([[maybe_unused]] auto const &entry : solutions(partition)) {
+								cancel();
+								break;
+							}
+						}
+						finish(nullptr);
+					} catch (...) {
+						finish(std::current_exception());
+					}
+				}
+			}
+
+			void cancel() {
+				std::unique_lock lock{mutex};
+				cancelled.store(true, std::memory_order_relaxed);
+				cv.notify_all();
+			}
+		};
+
+		/**
+		 * Adds an operand with the single variable var_id to odg that joins with all other operands like an additional triple pattern
+		 * of the same group.
+		 * @param operands the number of operands of odg
+		 * @return the index of the added operand
+		 */
+		size_t add_joined_operand(dice::query::OperandDependencyGraph &odg, size_t operands, char var_id) {
+			auto const joined = odg.add_operand({var_id});
+			for (size_t operand = 0; operand < operands; ++operand) {
+				auto const &var_ids = odg.operand_var_ids(operand);
+				if (std::ranges::find(var_ids, var_id) != var_ids.end()) {
+					odg.add_dependency(operand, joined, var_id);
+					odg.add_dependency(joined, operand, var_id);
+				} else {
+					odg.add_dependency(operand, joined);
+					odg.add_dependency(joined, operand);
+				}
+			}
+			return joined;
+		}
+
+		/**
+		 * Splits a query with a top-level UNION into one partition per branch. In each partition, the operands of the other branches are empty,
+		 * so the other components of the operand dependency graph have no solutions.
+		 * @param empty_operand called with a depth and the context of the partitioned query; returns an empty operand of that depth
+		 * @return the partitioned query or nullptr if the query has less than two UNION branches
+		 */
+		template<typename EmptyOperand>
+		std::shared_ptr<PartitionedQuery> partition_union(sparql2tensor::SPARQLQuery const &query,
+														  QueryOperands const &query_operands,
+														  EmptyOperand const &empty_operand,
+														  std::vector<char> const &proj_vars_id,
+														  std::vector<char> const &hint_vars_id,
+														  bool distinct,
+														  size_t max_solutions,
+														  std::chrono::steady_clock::time_point endtime) {
+			if (query.union_branches_.size() < 2)
+				return nullptr;
+			auto const &operands = query_operands.operands;
+			auto partitioned = std::make_shared<PartitionedQuery>();
+			partitioned->odg = query.odg_;
+			partitioned->context = query_operands.context;
+			partitioned->partition_operands.reserve(query.union_branches_.size());
+			for (auto const &branch : query.union_branches_) {
+				auto &partition_operands = partitioned->partition_operands.emplace_back();
+				partition_operands.reserve(operands.size());
+				for (size_t operand = 0; operand < operands.size(); ++operand) {
+					if (std::ranges::find(branch, operand) != branch.end())
+						partition_operands.push_back(operands[operand]);
+					else
+						partition_operands.push_back(empty_operand(query.odg_.operand_var_ids(operand).size(), partitioned->context));
+				}
+			}
+			partitioned->proj_vars_id = proj_vars_id;
+			partitioned->hint_vars_id = hint_vars_id;
+			partitioned->endtime = endtime;
+			partitioned->distinct = distinct;
+			// a solution of one branch may also be a solution of another
+			partitioned->disjoint = false;
+			// with deduplication, a branch may have to provide more solutions than the LIMIT
+			partitioned->max_solutions = (distinct) ? std::numeric_limits<size_t>::max() : max_solutions;
+			return partitioned;
+		}
+
+		/**
+		 * Splits a query into partitions by the domain of one variable, if it is worth it.
+		 * The variable is the first hint variable, or otherwise a variable of the smallest operand. For DISTINCT queries, it must be projected,
+		 * so that no solution occurs in two partitions.
+		 * The domain is scanned completely before the first solution, so queries that need fewer solutions than min_cardinality, i.e., with a
+		 * small LIMIT and no ORDER BY, and queries whose domain operand has more than max_domain_scan entries are evaluated sequentially.
+		 * @param odg the operand dependency graph of the operands
+		 * @param scratch_heap holds the parts of the domain, unless the operands of the query already have a context
+		 * @return the partitioned query or nullptr if the query is evaluated sequentially
+		 */
+		std::shared_ptr<PartitionedQuery> partition_query(sparql2tensor::SPARQLQuery const &query,
+														  dice::query::OperandDependencyGraph const &odg,
+														  QueryOperands const &query_operands,
+														  ScratchHeap const &scratch_heap,
+														  std::vector<char> const &proj_vars_id,
+														  std::vector<char> const &hint_vars_id,
+														  bool distinct,
+														  size_t max_solutions,
+														  std::chrono::steady_clock::time_point endtime,
+														  size_t max_partitions,
+														  size_t min_cardinality,
+														  size_t max_domain_scan) {
+			auto const &operands = query_operands.operands;
+			// the additional operand would change the semantics of OPTIONAL and UNION
+			if (max_partitions < 2 or operands.empty() or query.mandatory_operands_.size() != query.triple_patterns_.size())
+				return nullptr;
+			// the sequential evaluation stops after max_solutions, usually long before the domain would be scanned
+			if (max_solutions < min_cardinality)
+				return nullptr;
+
+			auto const has_var = [&](size_t operand, char var_id) {
+				auto const &var_ids = odg.operand_var_ids(operand);
+				return std::ranges::find(var_ids, var_id) != var_ids.end();
+			};
+			auto const eligible = [&](char var_id) {
+				return not distinct or std::ranges::find(proj_vars_id, var_id) != proj_vars_id.end();
+			};
+			// the smallest operand with the variable; the domain is read from it
+			auto const smallest_operand_with = [&](char var_id) {
+				std::optional<size_t> smallest;
+				for (size_t operand = 0; operand < operands.size(); ++operand) {
+					if (has_var(operand, var_id) and (not smallest or operands[operand].size() < operands[*smallest].size()))
+						smallest = operand;
+				}
+				return smallest;
+			};
+
+			size_t estimated_cardinality = std::numeric_limits<size_t>::max();
+			for (size_t operand = 0; operand < operands.size(); ++operand) {
+				if (not odg.operand_var_ids(operand).empty())
+					estimated_cardinality = std::min(estimated_cardinality, operands[operand].size());
+			}
+			if (estimated_cardinality == std::numeric_limits<size_t>::max() or estimated_cardinality < min_cardinality)
+				return nullptr;
+
+			std::optional<char> partition_var;
+			std::optional<size_t> domain_operand;
+			if (not hint_vars_id.empty() and eligible(hint_vars_id.front())) {
+				partition_var = hint_vars_id.front();
+				domain_operand = smallest_operand_with(*partition_var);
+			}
+			if (not domain_operand) {
+				for (size_t operand = 0; operand < operands.size(); ++operand) {
+					if (domain_operand and operands[operand].size() >= operands[*domain_operand].size())
+						continue;
+					for (auto const var_id : odg.operand_var_ids(operand)) {
+						if (eligible(var_id)) {
+							partition_var = var_id;
+							domain_operand = operand;
+							break;
+						}
+					}
+				}
+			}
+			if (not domain_operand or operands[*domain_operand].size() > max_domain_scan)
+				return nullptr;
+
+			auto const &domain_var_ids = odg.operand_var_ids(*domain_operand);
+			auto const position = size_t(std::ranges::find(domain_var_ids, *partition_var) - domain_var_ids.begin());
+			robin_hood::unordered_set<rdf_tensor::key_part_type, dice::hash::DiceHashMartinus<rdf_tensor::key_part_type>> domain;
+			size_t scanned = 0;
+			for (auto const &key : operands[*domain_operand]) {
+				domain.insert(key[position]);
+				// the sequential evaluation reports the timeout
+				if (++scanned % 65'536 == 0 and std::chrono::steady_clock::now() >= endtime)
+					return nullptr;
+			}
+			auto const partitions = std::min(max_partitions, domain.size());
+			if (partitions < 2)
+				return nullptr;
+
+			auto context = (query_operands.context) ? query_operands.context : scratch_heap.make_context();
+			// the values are assigned round-robin; the hash order of the set spreads them randomly
+			std::vector<rdf_tensor::BoolHypertrie> parts;
+			parts.reserve(partitions);
+			for (size_t part = 0; part < partitions; ++part)
+				parts.emplace_back(1, rdf_tensor::HypertrieContext_ptr{context.get()});
+			size_t part = 0;
+			for (auto const &value : domain) {
+				parts[part].set(rdf_tensor::Key{value}, true);
+				part = (part + 1) % partitions;
+			}
+
+			auto partitioned = std::make_shared<PartitionedQuery>();
+			partitioned->odg = odg;
+			partitioned->context = std::move(context);
+			add_joined_operand(partitioned->odg, operands.size(), *partition_var);
+			partitioned->partition_operands.reserve(partitions);
+			for (auto &domain_part : parts) {
+				auto &partition_operands = partitioned->partition_operands.emplace_back(operands);
+				partition_operands.push_back(std::move(domain_part));
+			}
+			partitioned->proj_vars_id = proj_vars_id;
+			partitioned->hint_vars_id = hint_vars_id;
+			partitioned->endtime = endtime;
+			partitioned->distinct = distinct;
+			partitioned->max_solutions = max_solutions;
+			return partitioned;
+		}
+
+		/**
+		 * Evaluates the partitions of a query in parallel.
+		 * @param partitioned the partitioned query
+		 * @param executor runs the tasks that evaluate partitions besides the consumer
+		 * @return the solutions of all partitions
+		 */
+		std::generator<rdf_tensor::Entry const &> evaluate_partitioned(std::shared_ptr<PartitionedQuery> partitioned, tf::Executor &executor) {
+			// the tasks keep the partitioned query alive; when the consumer stops early, they stop at the next solution
+			struct CancelOnExit {
+				PartitionedQuery &partitioned;
+				~CancelOnExit() { partitioned.cancel(); }
+			} cancel_on_exit{*partitioned};
+
+			auto const tasks = std::min<size_t>(executor.num_workers(), partitioned->partitions()) - 1;
+			for (size_t task = 0; task < tasks; ++task)
+				executor.silent_async([partitioned]() { partitioned->run(); });
+
+			std::deque<std::vector<rdf_tensor::Entry>> batches;
+			while (true) {
+				// a parked partition that the consumer continues itself because no batch is ready
+				std::optional<PartitionedQuery::StartedPartition> parked;
+				size_t resumed = 0;
+				{
+					std::unique_lock lock{partitioned->mutex};
+					auto const all_claimed = [&]() { return partitioned->next_partition.load(std::memory_order_relaxed) >= partitioned->partitions(); };
+					auto const done = [&]() { return partitioned->finished_partitions == partitioned->partitions(); };
+					if (partitioned->ready_batches.empty() and partitioned->parked.empty() and all_claimed() and not partitioned->error)
+						partitioned->cv.wait(lock, [&]() {
+							return not partitioned->ready_batches.empty() or not partitioned->parked.empty() or done() or partitioned->error;
+						});
+					if (partitioned->error)
+						std::rethrow_exception(partitioned->error);
+					if (partitioned->ready_batches.empty() and done())
+						co_return;
+					batches.swap(partitioned->ready_batches);
+					if (batches.empty() and not partitioned->parked.empty()) {
+						parked = std::move(partitioned->parked.front());
+						partitioned->parked.pop_front();
+					}
+					// the ready batches are taken, so there is room for the batches of the other parked partitions
+					resumed = std::min(partitioned->parked.size(), tasks);
+				}
+				for (size_t task = 0; task < resumed; ++task)
+					executor.silent_async([partitioned]() { partitioned->run(); });
+
+				if (not batches.empty()) {
+					for (auto const &batch : batches) {
+						for (auto const &entry : batch)
+							co_yield entry;
+					}
+					batches.clear();
+				} else if (parked) {
+					try {
+						for (auto const &entry : parked->batch)
+							co_yield entry;
+						for (auto &position = *parked->position; position != parked->solutions.end(); ++position)
+							co_yield *position;
+					} catch (...) {
+						partitioned->finish(std::current_exception());
+						continue;
+					}
+					partitioned->finish(nullptr);
+				} else if (auto const partition = partitioned->claim(); partition < partitioned->partitions()) {
+					try {
+						for (auto const &entry : partitioned->solutions(partition))
+							co_yield entry;
+					} catch (...) {
+						partitioned->finish(std::current_exception());
+						continue;
+					}
+					partitioned->finish(nullptr);
+				}
+			}
+		}
+
+		/**
+		 * Evaluates the partitions of a query as ASK queries in parallel. The first partition with a solution cancels the others; those that
+		 * are not started yet are skipped and running evaluations stop in the background at their next solution.
+		 * @param partitioned the partitioned query; it should project the variables of the query, so that its solutions are enumerated one by one
+		 * @param executor runs the tasks that evaluate partitions besides the caller
+		 * @return if any partition has a solution
+		 */
+		bool evaluate_ask_partitioned(std::shared_ptr<PartitionedQuery> partitioned, tf::Executor &executor) {
+			auto const tasks = std::min<size_t>(executor.num_workers(), partitioned->partitions()) - 1;
+			for (size_t task = 0; task < tasks; ++task)
+				executor.silent_async([partitioned]() { partitioned->run_ask(); });
+			partitioned->run_ask();
+			std::unique_lock lock{partitioned->mutex};
+			partitioned->cv.wait(lock, [&]() {
+				return partitioned->cancelled.load(std::memory_order_relaxed) or partitioned->error or
+					   partitioned->finished_partitions == partitioned->partitions();
+			});
+			if (partitioned->cancelled.load(std::memory_order_relaxed))
+				return true;
+			if (partitioned->error)
+				std::rethrow_exception(partitioned->error);
+			return false;
+		}
+
+		/**
+		 * The operands that restrict the variables of FILTER conjuncts before the join, and the conjuncts that are left to check per solution.
+		 */
+		struct FilterRestriction {
+			// the operand dependency graph with the restricting operands; std::nullopt if no variable is restricted
+			std::optional<dice::query::OperandDependencyGraph> odg;
+			// the conjuncts that the operands do not enforce
+			std::vector<sparql2tensor::FilterExpression const *> checked_filters;
+		};
+
+		/**
+		 * Restricts each variable that FILTER conjuncts of their own test, e.g., FILTER(?age > 18) or FILTER(isIRI(?x)), to the values that
+		 * satisfy them. The values are read from the smallest operand with the variable and checked once each. Those that satisfy the
+		 * conjuncts become an operand that joins with all other operands, so the join never binds the variable to another value and prunes
+		 * at the first operand that binds it instead of after enumerating complete solutions.
+		 * Queries with OPTIONAL or UNION are not restricted; there, the additional operand would change their semantics.
+		 * @param query_operands the operands of the query; the restricting operands are appended
+		 * @param scratch_heap holds the restricting operands, unless the operands of the query already have a context
+		 * @param max_entries variables whose smallest operand has more entries are not restricted
+		 * @param endtime variables whose values are not checked by then are not restricted; the evaluation reports the timeout
+		 */
+		FilterRestriction restrict_filtered_variables(sparql2tensor::SPARQLQuery const &query,
+													  QueryOperands &query_operands,
+													  ScratchHeap const &scratch_heap,
+													  size_t max_entries,
+													  std::chrono::steady_clock::time_point endtime) {
+			using Variable = rdf4cpp::rdf::query::Variable;
+			FilterRestriction restriction;
+			restriction.checked_filters.reserve(query.filters_.size());
+			bool const restrictable = max_entries != 0 and query.mandatory_operands_.size() == query.triple_patterns_.size();
+			// the conjuncts of each variable that is tested on its own
+			std::vector<std::pair<char, std::vector<sparql2tensor::FilterExpression const *>>> single_variable_filters;
+			std::vector<Variable> variables;
+			for (auto const &filter : query.filters_) {
+				variables.clear();
+				filter.collect_variables(variables);
+				auto const var_id = (restrictable and variables.size() == 1) ? query.var_to_id_.find(variables.front()) : query.var_to_id_.end();
+				if (var_id == query.var_to_id_.end()) {
+					restriction.checked_filters.push_back(&filter);
+					continue;
+				}
+				auto conjuncts = std::ranges::find(single_variable_filters, var_id->second, &decltype(single_variable_filters)::value_type::first);
+				if (conjuncts == single_variable_filters.end())
+					conjuncts = single_variable_filters.insert(conjuncts, {var_id->second, {}});
+				conjuncts->second.push_back(&filter);
+			}
+
+			auto &operands = query_operands.operands;
+			auto const query_operand_count = operands.size();
+			for (auto const &[var_id, conjuncts] : single_variable_filters) {
+				auto const &odg = (restriction.odg) ? *restriction.odg : query.odg_;
+				std::optional<size_t> domain_operand;
+				for (size_t operand = 0; operand < query_operand_count; ++operand) {
+					auto const &var_ids = odg.operand_var_ids(operand);
+					if (std::ranges::find(var_ids, var_id) != var_ids.end() and (not domain_operand or operands[operand].size() < operands[*domain_operand].size()))
+						domain_operand = operand;
+				}
+				if (not domain_operand or operands[*domain_operand].size() > max_entries) {
+					restriction.checked_filters.insert(restriction.checked_filters.end(), conjuncts.begin(), conjuncts.end());
+					continue;
+				}
+
+				auto const &domain_var_ids = odg.operand_var_ids(*domain_operand);
+				auto const position = size_t(std::ranges::find(domain_var_ids, var_id) - domain_var_ids.begin());
+				robin_hood::unordered_set<rdf_tensor::key_part_type, dice::hash::DiceHashMartinus<rdf_tensor::key_part_type>> checked;
+				std::vector<rdf_tensor::key_part_type> satisfying;
+				bool timed_out = false;
+				size_t scanned = 0;
+				for (auto const &key : operands[*domain_operand]) {
+					if (++scanned % 65'536 == 0 and std::chrono::steady_clock::now() >= endtime) {
+						timed_out = true;
+						break;
+					}
+					auto const value = key[position];
+					if (not checked.insert(value).second)
+						continue;
+					rdf4cpp::rdf::Node const term{value};
+					sparql2tensor::FilterExpression::Binding const binding = [&term](Variable const &) { return term; };
+					if (std::ranges::all_of(conjuncts, [&](auto const *filter) { return filter->satisfied(binding); }))
+						satisfying.push_back(value);
+				}
+				if (timed_out) {
+					restriction.checked_filters.insert(restriction.checked_filters.end(), conjuncts.begin(), conjuncts.end());
+					continue;
+				}
+				// if every value satisfies the conjuncts, they hold for every solution without restricting the variable
+				if (satisfying.size() == checked.size())
+					continue;
+
+				if (not query_operands.context)
+					query_operands.context = scratch_heap.make_context();
+				rdf_tensor::BoolHypertrie restricted{1, rdf_tensor::HypertrieContext_ptr{query_operands.context.get()}};
+				for (auto const &value : satisfying)
+					restricted.set(rdf_tensor::Key{value}, true);
+				if (not restriction.odg)
+					restriction.odg = query.odg_;
+				add_joined_operand(*restriction.odg, operands.size(), var_id);
+				operands.push_back(std::move(restricted));
+			}
+			return restriction;
+		}
+
+		/**
+		 * Relates the solutions of an evaluation to the requested variables and to the variables of the FILTERs.
+		 * The evaluation projects to the requested variables and to the variables that only the checked FILTER conjuncts use. Variables
+		 * that a FILTER fixes are not evaluated; they are bound to their constant.
+		 */
+		class SolutionProjection {
+			using Variable = rdf4cpp::rdf::query::Variable;
+			using Node = rdf4cpp::rdf::Node;
+
+			static constexpr size_t no_column = std::numeric_limits<size_t>::max();
+
+			/**
+			 * A column of the evaluated solutions or, if column is no_column, a constant. A null constant stands for an unbound variable.
+			 */
+			struct Term {
+				size_t column = no_column;
+				Node constant;
+
+				[[nodiscard]] Node of(rdf_tensor::Entry const &entry) const noexcept {
+					return (column != no_column) ? Node(entry.key()[column]) : constant;
+				}
+			};
+
+			sparql2tensor::SPARQLQuery const &query_;
+			// the FILTER conjuncts that are checked per solution
+			std::vector<sparql2tensor::FilterExpression const *> filters_;
+			std::vector<char> eval_vars_id_;
+			// the term of each requested variable
+			std::vector<Term> requested_;
+			// the term of each variable of the FILTERs
+			std::vector<std::pair<Variable, Term>> filter_terms_;
+			bool extended_ = false;
+			bool identity_ = false;
+
+			Term term_of(Variable const &var) {
+				if (auto fixed = query_.fixed_variables_.find(var); fixed != query_.fixed_variables_.end())
+					return Term{.constant = fixed->second};
+				auto const var_id = query_.var_to_id_.find(var);
+				if (var_id == query_.var_to_id_.end())// the variable is never bound
+					return Term{};
+				auto const column = std::ranges::find(eval_vars_id_, var_id->second);
+				if (column != eval_vars_id_.end())
+					return Term{.column = static_cast<size_t>(std::distance(eval_vars_id_.begin(), column))};
+				eval_vars_id_.push_back(var_id->second);
+				return Term{.column = eval_vars_id_.size() - 1};
+			}
+
+		public:
+			/**
+			 * @param query the query
+			 * @param variables the requested variables
+			 * @param filters the FILTER conjuncts that are checked per solution
+			 */
+			SolutionProjection(sparql2tensor::SPARQLQuery const &query, std::vector<Variable> const &variables,
+							   std::vector<sparql2tensor::FilterExpression const *> filters)
+				: query_(query), filters_(std::move(filters)) {
+				requested_.reserve(variables.size());
+				for (auto const &var : variables)
+					requested_.push_back(term_of(var));
+				auto const requested_columns = eval_vars_id_.size();
+				std::vector<Variable> filter_vars;
+				for (auto const *filter : filters_)
+					filter->collect_variables(filter_vars);
+				for (auto const &var : filter_vars)
+					filter_terms_.emplace_back(var, term_of(var));
+				if (eval_vars_id_.empty() and not query.var_to_id_.empty()) {
+					// multiplicities are summed up by the contraction, so any single variable yields the number of solutions
+					eval_vars_id_.push_back(query.var_to_id_.begin()->second);
+				}
+				extended_ = eval_vars_id_.size() > requested_columns;
+				identity_ = not extended_ and requested_.size() == eval_vars_id_.size();
+				for (size_t i = 0; identity_ and i < requested_.size(); ++i)
+					identity_ = requested_[i].column == i;
+			}
+
+			/**
+			 * @return the variables that the evaluation projects to
+			 */
+			[[nodiscard]] std::vector<char> const &eval_vars_id() const noexcept {
+				return eval_vars_id_;
+			}
+
+			/**
+			 * @return true if the evaluation binds variables that are not requested. Then different solutions may have the same projection.
+			 */
+			[[nodiscard]] bool extended() const noexcept {
+				return extended_;
+			}
+
+			/**
+			 * @return true if the evaluated solutions are the requested solutions
+			 */
+			[[nodiscard]] bool identity() const noexcept {
+				return identity_;
+			}
+
+			/**
+			 * @return true if FILTER conjuncts are checked per solution
+			 */
+			[[nodiscard]] bool filtered() const noexcept {
+				return not filters_.empty();
+			}
+
+			[[nodiscard]] bool satisfies_filters(rdf_tensor::Entry const &entry) const {
+				sparql2tensor::FilterExpression::Binding const binding = [&](Variable const &var) -> Node {
+					for (auto const &[filter_var, term] : filter_terms_) {
+						if (filter_var == var)
+							return term.of(entry);
+					}
+					return {};
+				};
+				return std::ranges::all_of(filters_, [&](auto const *filter) { return filter->satisfied(binding); });
+			}
+
+			/**
+			 * @param entry an evaluated solution
+			 * @param projected is set to the solution with the requested variables
+			 */
+			void project(rdf_tensor::Entry const &entry, rdf_tensor::Entry &projected) const {
+				projected.key().resize(requested_.size());
+				for (size_t i = 0; i < requested_.size(); ++i)
+					projected.key()[i] = requested_[i].of(entry);
+				projected.value() = entry.value();
+			}
+		};
+
+		/**
+		 * A bounded queue between the threads of a parallel load.
+		 * After close(), push fails and pop returns the remaining items and then std::nullopt.
+		 */
+		template<typename T>
+		class LoadQueue {
+			std::mutex mutex_;
+			std::condition_variable cv_;
+			std::deque<T> items_;
+			size_t capacity_;
+			bool closed_ = false;
+
+		public:
+			explicit LoadQueue(size_t capacity) noexcept : capacity_(capacity) {}
+
+			/**
+			 * @return false if the queue was closed
+			 */
+			bool push(T &&item) {
+				std::unique_lock lock{mutex_};
+				cv_.wait(lock, [this]() { return closed_ or items_.size() < capacity_; });
+				if (closed_)
+					return false;
+				items_.push_back(std::move(item));
+				cv_.notify_all();
+				return true;
+			}
+
+			std::optional<T> pop() {
+				std::unique_lock lock{mutex_};
+				cv_.wait(lock, [this]() { return closed_ or not items_.empty(); });
+				if (items_.empty())
+					return std::nullopt;
+				auto item = std::move(items_.front());
+				items_.pop_front();
+				cv_.notify_all();
+				return item;
+			}
+
+			void close() {
+				std::unique_lock lock{mutex_};
+				closed_ = true;
+				cv_.notify_all();
+			}
+		};
+
+		using LoadedEntry = hypertrie::internal::raw::SingleEntry<3, rdf_tensor::htt_t>;
+
+		/**
+		 * Adds the terms that were staged while entries were parsed to the node storage, one lock per shard, and replaces their
+		 * staging IDs in entries by the persistent IDs.
+		 */
+		void intern_staged(node_store::TermStaging &staging, std::vector<LoadedEntry> &entries) {
+			if (staging.empty())
+				return;
+			staging.intern();
+			for (auto &entry : entries) {
+				for (auto &key_part : entry.key())
+					key_part = staging.persistent(key_part);
+			}
+			staging.clear();
+		}
+
+		/**
+		 * Parses RDF from a stream with a single parser and inserts its triples. New terms are interned in batches of triples.
+		 */
+		void load_sequential(std::istream &is,
+							 rdf_tensor::HypertrieBulkInserter &bulk_inserter,
+							 std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback) {
+			static constexpr size_t batch_size = 100'000;
+
+			node_store::TermStaging staging;
+			std::vector<LoadedEntry> parsed;
+			parsed.reserve(batch_size);
+			auto const flush = [&]() {
+				intern_staged(staging, parsed);
+				for (auto &entry : parsed)
+					bulk_inserter.add(std::move(entry));
+				parsed.clear();
+			};
+			{
+				node_store::TermStaging::Scope const staging_scope{staging};
+				for (rdf4cpp::rdf::parser::IStreamQuadIterator qit{is}; qit != std::default_sentinel; ++qit) {
+					if (qit->has_value()) {
+						auto const &quad = qit->value();
+						parsed.push_back(LoadedEntry{{quad.subject(), quad.predicate(), quad.object()}});
+						if (parsed.size() == batch_size)
+							flush();
+					} else {
+						error_callback(qit->error());
+					}
+				}
+			}
+			flush();
+		}
+
+		/**
+		 * Loads an N-Triples file with several parser threads. N-Triples has one triple per line and no prefixes, so the file is
+		 * read in blocks of whole lines that are parsed independently. The parser threads intern the new terms of each block
+		 * in bulk, concurrently with each other; the triples are inserted into the hypertrie by the calling thread.
+		 *
+		 * Each parser scopes the labels of blank nodes to its block, so a label that occurs in two blocks would become two blank
+		 * nodes. Therefore, the file is parsed by a single parser from the first block that contains a blank node label on.
+		 * Line numbers of parsing errors are relative to the block, or to that block for the rest of the file.
+		 */
+		void load_ntriples_parallel(std::ifstream &ifs,
+									size_t parser_threads,
+									rdf_tensor::HypertrieBulkInserter &bulk_inserter,
+									std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback) {
+			static constexpr size_t block_bytes = size_t(4) << 20;
+
+			LoadQueue<std::string> blocks{2 * parser_threads};
+			LoadQueue<std::vector<LoadedEntry>> entries{2 * parser_threads};
+			std::mutex error_mutex;
+			std::exception_ptr error;
+			auto const fail = [&](std::exception_ptr thread_error) {
+				{
+					std::unique_lock lock{error_mutex};
+					if (not error)
+						error = std::move(thread_error);
+				}
+				blocks.close();
+				entries.close();
+			};
+			std::atomic<size_t> running_parsers = parser_threads;
+			// the offset of the first block with a blank node label; the rest of the file is parsed sequentially from there
+			std::optional<std::streamoff> sequential_from;
+
+			std::vector<std::jthread> threads;
+			threads.reserve(parser_threads + 1);
+			threads.emplace_back([&]() {
+				try {
+					std::string carry;
+					// the offset of the first character of carry in the file
+					std::streamoff block_start = 0;
+					while (ifs) {
+						std::string block = std::move(carry);
+						carry = {};
+						auto const carried = block.size();
+						block.resize(carried + block_bytes);
+						ifs.read(block.data() + carried, static_cast<std::streamsize>(block_bytes));
+						block.resize(carried + static_cast<size_t>(ifs.gcount()));
+						if (ifs) {
+							// the last line continues in the next block
+							auto const last_newline = block.rfind('\n');
+							if (last_newline == std::string::npos) {
+								carry = std::move(block);
+								continue;
+							}
+							carry.assign(block, last_newline + 1);
+							block.resize(last_newline + 1);
+						}
+						// may also match within an IRI or a literal; then the file is parsed sequentially needlessly, but correctly
+						if (block.find("_:") != std::string::npos) {
+							sequential_from = block_start;
+							break;
+						}
+						block_start += static_cast<std::streamoff>(block.size());
+						if (not block.empty() and not blocks.push(std::move(block)))
+							return;
+					}
+					blocks.close();
+				} catch (...) {
+					fail(std::current_exception());
+				}
+			});
+			for (size_t parser = 0; parser < parser_threads; ++parser) {
+				threads.emplace_back([&]() {
+					try {
+						node_store::TermStaging staging;
+						node_store::TermStaging::Scope const staging_scope{staging};
+						while (auto block = blocks.pop()) {
+							std::vector<LoadedEntry> parsed;
+							std::istringstream iss{std::move(*block)};
+							for (rdf4cpp::rdf::parser::IStreamQuadIterator qit{iss}; qit != std::default_sentinel; ++qit) {
+								if (qit->has_value()) {
+									auto const &quad = qit->value();
+									parsed.push_back(LoadedEntry{{quad.subject(), quad.predicate(), quad.object()}});
+								} else {
+									std::unique_lock lock{error_mutex};
+									error_callback(qit->error());
+								}
+							}
+							intern_staged(staging, parsed);
+							if (not entries.push(std::move(parsed)))
+								return;
+						}
+						if (running_parsers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+							entries.close();
+					} catch (...) {
+						fail(std::current_exception());
+					}
+				});
+			}
+
+			try {
+				while (auto parsed = entries.pop()) {
+					for (auto &entry : *parsed)
+						bulk_inserter.add(std::move(entry));
+				}
+			} catch (...) {
+				fail(std::current_exception());
+			}
+			threads.clear();
+			if (error)
+				std::rethrow_exception(error);
+
+			if (sequential_from) {
+				ifs.clear();
+				ifs.seekg(*sequential_from);
+				load_sequential(ifs, bulk_inserter, error_callback);
+			}
+		}
+
+		rdf_tensor::BoolHypertrie make_scalar(rdf_tensor::HypertrieContext &context, bool value) {
+			rdf_tensor::BoolHypertrie scalar{0, rdf_tensor::HypertrieContext_ptr{&context}};
+			if (value)
+				scalar.set({}, true);
+			return scalar;
+		}
+
+		/**
+		 * The estimated matches of a property path and the estimated numbers of distinct nodes at which they start and end.
+		 */
+		struct PathEstimate {
+			double matches = 0;
+			double starts = 0;
+			double ends = 0;
+		};
+
+		// the number of repetitions of a path that the estimate of a closure follows
+		constexpr size_t closure_estimate_steps = 8;
+
+		/**
+		 * Estimates the matches of a property path from the statistics of its predicates, without following the path. Without
+		 * statistics, the matches of a predicate are counted on its slice and each is assumed to start and end at a node of its own.
+		 * @param nodes the estimated number of nodes of the dataset; a path of length zero connects each of them with itself
+		 */
+		PathEstimate estimate_path(sparql2tensor::PropertyPath const &path, rdf_tensor::BoolHypertrie const &hypertrie,
+								   DatasetStatistics const *statistics, double nodes) {
+			using Kind = sparql2tensor::PropertyPath::Kind;
+			switch (path.kind) {
+				case Kind::Link: {
+					rdf_tensor::NodeWrapper const predicate{path.iri};
+					if (statistics != nullptr) {
+						auto const *predicate_statistics = statistics->find(predicate);
+						if (predicate_statistics == nullptr)
+							return {};
+						return {double(predicate_statistics->triples), double(predicate_statistics->distinct_subjects),
+								double(predicate_statistics->distinct_objects)};
+					}
+					auto const matches = double(std::get<rdf_tensor::const_BoolHypertrie>(hypertrie[rdf_tensor::SliceKey{std::nullopt, predicate, std::nullopt}]).size());
+					return {matches, matches, matches};
+				}
+				case Kind::Inverse: {
+					auto const inverse = estimate_path(path.operands.front(), hypertrie, statistics, nodes);
+					return {inverse.matches, inverse.ends, inverse.starts};
+				}
+				case Kind::Sequence: {
+					auto sequence = estimate_path(path.operands.front(), hypertrie, statistics, nodes);
+					for (auto step = std::next(path.operands.begin()); step != path.operands.end(); ++step) {
+						auto const next = estimate_path(*step, hypertrie, statistics, nodes);
+						auto const matches = sequence.matches * next.matches / std::max({sequence.ends, next.starts, 1.0});
+						sequence = {matches, std::min(sequence.starts, matches), std::min(next.ends, matches)};
+					}
+					return sequence;
+				}
+				case Kind::Alternative: {
+					PathEstimate alternative;
+					for (auto const &operand : path.operands) {
+						auto const estimate = estimate_path(operand, hypertrie, statistics, nodes);
+						alternative.matches += estimate.matches;
+						alternative.starts += estimate.starts;
+						alternative.ends += estimate.ends;
+					}
+					alternative.starts = std::min(alternative.starts, nodes);
+					alternative.ends = std::min(alternative.ends, nodes);
+					return alternative;
+				}
+				default: {
+					auto estimate = estimate_path(path.operands.front(), hypertrie, statistics, nodes);
+					if (path.kind != Kind::ZeroOrOne and estimate.starts > 0) {
+						// each start reaches the nodes of a few repetitions, but not more than all ends
+						auto const fanout = estimate.matches / estimate.starts;
+						double reached = 0;
+						double step = 1;
+						for (size_t repetition = 0; repetition < closure_estimate_steps; ++repetition) {
+							step *= fanout;
+							reached += step;
+						}
+						estimate.matches = estimate.starts * std::min(reached, estimate.ends);
+					}
+					if (path.kind != Kind::OneOrMore)
+						estimate = {estimate.matches + nodes, nodes, nodes};
+					return estimate;
+				}
+			}
+		}
+	}// namespace
+
+	TripleStore::TripleStore(TripleStore::BoolHypertrie &hypertrie)
+		: hypertrie_(hypertrie),
+		  shared_context_(scratch_heap_.make_context()),
+		  true_operand_(make_scalar(*shared_context_, true)),
+		  false_operand_(make_scalar(*shared_context_, false)),
+		  empty_operands_{BoolHypertrie{1, HypertrieContext_ptr{shared_context_.get()}},
+						  BoolHypertrie{2, HypertrieContext_ptr{shared_context_.get()}},
+						  BoolHypertrie{3, HypertrieContext_ptr{shared_context_.get()}}} {}
+
+	void TripleStore::enable_parallel_evaluation(tf::Executor &executor, ParallelEvaluationCfg const &cfg) {
+		executor_ = &executor;
+		parallel_cfg_ = cfg;
+	}
+
+	void TripleStore::set_statistics(DatasetStatistics const &statistics) noexcept {
+		statistics_ = &statistics;
+		statistics_generation_ = generation();
+	}
 
 	void TripleStore::load_ttl(std::string const &file_path, uint32_t bulk_size,
 							   rdf_tensor::HypertrieBulkInserter::BulkInserted_callback const &call_back,
-							   std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback) {
-		std::ifstream ifs{file_path};
+							   std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback,
+							   size_t parser_threads) {
+		std::ifstream ifs{file_path, std::ios::binary};
 
 		if (!ifs.is_open()) {
 			throw std::runtime_error{"unable to open provided file " + file_path};
 		}
 
-		HypertrieBulkInserter bulk_inserter{hypertrie_, bulk_size, call_back};
-		for (rdf4cpp::rdf::parser::IStreamQuadIterator qit{ifs}; qit != std::default_sentinel; ++qit) {
-			if (qit->has_value()) {
-				auto const &quad = qit->value();
-				bulk_inserter.add(
-						hypertrie::internal::raw::SingleEntry<3, htt_t>{{quad.subject(), quad.predicate(), quad.object()}});
+		{
+			HypertrieBulkInserter bulk_inserter{hypertrie_, bulk_size, call_back};
+			if (parser_threads > 1 and std::filesystem::path{file_path}.extension() == ".nt") {
+				load_ntriples_parallel(ifs, parser_threads, bulk_inserter, error_callback);
 			} else {
-				error_callback(qit->error());
+				load_sequential(ifs, bulk_inserter, error_callback);
 			}
-		}
+		}// the bulk inserter flushes the remaining entries when it is destroyed
+		generation_.fetch_add(1, std::memory_order_acq_rel);
 	}
 
 	bool TripleStore::is_rdf_list(rdf4cpp::rdf::Node list) const noexcept {
@@ -62,18 +1194,18 @@ namespace dice::triple_store {
 		std::vector<Node> node_vector;
 		auto head = list;
 		while (head != rdf_nil) {
-			auto element = std::get<0>(hypertrie_[rdf_tensor::SliceKey{list, rdf_first, std::nullopt}]);
+			auto element = std::get<0>(hypertrie_[rdf_tensor::SliceKey{head, rdf_first, std::nullopt}]);
 			if (element.size() > 1)
-				throw std::runtime_error("Invalid RDF seq. Multiple first elements for list node {}" + std::string(head));
+				throw std::runtime_error("Invalid RDF seq. Multiple first elements for list node " + std::string(head));
 			if (element.empty())
-				throw std::runtime_error("Invalid RDF seq. No first elements for list node {}" + std::string(head));
+				throw std::runtime_error("Invalid RDF seq. No first elements for list node " + std::string(head));
 
 			node_vector.push_back((*element.begin())[0]);
-			auto rest = std::get<0>(hypertrie_[rdf_tensor::SliceKey{list, rdf_rest, std::nullopt}]);
+			auto rest = std::get<0>(hypertrie_[rdf_tensor::SliceKey{head, rdf_rest, std::nullopt}]);
 			if (rest.size() > 1) {
-				throw std::runtime_error("Invalid RDF seq. Multiple rest elements for list node {}" + std::string(head));
+				throw std::runtime_error("Invalid RDF seq. Multiple rest elements for list node " + std::string(head));
 			} else if (rest.size() == 1) {
-				head = (*element.begin())[0];
+				head = (*rest.begin())[0];
 			} else /* rest.size() == 0 */ {
 
 				head = rdf_nil;// this is not canonical but seems better than throwing an error
@@ -85,21 +1217,21 @@ namespace dice::triple_store {
 	/**
 	 * @brief Generates the tensor operands of a query
 	 * @param slice_keys The slice keys corresponding to the query being evaluated
+	 * @param true_operand the depth-0 operand used for triple patterns without variables that are in rdf_tensor
+	 * @param false_operand the depth-0 operand used for triple patterns without variables that are not in rdf_tensor
 	 * @return A vector of tensor operands (const_BoolHypertries).
 	 */
-	std::vector<rdf_tensor::const_BoolHypertrie> generate_operands(rdf_tensor::BoolHypertrie rdf_tensor, std::vector<rdf_tensor::SliceKey> const &slice_keys) {
+	std::vector<rdf_tensor::const_BoolHypertrie> generate_operands(rdf_tensor::BoolHypertrie const &rdf_tensor, std::vector<rdf_tensor::SliceKey> const &slice_keys,
+																   rdf_tensor::const_BoolHypertrie const &true_operand, rdf_tensor::const_BoolHypertrie const &false_operand) {
 		using const_BoolHypertrie = rdf_tensor::const_BoolHypertrie;
-		using BoolHypertrie = rdf_tensor::BoolHypertrie;
 
 		std::vector<const_BoolHypertrie> operands;
+		operands.reserve(slice_keys.size());
 		for (auto const &slice_key : slice_keys) {
 			auto slice_result = rdf_tensor[slice_key];
 			if (slice_key.get_fixed_depth() == 3) {
-				auto entry_exists = std::get<bool>(slice_result);
-				BoolHypertrie ht_0{0, rdf_tensor.context()};
-				if (entry_exists)
-					ht_0.set({}, true);
-				operands.push_back(ht_0);
+				// the scalars are shared, so a lookup does not allocate a new scalar
+				operands.push_back(std::get<bool>(slice_result) ? true_operand : false_operand);
 			} else {
 				auto operand = std::get<const_BoolHypertrie>(slice_result);
 				operands.push_back(std::move(operand));
@@ -108,59 +1240,436 @@ namespace dice::triple_store {
 		return operands;
 	}
 
-	const std::vector<rdf_tensor::const_BoolHypertrie> &TripleStore::get_query_operands(const rdf_tensor::BoolHypertrie &rdf_tensor, const std::vector<rdf_tensor::SliceKey> &slice_keys) {
-		query_operands_ = generate_operands(rdf_tensor, slice_keys);
-		return query_operands_;
+	std::vector<rdf_tensor::const_BoolHypertrie> TripleStore::get_query_operands(const rdf_tensor::BoolHypertrie &rdf_tensor, const std::vector<rdf_tensor::SliceKey> &slice_keys) const {
+		return generate_operands(rdf_tensor, slice_keys, true_operand_, false_operand_);
+	}
+	TripleStore::HypertrieContext_ptr TripleStore::query_context(std::shared_ptr<HypertrieContext> &context) const {
+		if (not context)
+			context = scratch_heap_.make_context();
+		return HypertrieContext_ptr{context.get()};
+	}
+	rdf_tensor::const_BoolHypertrie TripleStore::empty_operand(size_t depth, std::shared_ptr<HypertrieContext> &context) const {
+		if (depth == 0)
+			return false_operand_;
+		if (depth <= empty_operands_.size())
+			return empty_operands_[depth - 1];
+		return BoolHypertrie{depth, query_context(context)};
+	}
+	QueryOperands TripleStore::get_query_operands(const sparql2tensor::SPARQLQuery &query,
+												  std::chrono::steady_clock::time_point endtime) const {
+		QueryOperands query_operands;
+		auto &operands = query_operands.operands;
+		operands = generate_operands(hypertrie_, query.get_slice_keys(), true_operand_, false_operand_);
+		// a VALUES block is a table with one dimension per variable; the whole block is joined in a single evaluation
+		for (auto const &values : query.values_) {
+			BoolHypertrie table{values.variables.size(), query_context(query_operands.context)};
+			Key key;
+			key.reserve(values.variables.size());
+			for (auto const &row : values.rows) {
+				key.clear();
+				for (auto const &value : row)
+					key.push_back(value);
+				table.set(key, true);
+			}
+			operands.push_back(std::move(table));
+		}
+		// a property path pattern is materialized as a table of its matches with one dimension per variable
+		PropertyPathEvaluator const path_evaluator{hypertrie_, endtime};
+		for (auto const &path_pattern : query.path_patterns_) {
+			auto const depth = path_pattern.variables().size();
+			if (depth == 0) {
+				operands.push_back(path_evaluator.matches(path_pattern.subject, path_pattern.path, path_pattern.object) ? true_operand_ : false_operand_);
+				continue;
+			}
+			BoolHypertrie table{depth, query_context(query_operands.context)};
+			path_evaluator.evaluate(path_pattern, table);
+			operands.push_back(std::move(table));
+		}
+		return query_operands;
+	}
+	QueryEstimate TripleStore::estimate(const sparql2tensor::SPARQLQuery &query) const {
+		std::vector<OperandEstimate> operands;
+		operands.reserve(query.triple_patterns_.size() + query.values_.size() + query.path_patterns_.size());
+		auto const *statistics = this->statistics();
+		auto const &slice_keys = query.get_slice_keys();
+		for (size_t tp = 0; tp < slice_keys.size(); ++tp) {
+			auto const &slice_key = slice_keys[tp];
+			auto const &var_ids = query.odg_.operand_var_ids(tp);
+			auto &operand = operands.emplace_back();
+			// a constant that is not in the dataset has no match
+			if (std::ranges::any_of(slice_key, [](auto const &term) { return term and rdf_tensor::is_transient(*term); }))
+				continue;
+			if (statistics != nullptr) {
+				// the statistics answer in O(1) without touching the hypertrie
+				operand.matches = statistics->estimate_matches(slice_key);
+				auto const *predicate_statistics = (slice_key[1]) ? statistics->find(*slice_key[1]) : nullptr;
+				std::array<double, 3> const distinct{
+						double((predicate_statistics != nullptr) ? predicate_statistics->distinct_subjects : statistics->distinct_subjects()),
+						double(statistics->distinct_predicates()),
+						double((predicate_statistics != nullptr) ? predicate_statistics->distinct_objects : statistics->distinct_objects())};
+				auto var_id = var_ids.begin();
+				for (size_t position = 0; position < distinct.size(); ++position) {
+					if (not slice_key[position])
+						operand.add_variable(*var_id++, distinct[position]);
+				}
+			} else if (slice_key.get_fixed_depth() == 3) {
+				operand.matches = std::get<bool>(hypertrie_[slice_key]) ? 1 : 0;
+			} else {
+				auto const slice = std::get<const_BoolHypertrie>(hypertrie_[slice_key]);
+				operand.matches = double(slice.size());
+				std::vector<size_t> positions(slice.depth());
+				std::iota(positions.begin(), positions.end(), size_t(0));
+				auto const cards = slice.get_cards(positions);
+				for (size_t position = 0; position < positions.size(); ++position)
+					operand.add_variable(var_ids[position], double(cards[position]));
+			}
+		}
+		// subject stars are estimated from the characteristic sets: mandatory triple patterns with a constant predicate that share
+		// their subject variable and whose objects are variables that no other triple pattern of the star has
+		std::vector<StarEstimate> stars;
+		if (statistics != nullptr) {
+			std::vector<std::pair<rdf4cpp::rdf::Node, std::vector<size_t>>> subject_stars;
+			for (auto const tp : query.mandatory_operands_) {
+				auto const &triple_pattern = query.triple_patterns_[tp];
+				if (not triple_pattern.subject().is_variable() or triple_pattern.predicate().is_variable() or
+					not triple_pattern.object().is_variable() or triple_pattern.object() == triple_pattern.subject())
+					continue;
+				auto star = std::ranges::find(subject_stars, triple_pattern.subject(), &decltype(subject_stars)::value_type::first);
+				if (star == subject_stars.end())
+					star = subject_stars.insert(subject_stars.end(), {triple_pattern.subject(), {}});
+				if (std::ranges::none_of(star->second, [&](size_t other) { return query.triple_patterns_[other].object() == triple_pattern.object(); }))
+					star->second.push_back(tp);
+			}
+			bool const all_sets_stored = statistics->characteristic_sets().size() == statistics->total_characteristic_sets();
+			std::vector<rdf_tensor::NodeWrapper> predicates;
+			for (auto &[subject, star_operands] : subject_stars) {
+				if (star_operands.size() < 2)
+					continue;
+				predicates.clear();
+				for (auto const tp : star_operands)
+					predicates.emplace_back(query.triple_patterns_[tp].predicate());
+				auto const solutions = statistics->estimate_star(predicates);
+				// a star that is missing from the stored sets is estimated from its triple patterns
+				if (solutions > 0 or all_sets_stored)
+					stars.push_back({std::move(star_operands), solutions});
+			}
+		}
+		robin_hood::unordered_set<rdf_tensor::key_part_type, dice::hash::DiceHashMartinus<rdf_tensor::key_part_type>> column_values;
+		for (auto const &values : query.values_) {
+			auto const &var_ids = query.odg_.operand_var_ids(operands.size());
+			auto &operand = operands.emplace_back();
+			operand.matches = double(values.rows.size());
+			for (size_t column = 0; column < values.variables.size(); ++column) {
+				column_values.clear();
+				for (auto const &row : values.rows)
+					column_values.insert(row[column]);
+				operand.add_variable(var_ids[column], double(column_values.size()));
+			}
+		}
+		// property paths are estimated without following them
+		auto const nodes = (statistics != nullptr) ? double(statistics->distinct_subjects() + statistics->distinct_objects())
+												   : 2.0 * double(hypertrie_.size());
+		for (auto const &path_pattern : query.path_patterns_) {
+			auto const &var_ids = query.odg_.operand_var_ids(operands.size());
+			auto &operand = operands.emplace_back();
+			auto const path = estimate_path(path_pattern.path, hypertrie_, statistics, nodes);
+			bool const subject_variable = path_pattern.subject.is_variable();
+			bool const object_variable = path_pattern.object.is_variable();
+			// a constant keeps the matches of one start or end node
+			operand.matches = path.matches;
+			if (not subject_variable)
+				operand.matches /= std::max(path.starts, 1.0);
+			if (not object_variable)
+				operand.matches /= std::max(path.ends, 1.0);
+			if (subject_variable and path_pattern.subject == path_pattern.object)
+				operand.matches /= std::max({path.starts, path.ends, 1.0});
+			if (var_ids.empty()) {
+				// the probability that the path connects subject and object
+				operand.matches = std::min(operand.matches, 1.0);
+				continue;
+			}
+			if (subject_variable)
+				operand.add_variable(var_ids.front(), path.starts);
+			if (object_variable)
+				operand.add_variable(var_ids.back(), path.ends);
+		}
+		return QueryEstimate{query, std::move(operands), std::move(stars)};
+	}
+	QueryOperands TripleStore::get_profiled_query_operands(const sparql2tensor::SPARQLQuery &query,
+														   std::chrono::steady_clock::time_point endtime,
+														   EvaluationProfile *profile) const {
+		if (profile == nullptr)
+			return get_query_operands(query, endtime);
+		auto const start_time = std::chrono::steady_clock::now();
+		auto query_operands = get_query_operands(query, endtime);
+		profile->slicing += std::chrono::steady_clock::now() - start_time;
+		profile->operand_sizes.clear();
+		for (auto const &operand : query_operands.operands)
+			profile->operand_sizes.push_back(operand.size());
+		return query_operands;
 	}
-	std::generator<rdf_tensor::Entry const &> TripleStore::eval_select(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime,
-		const std::vector<std::string> &query_plan) const {
 
-		auto operands = generate_operands(hypertrie_, query.get_slice_keys());
-		std::vector<char> proj_vars_id{};
-		for (auto const &proj_var : query.projected_variables_) {
-			proj_vars_id.push_back(query.var_to_id_.at(proj_var));
+	bool TripleStore::has_empty_mandatory_operand(const sparql2tensor::SPARQLQuery &query) const {
+		if (std::ranges::any_of(query.values_, [](auto const &values) { return values.rows.empty(); }))
+			return true;
+		if (query.mandatory_operands_.empty())
+			return false;
+		auto const &slice_keys = query.get_slice_keys();
+		// constants that are not in the dataset are transient; they are found without slicing
+		for (auto const operand : query.mandatory_operands_) {
+			for (auto const &term : slice_keys[operand]) {
+				if (term and rdf_tensor::is_transient(*term))
+					return true;
+			}
+		}
+		for (auto const operand : query.mandatory_operands_) {
+			auto const &slice_key = slice_keys[operand];
+			// terms that are not in the dataset have no entry in the hypertrie, so the slice fails at the first lookup
+			if (slice_key.get_fixed_depth() == 3) {
+				if (not std::get<bool>(hypertrie_[slice_key]))
+					return true;
+			} else if (slice_key.get_fixed_depth() != 0) {
+				if (std::get<const_BoolHypertrie>(hypertrie_[slice_key]).empty())
+					return true;
+			} else if (hypertrie_.empty()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::generator<rdf_tensor::Entry const &> TripleStore::eval_select(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime,
+		const std::vector<std::string> &query_plan, EvaluationProfile *profile) const {
+		if (query.count_) {
+			SolutionSlice slice{query};
+			if (slice.take(1) == 0)
+				co_return;
+			rdf_tensor::Entry entry;
+			entry.key().resize(1);
+			entry.key()[0] = rdf4cpp::rdf::Literal::make_typed(std::to_string(eval_count(query, endtime)),
+															   rdf4cpp::rdf::IRI("http://www.w3.org/2001/XMLSchema#integer"));
+			co_yield entry;
+			co_return;
 		}
-		rdf_tensor::Query q{query.odg_, operands, proj_vars_id, endtime};
 
 		// Add query plan variables as hints
+		std::vector<char> hint_vars_id;
 		for (const auto &var_name : query_plan) {
 			auto var = rdf4cpp::rdf::query::Variable::make_named(var_name);
-			q.add_query_hint_variable(query.var_to_id_.at(var));
+			hint_vars_id.push_back(query.var_to_id_.at(var));
 		}
 
-		if (query.distinct_) {
-			rdf_tensor::Entry entry;
-			entry.key().resize(query.projected_variables_.size());
-			for (auto const &distinct_entry : dice::query::Evaluation::evaluate<htt_t, allocator_type, true>(q)) {
-				std::copy(distinct_entry.key().begin(), distinct_entry.key().end(), entry.key().begin());
+		// the evaluation is not resumed once the LIMIT is reached
+		SolutionSlice slice{query};
+		if (slice.exhausted())
+			co_return;
+		// a partition never needs to provide more solutions than OFFSET + LIMIT
+		auto const max_solutions = (query.limit_) ? query.offset_ + std::min(*query.limit_, std::numeric_limits<size_t>::max() - query.offset_)
+												  : std::numeric_limits<size_t>::max();
+		// the first solutions in the ORDER BY are only known once all solutions are evaluated
+		bool const ordered = not query.order_by_.empty();
+		auto solutions = evaluate_solutions(query, query.projected_variables_, query.distinct_, std::move(hint_vars_id),
+											(ordered) ? std::numeric_limits<size_t>::max() : max_solutions, endtime, profile);
+		std::optional<SolutionSorter> sorter;
+		if (ordered) {
+			// with a LIMIT, only the first OFFSET + LIMIT solutions in the order are kept
+			sorter.emplace(query.order_by_, query.projected_variables_,
+						   (query.limit_) ? std::optional<size_t>{max_solutions} : std::nullopt, sort_memory_budget_);
+			for (auto const &entry : solutions)
+				sorter->add(entry);
+			solutions = sorter->sorted();
+		}
+
+		rdf_tensor::Entry sliced_entry;
+		for (auto const &entry : solutions) {
+			auto const multiplicity = slice.take(entry.value());
+			if (multiplicity == size_t(entry.value())) {
 				co_yield entry;
+			} else if (multiplicity != 0) {
+				// only a part of the copies of this solution is within OFFSET and LIMIT
+				sliced_entry = entry;
+				sliced_entry.value() = multiplicity;
+				co_yield sliced_entry;
 			}
-		} else {
-			for (auto const &entry : dice::query::Evaluation::evaluate<htt_t, allocator_type>(q)) {
+			if (slice.exhausted())
+				co_return;
+		}
+	}
+	std::generator<rdf_tensor::Entry const &> TripleStore::evaluate_solutions(sparql2tensor::SPARQLQuery const &query,
+																				std::vector<rdf4cpp::rdf::query::Variable> variables,
+																				bool distinct,
+																				std::vector<char> hint_vars_id,
+																				size_t max_solutions,
+																				std::chrono::steady_clock::time_point endtime,
+																				EvaluationProfile *profile) const {
+		auto query_operands = get_profiled_query_operands(query, endtime, profile);
+		auto const restriction_start = std::chrono::steady_clock::now();
+		auto restriction = restrict_filtered_variables(query, query_operands, scratch_heap_, filter_scan_limit_, endtime);
+		if (profile != nullptr) {
+			profile->slicing += std::chrono::steady_clock::now() - restriction_start;
+			for (size_t operand = profile->operand_sizes.size(); operand < query_operands.operands.size(); ++operand)
+				profile->operand_sizes.push_back(query_operands.operands[operand].size());
+		}
+		auto const &odg = (restriction.odg) ? *restriction.odg : query.odg_;
+		auto &operands = query_operands.operands;
+		SolutionProjection const projection{query, variables, std::move(restriction.checked_filters)};
+		rdf_tensor::Entry projected;
+		if (projection.eval_vars_id().empty()) {
+			// no variables: there is one solution if all triple patterns match
+			rdf_tensor::Query q{odg, operands, {}, endtime};
+			rdf_tensor::Entry entry;
+			entry.value() = 1;
+			if (profile != nullptr)
+				profile->partitions = 1;
+			if (dice::query::Evaluation::evaluate_ask<htt_t, allocator_type>(q)) {
+				if (profile != nullptr)
+					++profile->joined_entries;
+				if (projection.satisfies_filters(entry)) {
+					if (profile != nullptr)
+						++profile->selected_entries;
+					projection.project(entry, projected);
+					co_yield projected;
+				}
+			}
+			co_return;
+		}
+
+		rdf_tensor::Query q{odg, operands, projection.eval_vars_id(), endtime};
+		for (auto const var_id : hint_vars_id)
+			q.add_query_hint_variable(var_id);
+		bool const filtered = projection.filtered();
+		// solutions that are filtered out or merged by the projection do not count towards the LIMIT
+		if (filtered or (distinct and projection.extended()))
+			max_solutions = std::numeric_limits<size_t>::max();
+		std::shared_ptr<PartitionedQuery> partitioned;
+		if (executor_ != nullptr) {
+			partitioned = partition_union(query, query_operands, [this](size_t depth, auto &context) { return empty_operand(depth, context); }, projection.eval_vars_id(), hint_vars_id, distinct, max_solutions, endtime);
+			if (not partitioned)
+				partitioned = partition_query(query, odg, query_operands, scratch_heap_, projection.eval_vars_id(), hint_vars_id, distinct, max_solutions, endtime,
+											  parallel_cfg_.max_partitions, parallel_cfg_.min_cardinality, parallel_cfg_.max_domain_scan);
+		}
+		bool const deduplicate = distinct and (projection.extended() or (partitioned and not partitioned->disjoint));
+		if (profile != nullptr)
+			profile->partitions = (partitioned) ? partitioned->partitions() : 1;
+		auto solutions = (partitioned) ? evaluate_partitioned(std::move(partitioned), *executor_) : evaluate_sequential(q, distinct);
+		if (not filtered and not deduplicate and projection.identity()) {
+			for (auto const &entry : solutions) {
+				if (profile != nullptr) {
+					++profile->joined_entries;
+					++profile->selected_entries;
+				}
 				co_yield entry;
 			}
+			co_return;
+		}
+
+		robin_hood::unordered_set<rdf_tensor::Key, dice::hash::DiceHashMartinus<rdf_tensor::Key>> seen;
+		for (auto const &entry : solutions) {
+			if (profile != nullptr)
+				++profile->joined_entries;
+			// the FILTERs are checked before the solution is projected, sliced or serialized
+			if (filtered and not projection.satisfies_filters(entry))
+				continue;
+			if (not projection.identity())
+				projection.project(entry, projected);
+			auto const &solution = (projection.identity()) ? entry : projected;
+			if (deduplicate and not seen.insert(solution.key()).second)
+				continue;
+			if (profile != nullptr)
+				++profile->selected_entries;
+			co_yield solution;
 		}
 	}
-	bool TripleStore::eval_ask(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime) const {
-		auto operands = generate_operands(hypertrie_, query.get_slice_keys());
+
+	bool TripleStore::eval_ask(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime, EvaluationProfile *profile) const {
+		if (has_empty_mandatory_operand(query))
+			return false;
+		if (not query.filters_.empty()) {
+			// the first solution that satisfies the FILTERs answers the query
+			auto solutions = evaluate_solutions(query, {}, true, {}, 1, endtime, profile);
+			return solutions.begin() != solutions.end();
+		}
+		auto query_operands = get_profiled_query_operands(query, endtime, profile);
+		auto &operands = query_operands.operands;
+		if (executor_ != nullptr) {
+			// the UNION branch that finds a solution first answers the query. The branches enumerate solutions of all variables instead of
+			// answering ASK queries, so that they can be cancelled between two solutions.
+			std::vector<char> var_ids;
+			for (auto const &[var, var_id] : query.var_to_id_)
+				var_ids.push_back(var_id);
+			if (auto partitioned = partition_union(query, query_operands, [this](size_t depth, auto &context) { return empty_operand(depth, context); }, var_ids, {}, false, 1, endtime)) {
+				if (profile != nullptr)
+					profile->partitions = partitioned->partitions();
+				return evaluate_ask_partitioned(std::move(partitioned), *executor_);
+			}
+		}
+		if (profile != nullptr)
+			profile->partitions = 1;
 		rdf_tensor::Query q{query.odg_, operands, {}, endtime};
 		return dice::query::Evaluation::evaluate_ask<htt_t, allocator_type>(q);
 	}
 	size_t TripleStore::count(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime) const {
 		using namespace sparql2tensor;
-		if (query.triple_patterns_.size() == 1) {// O(1)
-			auto slice_key = query.get_slice_keys()[0];
+		if (query.count_) // a single row with the aggregate
+			return SolutionSlice{query}.count(1);
+		if (query.triple_patterns_.size() == 1 and query.filters_.empty() and query.values_.empty() and query.path_patterns_.empty()) {// O(1)
+			SolutionSlice const slice{query};
+			auto const &slice_key = query.get_slice_keys()[0];
 			if (slice_key.get_fixed_depth() == 3)
-				return static_cast<size_t>(std::get<bool>(get_hypertrie()[slice_key]));
+				return slice.count(static_cast<size_t>(std::get<bool>(get_hypertrie()[slice_key])));
 			else
-				return std::get<const_BoolHypertrie>(get_hypertrie()[slice_key]).size();
+				return slice.count(std::get<const_BoolHypertrie>(get_hypertrie()[slice_key]).size());
 		} else {
+			if (has_empty_mandatory_operand(query))
+				return 0;
 			size_t count = 0;
 			for (auto const &entry : this->eval_select(query, endtime))
 				count += entry.value();
 			return count;
 		}
 	}
+	size_t TripleStore::eval_count(const sparql2tensor::SPARQLQuery &query, std::chrono::steady_clock::time_point endtime) const {
+		if (not query.count_)
+			throw std::runtime_error{"Query has no COUNT aggregate."};
+		auto const &aggregate = *query.count_;
+		if (has_empty_mandatory_operand(query))
+			return 0;
+
+		std::vector<rdf4cpp::rdf::query::Variable> variables;
+		if (aggregate.variable) {
+			if (not query.var_to_id_.contains(*aggregate.variable) and not query.fixed_variables_.contains(*aggregate.variable))// the variable is never bound
+				return 0;
+			variables.push_back(*aggregate.variable);
+		} else if (aggregate.distinct) {
+			// distinct solutions are distinct bindings of all variables; the fixed variables have the same binding in all of them
+			for (auto const &[var, var_id] : query.var_to_id_) {
+				if (not var.is_anonymous())
+					variables.push_back(var);
+			}
+		}
+
+		if (not aggregate.distinct and query.triple_patterns_.size() == 1 and query.filters_.empty() and query.values_.empty() and query.path_patterns_.empty() and
+			query.get_slice_keys().front().get_fixed_depth() != 3) {
+			// the number of solutions of a single triple pattern without repeated variables is the size of its slice
+			auto const &tp = query.triple_patterns_.front();
+			bool const repeated_variable = (tp.subject().is_variable() and (tp.subject() == tp.predicate() or tp.subject() == tp.object())) or
+										   (tp.predicate().is_variable() and tp.predicate() == tp.object());
+			if (not repeated_variable)
+				return std::get<const_BoolHypertrie>(hypertrie_[query.get_slice_keys().front()]).size();
+		}
+
+		bool const counts_variable = aggregate.variable.has_value();
+		size_t count = 0;
+		// distinct solutions have multiplicity 1
+		for (auto const &entry : evaluate_solutions(query, std::move(variables), aggregate.distinct, {}, std::numeric_limits<size_t>::max(), endtime)) {
+			// COUNT(?x) only counts the solutions that bind ?x, e.g., not those in which an OPTIONAL left it unbound
+			if (counts_variable and entry.key()[0].null())
+				continue;
+			count += entry.value();
+		}
+		return count;
+	}
+
 	bool TripleStore::contains(const rdf4cpp::rdf::Statement &statement) const {
 		return hypertrie_[Key{statement.subject(), statement.predicate(), statement.object()}];
 	}
@@ -6,12 +6,64 @@
 
 #include <dice/sparql2tensor/SPARQLQuery.hpp>
 
+#include <dice/triple-store/DatasetStatistics.hpp>
+#include <dice/triple-store/QueryEstimate.hpp>
+#include <dice/triple-store/ScratchHeap.hpp>
+
 #ifndef BOOST_BIND_GLOBAL_PLACEHOLDERS
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
 #endif
 #include <metall/metall.hpp>
 
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace tf {
+	class Executor;
+}// namespace tf
+
 namespace dice::triple_store {
+
+	/**
+	 * Configuration of the parallel evaluation of single queries.
+	 */
+	struct ParallelEvaluationCfg {
+		// maximum number of partitions a query is split into; 0 or 1 disables the parallel evaluation
+		size_t max_partitions = 0;
+		// queries whose smallest triple pattern has fewer matches, or that need fewer solutions because of a LIMIT, are evaluated sequentially
+		size_t min_cardinality = 100'000;
+		// the domain of the partitioned variable is read from an operand with at most this many entries; otherwise, the query is evaluated sequentially
+		size_t max_domain_scan = 1'000'000;
+	};
+
+	/**
+	 * Measurements of the evaluation of one query. They are only taken if a profile is passed to eval_select or eval_ask.
+	 */
+	struct EvaluationProfile {
+		// time spent computing the operands, including the matches of VALUES blocks and property paths and the operands that restrict
+		// the variables of FILTERs
+		std::chrono::steady_clock::duration slicing{};
+		// the number of entries of each operand in the order of get_query_operands, followed by the operands that restrict the variables of FILTERs
+		std::vector<size_t> operand_sizes;
+		// the number of partitions the query was split into; 1 if it was evaluated sequentially
+		size_t partitions = 0;
+		// the entries that the join yielded, i.e., before FILTERs, projection and DISTINCT
+		size_t joined_entries = 0;
+		// the entries that are left after FILTERs, projection and DISTINCT, i.e., before ORDER BY, OFFSET and LIMIT
+		size_t selected_entries = 0;
+	};
+
+	/**
+	 * The operands of a query. Those that are computed for the query, i.e., the tables of VALUES blocks and the matches of property
+	 * paths, are allocated in context, which is not persistent. The operands are destroyed before it.
+	 */
+	struct QueryOperands {
+		// nullptr if no operand was computed for the query
+		std::shared_ptr<rdf_tensor::HypertrieContext> context;
+		std::vector<rdf_tensor::const_BoolHypertrie> operands;
+	};
+
 	class TripleStore {
 		using HypertrieContext = rdf_tensor::HypertrieContext;
 		using HypertrieContext_ptr = rdf_tensor::HypertrieContext_ptr;
@@ -28,16 +80,162 @@ namespace dice::triple_store {
 
 	private:
 		BoolHypertrie &hypertrie_;
-		std::vector<const_BoolHypertrie> query_operands_;
+		// holds the hypertries that are computed for queries, so answering a query never writes to the persistent heap of hypertrie_
+		ScratchHeap scratch_heap_;
+		// the context of the shared operands below
+		std::shared_ptr<HypertrieContext> shared_context_;
+		// shared depth-0 operands of triple patterns without variables, created once instead of per query
+		const_BoolHypertrie true_operand_;
+		const_BoolHypertrie false_operand_;
+		// shared empty operands of depth 1 to 3, which stand in for the operands of UNION branches that a partition does not evaluate
+		std::array<const_BoolHypertrie, 3> empty_operands_;
+		// incremented whenever the content of hypertrie_ changes
+		std::atomic<uint64_t> generation_{0};
+		// executes the partitions of queries that are evaluated in parallel; nullptr if the parallel evaluation is disabled
+		tf::Executor *executor_ = nullptr;
+		ParallelEvaluationCfg parallel_cfg_;
+		// the number of solutions of an ORDER BY without LIMIT that are sorted in memory before they are spilled to a temporary file
+		size_t sort_memory_budget_ = 1'000'000;
+		// variables of FILTER conjuncts are restricted before the join if their smallest operand has at most this many entries
+		size_t filter_scan_limit_ = 1'000'000;
+		// persistent statistics of hypertrie_; nullptr if there are none
+		DatasetStatistics const *statistics_ = nullptr;
+		// the generation at which statistics_ was set
+		uint64_t statistics_generation_ = 0;
+
+		/**
+		 * Evaluates the graph pattern of a query and yields the solutions that satisfy its FILTERs, projected to variables.
+		 * Variables that a FILTER fixes to a constant are bound to it.
+		 * @param query The parsed SPARQL query.
+		 * @param variables the variables of the yielded solutions
+		 * @param distinct if the yielded solutions are distinct; then each has multiplicity 1
+		 * @param hint_vars_id variables that the query planner should prefer
+		 * @param max_solutions the evaluation may stop after this many solutions
+		 * @param endtime The timeout value
+		 * @param profile if not nullptr, the evaluation is measured into it
+		 * @return A generator yielding the solutions
+		 */
+		std::generator<rdf_tensor::Entry const &>
+		evaluate_solutions(sparql2tensor::SPARQLQuery const &query,
+						   std::vector<rdf4cpp::rdf::query::Variable> variables,
+						   bool distinct,
+						   std::vector<char> hint_vars_id,
+						   size_t max_solutions,
+						   std::chrono::steady_clock::time_point endtime,
+						   EvaluationProfile *profile = nullptr) const;
+
+		/**
+		 * @param context the context of the operands that are computed for a query; it is created if it is nullptr
+		 * @return a pointer to context
+		 */
+		HypertrieContext_ptr query_context(std::shared_ptr<HypertrieContext> &context) const;
+
+		/**
+		 * @param depth the depth of the operand
+		 * @param context the context of the operands that are computed for a query; it is only used, and created if it is nullptr,
+		 * if there is no shared empty operand of depth
+		 * @return an operand of depth without entries
+		 */
+		[[nodiscard]] const_BoolHypertrie empty_operand(size_t depth, std::shared_ptr<HypertrieContext> &context) const;
+
+		/**
+		 * Like get_query_operands, but measures the time it takes and the sizes of the operands into profile.
+		 * @param profile may be nullptr; then nothing is measured
+		 */
+		[[nodiscard]] QueryOperands get_profiled_query_operands(sparql2tensor::SPARQLQuery const &query,
+																std::chrono::steady_clock::time_point endtime,
+																EvaluationProfile *profile) const;
 
 	public:
+		/**
+		 * @param hypertrie the indexed triples
+		 * @throws std::runtime_error if the scratch heap for query operands cannot be created in the temporary directory
+		 */
 		explicit TripleStore(BoolHypertrie &hypertrie);
 
 		[[nodiscard]] BoolHypertrie const &get_hypertrie() const {
 			return hypertrie_;
 		}
 
-		const std::vector<const_BoolHypertrie> &get_query_operands(const rdf_tensor::BoolHypertrie &rdf_tensor, const std::vector<rdf_tensor::SliceKey> &slice_keys);
+		/**
+		 * The generation changes whenever data is loaded into the store. Results computed at one generation are not valid at another.
+		 * A result is valid if the generation read before computing it still equals the current generation.
+		 * @return the current generation
+		 */
+		[[nodiscard]] uint64_t generation() const noexcept {
+			return generation_.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * Enables the parallel evaluation of single queries in eval_select, eval_ask, count and eval_count.
+		 * The branches of a top-level UNION are evaluated as separate tasks on the executor; for ASK, the first branch with a solution answers the query.
+		 * Otherwise, the domain of one join variable is split into partitions, which are evaluated as tasks. Queries with OPTIONAL and
+		 * queries whose smallest triple pattern has fewer matches than cfg.min_cardinality are not partitioned. Neither are queries with a
+		 * LIMIT below cfg.min_cardinality and no ORDER BY, nor queries whose domain would have to be read from more than cfg.max_domain_scan
+		 * entries, because the domain is read before the first solution.
+		 * @param executor executes the partitions. It must outlive this triple store.
+		 * @param cfg the number of partitions, the minimum cardinality and the maximum domain scan
+		 */
+		void enable_parallel_evaluation(tf::Executor &executor, ParallelEvaluationCfg const &cfg);
+
+		/**
+		 * Sets how many solutions of an ORDER BY without LIMIT are sorted in memory. Beyond that, sorted runs are spilled to temporary
+		 * files and merged. With a LIMIT, only OFFSET + LIMIT solutions are held.
+		 * @param solutions the number of solutions held in memory
+		 */
+		void set_sort_memory_budget(size_t solutions) noexcept {
+			sort_memory_budget_ = solutions;
+		}
+
+		/**
+		 * Sets how many entries an operand may have at most to restrict the variable of FILTER conjuncts that test a single variable,
+		 * e.g., FILTER(?age > 18). The values of the variable in its smallest operand are checked once each before the join, and only
+		 * those that satisfy the conjuncts are joined. Otherwise, the conjuncts are checked per solution.
+		 * @param entries the maximum number of entries that are scanned per variable; 0 checks all conjuncts per solution
+		 */
+		void set_filter_scan_limit(size_t entries) noexcept {
+			filter_scan_limit_ = entries;
+		}
+
+		/**
+		 * Makes statistics that were built for the hypertrie of this triple store available via statistics().
+		 * @param statistics the statistics. They must outlive this triple store.
+		 */
+		void set_statistics(DatasetStatistics const &statistics) noexcept;
+
+		/**
+		 * @return the statistics of the dataset; nullptr if none were set or if data was loaded since, so they are outdated
+		 */
+		[[nodiscard]] DatasetStatistics const *statistics() const noexcept {
+			return (statistics_ != nullptr and statistics_generation_ == generation()) ? statistics_ : nullptr;
+		}
+
+		/**
+		 * @param rdf_tensor the hypertrie that is sliced
+		 * @param slice_keys the slice keys of the triple patterns
+		 * @return the operands of the triple patterns
+		 */
+		[[nodiscard]] std::vector<const_BoolHypertrie> get_query_operands(const rdf_tensor::BoolHypertrie &rdf_tensor, const std::vector<rdf_tensor::SliceKey> &slice_keys) const;
+
+		/**
+		 * @param query The parsed SPARQL query.
+		 * @param endtime The timeout value for computing the matches of property paths
+		 * @return all operands of the query: the slices of its triple patterns followed by the tables of its VALUES blocks and the
+		 * matches of its property path patterns. The tables are allocated in a context of the scratch heap, not in the persistent heap.
+		 * @throws std::runtime_error if the endtime is reached while the property paths are evaluated
+		 */
+		[[nodiscard]] QueryOperands get_query_operands(const sparql2tensor::SPARQLQuery &query,
+													   std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max()) const;
+
+		/**
+		 * Estimates the solutions of a query without building its operands. With up-to-date statistics, triple patterns and subject
+		 * stars are estimated from them in O(1) each; otherwise, triple patterns are counted on slices of the stored hypertrie, which are
+		 * views. A VALUES block is estimated from its rows instead of being built as a table. Property paths are estimated from the
+		 * statistics of their predicates, or from the sizes of their slices if there are no statistics; they are not followed.
+		 * @param query The parsed SPARQL query.
+		 * @return the estimate
+		 */
+		[[nodiscard]] QueryEstimate estimate(const sparql2tensor::SPARQLQuery &query) const;
 
 		/**
 		 * This function enforces stricter requirements upon rdf:Lists than described in <a href="https://www.w3.org/TR/2014/REC-rdf11-mt-20140225/#rdf-containers">D.3 RDF collections</a>.
@@ -63,37 +261,76 @@ namespace dice::triple_store {
 		 * @param file_path path to the file
 		 * @param bulk_size number of entries to insert at once
 		 * @param call_back function to call when a bulk is inserted
-		 * @param error_callback function to call when an error is encountered in the file
+		 * @param error_callback function to call when an error is encountered in the file. Calls are serialized.
+		 * @param parser_threads number of threads that parse an N-Triples file (extension .nt) and intern its terms concurrently.
+		 * Other files are parsed by the calling thread. From the first block with a blank node label on, an N-Triples file is parsed by
+		 * the calling thread, too, so each label is one blank node throughout the file.
+		 * With more than one thread, line numbers of parsing errors are relative to the block of the file that was parsed.
 		 */
 		void load_ttl(
 				std::string const &file_path,
 				uint32_t bulk_size = 1'000'000,
 				HypertrieBulkInserter::BulkInserted_callback const &call_back = [](size_t, size_t, size_t) -> void {},
-				std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback = [](rdf_tensor::parser::ParsingError const &) -> void {});
+				std::function<void(rdf_tensor::parser::ParsingError const &)> const &error_callback = [](rdf_tensor::parser::ParsingError const &) -> void {},
+				size_t parser_threads = 1);
+
+		/**
+		 * @brief Checks cheaply whether a query trivially has no solution.
+		 * That is the case if a mandatory triple pattern has no match, e.g., because it contains a term that is not in the dataset.
+		 * Such terms are transient (see rdf_tensor::is_transient) and are detected without slicing. Otherwise, only the operands
+		 * are sliced; the query is neither planned nor evaluated.
+		 * @param query The parsed SPARQL query.
+		 * @return true if the query has no solution. false if it might have solutions.
+		 */
+		[[nodiscard]] bool has_empty_mandatory_operand(const sparql2tensor::SPARQLQuery &query) const;
 
 		/**
 		 * @brief Evaluation of SPARQL SELECT queries.
+		 * For a COUNT aggregate, a single solution is yielded that binds the count.
 		 * @param query The parsed SPARQL query.
 		 * @param endtime The timeout value
+		 * @param query_plan the names of the variables that the evaluation should prefer, in order
+		 * @param profile if not nullptr, the evaluation is measured into it; it must outlive the iteration. COUNT aggregates are not measured.
 		 * @return A generator yielding the solutions of the query
 		 */
 		std::generator<rdf_tensor::Entry const &>
 		eval_select(const sparql2tensor::SPARQLQuery &query,
 					std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max(),
-					const std::vector<std::string> &query_plan = {}) const;
+					const std::vector<std::string> &query_plan = {},
+					EvaluationProfile *profile = nullptr) const;
 
 		/**
 		 * @brief Evaluation of SPARQL ASK queries.
 		 * @param query The parsed SPARQL query.
 		 * @param endtime The timeout value
+		 * @param profile if not nullptr, the evaluation is measured into it
 		 * @return The result of the ask query (true or false).
 		 */
 		bool eval_ask(const sparql2tensor::SPARQLQuery &query,
-					  std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max()) const;
+					  std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max(),
+					  EvaluationProfile *profile = nullptr) const;
 
+		/**
+		 * @brief Counts the solutions of a query, i.e., the number of rows eval_select yields.
+		 * @param query The parsed SPARQL query.
+		 * @param endtime The timeout value
+		 * @return The number of solutions.
+		 */
 		size_t count(const sparql2tensor::SPARQLQuery &query,
 					 std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max()) const;
 
+		/**
+		 * @brief Evaluates the COUNT aggregate of a query.
+		 * The solutions are contracted to at most the counted variable and summed up by multiplicity; full solutions are not materialized.
+		 * COUNT(?x) skips solutions in which ?x is unbound.
+		 * @param query The parsed SPARQL query. query.count_ must be set.
+		 * @param endtime The timeout value
+		 * @return The value of the aggregate.
+		 * @throws std::runtime_error If the query has no COUNT aggregate.
+		 */
+		size_t eval_count(const sparql2tensor::SPARQLQuery &query,
+						  std::chrono::steady_clock::time_point endtime = std::chrono::steady_clock::time_point::max()) const;
+
 		bool contains(const rdf4cpp::rdf::Statement &statement) const;
 
 		[[nodiscard]] size_t size() const;
@@ -0,0 +1,258 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <dice/sparql2tensor/SPARQLQuery.hpp>
+
+/*
+ * Differential tests of the hand-written parser for plain basic graph pattern queries (SPARQLQuery::parse_bgp) against the
+ * ANTLR parser (SPARQLQuery::parse_with_grammar). Every query of the corpus is in the subset of the hand-written parser, and
+ * both parsers must produce the same query.
+ * Further, tests of which FILTER conjuncts the parser rewrites into constants of the triple patterns.
+ */
+
+namespace dice::sparql2tensor {
+
+	namespace {
+		std::vector<std::string> const corpus{
+				// projections and modifiers
+				"SELECT ?s WHERE { ?s ?p ?o }",
+				"SELECT ?o ?s WHERE { ?s ?p ?o . }",
+				"select distinct ?s where { ?s ?p ?o }",
+				"SELECT * WHERE { ?s ?p ?o . ?o ?q ?s }",
+				"SELECT DISTINCT * { ?s <http://example.com/p> ?o }",
+				"SELECT ?x ?s WHERE { ?s ?p ?o }",
+				"SELECT ?s ?s WHERE { ?s ?p ?o }",
+				"SELECT $s WHERE { $s ?p ?o }",
+				"SELECT ?s WHERE { ?s ?p ?o } LIMIT 10",
+				"SELECT ?s WHERE { ?s ?p ?o } OFFSET 5",
+				"SELECT ?s WHERE { ?s ?p ?o } LIMIT 10 OFFSET 5",
+				"SELECT ?s WHERE { ?s ?p ?o } OFFSET 5 LIMIT 10",
+				"ASK { ?s ?p ?o }",
+				"ASK WHERE { <http://example.com/s> ?p ?o }",
+				"SELECT (COUNT(*) AS ?count) WHERE { ?s ?p ?o }",
+				"SELECT (COUNT(?s) AS ?count) WHERE { ?s ?p ?o }",
+				"SELECT (COUNT(DISTINCT ?o) AS ?c) WHERE { ?s ?p ?o }",
+				"SELECT (count(distinct *) AS ?c) WHERE { ?s ?p ?o }",
+				// abbreviations and comments
+				"SELECT ?s WHERE { ?s a <http://example.com/C> }",
+				"SELECT ?s ?o WHERE { ?s <http://example.com/p> ?o ; <http://example.com/q> ?o2 , ?o3 . }",
+				"SELECT ?s WHERE { ?s <http://example.com/p> ?o ;; <http://example.com/q> ?o ; . }",
+				"SELECT ?s # the subject\nWHERE {\n\t?s ?p ?o . # any triple\n}",
+				// prefixes
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex:o }",
+				"PREFIX : <http://example.com/> SELECT ?s WHERE { ?s :p :o }",
+				"PREFIX ex: <http://example.com/> PREFIX ex: <http://example.org/> SELECT ?s WHERE { ?s ex:p ?o }",
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p.q ex:o.}",
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex:1 }",
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex:a:b }",
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex:a%20b }",
+				"PREFIX ex: <http://example.com/a/../b/> SELECT ?s WHERE { ?s ex:p ex:c }",
+				"PREFIX ex: <http://example.com/#> SELECT ?s WHERE { ?s ex:p ex:o }",
+				"PREFIX dbo: <http://dbpedia.org/ontology/> PREFIX rdfs: <http://www.w3.org/2000/01/rdf-schema#> "
+				"SELECT ?label WHERE { ?s a dbo:City ; rdfs:label ?label }",
+				// literal quoting
+				R"(SELECT ?s WHERE { ?s ?p "plain" })",
+				R"(SELECT ?s WHERE { ?s ?p 'single' })",
+				R"(SELECT ?s WHERE { ?s ?p "" })",
+				R"(SELECT ?s WHERE { ?s ?p '' })",
+				R"(SELECT ?s WHERE { ?s ?p """long "quoted" string""" })",
+				R"(SELECT ?s WHERE { ?s ?p '''long 'quoted' string''' })",
+				R"(SELECT ?s WHERE { ?s ?p """""" })",
+				"SELECT ?s WHERE { ?s ?p \"\"\"multi\nline\"\"\" }",
+				R"(SELECT ?s WHERE { ?s ?p "es\"caped" })",
+				R"(SELECT ?s WHERE { ?s ?p "tab\tand\\backslash" })",
+				R"(SELECT ?s WHERE { ?s ?p "with # hash" })",
+				R"(SELECT ?s WHERE { ?s ?p "with } brace" })",
+				// language tags and datatypes
+				R"(SELECT ?s WHERE { ?s ?p "chat"@fr })",
+				R"(SELECT ?s WHERE { ?s ?p "colour"@en-GB })",
+				R"(SELECT ?s WHERE { ?s ?p "x"@EN })",
+				R"(SELECT ?s WHERE { ?s ?p "1"^^<http://www.w3.org/2001/XMLSchema#integer> })",
+				R"(SELECT ?s WHERE { ?s ?p "x"^^<http://www.w3.org/2001/XMLSchema#string> })",
+				R"(PREFIX xsd: <http://www.w3.org/2001/XMLSchema#> SELECT ?s WHERE { ?s ?p "2020-01-01"^^xsd:date })",
+				R"(PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ?p "x"^^ex:type })",
+				// numbers
+				"SELECT ?s WHERE { ?s ?p 1 }",
+				"SELECT ?s WHERE { ?s ?p 1. }",
+				"SELECT ?s WHERE { ?s ?p 0042 }",
+				"SELECT ?s WHERE { ?s ?p +1 }",
+				"SELECT ?s WHERE { ?s ?p -1 }",
+				"SELECT ?s WHERE { ?s ?p 1.5 }",
+				"SELECT ?s WHERE { ?s ?p .5 }",
+				"SELECT ?s WHERE { ?s ?p -.5 }",
+				"SELECT ?s WHERE { ?s ?p +1.50 }",
+				"SELECT ?s WHERE { ?s ?p 1e3 }",
+				"SELECT ?s WHERE { ?s ?p 1E3 }",
+				"SELECT ?s WHERE { ?s ?p 1.5e-3 }",
+				"SELECT ?s WHERE { ?s ?p -2.5E+10 }",
+				"SELECT ?s WHERE { ?s ?p 1 , 1.0 , 1e0 }",
+				// booleans
+				"SELECT ?s WHERE { ?s ?p true }",
+				"SELECT ?s WHERE { ?s ?p false . ?s ?q true }",
+		};
+
+		/**
+		 * Queries that the hand-written parser must leave to the ANTLR parser.
+		 */
+		std::vector<std::string> const unsupported{
+				"SELECT ?s WHERE { ?s ?p ?o OPTIONAL { ?o ?q ?r } }",
+				"SELECT ?s WHERE { ?s ?p ?o FILTER(?o = 1) }",
+				"SELECT ?s WHERE { ?s ?p ?o } ORDER BY ?s",
+				"SELECT ?s WHERE { ?s ?p _:b }",
+				"SELECT ?s WHERE { ?s ?p [] }",
+				"SELECT ?s WHERE { ?s ex:p ?o }",
+				"PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex: }",
+				R"(PREFIX ex: <http://example.com/> SELECT ?s WHERE { ?s ex:p ex:a\.b })",
+				"SELECT ?s WHERE { ?s ?p 1.e5 }",
+				"SELECT ?s WHERE { ?s <http://example.com/p>* ?o }",
+				"SELECT ?s WHERE { ?s ?p ?o VALUES ?s { <http://example.com/s> } }",
+				"ASK { ?s ?p ?o } LIMIT 1",
+				"SELECT ?s WHERE { }",
+				"BASE <http://example.com/> SELECT ?s WHERE { ?s <p> ?o }",
+		};
+
+		void check_same(SPARQLQuery const &bgp, SPARQLQuery const &grammar) {
+			CHECK(bgp.triple_patterns_ == grammar.triple_patterns_);
+			CHECK(bgp.var_to_id_ == grammar.var_to_id_);
+			CHECK(bgp.projected_variables_ == grammar.projected_variables_);
+			CHECK(bgp.mandatory_operands_ == grammar.mandatory_operands_);
+			CHECK(bgp.distinct_ == grammar.distinct_);
+			CHECK(bgp.ask_ == grammar.ask_);
+			CHECK(bgp.project_all_variables_ == grammar.project_all_variables_);
+			CHECK(bgp.limit_ == grammar.limit_);
+			CHECK(bgp.offset_ == grammar.offset_);
+			REQUIRE(bgp.count_.has_value() == grammar.count_.has_value());
+			if (bgp.count_) {
+				CHECK(bgp.count_->variable == grammar.count_->variable);
+				CHECK(bgp.count_->distinct == grammar.count_->distinct);
+			}
+			CHECK(bgp.get_slice_keys() == grammar.get_slice_keys());
+			CHECK(grammar.filters_.empty());
+			CHECK(grammar.values_.empty());
+			CHECK(grammar.path_patterns_.empty());
+			CHECK(grammar.union_branches_.empty());
+		}
+	}// namespace
+
+	TEST_SUITE("SPARQL parser") {
+		TEST_CASE("the hand-written parser and the ANTLR parser produce the same query") {
+			for (auto const &query : corpus) {
+				CAPTURE(query);
+				auto const bgp = SPARQLQuery::parse_bgp(query);
+				REQUIRE(bgp.has_value());
+				auto const grammar = SPARQLQuery::parse_with_grammar(query);
+				check_same(*bgp, grammar);
+			}
+		}
+
+		TEST_CASE("numbers get the datatype of their syntax") {
+			auto const query = SPARQLQuery::parse_bgp("SELECT ?s WHERE { ?s ?p 1 , -1.5 , 1e3 , true }");
+			REQUIRE(query.has_value());
+			REQUIRE(query->triple_patterns_.size() == 4);
+			std::vector<std::string_view> const datatypes{
+					"http://www.w3.org/2001/XMLSchema#integer",
+					"http://www.w3.org/2001/XMLSchema#decimal",
+					"http://www.w3.org/2001/XMLSchema#double",
+					"http://www.w3.org/2001/XMLSchema#boolean"};
+			for (size_t i = 0; i < datatypes.size(); ++i) {
+				auto const object = query->triple_patterns_[i].object();
+				REQUIRE(object.is_literal());
+				CHECK(object.as_literal().datatype().identifier() == datatypes[i]);
+			}
+		}
+
+		TEST_CASE("literals are unquoted") {
+			auto const query = SPARQLQuery::parse_bgp(R"(SELECT ?s WHERE { ?s ?p "a" , 'b' , """c "d" e""" , '''''' , "f"@en })");
+			REQUIRE(query.has_value());
+			std::vector<std::string_view> const lexical_forms{"a", "b", R"(c "d" e)", "", "f"};
+			REQUIRE(query->triple_patterns_.size() == lexical_forms.size());
+			for (size_t i = 0; i < lexical_forms.size(); ++i)
+				CHECK(query->triple_patterns_[i].object().as_literal().lexical_form() == lexical_forms[i]);
+		}
+
+		TEST_CASE("queries outside of the basic graph pattern subset are left to the ANTLR parser") {
+			for (auto const &query : unsupported) {
+				CAPTURE(query);
+				CHECK_FALSE(SPARQLQuery::parse_bgp(query).has_value());
+			}
+		}
+
+		TEST_CASE("parse falls back to the ANTLR parser") {
+			auto const query = SPARQLQuery::parse("SELECT ?s WHERE { ?s ?p ?o FILTER(?o = 1) }");
+			CHECK(query.filters_.size() == 1);
+		}
+	}
+
+	TEST_SUITE("FILTER rewriting") {
+		// ?o = term holds exactly for the solutions that bind ?o to term, so ?o is replaced by term
+		TEST_CASE("= with an IRI or a plain string fixes the variable") {
+			rdf4cpp::rdf::query::Variable const o{"o"};
+			std::vector<std::pair<std::string, rdf4cpp::rdf::Node>> const cases{
+					{"SELECT ?s WHERE { ?s ?p ?o FILTER(?o = <http://example.com/x>) }", rdf4cpp::rdf::IRI{"http://example.com/x"}},
+					{"SELECT ?s WHERE { ?s ?p ?o FILTER(<http://example.com/x> = ?o) }", rdf4cpp::rdf::IRI{"http://example.com/x"}},
+					{R"(SELECT ?s WHERE { ?s ?p ?o FILTER(?o = "x") })", rdf4cpp::rdf::Literal::make_simple("x")},
+			};
+			for (auto const &[query_str, term] : cases) {
+				CAPTURE(query_str);
+				SPARQLQuery const query{query_str};
+				CHECK(query.filters_.empty());
+				REQUIRE(query.fixed_variables_.contains(o));
+				CHECK(query.fixed_variables_.at(o) == term);
+			}
+		}
+
+		// equal numbers or strings with language tags that differ in case may be different terms, so = must be checked per value
+		TEST_CASE("= with a numeric, boolean or language-tagged constant is not rewritten") {
+			std::vector<std::string> const queries{
+					"SELECT ?s WHERE { ?s ?p ?o FILTER(?o = 1) }",
+					"SELECT ?s WHERE { ?s ?p ?o FILTER(?o = 1.0) }",
+					R"(SELECT ?s WHERE { ?s ?p ?o FILTER(?o = "1"^^<http://www.w3.org/2001/XMLSchema#integer>) })",
+					"SELECT ?s WHERE { ?s ?p ?o FILTER(?o = true) }",
+					R"(SELECT ?s WHERE { ?s ?p ?o FILTER(?o = "chat"@fr) })",
+					R"(SELECT ?s WHERE { ?s ?p ?o FILTER("chat"@fr = ?o) })",
+			};
+			for (auto const &query_str : queries) {
+				CAPTURE(query_str);
+				SPARQLQuery const query{query_str};
+				CHECK(query.fixed_variables_.empty());
+				CHECK(query.filters_.size() == 1);
+			}
+		}
+
+		TEST_CASE("sameTerm fixes the variable to any constant") {
+			rdf4cpp::rdf::query::Variable const o{"o"};
+			std::vector<std::pair<std::string, rdf4cpp::rdf::Node>> const cases{
+					{"SELECT ?s WHERE { ?s ?p ?o FILTER(sameTerm(?o, <http://example.com/x>)) }", rdf4cpp::rdf::IRI{"http://example.com/x"}},
+					{R"(SELECT ?s WHERE { ?s ?p ?o FILTER(sameTerm(?o, "chat"@fr)) })", rdf4cpp::rdf::Literal::make_lang_tagged("chat", "fr")},
+					{R"(SELECT ?s WHERE { ?s ?p ?o FILTER(sameTerm(?o, "1"^^<http://www.w3.org/2001/XMLSchema#integer>)) })",
+					 rdf4cpp::rdf::Literal::make_typed("1", rdf4cpp::rdf::IRI{"http://www.w3.org/2001/XMLSchema#integer"})},
+			};
+			for (auto const &[query_str, term] : cases) {
+				CAPTURE(query_str);
+				SPARQLQuery const query{query_str};
+				CHECK(query.filters_.empty());
+				REQUIRE(query.fixed_variables_.contains(o));
+				CHECK(query.fixed_variables_.at(o) == term);
+			}
+		}
+
+		// an unbound variable fails the FILTER, while a constant in the OPTIONAL would only drop the optional part
+		TEST_CASE("a FILTER on a variable of an OPTIONAL is not rewritten") {
+			SPARQLQuery const query{"SELECT ?s WHERE { ?s ?p ?o OPTIONAL { ?s ?q ?x } FILTER(?x = <http://example.com/x>) }"};
+			CHECK(query.fixed_variables_.empty());
+			CHECK(query.filters_.size() == 1);
+		}
+
+		TEST_CASE("a FILTER on a variable of a VALUES block is not rewritten") {
+			SPARQLQuery const query{"SELECT ?s WHERE { ?s ?p ?o VALUES ?o { <http://example.com/x> <http://example.com/y> } FILTER(?o = <http://example.com/x>) }"};
+			CHECK(query.fixed_variables_.empty());
+			CHECK(query.filters_.size() == 1);
+		}
+	}
+
+}// namespace dice::sparql2tensor
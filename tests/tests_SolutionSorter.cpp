@@ -0,0 +1,119 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dice/triple-store/SolutionSorter.hpp>
+
+/*
+ * Tests of the SolutionSorter against a full sort in memory: the bounded heap for OFFSET + LIMIT, and the sorted runs that are
+ * spilled to temporary files and merged.
+ */
+
+namespace dice::triple_store {
+
+	namespace {
+		using Entry = rdf_tensor::Entry;
+		using Variable = rdf4cpp::rdf::query::Variable;
+
+		std::vector<Variable> const variables{Variable{"n"}, Variable{"s"}};
+		// ?s is unique, so the order is total
+		std::vector<sparql2tensor::OrderCondition> const order_by{{.variable = Variable{"n"}, .descending = false},
+																  {.variable = Variable{"s"}, .descending = true}};
+
+		/**
+		 * @return solutions with few distinct values of ?n, unique values of ?s and multiplicities 1 to 3
+		 */
+		std::vector<Entry> make_solutions(size_t count) {
+			rdf4cpp::rdf::IRI const xsd_integer{"http://www.w3.org/2001/XMLSchema#integer"};
+			std::vector<Entry> solutions;
+			for (size_t i = 0; i < count; ++i) {
+				Entry entry;
+				entry.key().resize(2);
+				entry.key()[0] = rdf4cpp::rdf::Literal::make_typed(std::to_string((i * 7919) % 37), xsd_integer);
+				entry.key()[1] = rdf4cpp::rdf::IRI{"http://example.com/" + std::to_string(i)};
+				entry.value() = i % 3 + 1;
+				solutions.push_back(std::move(entry));
+			}
+			return solutions;
+		}
+
+		/**
+		 * @return each solution repeated by its multiplicity, as its terms
+		 */
+		std::vector<std::vector<std::string>> expand(auto &&solutions) {
+			std::vector<std::vector<std::string>> rows;
+			for (auto const &entry : solutions) {
+				std::vector<std::string> row;
+				for (auto const &term : entry.key())
+					row.push_back(std::string(term));
+				for (size_t copy = 0; copy < size_t(entry.value()); ++copy)
+					rows.push_back(row);
+			}
+			return rows;
+		}
+
+		/**
+		 * @return the solutions sorted in memory by the ORDER BY, each repeated by its multiplicity
+		 */
+		std::vector<std::vector<std::string>> sort_in_memory(std::vector<Entry> solutions) {
+			std::ranges::sort(solutions, [](Entry const &lhs, Entry const &rhs) {
+				for (size_t column = 0; column < order_by.size(); ++column) {
+					auto const order = sparql2tensor::TermSortKey::of(lhs.key()[column]).compare(sparql2tensor::TermSortKey::of(rhs.key()[column]));
+					if (order != 0)
+						return (order_by[column].descending) ? order > 0 : order < 0;
+				}
+				return false;
+			});
+			return expand(solutions);
+		}
+
+		std::vector<std::vector<std::string>> sort_with_sorter(std::vector<Entry> const &solutions, std::optional<size_t> max_solutions, size_t memory_budget) {
+			SolutionSorter sorter{order_by, variables, max_solutions, memory_budget};
+			for (auto const &entry : solutions)
+				sorter.add(entry);
+			return expand(sorter.sorted());
+		}
+	}// namespace
+
+	TEST_SUITE("SolutionSorter") {
+		TEST_CASE("the bounded heap yields the first solutions of the order for OFFSET + LIMIT") {
+			auto const solutions = make_solutions(1'000);
+			auto const expected = sort_in_memory(solutions);
+			for (size_t const offset : {size_t(0), size_t(1), size_t(100)}) {
+				for (size_t const limit : {size_t(0), size_t(1), size_t(10), size_t(57), expected.size() + 10}) {
+					CAPTURE(offset);
+					CAPTURE(limit);
+					auto const sorted = sort_with_sorter(solutions, offset + limit, 1'000'000);
+					auto const end = std::min(offset + limit, expected.size());
+					// whole solutions are yielded, so the last one may have more copies than needed
+					REQUIRE(sorted.size() >= end);
+					CHECK(std::vector(sorted.begin() + std::min(offset, end), sorted.begin() + end) ==
+						  std::vector(expected.begin() + std::min(offset, end), expected.begin() + end));
+				}
+			}
+		}
+
+		TEST_CASE("spilled runs are merged into the order") {
+			// each run is a temporary file, so small budgets are only used with few solutions
+			std::vector<std::pair<size_t, size_t>> const solutions_and_budgets{
+					{200, 1}, {200, 7}, {5'000, 50}, {5'000, 999}, {5'000, 5'000}, {5'000, 1'000'000}};
+			for (auto const &[count, memory_budget] : solutions_and_budgets) {
+				CAPTURE(count);
+				CAPTURE(memory_budget);
+				auto const solutions = make_solutions(count);
+				CHECK(sort_with_sorter(solutions, std::nullopt, memory_budget) == sort_in_memory(solutions));
+			}
+		}
+
+		TEST_CASE("no solutions are sorted into nothing") {
+			CHECK(sort_with_sorter({}, std::nullopt, 10).empty());
+			CHECK(sort_with_sorter({}, 10, 10).empty());
+		}
+	}
+
+}// namespace dice::triple_store
@@ -0,0 +1,335 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <dice/node-store/PersistentNodeStorageBackend.hpp>
+#include <dice/triple-store/TripleStore.hpp>
+
+/*
+ * Tests of loading and evaluating queries with a TripleStore on small datasets.
+ */
+
+namespace dice::triple_store {
+
+	namespace {
+		namespace fs = std::filesystem;
+		using metall_manager = rdf_tensor::metall_manager;
+
+		/**
+		 * The node storage and the heap of the hypertries of all tests. The node storage is the default one of the process, so it
+		 * is shared by all stores and lives as long as the process.
+		 */
+		class Storage {
+			fs::path directory_ = fs::temp_directory_path() / ("tentris_tests_" + std::to_string(::getpid()));
+			std::unique_ptr<metall_manager> manager_;
+			std::atomic<size_t> next_file_ = 0;
+
+			Storage() {
+				using namespace rdf4cpp::rdf::storage::node;
+				fs::remove_all(directory_);
+				fs::create_directories(directory_);
+				manager_ = std::make_unique<metall_manager>(metall::create_only, (directory_ / "storage").c_str());
+				auto *nodestore_backend = manager_->construct<node_store::PersistentNodeStorageBackendImpl>(metall::anonymous_instance)(manager_->get_allocator());
+				NodeStorage::set_default_instance(NodeStorage::new_instance<node_store::PersistentNodeStorageBackend>(nodestore_backend));
+			}
+
+		public:
+			~Storage() {
+				manager_.reset();
+				std::error_code ignored;
+				fs::remove_all(directory_, ignored);
+			}
+
+			static Storage &instance() {
+				static Storage storage;
+				return storage;
+			}
+
+			metall_manager &manager() noexcept { return *manager_; }
+
+			/**
+			 * @return a path for a new file with the extension
+			 */
+			fs::path file(std::string_view extension) {
+				return directory_ / ("file_" + std::to_string(next_file_++) + std::string{extension});
+			}
+		};
+
+		/**
+		 * A triple store with the triples of an N-Triples document.
+		 */
+		class TestStore {
+			rdf_tensor::HypertrieContext *context_;
+			rdf_tensor::BoolHypertrie *hypertrie_;
+			std::optional<TripleStore> triplestore_;
+
+		public:
+			/**
+			 * @param ntriples the triples
+			 * @param parser_threads see TripleStore::load_ttl
+			 */
+			explicit TestStore(std::string_view ntriples, size_t parser_threads = 1) {
+				auto &storage = Storage::instance();
+				auto &manager = storage.manager();
+				context_ = manager.construct<rdf_tensor::HypertrieContext>(metall::anonymous_instance)(manager.get_allocator());
+				hypertrie_ = manager.construct<rdf_tensor::BoolHypertrie>(metall::anonymous_instance)(3, rdf_tensor::HypertrieContext_ptr{context_});
+				triplestore_.emplace(*hypertrie_);
+				auto const file = storage.file(".nt");
+				std::ofstream{file} << ntriples;
+				triplestore_->load_ttl(file.string(), 1'000'000, [](size_t, size_t, size_t) {}, [](rdf_tensor::parser::ParsingError const &) {},
+									   parser_threads);
+				fs::remove(file);
+			}
+
+			TestStore(TestStore const &) = delete;
+			TestStore &operator=(TestStore const &) = delete;
+
+			~TestStore() {
+				triplestore_.reset();
+				auto &manager = Storage::instance().manager();
+				manager.destroy_ptr(hypertrie_);
+				manager.destroy_ptr(context_);
+			}
+
+			rdf_tensor::BoolHypertrie const &hypertrie() const noexcept { return *hypertrie_; }
+
+			TripleStore &operator*() noexcept { return *triplestore_; }
+			TripleStore *operator->() noexcept { return &*triplestore_; }
+
+			/**
+			 * @return the solutions of a SELECT query, each as the terms of its projected variables; unbound variables are empty
+			 */
+			std::vector<std::vector<std::string>> select(std::string const &query) {
+				sparql2tensor::SPARQLQuery const parsed{query};
+				std::vector<std::vector<std::string>> solutions;
+				for (auto const &entry : triplestore_->eval_select(parsed)) {
+					std::vector<std::string> solution;
+					for (auto const &term : entry.key())
+						solution.push_back(term.null() ? std::string{} : std::string(term));
+					for (size_t copy = 0; copy < size_t(entry.value()); ++copy)
+						solutions.push_back(solution);
+				}
+				return solutions;
+			}
+		};
+
+		/**
+		 * @return lines of N-Triples without blank nodes, of about 80 bytes each
+		 */
+		std::string filler(size_t first, size_t lines) {
+			std::string out;
+			for (size_t i = first; i < first + lines; ++i)
+				out += "<http://example.com/filler/" + std::to_string(i) + "> <http://example.com/p> <http://example.com/o/" + std::to_string(i) + "> .\n";
+			return out;
+		}
+
+		// more than the 4 MiB blocks of the parallel N-Triples loader
+		constexpr size_t filler_lines = 80'000;
+	}// namespace
+
+	TEST_SUITE("loading") {
+		TEST_CASE("a blank node label is one blank node in all blocks of a parallel load") {
+			// the first blocks have no blank node, so they are parsed in parallel
+			std::string ntriples = filler(0, filler_lines);
+			ntriples += "_:b0 <http://example.com/first> \"1\" .\n";
+			ntriples += filler(filler_lines, filler_lines);
+			ntriples += "_:b0 <http://example.com/last> \"2\" .\n";
+			ntriples += filler(2 * filler_lines, filler_lines);
+			REQUIRE(ntriples.size() > (size_t(8) << 20));
+
+			std::string const query = "SELECT ?x WHERE { ?x <http://example.com/first> ?a . ?x <http://example.com/last> ?b }";
+			TestStore sequential{ntriples, 1};
+			TestStore parallel{ntriples, 4};
+			CHECK(parallel->size() == 3 * filler_lines + 2);
+			CHECK(parallel->size() == sequential->size());
+			CHECK(sequential.select(query).size() == 1);
+			CHECK(parallel.select(query).size() == 1);
+		}
+
+		TEST_CASE("a blank node label in the first block is one blank node in all blocks of a parallel load") {
+			std::string ntriples = "_:b1 <http://example.com/first> \"1\" .\n";
+			ntriples += filler(0, 2 * filler_lines);
+			ntriples += "_:b1 <http://example.com/last> \"2\" .\n";
+
+			TestStore parallel{ntriples, 4};
+			CHECK(parallel->size() == 2 * filler_lines + 2);
+			CHECK(parallel.select("SELECT ?x WHERE { ?x <http://example.com/first> ?a . ?x <http://example.com/last> ?b }").size() == 1);
+		}
+
+		TEST_CASE("a parallel load without blank nodes loads all triples") {
+			auto const ntriples = filler(0, 2 * filler_lines);
+			TestStore parallel{ntriples, 4};
+			CHECK(parallel->size() == 2 * filler_lines);
+		}
+
+		TEST_CASE("a term in several batches of a load is one term") {
+			// more triples than a batch of the sequential loader and than a block of the parallel one
+			auto const ntriples = filler(0, 3 * filler_lines);
+			std::string const query = "SELECT ?s WHERE { ?s <http://example.com/p> ?o }";
+			TestStore sequential{ntriples, 1};
+			TestStore parallel{ntriples, 4};
+			CHECK(sequential.select(query).size() == 3 * filler_lines);
+			CHECK(parallel.select(query).size() == 3 * filler_lines);
+		}
+
+		TEST_CASE("literals that are interned in bulk keep their datatype and language tag") {
+			std::string ntriples = filler(0, 2 * filler_lines);
+			ntriples += "<http://example.com/s> <http://example.com/q> \"x\"^^<http://example.com/datatype> .\n";
+			ntriples += "<http://example.com/s> <http://example.com/q> \"y\"@en .\n";
+			ntriples += "<http://example.com/s> <http://example.com/q> \"z\" .\n";
+			ntriples += "<http://example.com/s> <http://example.com/q> \"5\"^^<http://www.w3.org/2001/XMLSchema#integer> .\n";
+
+			std::string const query = "SELECT ?o WHERE { <http://example.com/s> <http://example.com/q> ?o }";
+			// the parallel load adds the literals to the node storage, the sequential one finds them
+			TestStore parallel{ntriples, 4};
+			TestStore sequential{ntriples, 1};
+			auto sequential_solutions = sequential.select(query);
+			auto parallel_solutions = parallel.select(query);
+			std::ranges::sort(sequential_solutions);
+			std::ranges::sort(parallel_solutions);
+			CHECK(sequential_solutions.size() == 4);
+			CHECK(parallel_solutions == sequential_solutions);
+			CHECK(sequential.select("SELECT ?s WHERE { ?s <http://example.com/q> \"x\"^^<http://example.com/datatype> }").size() == 1);
+			CHECK(parallel.select("SELECT ?s WHERE { ?s <http://example.com/q> \"y\"@en }").size() == 1);
+		}
+	}
+
+	TEST_SUITE("aggregates") {
+		TEST_CASE("COUNT of a variable skips solutions in which it is unbound") {
+			TestStore store{"<http://example.com/a> <http://example.com/p> <http://example.com/b> .\n"
+							"<http://example.com/c> <http://example.com/p> <http://example.com/d> .\n"
+							"<http://example.com/e> <http://example.com/p> <http://example.com/f> .\n"
+							"<http://example.com/a> <http://example.com/q> \"x\" .\n"
+							"<http://example.com/c> <http://example.com/q> \"x\" .\n"};
+			auto const count = [&](std::string const &aggregate) {
+				return store->eval_count(sparql2tensor::SPARQLQuery{
+						"SELECT (" + aggregate + " AS ?n) WHERE { ?s <http://example.com/p> ?x OPTIONAL { ?s <http://example.com/q> ?o } }"});
+			};
+			CHECK(count("COUNT(*)") == 3);
+			CHECK(count("COUNT(?s)") == 3);
+			CHECK(count("COUNT(?o)") == 2);
+			CHECK(count("COUNT(DISTINCT ?o)") == 1);
+		}
+	}
+
+	TEST_SUITE("statistics") {
+		TEST_CASE("the estimate of a star sums the characteristic sets that contain all of its predicates") {
+			// each subject has one object per predicate, so the estimates from complete statistics are exact
+			std::string ntriples;
+			auto const add = [&](std::string const &subject, std::initializer_list<char const *> predicates) {
+				for (auto const *predicate : predicates)
+					ntriples += "<http://example.com/" + subject + "> <http://example.com/" + predicate + "> <http://example.com/o> .\n";
+			};
+			for (size_t i = 0; i < 5; ++i)
+				add("pq" + std::to_string(i), {"p", "q"});
+			for (size_t i = 0; i < 3; ++i)
+				add("pqr" + std::to_string(i), {"p", "q", "r"});
+			for (size_t i = 0; i < 4; ++i)
+				add("p" + std::to_string(i), {"p"});
+			add("qr", {"q", "r"});
+			TestStore store{ntriples};
+			auto &manager = Storage::instance().manager();
+			auto *statistics = manager.construct<DatasetStatistics>(metall::anonymous_instance)(manager.get_allocator());
+			statistics->build(store.hypertrie(), 1);
+			auto const star = [&](std::initializer_list<char const *> predicates) {
+				std::vector<rdf_tensor::NodeWrapper> nodes;
+				for (auto const *predicate : predicates)
+					nodes.emplace_back(rdf4cpp::rdf::IRI{std::string{"http://example.com/"} + predicate});
+				return statistics->estimate_star(nodes);
+			};
+			REQUIRE(statistics->characteristic_sets().size() == 4);
+			CHECK(star({"p", "q"}) == doctest::Approx(8));
+			CHECK(star({"q", "p"}) == doctest::Approx(8));
+			CHECK(star({"q", "r"}) == doctest::Approx(4));
+			CHECK(star({"p", "q", "r"}) == doctest::Approx(3));
+			CHECK(star({"p"}) == doctest::Approx(12));
+			CHECK(star({"p", "unknown"}) == 0);
+			manager.destroy_ptr(statistics);
+		}
+	}
+
+	TEST_SUITE("FILTER") {
+		namespace {
+			std::string const filter_data =
+					"<http://example.com/a> <http://example.com/p> \"1\"^^<http://www.w3.org/2001/XMLSchema#integer> .\n"
+					"<http://example.com/b> <http://example.com/p> \"1.0\"^^<http://www.w3.org/2001/XMLSchema#decimal> .\n"
+					"<http://example.com/c> <http://example.com/p> \"chat\"@fr .\n"
+					"<http://example.com/d> <http://example.com/p> \"chat\" .\n"
+					"<http://example.com/e> <http://example.com/p> <http://example.com/x> .\n"
+					"<http://example.com/a> <http://example.com/q> <http://example.com/x> .\n";
+
+			/**
+			 * @return the sorted bindings of ?s, once with the FILTER variables restricted before the join and once with all FILTERs
+			 * checked per solution; both must be equal
+			 */
+			std::vector<std::string> subjects(TestStore &store, std::string const &filter) {
+				auto const query = "SELECT ?s WHERE { ?s <http://example.com/p> ?o OPTIONAL { ?s <http://example.com/q> ?x } FILTER(" + filter + ") }";
+				auto const evaluate = [&]() {
+					std::vector<std::string> bindings;
+					for (auto const &solution : store.select(query))
+						bindings.push_back(solution.front());
+					std::ranges::sort(bindings);
+					return bindings;
+				};
+				store->set_filter_scan_limit(1'000'000);
+				auto const restricted = evaluate();
+				store->set_filter_scan_limit(0);
+				auto const checked = evaluate();
+				CHECK(restricted == checked);
+				return restricted;
+			}
+
+			std::vector<std::string> iris(std::vector<std::string> const &names) {
+				std::vector<std::string> out;
+				for (auto const &name : names)
+					out.push_back(std::string(rdf4cpp::rdf::IRI{"http://example.com/" + name}));
+				std::ranges::sort(out);
+				return out;
+			}
+		}// namespace
+
+		TEST_CASE("= compares numbers by value and sameTerm compares terms") {
+			TestStore store{filter_data};
+			CHECK(subjects(store, "?o = 1") == iris({"a", "b"}));
+			CHECK(subjects(store, "?o = 1.0") == iris({"a", "b"}));
+			CHECK(subjects(store, "sameTerm(?o, 1)") == iris({"a"}));
+			// an IRI is not equal to a number; strings cannot be compared with numbers, which is an error
+			CHECK(subjects(store, "?o != 1") == iris({"e"}));
+		}
+
+		TEST_CASE("= compares language tags case-insensitively and distinguishes strings with and without tag") {
+			TestStore store{filter_data};
+			CHECK(subjects(store, "?o = \"chat\"@fr") == iris({"c"}));
+			CHECK(subjects(store, "?o = \"chat\"@FR") == iris({"c"}));
+			CHECK(subjects(store, "sameTerm(?o, \"chat\"@fr)") == iris({"c"}));
+			CHECK(subjects(store, "?o = \"chat\"") == iris({"d"}));
+		}
+
+		TEST_CASE("= with an IRI matches the IRI") {
+			TestStore store{filter_data};
+			CHECK(subjects(store, "?o = <http://example.com/x>") == iris({"e"}));
+			CHECK(subjects(store, "?o = <http://example.com/y>") == iris({}));
+		}
+
+		TEST_CASE("a FILTER on a variable of an OPTIONAL removes the solutions in which it is unbound") {
+			TestStore store{filter_data};
+			CHECK(subjects(store, "?x = <http://example.com/x>") == iris({"a"}));
+			CHECK(subjects(store, "sameTerm(?x, <http://example.com/x>)") == iris({"a"}));
+			CHECK(subjects(store, "BOUND(?x)") == iris({"a"}));
+			CHECK(subjects(store, "isIRI(?x) || isLiteral(?o)") == iris({"a", "b", "c", "d"}));
+		}
+	}
+
+}// namespace dice::triple_store